@@ -0,0 +1,545 @@
+#include <grilo.h>
+#include <gio/gio.h>
+
+#include "ges-asset.h"
+#include "ges-discovery-cache.h"
+#include "ges-internal.h"
+
+/**
+ * SECTION: gesasset
+ *
+ * A #GESAsset holds what was discovered about a given media URI. Assets
+ * are shared: all the #GESUriSources created from the same URI, whatever
+ * their media type, use the same #GESAsset, so a media only gets
+ * discovered once per process.
+ *
+ * Requesting an asset that is already being discovered by another thread
+ * waits for that discovery to complete instead of starting a new one.
+ */
+
+/* Structure definitions */
+
+#define GES_ASSET_PRIV(self) (ges_asset_get_instance_private (GES_ASSET (self)))
+
+typedef struct _GESAssetPrivate
+{
+  gchar *uri;
+  gchar *url;
+  GstDiscovererInfo *info;
+} GESAssetPrivate;
+
+struct _GESAsset
+{
+  GObject parent;
+};
+
+G_DEFINE_TYPE_WITH_CODE (GESAsset, ges_asset, G_TYPE_OBJECT,
+    G_ADD_PRIVATE (GESAsset)
+    )
+
+/* One entry per requested URI, refcounted as the requesting threads
+ * may still be waiting on it when it gets removed from the registry */
+typedef struct
+{
+  GESAsset *asset;
+  gboolean discovering;
+  guint refcount;
+  /* GTasks of the asynchronous requests waiting for the discovery */
+  GList *pending_tasks;
+} RegistryEntry;
+
+typedef struct
+{
+  gchar *uri;
+  RegistryEntry *entry;
+} DiscoveryJob;
+
+static GMutex registry_lock;
+static GCond registry_cond;
+static GHashTable *registry = NULL;
+
+/* Asynchronous discoveries are run there, it is bounded so that loading
+ * a large project doesn't spawn one thread per media */
+static GThreadPool *discovery_pool = NULL;
+static gint max_discovery_threads = -1;
+
+/* Implementation */
+
+/* Call with the registry lock */
+static void
+_entry_unref (RegistryEntry *entry)
+{
+  if (--entry->refcount)
+    return;
+
+  if (entry->asset)
+    g_object_unref (entry->asset);
+  g_slice_free (RegistryEntry, entry);
+}
+
+static GrlMedia *
+grl_media_from_uri (const gchar * uri)
+{
+  GrlMedia *media = NULL;
+  GError *error = NULL;
+  GList *tmp;
+  GrlOperationOptions *options;
+  GrlRegistry *registry = grl_registry_get_default ();
+  GrlSource *source;
+  GrlKeyID disco_key_id =
+    grl_registry_lookup_metadata_key (registry, "discovery");
+  GList *keys = grl_metadata_key_list_new (GRL_METADATA_KEY_EXTERNAL_URL,
+      GRL_METADATA_KEY_URL,
+      disco_key_id,
+      GRL_METADATA_KEY_INVALID);
+
+  if (disco_key_id == GRL_METADATA_KEY_INVALID)
+    return NULL;
+
+  registry = grl_registry_get_default ();
+
+  options = grl_operation_options_new (NULL);
+  grl_operation_options_set_count (options, 1);
+  grl_operation_options_set_resolution_flags (options, GRL_RESOLVE_FULL);
+
+  for (tmp = grl_registry_get_sources_by_operations (registry, GRL_OP_MEDIA_FROM_URI, TRUE); tmp; tmp=tmp->next)  {
+    source = GRL_SOURCE (tmp->data);
+    if (grl_source_test_media_from_uri (source, uri)) {
+      error = NULL;
+      media = grl_source_get_media_from_uri_sync (source,
+          uri, keys, options, &error);
+      if (media) {
+        break;
+      }
+    }
+  }
+
+  return media;
+}
+
+static GstDiscovererInfo *
+_get_discoverer_info_from_grl_media (GrlMedia *media)
+{
+  GrlRegistry *registry = grl_registry_get_default ();
+  const GValue *info_value;
+  GstDiscovererInfo *info;
+
+  GrlKeyID disco_key_id =
+    grl_registry_lookup_metadata_key (registry, "discovery");
+
+  info_value = grl_data_get (GRL_DATA (media), disco_key_id);
+  if (!info_value)
+    return NULL;
+
+  info = g_value_get_object (info_value);
+
+  return info;
+}
+
+/* Returns a new reference to the GstDiscovererInfo of @uri, and the actual
+ * url of the media in @url. The discovery cache is consulted first, grilo
+ * only gets asked on a miss. */
+static GstDiscovererInfo *
+_discover (const gchar *uri, gchar **url)
+{
+  GESDiscoveryCache *cache = ges_discovery_cache_get_default ();
+  GstDiscovererInfo *info;
+  GrlMedia *media;
+
+  info = ges_discovery_cache_lookup (cache, uri, url);
+  if (info)
+    return info;
+
+  media = grl_media_from_uri (uri);
+  if (!media)
+    return NULL;
+
+  info = _get_discoverer_info_from_grl_media (media);
+  if (info) {
+    gst_discoverer_info_ref (info);
+    *url = g_strdup (grl_media_get_url (media));
+    ges_discovery_cache_store (cache, uri, *url, info);
+  }
+
+  g_object_unref (media);
+
+  return info;
+}
+
+/* Call with the registry lock. Returns TRUE if the caller got a new
+ * entry and has to run the discovery of @uri itself, in which case it also
+ * owns a reference to @entry */
+static gboolean
+_claim_entry (const gchar *uri, RegistryEntry **entry)
+{
+  if (!registry)
+    registry = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) _entry_unref);
+
+  *entry = g_hash_table_lookup (registry, uri);
+  if (*entry)
+    return FALSE;
+
+  *entry = g_slice_new0 (RegistryEntry);
+  (*entry)->discovering = TRUE;
+  /* One for the registry, one for the caller */
+  (*entry)->refcount = 2;
+  g_hash_table_insert (registry, g_strdup (uri), *entry);
+
+  return TRUE;
+}
+
+static void
+_return_task (GTask *task, GESAsset *asset, const gchar *uri)
+{
+  if (asset)
+    g_task_return_pointer (task, g_object_ref (asset), g_object_unref);
+  else
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+        "Could not discover %s", uri);
+  g_object_unref (task);
+}
+
+/* Discover @uri, fill @entry and wake up everyone waiting for it */
+static GESAsset *
+_run_discovery (const gchar *uri, RegistryEntry *entry)
+{
+  GESAssetPrivate *priv;
+  GESAsset *res = NULL;
+  GstDiscovererInfo *info;
+  GList *pending_tasks, *tmp;
+  gchar *url = NULL;
+
+  info = _discover (uri, &url);
+
+  if (info) {
+    res = g_object_new (GES_TYPE_ASSET, NULL);
+    priv = GES_ASSET_PRIV (res);
+    priv->uri = g_strdup (uri);
+    priv->url = url;
+    priv->info = info;
+  }
+
+  g_mutex_lock (&registry_lock);
+  entry->discovering = FALSE;
+  if (res) {
+    entry->asset = g_object_ref (res);
+  } else if (g_hash_table_lookup (registry, uri) == entry) {
+    /* Let later requests try again */
+    g_hash_table_remove (registry, uri);
+  }
+  pending_tasks = entry->pending_tasks;
+  entry->pending_tasks = NULL;
+  _entry_unref (entry);
+  g_cond_broadcast (&registry_cond);
+  g_mutex_unlock (&registry_lock);
+
+  for (tmp = pending_tasks; tmp; tmp = tmp->next)
+    _return_task (tmp->data, res, uri);
+  g_list_free (pending_tasks);
+
+  return res;
+}
+
+static void
+_discovery_job_func (GTask *task, gpointer unused)
+{
+  DiscoveryJob *job = g_task_get_task_data (task);
+  GESAsset *asset = _run_discovery (job->uri, job->entry);
+
+  if (asset)
+    g_object_unref (asset);
+
+  /* The reference given to the pool */
+  g_object_unref (task);
+}
+
+static void
+_free_discovery_job (DiscoveryJob *job)
+{
+  g_free (job->uri);
+  g_slice_free (DiscoveryJob, job);
+}
+
+/* API */
+
+/**
+ * ges_asset_request:
+ * @uri: The URI of the media
+ *
+ * Get the #GESAsset for @uri, discovering it if it is not known yet.
+ * This can safely be called from any thread.
+ *
+ * Returns: (transfer full) (allow-none): The #GESAsset for @uri, %NULL
+ * if @uri could not be discovered.
+ */
+GESAsset *
+ges_asset_request (const gchar *uri)
+{
+  RegistryEntry *entry;
+  GESAsset *res = NULL;
+
+  g_mutex_lock (&registry_lock);
+
+  if (_claim_entry (uri, &entry)) {
+    g_mutex_unlock (&registry_lock);
+    return _run_discovery (uri, entry);
+  }
+
+  entry->refcount += 1;
+  while (entry->discovering) {
+    GST_DEBUG ("Waiting for the ongoing discovery of %s", uri);
+    g_cond_wait (&registry_cond, &registry_lock);
+  }
+
+  if (entry->asset)
+    res = g_object_ref (entry->asset);
+  _entry_unref (entry);
+  g_mutex_unlock (&registry_lock);
+
+  return res;
+}
+
+/**
+ * ges_asset_request_async:
+ * @uri: The URI of the media
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async) (allow-none): callback to call when the asset is ready
+ * @user_data: the data to pass to @callback
+ *
+ * Asynchronous version of ges_asset_request(). The discovery runs on a
+ * bounded pool of worker threads, see ges_asset_set_max_discovery_threads(),
+ * and @callback is called in the thread-default main context of the caller.
+ *
+ * Requests for a URI that is already being discovered don't occupy a
+ * worker thread, they complete together with the ongoing discovery.
+ * Passing a %NULL @callback can be used to prefetch assets before
+ * deserializing objects.
+ */
+void
+ges_asset_request_async (const gchar *uri, GCancellable *cancellable,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  GTask *task = g_task_new (NULL, cancellable, callback, user_data);
+  RegistryEntry *entry;
+  DiscoveryJob *job;
+
+  g_mutex_lock (&registry_lock);
+
+  if (!_claim_entry (uri, &entry)) {
+    if (entry->discovering) {
+      entry->pending_tasks = g_list_append (entry->pending_tasks, task);
+      g_mutex_unlock (&registry_lock);
+    } else {
+      GESAsset *asset = g_object_ref (entry->asset);
+
+      g_mutex_unlock (&registry_lock);
+      _return_task (task, asset, uri);
+      g_object_unref (asset);
+    }
+    return;
+  }
+
+  if (!discovery_pool)
+    discovery_pool = g_thread_pool_new ((GFunc) _discovery_job_func, NULL,
+        max_discovery_threads > 0 ? max_discovery_threads : (gint) g_get_num_processors (),
+        FALSE, NULL);
+
+  job = g_slice_new0 (DiscoveryJob);
+  job->uri = g_strdup (uri);
+  job->entry = entry;
+  g_task_set_task_data (task, job, (GDestroyNotify) _free_discovery_job);
+
+  /* The requesting task is also the first one waiting for the result */
+  entry->pending_tasks = g_list_append (entry->pending_tasks, g_object_ref (task));
+  g_thread_pool_push (discovery_pool, task, NULL);
+  g_mutex_unlock (&registry_lock);
+}
+
+/**
+ * ges_asset_request_finish:
+ * @result: The #GAsyncResult passed to the callback of ges_asset_request_async()
+ * @error: return location for a #GError, or %NULL
+ *
+ * Returns: (transfer full) (allow-none): The requested #GESAsset, %NULL
+ * if it couldn't be discovered, in which case @error is set.
+ */
+GESAsset *
+ges_asset_request_finish (GAsyncResult *result, GError **error)
+{
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/* Discovers @uris in parallel on the discovery pool and waits for all of
+ * them, the ges_asset_request() calls made while deserializing objects
+ * then complete right away instead of discovering one media at a time */
+void
+ges_asset_prefetch (GPtrArray *uris)
+{
+  guint i;
+
+  for (i = 0; i < uris->len; i++)
+    ges_asset_request_async (g_ptr_array_index (uris, i), NULL, NULL, NULL);
+
+  g_mutex_lock (&registry_lock);
+  for (i = 0; i < uris->len; i++) {
+    RegistryEntry *entry;
+
+    /* Failed discoveries get removed from the registry */
+    while ((entry = g_hash_table_lookup (registry, g_ptr_array_index (uris, i))) &&
+        entry->discovering)
+      g_cond_wait (&registry_cond, &registry_lock);
+  }
+  g_mutex_unlock (&registry_lock);
+}
+
+/**
+ * ges_asset_set_max_discovery_threads:
+ * @max_threads: The maximum number of asynchronous discoveries to run at
+ * once, -1 to use the number of processors.
+ *
+ * Bound the number of worker threads used by ges_asset_request_async().
+ */
+void
+ges_asset_set_max_discovery_threads (gint max_threads)
+{
+  g_mutex_lock (&registry_lock);
+  max_discovery_threads = max_threads;
+  if (discovery_pool)
+    g_thread_pool_set_max_threads (discovery_pool,
+        max_threads > 0 ? max_threads : (gint) g_get_num_processors (), NULL);
+  g_mutex_unlock (&registry_lock);
+}
+
+/**
+ * ges_asset_registry_clear:
+ *
+ * Forget about all the known assets, the next request for a given URI
+ * will discover it again. Assets still in use are not affected.
+ */
+void
+ges_asset_registry_clear (void)
+{
+  g_mutex_lock (&registry_lock);
+  if (registry)
+    g_hash_table_remove_all (registry);
+  g_mutex_unlock (&registry_lock);
+}
+
+/**
+ * ges_asset_get_uri:
+ * @asset: a #GESAsset
+ *
+ * Returns: The URI @asset was requested for
+ */
+const gchar *
+ges_asset_get_uri (GESAsset *asset)
+{
+  GESAssetPrivate *priv = GES_ASSET_PRIV (asset);
+
+  return priv->uri;
+}
+
+/**
+ * ges_asset_get_url:
+ * @asset: a #GESAsset
+ *
+ * Returns: The actual url of the media, which can differ from its URI
+ * for media resolved by grilo.
+ */
+const gchar *
+ges_asset_get_url (GESAsset *asset)
+{
+  GESAssetPrivate *priv = GES_ASSET_PRIV (asset);
+
+  return priv->url;
+}
+
+/**
+ * ges_asset_get_info:
+ * @asset: a #GESAsset
+ *
+ * Returns: (transfer none): The #GstDiscovererInfo of @asset
+ */
+GstDiscovererInfo *
+ges_asset_get_info (GESAsset *asset)
+{
+  GESAssetPrivate *priv = GES_ASSET_PRIV (asset);
+
+  return priv->info;
+}
+
+/**
+ * ges_asset_get_duration:
+ * @asset: a #GESAsset
+ *
+ * Returns: The duration of the media
+ */
+GstClockTime
+ges_asset_get_duration (GESAsset *asset)
+{
+  GESAssetPrivate *priv = GES_ASSET_PRIV (asset);
+
+  return gst_discoverer_info_get_duration (priv->info);
+}
+
+/**
+ * ges_asset_has_media_type:
+ * @asset: a #GESAsset
+ * @media_type: a #GESMediaType
+ *
+ * Returns: %TRUE if the media contains at least one stream of @media_type
+ */
+gboolean
+ges_asset_has_media_type (GESAsset *asset, GESMediaType media_type)
+{
+  GESAssetPrivate *priv = GES_ASSET_PRIV (asset);
+  GList *streams;
+
+  if (media_type == GES_MEDIA_TYPE_AUDIO)
+    streams = gst_discoverer_info_get_audio_streams (priv->info);
+  else if (media_type == GES_MEDIA_TYPE_VIDEO)
+    streams = gst_discoverer_info_get_video_streams (priv->info);
+  else
+    return FALSE;
+
+  if (!streams)
+    return FALSE;
+
+  gst_discoverer_stream_info_list_free (streams);
+
+  return TRUE;
+}
+
+/* GObject initialization */
+
+static void
+_finalize (GObject *object)
+{
+  GESAssetPrivate *priv = GES_ASSET_PRIV (object);
+
+  g_free (priv->uri);
+  g_free (priv->url);
+  if (priv->info)
+    gst_discoverer_info_unref (priv->info);
+
+  G_OBJECT_CLASS (ges_asset_parent_class)->finalize (object);
+}
+
+static void
+ges_asset_class_init (GESAssetClass *klass)
+{
+  GObjectClass *g_object_class = G_OBJECT_CLASS (klass);
+
+  g_object_class->finalize = _finalize;
+}
+
+static void
+ges_asset_init (GESAsset *self)
+{
+  GESAssetPrivate *priv = GES_ASSET_PRIV (self);
+
+  priv->uri = NULL;
+  priv->url = NULL;
+  priv->info = NULL;
+}
@@ -0,0 +1,31 @@
+#ifndef _GES_ASSET
+#define _GES_ASSET
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <gst/gst.h>
+#include <gst/pbutils/gstdiscoverer.h>
+#include <ges-enums.h>
+
+G_BEGIN_DECLS
+
+#define GES_TYPE_ASSET (ges_asset_get_type ())
+
+G_DECLARE_FINAL_TYPE(GESAsset, ges_asset, GES, ASSET, GObject)
+
+GESAsset *ges_asset_request (const gchar *uri);
+void ges_asset_request_async (const gchar *uri, GCancellable *cancellable,
+    GAsyncReadyCallback callback, gpointer user_data);
+GESAsset *ges_asset_request_finish (GAsyncResult *result, GError **error);
+void ges_asset_set_max_discovery_threads (gint max_threads);
+void ges_asset_registry_clear (void);
+
+const gchar *ges_asset_get_uri (GESAsset *asset);
+const gchar *ges_asset_get_url (GESAsset *asset);
+GstDiscovererInfo *ges_asset_get_info (GESAsset *asset);
+GstClockTime ges_asset_get_duration (GESAsset *asset);
+gboolean ges_asset_has_media_type (GESAsset *asset, GESMediaType media_type);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,663 @@
+#include "ges-clip-table.h"
+#include "ges-uri-source.h"
+
+/**
+ * SECTION: gescliptable
+ *
+ * A #GESClipTable is a compact storage for a large number of clips. Each
+ * clip is a row, and the start, duration, inpoint, track index, media type
+ * and asset id of all the rows are stored in contiguous arrays, so
+ * scanning a few hundred thousand clips doesn't involve touching as many
+ * #GObjects.
+ *
+ * #GESObject wrappers are only created when asked for with
+ * ges_clip_table_get_object() or ges_clip_table_add_to_timeline(). While a
+ * row is materialized its wrapper is authoritative, the values in the
+ * arrays are updated from it when it gets released with
+ * ges_clip_table_release_object().
+ */
+
+/* Structure definitions */
+
+#define GES_CLIP_TABLE_PRIV(self) (ges_clip_table_get_instance_private (GES_CLIP_TABLE (self)))
+
+typedef enum
+{
+  ROW_MATERIALIZED = 1 << 0,
+  ROW_IN_TIMELINE = 1 << 1,
+} RowFlags;
+
+typedef struct _GESClipTablePrivate
+{
+  /* One element per row */
+  GArray *starts;
+  GArray *durations;
+  GArray *inpoints;
+  GArray *track_indexes;
+  GArray *asset_ids;
+  GArray *media_types;
+  GArray *flags;
+
+  /* Asset ids index uris, uri_ids maps them back */
+  GPtrArray *uris;
+  GHashTable *uri_ids;
+
+  /* row index -> GESObject, only for materialized rows */
+  GHashTable *objects;
+
+  /* GESTimeline -> GArray of the indexes of the rows added to it. Those
+   * rows leave it when it gets finalized, see _timeline_finalized_cb */
+  GHashTable *timelines;
+} GESClipTablePrivate;
+
+struct _GESClipTable
+{
+  GObject parent;
+};
+
+G_DEFINE_TYPE_WITH_CODE (GESClipTable, ges_clip_table, G_TYPE_OBJECT,
+    G_ADD_PRIVATE (GESClipTable)
+    )
+
+/* Implementation */
+
+#define ROW_FLAGS(priv, index) g_array_index ((priv)->flags, guint8, (index))
+
+static GESObject *
+_get_materialized (GESClipTablePrivate *priv, guint index)
+{
+  if (!(ROW_FLAGS (priv, index) & ROW_MATERIALIZED))
+    return NULL;
+
+  return g_hash_table_lookup (priv->objects, GUINT_TO_POINTER (index));
+}
+
+static guint
+_get_asset_id (GESClipTablePrivate *priv, const gchar *uri)
+{
+  gpointer id;
+
+  if (g_hash_table_lookup_extended (priv->uri_ids, uri, NULL, &id))
+    return GPOINTER_TO_UINT (id);
+
+  g_ptr_array_add (priv->uris, g_strdup (uri));
+  id = GUINT_TO_POINTER (priv->uris->len - 1);
+  g_hash_table_insert (priv->uri_ids, g_ptr_array_index (priv->uris, priv->uris->len - 1), id);
+
+  return GPOINTER_TO_UINT (id);
+}
+
+static void
+_sync_row (GESClipTablePrivate *priv, guint index, GESObject *object)
+{
+  GESMediaType media_type = g_array_index (priv->media_types, guint8, index);
+
+  g_array_index (priv->starts, GstClockTime, index) = ges_object_get_start (object);
+  g_array_index (priv->durations, GstClockTime, index) = ges_object_get_duration (object);
+  g_array_index (priv->inpoints, GstClockTime, index) = ges_object_get_inpoint (object);
+
+  if (media_type == GES_MEDIA_TYPE_VIDEO)
+    g_array_index (priv->track_indexes, guint, index) = ges_object_get_video_track_index (object);
+  else
+    g_array_index (priv->track_indexes, guint, index) = ges_object_get_audio_track_index (object);
+}
+
+/* The objects of the rows added to @timeline are not part of any timeline
+ * anymore, they can be released or added to another one */
+static void
+_timeline_finalized_cb (GESClipTable *self, GObject *timeline)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GArray *indexes = g_hash_table_lookup (priv->timelines, timeline);
+  guint i;
+
+  for (i = 0; i < indexes->len; i++)
+    ROW_FLAGS (priv, g_array_index (indexes, guint, i)) &= ~ROW_IN_TIMELINE;
+
+  g_hash_table_remove (priv->timelines, timeline);
+}
+
+static void
+_track_timeline_row (GESClipTable *self, GESTimeline *timeline, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GArray *indexes = g_hash_table_lookup (priv->timelines, timeline);
+
+  if (!indexes) {
+    indexes = g_array_new (FALSE, FALSE, sizeof (guint));
+    g_hash_table_insert (priv->timelines, timeline, indexes);
+    g_object_weak_ref (G_OBJECT (timeline), (GWeakNotify) _timeline_finalized_cb, self);
+  }
+
+  g_array_append_val (indexes, index);
+  ROW_FLAGS (priv, index) |= ROW_IN_TIMELINE;
+}
+
+static GESObject *
+_materialize (GESClipTable *self, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GESMediaType media_type = g_array_index (priv->media_types, guint8, index);
+  guint asset_id = g_array_index (priv->asset_ids, guint, index);
+  guint track_index = g_array_index (priv->track_indexes, guint, index);
+  GESObject *object;
+
+  object = (GESObject *) ges_uri_source_new (g_ptr_array_index (priv->uris, asset_id), media_type);
+  if (!object) {
+    GST_ERROR_OBJECT (self, "could not create an object for clip %u", index);
+    return NULL;
+  }
+
+  g_object_ref_sink (object);
+
+  ges_object_set_inpoint (object, g_array_index (priv->inpoints, GstClockTime, index));
+  ges_object_set_duration (object, g_array_index (priv->durations, GstClockTime, index));
+  ges_object_set_start (object, g_array_index (priv->starts, GstClockTime, index));
+
+  if (media_type == GES_MEDIA_TYPE_VIDEO)
+    ges_object_set_video_track_index (object, track_index);
+  else
+    ges_object_set_audio_track_index (object, track_index);
+
+  g_hash_table_insert (priv->objects, GUINT_TO_POINTER (index), object);
+  ROW_FLAGS (priv, index) |= ROW_MATERIALIZED;
+
+  return object;
+}
+
+/* API */
+
+/**
+ * ges_clip_table_new:
+ *
+ * Returns: A new, empty #GESClipTable
+ */
+GESClipTable *
+ges_clip_table_new (void)
+{
+  return g_object_new (GES_TYPE_CLIP_TABLE, NULL);
+}
+
+/**
+ * ges_clip_table_add_clip:
+ * @self: a #GESClipTable
+ * @uri: The URI of the media of the clip
+ * @media_type: Either %GES_MEDIA_TYPE_VIDEO or %GES_MEDIA_TYPE_AUDIO
+ * @start: The start of the clip, see #GESObject:start
+ * @duration: The duration of the clip, see #GESObject:duration
+ * @inpoint: The inpoint of the clip, see #GESObject:inpoint
+ * @track_index: The video or audio track index of the clip, depending on
+ * @media_type
+ *
+ * Adds a clip to @self. This doesn't create any #GESObject nor requires
+ * @uri to be discovered, this will only happen if the clip gets
+ * materialized.
+ *
+ * Returns: The index of the new row
+ */
+guint
+ges_clip_table_add_clip (GESClipTable *self, const gchar *uri, GESMediaType media_type,
+    GstClockTime start, GstClockTime duration, GstClockTime inpoint, guint track_index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  guint8 media_type_value = media_type;
+  guint8 flags = 0;
+  guint asset_id;
+
+  g_return_val_if_fail (media_type == GES_MEDIA_TYPE_VIDEO || media_type == GES_MEDIA_TYPE_AUDIO, G_MAXUINT);
+
+  asset_id = _get_asset_id (priv, uri);
+
+  g_array_append_val (priv->starts, start);
+  g_array_append_val (priv->durations, duration);
+  g_array_append_val (priv->inpoints, inpoint);
+  g_array_append_val (priv->track_indexes, track_index);
+  g_array_append_val (priv->asset_ids, asset_id);
+  g_array_append_val (priv->media_types, media_type_value);
+  g_array_append_val (priv->flags, flags);
+
+  return priv->starts->len - 1;
+}
+
+/**
+ * ges_clip_table_get_n_clips:
+ * @self: a #GESClipTable
+ *
+ * Returns: The number of rows in @self
+ */
+guint
+ges_clip_table_get_n_clips (GESClipTable *self)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+
+  return priv->starts->len;
+}
+
+/**
+ * ges_clip_table_get_start:
+ * @self: a #GESClipTable
+ * @index: A row index
+ *
+ * Returns: The start of the clip at @index
+ */
+GstClockTime
+ges_clip_table_get_start (GESClipTable *self, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GESObject *object;
+
+  g_return_val_if_fail (index < priv->starts->len, GST_CLOCK_TIME_NONE);
+
+  if ((object = _get_materialized (priv, index)))
+    return ges_object_get_start (object);
+
+  return g_array_index (priv->starts, GstClockTime, index);
+}
+
+/**
+ * ges_clip_table_get_duration:
+ * @self: a #GESClipTable
+ * @index: A row index
+ *
+ * Returns: The duration of the clip at @index
+ */
+GstClockTime
+ges_clip_table_get_duration (GESClipTable *self, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GESObject *object;
+
+  g_return_val_if_fail (index < priv->starts->len, GST_CLOCK_TIME_NONE);
+
+  if ((object = _get_materialized (priv, index)))
+    return ges_object_get_duration (object);
+
+  return g_array_index (priv->durations, GstClockTime, index);
+}
+
+/**
+ * ges_clip_table_get_inpoint:
+ * @self: a #GESClipTable
+ * @index: A row index
+ *
+ * Returns: The inpoint of the clip at @index
+ */
+GstClockTime
+ges_clip_table_get_inpoint (GESClipTable *self, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GESObject *object;
+
+  g_return_val_if_fail (index < priv->starts->len, GST_CLOCK_TIME_NONE);
+
+  if ((object = _get_materialized (priv, index)))
+    return ges_object_get_inpoint (object);
+
+  return g_array_index (priv->inpoints, GstClockTime, index);
+}
+
+/**
+ * ges_clip_table_get_track_index:
+ * @self: a #GESClipTable
+ * @index: A row index
+ *
+ * Returns: The video or audio track index of the clip at @index,
+ * depending on its media type
+ */
+guint
+ges_clip_table_get_track_index (GESClipTable *self, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GESObject *object;
+
+  g_return_val_if_fail (index < priv->starts->len, 0);
+
+  if ((object = _get_materialized (priv, index))) {
+    if (g_array_index (priv->media_types, guint8, index) == GES_MEDIA_TYPE_VIDEO)
+      return ges_object_get_video_track_index (object);
+    return ges_object_get_audio_track_index (object);
+  }
+
+  return g_array_index (priv->track_indexes, guint, index);
+}
+
+/**
+ * ges_clip_table_get_media_type:
+ * @self: a #GESClipTable
+ * @index: A row index
+ *
+ * Returns: The media type of the clip at @index
+ */
+GESMediaType
+ges_clip_table_get_media_type (GESClipTable *self, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+
+  g_return_val_if_fail (index < priv->starts->len, GES_MEDIA_TYPE_UNKNOWN);
+
+  return g_array_index (priv->media_types, guint8, index);
+}
+
+/**
+ * ges_clip_table_get_asset_id:
+ * @self: a #GESClipTable
+ * @index: A row index
+ *
+ * Clips using the same media share the same asset id.
+ *
+ * Returns: The asset id of the clip at @index, see
+ * ges_clip_table_get_asset_uri()
+ */
+guint
+ges_clip_table_get_asset_id (GESClipTable *self, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+
+  g_return_val_if_fail (index < priv->starts->len, G_MAXUINT);
+
+  return g_array_index (priv->asset_ids, guint, index);
+}
+
+/**
+ * ges_clip_table_get_asset_uri:
+ * @self: a #GESClipTable
+ * @asset_id: An asset id, as returned by ges_clip_table_get_asset_id()
+ *
+ * Returns: The URI corresponding to @asset_id
+ */
+const gchar *
+ges_clip_table_get_asset_uri (GESClipTable *self, guint asset_id)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+
+  g_return_val_if_fail (asset_id < priv->uris->len, NULL);
+
+  return g_ptr_array_index (priv->uris, asset_id);
+}
+
+/**
+ * ges_clip_table_set_start:
+ * @self: a #GESClipTable
+ * @index: A row index
+ * @start: The new start of the clip
+ *
+ * Returns: %TRUE if @start could be set, %FALSE otherwise
+ */
+gboolean
+ges_clip_table_set_start (GESClipTable *self, guint index, GstClockTime start)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GESObject *object;
+
+  g_return_val_if_fail (index < priv->starts->len, FALSE);
+
+  if ((object = _get_materialized (priv, index)))
+    return ges_object_set_start (object, start);
+
+  g_array_index (priv->starts, GstClockTime, index) = start;
+
+  return TRUE;
+}
+
+/**
+ * ges_clip_table_set_duration:
+ * @self: a #GESClipTable
+ * @index: A row index
+ * @duration: The new duration of the clip
+ *
+ * Returns: %TRUE if @duration could be set, %FALSE otherwise
+ */
+gboolean
+ges_clip_table_set_duration (GESClipTable *self, guint index, GstClockTime duration)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GESObject *object;
+
+  g_return_val_if_fail (index < priv->starts->len, FALSE);
+
+  if ((object = _get_materialized (priv, index)))
+    return ges_object_set_duration (object, duration);
+
+  g_array_index (priv->durations, GstClockTime, index) = duration;
+
+  return TRUE;
+}
+
+/**
+ * ges_clip_table_set_inpoint:
+ * @self: a #GESClipTable
+ * @index: A row index
+ * @inpoint: The new inpoint of the clip
+ *
+ * Returns: %TRUE if @inpoint could be set, %FALSE otherwise
+ */
+gboolean
+ges_clip_table_set_inpoint (GESClipTable *self, guint index, GstClockTime inpoint)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GESObject *object;
+
+  g_return_val_if_fail (index < priv->starts->len, FALSE);
+
+  if ((object = _get_materialized (priv, index)))
+    return ges_object_set_inpoint (object, inpoint);
+
+  g_array_index (priv->inpoints, GstClockTime, index) = inpoint;
+
+  return TRUE;
+}
+
+/**
+ * ges_clip_table_find_clips:
+ * @self: a #GESClipTable
+ * @start: The start of the range to look up
+ * @stop: The end of the range to look up, exclusive
+ *
+ * Returns: (transfer full) (element-type guint): The indexes of the rows
+ * of the clips overlapping with [@start, @stop[, in row order
+ */
+GArray *
+ges_clip_table_find_clips (GESClipTable *self, GstClockTime start, GstClockTime stop)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GArray *res = g_array_new (FALSE, FALSE, sizeof (guint));
+  const GstClockTime *starts = (const GstClockTime *) priv->starts->data;
+  const GstClockTime *durations = (const GstClockTime *) priv->durations->data;
+  const guint8 *flags = (const guint8 *) priv->flags->data;
+  guint i;
+
+  for (i = 0; i < priv->starts->len; i++) {
+    GstClockTime clip_start, clip_stop;
+
+    if (G_UNLIKELY (flags[i] & ROW_MATERIALIZED)) {
+      clip_start = ges_clip_table_get_start (self, i);
+      clip_stop = clip_start + ges_clip_table_get_duration (self, i);
+    } else {
+      clip_start = starts[i];
+      clip_stop = starts[i] + durations[i];
+    }
+
+    if (clip_start < stop && clip_stop > start)
+      g_array_append_val (res, i);
+  }
+
+  return res;
+}
+
+/**
+ * ges_clip_table_get_object:
+ * @self: a #GESClipTable
+ * @index: A row index
+ *
+ * Get the #GESObject for the clip at @index, creating it if needed. As long
+ * as it isn't released with ges_clip_table_release_object(), the same object
+ * is returned, and changes made to it are reflected by the getters of @self.
+ *
+ * Returns: (transfer full): The #GESObject for the clip at @index, or
+ * %NULL if it could not be created.
+ */
+GESObject *
+ges_clip_table_get_object (GESClipTable *self, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GESObject *object;
+
+  g_return_val_if_fail (index < priv->starts->len, NULL);
+
+  object = _get_materialized (priv, index);
+  if (!object)
+    object = _materialize (self, index);
+
+  return object ? g_object_ref (object) : NULL;
+}
+
+/**
+ * ges_clip_table_is_materialized:
+ * @self: a #GESClipTable
+ * @index: A row index
+ *
+ * Returns: %TRUE if a #GESObject currently exists for the clip at @index
+ */
+gboolean
+ges_clip_table_is_materialized (GESClipTable *self, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+
+  g_return_val_if_fail (index < priv->starts->len, FALSE);
+
+  return (ROW_FLAGS (priv, index) & ROW_MATERIALIZED) != 0;
+}
+
+/**
+ * ges_clip_table_release_object:
+ * @self: a #GESClipTable
+ * @index: A row index
+ *
+ * Stores the current values of the #GESObject of the clip at @index back in
+ * @self and drops the reference @self holds on it. Later changes to that
+ * object are not reflected in @self anymore.
+ *
+ * Clips that were added to a timeline with ges_clip_table_add_to_timeline()
+ * can't be released until that timeline is finalized.
+ */
+void
+ges_clip_table_release_object (GESClipTable *self, guint index)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GESObject *object;
+
+  g_return_if_fail (index < priv->starts->len);
+
+  if (ROW_FLAGS (priv, index) & ROW_IN_TIMELINE) {
+    GST_WARNING_OBJECT (self, "clip %u is in a timeline, not releasing it", index);
+    return;
+  }
+
+  if (!(object = _get_materialized (priv, index)))
+    return;
+
+  _sync_row (priv, index, object);
+  ROW_FLAGS (priv, index) &= ~ROW_MATERIALIZED;
+  g_hash_table_remove (priv->objects, GUINT_TO_POINTER (index));
+}
+
+/**
+ * ges_clip_table_add_to_timeline:
+ * @self: a #GESClipTable
+ * @timeline: The #GESTimeline to add clips to
+ * @start: The start of the range of clips to add
+ * @stop: The end of the range of clips to add, exclusive
+ *
+ * Materializes the clips of @self overlapping with [@start, @stop[ and adds
+ * them to @timeline. This lets applications only create objects for the
+ * part of a very large project they are currently working on. Clips that
+ * were already added to a timeline are skipped, until that timeline gets
+ * finalized.
+ *
+ * Returns: The number of clips that were added to @timeline
+ */
+guint
+ges_clip_table_add_to_timeline (GESClipTable *self, GESTimeline *timeline,
+    GstClockTime start, GstClockTime stop)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+  GArray *indexes = ges_clip_table_find_clips (self, start, stop);
+  guint i, n_added = 0;
+
+  for (i = 0; i < indexes->len; i++) {
+    guint index = g_array_index (indexes, guint, i);
+    GESObject *object;
+
+    if (ROW_FLAGS (priv, index) & ROW_IN_TIMELINE)
+      continue;
+
+    object = ges_clip_table_get_object (self, index);
+    if (!object)
+      continue;
+
+    if (ges_timeline_add_object (timeline, object)) {
+      _track_timeline_row (self, timeline, index);
+      n_added += 1;
+    }
+
+    g_object_unref (object);
+  }
+
+  g_array_unref (indexes);
+
+  return n_added;
+}
+
+/* GObject initialization */
+
+static void
+_finalize (GObject *object)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (object);
+  GHashTableIter iter;
+  gpointer timeline;
+
+  g_hash_table_iter_init (&iter, priv->timelines);
+  while (g_hash_table_iter_next (&iter, &timeline, NULL))
+    g_object_weak_unref (timeline, (GWeakNotify) _timeline_finalized_cb, object);
+  g_hash_table_unref (priv->timelines);
+  g_hash_table_unref (priv->objects);
+  g_hash_table_unref (priv->uri_ids);
+  g_ptr_array_unref (priv->uris);
+  g_array_unref (priv->starts);
+  g_array_unref (priv->durations);
+  g_array_unref (priv->inpoints);
+  g_array_unref (priv->track_indexes);
+  g_array_unref (priv->asset_ids);
+  g_array_unref (priv->media_types);
+  g_array_unref (priv->flags);
+
+  G_OBJECT_CLASS (ges_clip_table_parent_class)->finalize (object);
+}
+
+static void
+ges_clip_table_class_init (GESClipTableClass *klass)
+{
+  GObjectClass *g_object_class = G_OBJECT_CLASS (klass);
+
+  g_object_class->finalize = _finalize;
+}
+
+static void
+ges_clip_table_init (GESClipTable *self)
+{
+  GESClipTablePrivate *priv = GES_CLIP_TABLE_PRIV (self);
+
+  priv->starts = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  priv->durations = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  priv->inpoints = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  priv->track_indexes = g_array_new (FALSE, FALSE, sizeof (guint));
+  priv->asset_ids = g_array_new (FALSE, FALSE, sizeof (guint));
+  priv->media_types = g_array_new (FALSE, FALSE, sizeof (guint8));
+  priv->flags = g_array_new (FALSE, FALSE, sizeof (guint8));
+
+  priv->uris = g_ptr_array_new_with_free_func (g_free);
+  priv->uri_ids = g_hash_table_new (g_str_hash, g_str_equal);
+  priv->objects = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
+  priv->timelines = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_array_unref);
+}
@@ -0,0 +1,43 @@
+#ifndef _GES_CLIP_TABLE
+#define _GES_CLIP_TABLE
+
+#include <glib-object.h>
+#include <gst/gst.h>
+#include <ges-object.h>
+#include <ges-timeline.h>
+
+G_BEGIN_DECLS
+
+#define GES_TYPE_CLIP_TABLE (ges_clip_table_get_type ())
+
+G_DECLARE_FINAL_TYPE(GESClipTable, ges_clip_table, GES, CLIP_TABLE, GObject)
+
+GESClipTable *ges_clip_table_new (void);
+
+guint ges_clip_table_add_clip (GESClipTable *self, const gchar *uri, GESMediaType media_type,
+    GstClockTime start, GstClockTime duration, GstClockTime inpoint, guint track_index);
+guint ges_clip_table_get_n_clips (GESClipTable *self);
+
+GstClockTime ges_clip_table_get_start (GESClipTable *self, guint index);
+GstClockTime ges_clip_table_get_duration (GESClipTable *self, guint index);
+GstClockTime ges_clip_table_get_inpoint (GESClipTable *self, guint index);
+guint ges_clip_table_get_track_index (GESClipTable *self, guint index);
+GESMediaType ges_clip_table_get_media_type (GESClipTable *self, guint index);
+guint ges_clip_table_get_asset_id (GESClipTable *self, guint index);
+const gchar *ges_clip_table_get_asset_uri (GESClipTable *self, guint asset_id);
+
+gboolean ges_clip_table_set_start (GESClipTable *self, guint index, GstClockTime start);
+gboolean ges_clip_table_set_duration (GESClipTable *self, guint index, GstClockTime duration);
+gboolean ges_clip_table_set_inpoint (GESClipTable *self, guint index, GstClockTime inpoint);
+
+GArray *ges_clip_table_find_clips (GESClipTable *self, GstClockTime start, GstClockTime stop);
+
+GESObject *ges_clip_table_get_object (GESClipTable *self, guint index);
+gboolean ges_clip_table_is_materialized (GESClipTable *self, guint index);
+void ges_clip_table_release_object (GESClipTable *self, guint index);
+guint ges_clip_table_add_to_timeline (GESClipTable *self, GESTimeline *timeline,
+    GstClockTime start, GstClockTime stop);
+
+G_END_DECLS
+
+#endif
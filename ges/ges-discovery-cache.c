@@ -0,0 +1,463 @@
+#include <string.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "ges-discovery-cache.h"
+
+/**
+ * SECTION: gesdiscoverycache
+ *
+ * #GESDiscoveryCache stores the #GstDiscovererInfo of local media files on
+ * disk, so that creating a #GESUriSource for a file that was already
+ * discovered doesn't require running a #GstDiscoverer on it again.
+ *
+ * Entries are keyed by URI, and stamped with the size and modification
+ * time of the file they describe: an entry whose stamp doesn't match the
+ * file on disk anymore is dropped on lookup.
+ *
+ * The default cache lives in the "ges-2.0/discovery" subdirectory of the
+ * user cache directory, it can be relocated with the GES_DISCOVERY_CACHE_DIR
+ * environment variable.
+ */
+
+/* Bump this whenever the layout of the entries changes, older entries
+ * will then be treated as invalid */
+#define CACHE_FORMAT_VERSION 1
+#define CACHE_ENTRY_TYPE "(ussttv)"
+#define CACHE_ENTRY_SUFFIX ".gvariant"
+
+/* Structure definitions */
+
+#define GES_DISCOVERY_CACHE_PRIV(self) (ges_discovery_cache_get_instance_private (GES_DISCOVERY_CACHE (self)))
+
+typedef struct _GESDiscoveryCachePrivate
+{
+  gchar *directory;
+  gboolean directory_created;
+  GMutex lock;
+
+  gint hits;
+  gint misses;
+  gint invalidations;
+} GESDiscoveryCachePrivate;
+
+struct _GESDiscoveryCache
+{
+  GObject parent;
+};
+
+G_DEFINE_TYPE_WITH_CODE (GESDiscoveryCache, ges_discovery_cache, G_TYPE_OBJECT,
+    G_ADD_PRIVATE (GESDiscoveryCache)
+    )
+
+enum
+{
+  PROP_0,
+  PROP_DIRECTORY,
+};
+
+/* Implementation */
+
+static gboolean
+_get_file_stamp (const gchar *uri, guint64 *size, guint64 *mtime)
+{
+  GFile *file;
+  GFileInfo *info;
+
+  /* We have no way to tell whether a remote resource changed */
+  if (!gst_uri_has_protocol (uri, "file"))
+    return FALSE;
+
+  file = g_file_new_for_uri (uri);
+  info = g_file_query_info (file,
+      G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+      G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+      G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+      G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  g_object_unref (file);
+
+  if (!info)
+    return FALSE;
+
+  *size = g_file_info_get_size (info);
+  *mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+      g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+  g_object_unref (info);
+
+  return TRUE;
+}
+
+static gchar *
+_get_entry_path (GESDiscoveryCache *self, const gchar *uri)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (self);
+  gchar *checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+  gchar *filename = g_strconcat (checksum, CACHE_ENTRY_SUFFIX, NULL);
+  gchar *path = g_build_filename (priv->directory, filename, NULL);
+
+  g_free (checksum);
+  g_free (filename);
+
+  return path;
+}
+
+static void
+_invalidate_entry (GESDiscoveryCache *self, const gchar *path)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (self);
+
+  g_unlink (path);
+  g_atomic_int_inc (&priv->invalidations);
+}
+
+/* API */
+
+/**
+ * ges_discovery_cache_lookup:
+ * @self: a #GESDiscoveryCache
+ * @uri: The URI that was discovered
+ * @url: (out) (allow-none): Return location for the actual url of the media,
+ * as it was resolved when discovering @uri
+ *
+ * Look up @uri in the cache. Entries that are stale because the file
+ * was modified since it was discovered are removed.
+ *
+ * Returns: (transfer full) (allow-none): The cached #GstDiscovererInfo,
+ * %NULL if there was no valid entry for @uri.
+ */
+GstDiscovererInfo *
+ges_discovery_cache_lookup (GESDiscoveryCache *self, const gchar *uri, gchar **url)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (self);
+  GstDiscovererInfo *info = NULL;
+  GVariant *entry = NULL;
+  GVariant *info_variant = NULL;
+  const gchar *entry_uri, *entry_url;
+  guint32 version;
+  guint64 size, mtime, entry_size, entry_mtime;
+  gchar *contents;
+  gsize length;
+  gchar *path;
+
+  if (!_get_file_stamp (uri, &size, &mtime))
+    goto miss;
+
+  path = _get_entry_path (self, uri);
+
+  if (!g_file_get_contents (path, &contents, &length, NULL)) {
+    g_free (path);
+    goto miss;
+  }
+
+  entry = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE (CACHE_ENTRY_TYPE),
+        contents, length, FALSE, g_free, contents));
+  g_variant_get (entry, "(u&s&stt@v)", &version, &entry_uri, &entry_url,
+      &entry_size, &entry_mtime, &info_variant);
+
+  if (version != CACHE_FORMAT_VERSION || g_strcmp0 (entry_uri, uri) ||
+      entry_size != size || entry_mtime != mtime) {
+    GST_INFO_OBJECT (self, "Cached discovery of %s is stale, dropping it", uri);
+    _invalidate_entry (self, path);
+    g_free (path);
+    goto miss;
+  }
+
+  info = gst_discoverer_info_from_variant (info_variant);
+  if (!info) {
+    GST_WARNING_OBJECT (self, "Could not load cached discovery of %s", uri);
+    _invalidate_entry (self, path);
+    g_free (path);
+    goto miss;
+  }
+
+  if (url)
+    *url = g_strdup (entry_url);
+
+  g_free (path);
+  g_variant_unref (info_variant);
+  g_variant_unref (entry);
+
+  g_atomic_int_inc (&priv->hits);
+  GST_INFO_OBJECT (self, "Cache hit for %s (%d hits, %d misses)", uri,
+      g_atomic_int_get (&priv->hits), g_atomic_int_get (&priv->misses));
+
+  return info;
+
+miss:
+  if (info_variant)
+    g_variant_unref (info_variant);
+  if (entry)
+    g_variant_unref (entry);
+
+  g_atomic_int_inc (&priv->misses);
+  GST_INFO_OBJECT (self, "Cache miss for %s (%d hits, %d misses)", uri,
+      g_atomic_int_get (&priv->hits), g_atomic_int_get (&priv->misses));
+
+  return NULL;
+}
+
+/**
+ * ges_discovery_cache_store:
+ * @self: a #GESDiscoveryCache
+ * @uri: The URI that was discovered
+ * @url: The actual url @uri was resolved to
+ * @info: The #GstDiscovererInfo for @uri
+ *
+ * Store @info in the cache, replacing any previous entry for @uri.
+ * Only local files can be cached.
+ *
+ * Returns: %TRUE if @info was stored, %FALSE otherwise
+ */
+gboolean
+ges_discovery_cache_store (GESDiscoveryCache *self, const gchar *uri, const gchar *url,
+    GstDiscovererInfo *info)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (self);
+  GVariant *info_variant, *entry;
+  GError *error = NULL;
+  guint64 size, mtime;
+  gboolean res;
+  gchar *path;
+
+  if (!_get_file_stamp (uri, &size, &mtime))
+    return FALSE;
+
+  if (gst_discoverer_info_get_result (info) != GST_DISCOVERER_OK)
+    return FALSE;
+
+  info_variant = gst_discoverer_info_to_variant (info, GST_DISCOVERER_SERIALIZE_ALL);
+  if (!info_variant) {
+    GST_WARNING_OBJECT (self, "Could not serialize discovery of %s", uri);
+    return FALSE;
+  }
+  g_variant_ref_sink (info_variant);
+
+  g_mutex_lock (&priv->lock);
+  if (!priv->directory_created) {
+    if (g_mkdir_with_parents (priv->directory, 0755)) {
+      g_mutex_unlock (&priv->lock);
+      GST_WARNING_OBJECT (self, "Could not create cache directory %s", priv->directory);
+      g_variant_unref (info_variant);
+      return FALSE;
+    }
+    priv->directory_created = TRUE;
+  }
+  g_mutex_unlock (&priv->lock);
+
+  /* info_variant already is a "v", store it as is */
+  entry = g_variant_ref_sink (g_variant_new ("(usstt@v)", CACHE_FORMAT_VERSION,
+        uri, url ? url : uri, size, mtime, info_variant));
+
+  path = _get_entry_path (self, uri);
+  /* g_file_set_contents is atomic, concurrent stores are fine */
+  res = g_file_set_contents (path, g_variant_get_data (entry),
+      g_variant_get_size (entry), &error);
+
+  if (!res) {
+    GST_WARNING_OBJECT (self, "Could not write %s : %s", path, error->message);
+    g_error_free (error);
+  }
+
+  g_free (path);
+  g_variant_unref (info_variant);
+  g_variant_unref (entry);
+
+  return res;
+}
+
+/**
+ * ges_discovery_cache_clear:
+ * @self: a #GESDiscoveryCache
+ *
+ * Remove all the entries of the cache and reset its statistics.
+ */
+void
+ges_discovery_cache_clear (GESDiscoveryCache *self)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (self);
+  GDir *dir = g_dir_open (priv->directory, 0, NULL);
+  const gchar *filename;
+
+  if (dir) {
+    while ((filename = g_dir_read_name (dir))) {
+      gchar *path;
+
+      if (!g_str_has_suffix (filename, CACHE_ENTRY_SUFFIX))
+        continue;
+
+      path = g_build_filename (priv->directory, filename, NULL);
+      g_unlink (path);
+      g_free (path);
+    }
+    g_dir_close (dir);
+  }
+
+  g_atomic_int_set (&priv->hits, 0);
+  g_atomic_int_set (&priv->misses, 0);
+  g_atomic_int_set (&priv->invalidations, 0);
+}
+
+/**
+ * ges_discovery_cache_get_hits:
+ * @self: a #GESDiscoveryCache
+ *
+ * Returns: The number of lookups that were answered from the cache
+ */
+guint
+ges_discovery_cache_get_hits (GESDiscoveryCache *self)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (self);
+
+  return g_atomic_int_get (&priv->hits);
+}
+
+/**
+ * ges_discovery_cache_get_misses:
+ * @self: a #GESDiscoveryCache
+ *
+ * Returns: The number of lookups that required a new discovery,
+ * including the ones that found a stale entry.
+ */
+guint
+ges_discovery_cache_get_misses (GESDiscoveryCache *self)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (self);
+
+  return g_atomic_int_get (&priv->misses);
+}
+
+/**
+ * ges_discovery_cache_get_invalidations:
+ * @self: a #GESDiscoveryCache
+ *
+ * Returns: The number of stale entries that were dropped
+ */
+guint
+ges_discovery_cache_get_invalidations (GESDiscoveryCache *self)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (self);
+
+  return g_atomic_int_get (&priv->invalidations);
+}
+
+/**
+ * ges_discovery_cache_new:
+ * @directory: The directory to store the entries in
+ *
+ * Returns: A new #GESDiscoveryCache
+ */
+GESDiscoveryCache *
+ges_discovery_cache_new (const gchar *directory)
+{
+  return g_object_new (GES_TYPE_DISCOVERY_CACHE, "directory", directory, NULL);
+}
+
+static GESDiscoveryCache *
+_create_default (gpointer unused)
+{
+  const gchar *env = g_getenv ("GES_DISCOVERY_CACHE_DIR");
+  GESDiscoveryCache *res;
+  gchar *directory;
+
+  if (env && *env)
+    directory = g_strdup (env);
+  else
+    directory = g_build_filename (g_get_user_cache_dir (), "ges-2.0", "discovery", NULL);
+
+  res = ges_discovery_cache_new (directory);
+  g_free (directory);
+
+  return res;
+}
+
+/**
+ * ges_discovery_cache_get_default:
+ *
+ * Returns: (transfer none): The #GESDiscoveryCache used by #GESUriSource
+ */
+GESDiscoveryCache *
+ges_discovery_cache_get_default (void)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  g_once (&once, (GThreadFunc) _create_default, NULL);
+
+  return once.retval;
+}
+
+/* GObject initialization */
+
+static void
+_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (object);
+
+  switch (property_id) {
+    case PROP_DIRECTORY:
+      g_free (priv->directory);
+      priv->directory = g_value_dup_string (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (object);
+
+  switch (property_id) {
+    case PROP_DIRECTORY:
+      g_value_set_string (value, priv->directory);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_finalize (GObject *object)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (object);
+
+  g_free (priv->directory);
+  g_mutex_clear (&priv->lock);
+
+  G_OBJECT_CLASS (ges_discovery_cache_parent_class)->finalize (object);
+}
+
+static void
+ges_discovery_cache_class_init (GESDiscoveryCacheClass *klass)
+{
+  GObjectClass *g_object_class = G_OBJECT_CLASS (klass);
+
+  g_object_class->set_property = _set_property;
+  g_object_class->get_property = _get_property;
+  g_object_class->finalize = _finalize;
+
+  /**
+   * GESDiscoveryCache:directory:
+   *
+   * The directory in which the cache entries are stored, it will be
+   * created on the first store if needed.
+   */
+  g_object_class_install_property (g_object_class, PROP_DIRECTORY,
+      g_param_spec_string ("directory", "Directory", "Where to store the cache entries", NULL,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+}
+
+static void
+ges_discovery_cache_init (GESDiscoveryCache *self)
+{
+  GESDiscoveryCachePrivate *priv = GES_DISCOVERY_CACHE_PRIV (self);
+
+  priv->directory = NULL;
+  priv->directory_created = FALSE;
+  g_mutex_init (&priv->lock);
+  priv->hits = 0;
+  priv->misses = 0;
+  priv->invalidations = 0;
+}
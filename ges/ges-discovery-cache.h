@@ -0,0 +1,28 @@
+#ifndef _GES_DISCOVERY_CACHE
+#define _GES_DISCOVERY_CACHE
+
+#include <glib-object.h>
+#include <gst/gst.h>
+#include <gst/pbutils/gstdiscoverer.h>
+
+G_BEGIN_DECLS
+
+#define GES_TYPE_DISCOVERY_CACHE (ges_discovery_cache_get_type ())
+
+G_DECLARE_FINAL_TYPE(GESDiscoveryCache, ges_discovery_cache, GES, DISCOVERY_CACHE, GObject)
+
+GESDiscoveryCache *ges_discovery_cache_new (const gchar *directory);
+GESDiscoveryCache *ges_discovery_cache_get_default (void);
+
+GstDiscovererInfo *ges_discovery_cache_lookup (GESDiscoveryCache *self, const gchar *uri, gchar **url);
+gboolean ges_discovery_cache_store (GESDiscoveryCache *self, const gchar *uri, const gchar *url,
+    GstDiscovererInfo *info);
+void ges_discovery_cache_clear (GESDiscoveryCache *self);
+
+guint ges_discovery_cache_get_hits (GESDiscoveryCache *self);
+guint ges_discovery_cache_get_misses (GESDiscoveryCache *self);
+guint ges_discovery_cache_get_invalidations (GESDiscoveryCache *self);
+
+G_END_DECLS
+
+#endif
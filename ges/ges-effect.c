@@ -0,0 +1,338 @@
+#include <math.h>
+#include <string.h>
+
+#include "ges-effect.h"
+#include "ges-internal.h"
+
+/* Structure definitions */
+
+#define GES_EFFECT_PRIV(self) (ges_effect_get_instance_private (GES_EFFECT (self)))
+
+typedef struct _GESEffectPrivate
+{
+  gchar *bin_description;
+  /* What the elements of the description say they deal with */
+  GESMediaType media_type;
+
+  /* Set when the effect is a per-pixel one that can get fused with the
+   * ones next to it, see ges_effect_get_pixel_transform */
+  gboolean per_pixel;
+  guint8 curve[256];
+  gdouble saturation;
+} GESEffectPrivate;
+
+struct _GESEffect
+{
+  GObject parent;
+};
+
+G_DEFINE_TYPE_WITH_CODE (GESEffect, ges_effect, G_TYPE_OBJECT,
+    G_ADD_PRIVATE (GESEffect)
+    )
+
+/* Implementation */
+
+/* What videobalance does to luma and chroma, the hue rotation mixes the
+ * chroma components so it can't be expressed as a table */
+static gboolean
+_get_balance_transform (GstElement *element, guint8 *curve, gdouble *saturation)
+{
+  gdouble brightness, contrast, hue;
+  guint i;
+
+  g_object_get (element, "brightness", &brightness, "contrast", &contrast,
+      "hue", &hue, "saturation", saturation, NULL);
+
+  if (hue != 0.0)
+    return FALSE;
+
+  for (i = 0; i < 256; i++) {
+    gdouble y = 16 + (((gdouble) i - 16) * contrast + brightness * 255);
+
+    curve[i] = (guint8) rint (CLAMP (y, 0, 255));
+  }
+
+  return TRUE;
+}
+
+/* What the gamma element does to luma */
+static gboolean
+_get_gamma_transform (GstElement *element, guint8 *curve, gdouble *saturation)
+{
+  gdouble gamma;
+  guint i;
+
+  g_object_get (element, "gamma", &gamma, NULL);
+
+  for (i = 0; i < 256; i++)
+    curve[i] = (guint8) floor (255.0 * pow (i / 255.0, 1.0 / gamma) + 0.5);
+  *saturation = 1.0;
+
+  return TRUE;
+}
+
+/* Lookup tables and already fused effects */
+static gboolean
+_get_pixeltransform_transform (GstElement *element, guint8 *curve, gdouble *saturation)
+{
+  gchar *string, **levels;
+  guint i, n = 0;
+
+  g_object_get (element, "curve", &string, "saturation", saturation, NULL);
+
+  /* The element validated it already */
+  levels = g_strsplit_set (string, " ,", -1);
+  for (i = 0; levels[i] && n < 256; i++) {
+    if (*levels[i])
+      curve[n++] = g_ascii_strtoull (levels[i], NULL, 10);
+  }
+  g_strfreev (levels);
+  g_free (string);
+
+  return n == 256;
+}
+
+static GESMediaType
+_get_element_media_type (GstElement *element)
+{
+  GstElementFactory *factory = gst_element_get_factory (element);
+  const gchar *klass;
+  GESMediaType res = 0;
+
+  if (!factory)
+    return 0;
+
+  klass = gst_element_factory_get_metadata (factory, GST_ELEMENT_METADATA_KLASS);
+  if (klass && strstr (klass, "Video"))
+    res |= GES_MEDIA_TYPE_VIDEO;
+  if (klass && strstr (klass, "Audio"))
+    res |= GES_MEDIA_TYPE_AUDIO;
+
+  return res;
+}
+
+static void
+_detect_media_type (GESEffect *self, GstElement *element)
+{
+  GESEffectPrivate *priv = GES_EFFECT_PRIV (self);
+  GValue item = G_VALUE_INIT;
+  GstIterator *it;
+
+  if (!GST_IS_BIN (element)) {
+    priv->media_type = _get_element_media_type (element);
+    return;
+  }
+
+  it = gst_bin_iterate_recurse (GST_BIN (element));
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+    priv->media_type |= _get_element_media_type (g_value_get_object (&item));
+    g_value_reset (&item);
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+}
+
+static void
+_inspect_description (GESEffect *self)
+{
+  GESEffectPrivate *priv = GES_EFFECT_PRIV (self);
+  GstElement *element;
+  GstElementFactory *factory;
+  const gchar *name;
+
+  element = gst_parse_launch (priv->bin_description, NULL);
+  if (!element)
+    return;
+
+  _detect_media_type (self, element);
+
+  /* Only single elements, anything more might not be per-pixel */
+  factory = gst_element_get_factory (element);
+  name = factory ? GST_OBJECT_NAME (factory) : NULL;
+
+  if (!g_strcmp0 (name, "videobalance"))
+    priv->per_pixel = _get_balance_transform (element, priv->curve, &priv->saturation);
+  else if (!g_strcmp0 (name, "gamma"))
+    priv->per_pixel = _get_gamma_transform (element, priv->curve, &priv->saturation);
+  else if (!g_strcmp0 (name, "pixeltransform"))
+    priv->per_pixel = _get_pixeltransform_transform (element, priv->curve, &priv->saturation);
+
+  GST_DEBUG_OBJECT (self, "%s is per-pixel: %d", priv->bin_description, priv->per_pixel);
+
+  gst_object_unref (gst_object_ref_sink (element));
+}
+
+/* API */
+
+/**
+ * ges_effect_new:
+ * @bin_description: The description of the effect, in gst-launch-1.0
+ * syntax, with one sink pad and one source pad left unlinked
+ *
+ * Effects apply to the #GESSource they get added to, see
+ * ges_source_add_effect().
+ *
+ * Returns: A new #GESEffect
+ */
+GESEffect *
+ges_effect_new (const gchar *bin_description)
+{
+  return g_object_new (GES_TYPE_EFFECT, "bin-description", bin_description, NULL);
+}
+
+/**
+ * ges_effect_get_bin_description:
+ * @effect: a #GESEffect
+ *
+ * Returns: The description @effect was created from
+ */
+const gchar *
+ges_effect_get_bin_description (GESEffect *self)
+{
+  GESEffectPrivate *priv = GES_EFFECT_PRIV (self);
+
+  return priv->bin_description;
+}
+
+/**
+ * ges_effect_get_media_type:
+ * @effect: a #GESEffect
+ *
+ * Returns: The media types the elements of @effect deal with, 0 if they
+ * don't tell
+ */
+GESMediaType
+ges_effect_get_media_type (GESEffect *self)
+{
+  GESEffectPrivate *priv = GES_EFFECT_PRIV (self);
+
+  return priv->media_type;
+}
+
+/* Whether @self only maps each pixel through a luma curve and a chroma
+ * scaling, in which case it can be fused with the effects next to it.
+ * @curve has to hold 256 levels */
+gboolean
+ges_effect_get_pixel_transform (GESEffect *self, guint8 *curve, gdouble *saturation)
+{
+  GESEffectPrivate *priv = GES_EFFECT_PRIV (self);
+
+  if (!priv->per_pixel)
+    return FALSE;
+
+  memcpy (curve, priv->curve, sizeof (priv->curve));
+  *saturation = priv->saturation;
+
+  return TRUE;
+}
+
+/* The elements applying @self on its own, converting from and back to
+ * whatever the stream is */
+GstElement *
+ges_effect_make_element (GESEffect *self, GESMediaType media_type)
+{
+  GESEffectPrivate *priv = GES_EFFECT_PRIV (self);
+  const gchar *converter = media_type == GES_MEDIA_TYPE_VIDEO ? "videoconvert" : "audioconvert";
+  GError *error = NULL;
+  GstElement *bin;
+  gchar *description;
+
+  description = g_strdup_printf ("%s ! %s ! %s", converter, priv->bin_description, converter);
+  bin = gst_parse_bin_from_description (description, TRUE, &error);
+  g_free (description);
+
+  if (!bin) {
+    GST_ERROR_OBJECT (self, "couldn't make %s: %s", priv->bin_description, error->message);
+    g_clear_error (&error);
+  }
+
+  return bin;
+}
+
+/* GObject initialization */
+
+enum
+{
+  PROP_0,
+  PROP_BIN_DESCRIPTION,
+};
+
+static void
+_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GESEffectPrivate *priv = GES_EFFECT_PRIV (object);
+
+  switch (property_id) {
+    case PROP_BIN_DESCRIPTION:
+      priv->bin_description = g_value_dup_string (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GESEffectPrivate *priv = GES_EFFECT_PRIV (object);
+
+  switch (property_id) {
+    case PROP_BIN_DESCRIPTION:
+      g_value_set_string (value, priv->bin_description);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+  }
+}
+
+static void
+_constructed (GObject *object)
+{
+  _inspect_description (GES_EFFECT (object));
+
+  G_OBJECT_CLASS (ges_effect_parent_class)->constructed (object);
+}
+
+static void
+_finalize (GObject *object)
+{
+  GESEffectPrivate *priv = GES_EFFECT_PRIV (object);
+
+  g_free (priv->bin_description);
+
+  G_OBJECT_CLASS (ges_effect_parent_class)->finalize (object);
+}
+
+static void
+ges_effect_class_init (GESEffectClass *klass)
+{
+  GObjectClass *g_object_class = G_OBJECT_CLASS (klass);
+
+  g_object_class->set_property = _set_property;
+  g_object_class->get_property = _get_property;
+  g_object_class->constructed = _constructed;
+  g_object_class->finalize = _finalize;
+
+  /**
+   * GESEffect:bin-description:
+   *
+   * The elements applying the effect, in gst-launch-1.0 syntax.
+   */
+  g_object_class_install_property (g_object_class, PROP_BIN_DESCRIPTION,
+      g_param_spec_string ("bin-description", "bin-description",
+        "The description of the effect", NULL,
+        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+}
+
+static void
+ges_effect_init (GESEffect *self)
+{
+  GESEffectPrivate *priv = GES_EFFECT_PRIV (self);
+
+  priv->bin_description = NULL;
+  priv->media_type = 0;
+  priv->per_pixel = FALSE;
+  priv->saturation = 1.0;
+}
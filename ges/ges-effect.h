@@ -0,0 +1,19 @@
+#ifndef _GES_EFFECT
+#define _GES_EFFECT
+
+#include <gst/gst.h>
+#include <ges-enums.h>
+
+G_BEGIN_DECLS
+
+#define GES_TYPE_EFFECT (ges_effect_get_type ())
+
+G_DECLARE_FINAL_TYPE(GESEffect, ges_effect, GES, EFFECT, GObject)
+
+GESEffect *   ges_effect_new (const gchar *bin_description);
+const gchar * ges_effect_get_bin_description (GESEffect *effect);
+GESMediaType  ges_effect_get_media_type (GESEffect *effect);
+
+G_END_DECLS
+
+#endif
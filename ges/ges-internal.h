@@ -2,8 +2,32 @@
 #define GES_INTERNAL
 
 #include <ges-object.h>
+#include <ges-source.h>
 
 GList *      ges_object_get_nle_objects (GESObject *object);
+void         ges_object_begin_edit (GESObject *object);
+gboolean     ges_object_end_edit (GESObject *object);
+gboolean     ges_object_bind_control_source (GstObject *element, const gchar *property_name,
+                                             GstControlSource *source, gboolean absolute);
+void         ges_source_set_zorder (GESSource *source, guint zorder);
+void         ges_source_set_restriction_caps (GESSource *source, GstCaps *caps);
+gboolean     ges_source_has_default_geometry (GESSource *source);
+GESTransition * ges_transition_new_crossfade (GESObject *fadeout_source, GESObject *fadein_source,
+                                              GstElement *composition);
+gboolean     ges_effect_get_pixel_transform (GESEffect *effect, guint8 *curve, gdouble *saturation);
+GstElement * ges_effect_make_element (GESEffect *effect, GESMediaType media_type);
+
+GESObject *  ges_object_new_from_fields (const gchar *type_name, GESMediaType media_type,
+                                         GstClockTime inpoint, GstClockTime duration,
+                                         GstClockTime start, guint video_track_index,
+                                         guint audio_track_index, GVariant *subclass_variant);
+
+/* Collecting the media of serialized objects so that they can be
+ * discovered in parallel before the objects get created */
+void         ges_object_collect_uris (GVariant *object_variant, GPtrArray *uris);
+void         ges_uri_source_collect_uri (const gchar *type_name, GVariant *subclass_variant,
+                                         GPtrArray *uris);
+void         ges_asset_prefetch (GPtrArray *uris);
 
 #define GET_FROM_TUPLE(v, t, n, val) G_STMT_START{         \
   GVariant *child = g_variant_get_child_value (v, n); \
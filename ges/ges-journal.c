@@ -0,0 +1,838 @@
+#include <errno.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "ges-journal.h"
+#include "ges-internal.h"
+
+/**
+ * SECTION: gesjournal
+ *
+ * A #GESJournal keeps a project saved on disk without re-serializing it
+ * entirely every time. It is made of a snapshot of the whole timeline and
+ * of an append-only journal of the changes made to the objects of the
+ * timeline since that snapshot was taken.
+ *
+ * Changes are recorded as compact binary records as they happen, and
+ * written to disk by ges_journal_flush(), so autosaving only costs as
+ * much as the number of edits since the last flush.
+ * ges_journal_compact_async() takes a new snapshot, serializing and
+ * writing it in a separate thread. ges_journal_recover() rebuilds a timeline from the
+ * latest snapshot and the journals written after it, for example after a
+ * crash.
+ *
+ * The directory of a journal contains a "snapshot" file and "journal-N"
+ * files, N being the generation of the journal. A snapshot of generation
+ * N is followed by journals N, N + 1 and so on. Journals older than the
+ * snapshot are removed once it is written.
+ */
+
+/* Structure definitions */
+
+#define GES_JOURNAL_PRIV(self) (ges_journal_get_instance_private (GES_JOURNAL (self)))
+
+#define SNAPSHOT_MAGIC "GESSNAP\0"
+#define JOURNAL_MAGIC "GESJRNL\0"
+#define MAGIC_SIZE 8
+#define JOURNAL_HEADER_SIZE (MAGIC_SIZE + 4)
+#define SNAPSHOT_FILE "snapshot"
+#define JOURNAL_FILE_PREFIX "journal-"
+
+/* Generation, media type of the timeline, id and serialization of each
+ * object */
+#define SNAPSHOT_FORMAT "(uua(uv))"
+
+typedef enum
+{
+  RECORD_ADD,
+  RECORD_UPDATE,
+  RECORD_START,
+  RECORD_DURATION,
+  RECORD_INPOINT,
+  RECORD_VIDEO_TRACK_INDEX,
+  RECORD_AUDIO_TRACK_INDEX,
+} RecordKind;
+
+/* Records are laid out as follows, all integers being little-endian:
+ *
+ * guint32 size of the rest of the record
+ * guint32 id of the object
+ * guint8 RecordKind
+ * payload: a guint64 for timings, a guint32 for track indexes, the
+ * serialization of the whole object for additions and updates.
+ */
+#define RECORD_HEADER_SIZE 9
+
+typedef struct _GESJournalPrivate
+{
+  GESTimeline *timeline;
+  gulong object_added_id;
+  gchar *directory;
+
+  /* GESObject -> id */
+  GHashTable *ids;
+  guint next_id;
+
+  guint generation;
+  GOutputStream *stream;
+  /* Records that weren't flushed yet */
+  GByteArray *pending;
+  guint n_records;
+  gint compacting;
+} GESJournalPrivate;
+
+struct _GESJournal
+{
+  GObject parent;
+};
+
+G_DEFINE_TYPE_WITH_CODE (GESJournal, ges_journal, G_TYPE_OBJECT,
+    G_ADD_PRIVATE (GESJournal)
+    )
+
+/* Implementation */
+
+static gchar *
+_get_journal_path (const gchar *directory, guint generation)
+{
+  gchar *name = g_strdup_printf (JOURNAL_FILE_PREFIX "%u", generation);
+  gchar *path = g_build_filename (directory, name, NULL);
+
+  g_free (name);
+
+  return path;
+}
+
+static GVariant *
+_to_little_endian (GVariant *variant)
+{
+  GVariant *res;
+
+  if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
+    return g_variant_ref_sink (variant);
+
+  g_variant_ref_sink (variant);
+  res = g_variant_byteswap (variant);
+  g_variant_unref (variant);
+
+  return res;
+}
+
+static GVariant *
+_from_little_endian (GVariant *variant)
+{
+  return _to_little_endian (variant);
+}
+
+static void
+_append_record (GESJournalPrivate *priv, guint id, RecordKind kind,
+    gconstpointer payload, gsize payload_size)
+{
+  guint32 size = GUINT32_TO_LE (4 + 1 + payload_size);
+  guint32 le_id = GUINT32_TO_LE (id);
+  guint8 record_kind = kind;
+
+  g_byte_array_append (priv->pending, (const guint8 *) &size, 4);
+  g_byte_array_append (priv->pending, (const guint8 *) &le_id, 4);
+  g_byte_array_append (priv->pending, &record_kind, 1);
+  g_byte_array_append (priv->pending, payload, payload_size);
+  priv->n_records += 1;
+}
+
+static void
+_append_object_record (GESJournalPrivate *priv, guint id, RecordKind kind, GESObject *object)
+{
+  GVariant *variant = _to_little_endian (ges_object_serialize (object));
+
+  _append_record (priv, id, kind, g_variant_get_data (variant), g_variant_get_size (variant));
+  g_variant_unref (variant);
+}
+
+static void
+_object_notify_cb (GESObject *object, GParamSpec *pspec, GESJournal *self)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+  guint id = GPOINTER_TO_UINT (g_hash_table_lookup (priv->ids, object));
+  const gchar *name = g_param_spec_get_name (pspec);
+  guint64 timing;
+  guint32 track_index;
+
+  if (!g_strcmp0 (name, "start")) {
+    timing = GUINT64_TO_LE (ges_object_get_start (object));
+    _append_record (priv, id, RECORD_START, &timing, sizeof (timing));
+  } else if (!g_strcmp0 (name, "duration")) {
+    timing = GUINT64_TO_LE (ges_object_get_duration (object));
+    _append_record (priv, id, RECORD_DURATION, &timing, sizeof (timing));
+  } else if (!g_strcmp0 (name, "inpoint")) {
+    timing = GUINT64_TO_LE (ges_object_get_inpoint (object));
+    _append_record (priv, id, RECORD_INPOINT, &timing, sizeof (timing));
+  } else if (!g_strcmp0 (name, "video-track-index")) {
+    track_index = GUINT32_TO_LE (ges_object_get_video_track_index (object));
+    _append_record (priv, id, RECORD_VIDEO_TRACK_INDEX, &track_index, sizeof (track_index));
+  } else if (!g_strcmp0 (name, "audio-track-index")) {
+    track_index = GUINT32_TO_LE (ges_object_get_audio_track_index (object));
+    _append_record (priv, id, RECORD_AUDIO_TRACK_INDEX, &track_index, sizeof (track_index));
+  } else {
+    /* Media type or subclass data, store the whole object again */
+    _append_object_record (priv, id, RECORD_UPDATE, object);
+  }
+}
+
+static guint
+_track_object (GESJournal *self, GESObject *object)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+  guint id = priv->next_id++;
+
+  g_hash_table_insert (priv->ids, g_object_ref (object), GUINT_TO_POINTER (id));
+  g_signal_connect (object, "notify", G_CALLBACK (_object_notify_cb), self);
+
+  return id;
+}
+
+static void
+_object_added_cb (GESTimeline *timeline, GESObject *object, GESJournal *self)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+  guint id = _track_object (self, object);
+
+  _append_object_record (priv, id, RECORD_ADD, object);
+}
+
+static gboolean
+_open_journal (GESJournal *self, GError **error)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+  gchar *path = _get_journal_path (priv->directory, priv->generation);
+  GFile *file = g_file_new_for_path (path);
+  guint32 generation = GUINT32_TO_LE (priv->generation);
+  gboolean ret = FALSE;
+
+  g_unlink (path);
+  priv->stream = G_OUTPUT_STREAM (g_file_append_to (file, G_FILE_CREATE_NONE, NULL, error));
+  if (!priv->stream)
+    goto done;
+
+  if (!g_output_stream_write_all (priv->stream, JOURNAL_MAGIC, MAGIC_SIZE, NULL, NULL, error) ||
+      !g_output_stream_write_all (priv->stream, &generation, 4, NULL, NULL, error) ||
+      !g_output_stream_flush (priv->stream, NULL, error))
+    goto done;
+
+  ret = TRUE;
+
+done:
+  g_object_unref (file);
+  g_free (path);
+  return ret;
+}
+
+static void
+_close_journal (GESJournal *self)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+
+  if (!priv->stream)
+    return;
+
+  g_output_stream_close (priv->stream, NULL, NULL);
+  g_object_unref (priv->stream);
+  priv->stream = NULL;
+}
+
+/* Can run in any thread, @objects maps the objects to their ids */
+static GVariant *
+_make_snapshot (GHashTable *objects, guint generation, GESMediaType media_type)
+{
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer object, id;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(uv)"));
+
+  g_hash_table_iter_init (&iter, objects);
+  while (g_hash_table_iter_next (&iter, &object, &id))
+    g_variant_builder_add (&builder, "(u@v)", GPOINTER_TO_UINT (id),
+        ges_object_serialize (GES_OBJECT (object)));
+
+  return g_variant_new (SNAPSHOT_FORMAT, generation, media_type, &builder);
+}
+
+/* Can run in any thread */
+static gboolean
+_write_snapshot (const gchar *directory, GVariant *snapshot, GError **error)
+{
+  gchar *path = g_build_filename (directory, SNAPSHOT_FILE, NULL);
+  GVariant *variant = _to_little_endian (g_variant_ref (snapshot));
+  gsize size = g_variant_get_size (variant);
+  gchar *contents = g_malloc (MAGIC_SIZE + size);
+  gboolean ret;
+
+  memcpy (contents, SNAPSHOT_MAGIC, MAGIC_SIZE);
+  g_variant_store (variant, contents + MAGIC_SIZE);
+  ret = g_file_set_contents (path, contents, MAGIC_SIZE + size, error);
+
+  g_free (contents);
+  g_variant_unref (variant);
+  g_free (path);
+
+  return ret;
+}
+
+/* Removes the journals older than @generation, or all of them if
+ * @generation is G_MAXUINT */
+static void
+_remove_journals (const gchar *directory, guint generation)
+{
+  GDir *dir = g_dir_open (directory, 0, NULL);
+  const gchar *name;
+
+  if (!dir)
+    return;
+
+  while ((name = g_dir_read_name (dir))) {
+    guint64 journal_generation;
+    gchar *path;
+
+    if (!g_str_has_prefix (name, JOURNAL_FILE_PREFIX))
+      continue;
+
+    journal_generation = g_ascii_strtoull (name + strlen (JOURNAL_FILE_PREFIX), NULL, 10);
+    if (generation != G_MAXUINT && journal_generation >= generation)
+      continue;
+
+    path = g_build_filename (directory, name, NULL);
+    g_unlink (path);
+    g_free (path);
+  }
+
+  g_dir_close (dir);
+}
+
+typedef struct
+{
+  gchar *directory;
+  /* A copy of the ids table, holding a reference on the objects */
+  GHashTable *objects;
+  GESMediaType media_type;
+  guint generation;
+} CompactData;
+
+static void
+_free_compact_data (CompactData *data)
+{
+  g_free (data->directory);
+  g_hash_table_unref (data->objects);
+  g_slice_free (CompactData, data);
+}
+
+static void
+_compact_thread_func (GTask *task, GESJournal *self, CompactData *data,
+    GCancellable *cancellable)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+  GError *error = NULL;
+  GVariant *snapshot;
+
+  /* Changes made from now on land in the new journal, replaying it over
+   * a snapshot that already has them gives the same result */
+  snapshot = g_variant_ref_sink (_make_snapshot (data->objects,
+          data->generation, data->media_type));
+
+  if (_write_snapshot (data->directory, snapshot, &error)) {
+    _remove_journals (data->directory, data->generation);
+    g_task_return_boolean (task, TRUE);
+  } else {
+    g_task_return_error (task, error);
+  }
+
+  g_variant_unref (snapshot);
+
+  g_atomic_int_set (&priv->compacting, FALSE);
+}
+
+/* Recovery */
+
+static GVariant *
+_map_variant (const gchar *path, const gchar *magic, const GVariantType *type, GError **error)
+{
+  GMappedFile *file = g_mapped_file_new (path, FALSE, error);
+  GBytes *bytes, *data;
+  GVariant *variant;
+
+  if (!file)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (file);
+  g_mapped_file_unref (file);
+
+  if (g_bytes_get_size (bytes) < MAGIC_SIZE ||
+      memcmp (g_bytes_get_data (bytes, NULL), magic, MAGIC_SIZE)) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "%s is not a valid GES journal file", path);
+    g_bytes_unref (bytes);
+    return NULL;
+  }
+
+  data = g_bytes_new_from_bytes (bytes, MAGIC_SIZE, g_bytes_get_size (bytes) - MAGIC_SIZE);
+  g_bytes_unref (bytes);
+  variant = _from_little_endian (g_variant_new_from_bytes (type, data, FALSE));
+  g_bytes_unref (data);
+
+  return variant;
+}
+
+static GESObject *
+_deserialize_record_object (const guint8 *payload, gsize size)
+{
+  GBytes *bytes = g_bytes_new (payload, size);
+  GVariant *variant = _from_little_endian (g_variant_new_from_bytes (G_VARIANT_TYPE_VARIANT, bytes, FALSE));
+  GESObject *object = ges_object_deserialize (variant);
+
+  g_variant_unref (variant);
+  g_bytes_unref (bytes);
+
+  return object ? g_object_ref_sink (object) : NULL;
+}
+
+static void
+_collect_record_uri (RecordKind kind, const guint8 *payload, gsize size, GPtrArray *uris)
+{
+  GBytes *bytes;
+  GVariant *variant;
+
+  if (kind != RECORD_ADD && kind != RECORD_UPDATE)
+    return;
+
+  bytes = g_bytes_new (payload, size);
+  variant = _from_little_endian (g_variant_new_from_bytes (G_VARIANT_TYPE_VARIANT, bytes, FALSE));
+  ges_object_collect_uris (variant, uris);
+  g_variant_unref (variant);
+  g_bytes_unref (bytes);
+}
+
+static void
+_replay_record (GHashTable *objects, guint id, RecordKind kind,
+    const guint8 *payload, gsize size)
+{
+  GESObject *object = g_hash_table_lookup (objects, GUINT_TO_POINTER (id));
+  guint64 timing = 0;
+  guint32 track_index = 0;
+
+  if (kind == RECORD_ADD || kind == RECORD_UPDATE) {
+    GESObject *new_object = _deserialize_record_object (payload, size);
+
+    if (new_object)
+      g_hash_table_insert (objects, GUINT_TO_POINTER (id), new_object);
+    return;
+  }
+
+  if (!object) {
+    GST_WARNING ("journal references unknown object %u", id);
+    return;
+  }
+
+  if (size >= sizeof (timing))
+    memcpy (&timing, payload, sizeof (timing));
+  if (size >= sizeof (track_index))
+    memcpy (&track_index, payload, sizeof (track_index));
+
+  switch (kind) {
+    case RECORD_START:
+      ges_object_set_start (object, GUINT64_FROM_LE (timing));
+      break;
+    case RECORD_DURATION:
+      ges_object_set_duration (object, GUINT64_FROM_LE (timing));
+      break;
+    case RECORD_INPOINT:
+      ges_object_set_inpoint (object, GUINT64_FROM_LE (timing));
+      break;
+    case RECORD_VIDEO_TRACK_INDEX:
+      ges_object_set_video_track_index (object, GUINT32_FROM_LE (track_index));
+      break;
+    case RECORD_AUDIO_TRACK_INDEX:
+      ges_object_set_audio_track_index (object, GUINT32_FROM_LE (track_index));
+      break;
+    default:
+      GST_WARNING ("unknown journal record kind %d", kind);
+      break;
+  }
+}
+
+/* Returns FALSE if there is no journal for @generation */
+/* Replays the journal of @generation on @objects, or only collects the
+ * media its added objects use into @uris when it is not %NULL */
+static gboolean
+_replay_journal (const gchar *directory, guint generation, GHashTable *objects,
+    GPtrArray *uris)
+{
+  gchar *path = _get_journal_path (directory, generation);
+  GMappedFile *file = g_mapped_file_new (path, FALSE, NULL);
+  const guint8 *data, *end;
+  guint32 file_generation;
+
+  g_free (path);
+
+  if (!file)
+    return FALSE;
+
+  data = (const guint8 *) g_mapped_file_get_contents (file);
+  end = data + g_mapped_file_get_length (file);
+
+  if (end - data < JOURNAL_HEADER_SIZE || memcmp (data, JOURNAL_MAGIC, MAGIC_SIZE)) {
+    g_mapped_file_unref (file);
+    return FALSE;
+  }
+
+  memcpy (&file_generation, data + MAGIC_SIZE, 4);
+  if (GUINT32_FROM_LE (file_generation) != generation) {
+    g_mapped_file_unref (file);
+    return FALSE;
+  }
+
+  data += JOURNAL_HEADER_SIZE;
+
+  /* A record cut short means we crashed while writing it, stop there */
+  while (end - data >= RECORD_HEADER_SIZE) {
+    guint32 size, id;
+
+    memcpy (&size, data, 4);
+    memcpy (&id, data + 4, 4);
+    size = GUINT32_FROM_LE (size);
+
+    if (size < 5 || (gsize) (end - data - 4) < size)
+      break;
+
+    if (uris)
+      _collect_record_uri (data[8], data + RECORD_HEADER_SIZE, size - 5, uris);
+    else
+      _replay_record (objects, GUINT32_FROM_LE (id), data[8], data + RECORD_HEADER_SIZE,
+          size - 5);
+    data += 4 + size;
+  }
+
+  g_mapped_file_unref (file);
+
+  return TRUE;
+}
+
+static gint
+_compare_ids (gconstpointer a, gconstpointer b)
+{
+  guint id_a = GPOINTER_TO_UINT (a), id_b = GPOINTER_TO_UINT (b);
+
+  return id_a < id_b ? -1 : id_a > id_b;
+}
+
+/* API */
+
+/**
+ * ges_journal_new:
+ * @timeline: The #GESTimeline to record changes of
+ * @directory: The directory to store the snapshot and journals in, it
+ * will be created if needed
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Starts recording the changes made to @timeline and to the objects it
+ * contains in @directory. A first snapshot of @timeline is written, any
+ * previous journal in @directory is discarded.
+ *
+ * Returns: A new #GESJournal, or %NULL if @directory could not be written to
+ */
+GESJournal *
+ges_journal_new (GESTimeline *timeline, const gchar *directory, GError **error)
+{
+  GESJournal *self;
+  GESJournalPrivate *priv;
+  GVariant *snapshot;
+  GList *objects, *tmp;
+
+  if (g_mkdir_with_parents (directory, 0755) != 0) {
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+        "Could not create %s", directory);
+    return NULL;
+  }
+
+  self = g_object_new (GES_TYPE_JOURNAL, NULL);
+  priv = GES_JOURNAL_PRIV (self);
+  priv->directory = g_strdup (directory);
+  priv->timeline = g_object_ref (timeline);
+  priv->generation = 1;
+
+  objects = ges_timeline_get_objects (timeline);
+  for (tmp = objects; tmp; tmp = tmp->next)
+    _track_object (self, tmp->data);
+  g_list_free (objects);
+
+  priv->object_added_id = g_signal_connect (timeline, "object-added",
+      G_CALLBACK (_object_added_cb), self);
+
+  _remove_journals (directory, G_MAXUINT);
+
+  snapshot = g_variant_ref_sink (_make_snapshot (priv->ids, priv->generation,
+          ges_object_get_media_type (GES_OBJECT (timeline))));
+  if (!_write_snapshot (directory, snapshot, error) || !_open_journal (self, error)) {
+    g_variant_unref (snapshot);
+    g_object_unref (self);
+    return NULL;
+  }
+  g_variant_unref (snapshot);
+
+  return self;
+}
+
+/**
+ * ges_journal_flush:
+ * @self: a #GESJournal
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Appends the changes recorded since the last flush to the journal on
+ * disk. This is what autosaving should call, its cost only depends on the
+ * number of changes.
+ *
+ * Returns: %TRUE if the changes were written, %FALSE otherwise
+ */
+gboolean
+ges_journal_flush (GESJournal *self, GError **error)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+
+  if (!priv->pending->len)
+    return TRUE;
+
+  if (!g_output_stream_write_all (priv->stream, priv->pending->data, priv->pending->len,
+          NULL, NULL, error) ||
+      !g_output_stream_flush (priv->stream, NULL, error))
+    return FALSE;
+
+  g_byte_array_set_size (priv->pending, 0);
+
+  return TRUE;
+}
+
+/**
+ * ges_journal_compact_async:
+ * @self: a #GESJournal
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @callback: a #GAsyncReadyCallback to call when the snapshot was written
+ * @user_data: the data to pass to callback function
+ *
+ * Takes a new snapshot of the timeline, recording continues in a new
+ * journal right away. The objects are serialized and written to disk in a
+ * separate thread, the journals the snapshot replaces are removed once it
+ * is.
+ *
+ * Only one compaction can happen at a time, %G_IO_ERROR_PENDING is
+ * returned if one is already in progress.
+ */
+void
+ges_journal_compact_async (GESJournal *self, GCancellable *cancellable,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+  GTask *task = g_task_new (self, cancellable, callback, user_data);
+  CompactData *data;
+  GHashTableIter iter;
+  gpointer object, id;
+  GError *error = NULL;
+
+  if (!g_atomic_int_compare_and_exchange (&priv->compacting, FALSE, TRUE)) {
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_PENDING,
+        "A compaction is already in progress");
+    goto done;
+  }
+
+  if (!ges_journal_flush (self, &error)) {
+    g_atomic_int_set (&priv->compacting, FALSE);
+    g_task_return_error (task, error);
+    goto done;
+  }
+
+  _close_journal (self);
+  priv->generation += 1;
+  priv->n_records = 0;
+
+  data = g_slice_new (CompactData);
+  data->directory = g_strdup (priv->directory);
+  data->objects = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+  g_hash_table_iter_init (&iter, priv->ids);
+  while (g_hash_table_iter_next (&iter, &object, &id))
+    g_hash_table_insert (data->objects, g_object_ref (object), id);
+  data->media_type = ges_object_get_media_type (GES_OBJECT (priv->timeline));
+  data->generation = priv->generation;
+  g_task_set_task_data (task, data, (GDestroyNotify) _free_compact_data);
+
+  if (!_open_journal (self, &error)) {
+    g_atomic_int_set (&priv->compacting, FALSE);
+    g_task_return_error (task, error);
+    goto done;
+  }
+
+  g_task_run_in_thread (task, (GTaskThreadFunc) _compact_thread_func);
+
+done:
+  g_object_unref (task);
+}
+
+/**
+ * ges_journal_compact_finish:
+ * @self: a #GESJournal
+ * @result: The #GAsyncResult passed to the callback of
+ * ges_journal_compact_async()
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Returns: %TRUE if the snapshot was written, %FALSE otherwise
+ */
+gboolean
+ges_journal_compact_finish (GESJournal *self, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, self), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/**
+ * ges_journal_get_n_records:
+ * @self: a #GESJournal
+ *
+ * Returns: The number of changes recorded since the last snapshot
+ */
+guint
+ges_journal_get_n_records (GESJournal *self)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+
+  return priv->n_records;
+}
+
+/**
+ * ges_journal_recover:
+ * @directory: The directory a #GESJournal was recording to
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Rebuilds a timeline from the latest snapshot in @directory, replaying
+ * the changes recorded after it. Changes that weren't flushed are lost.
+ *
+ * Returns: (transfer floating): A new #GESTimeline, or %NULL if
+ * @directory doesn't contain a valid snapshot
+ */
+GESTimeline *
+ges_journal_recover (const gchar *directory, GError **error)
+{
+  gchar *path = g_build_filename (directory, SNAPSHOT_FILE, NULL);
+  GVariant *snapshot = _map_variant (path, SNAPSHOT_MAGIC, G_VARIANT_TYPE (SNAPSHOT_FORMAT), error);
+  GHashTable *objects;
+  GESTimeline *timeline;
+  GVariantIter *iter;
+  GVariant *object_variant;
+  GList *ids, *tmp;
+  GPtrArray *uris;
+  guint generation, media_type, id, journal_generation;
+
+  g_free (path);
+
+  if (!snapshot)
+    return NULL;
+
+  objects = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
+
+  /* Discover all the media at once before creating the objects */
+  uris = g_ptr_array_new_with_free_func (g_free);
+  g_variant_get (snapshot, "(uua(uv))", &generation, &media_type, &iter);
+  while (g_variant_iter_next (iter, "(u@v)", &id, &object_variant)) {
+    ges_object_collect_uris (object_variant, uris);
+    g_variant_unref (object_variant);
+  }
+  g_variant_iter_free (iter);
+  journal_generation = generation;
+  while (_replay_journal (directory, journal_generation, NULL, uris))
+    journal_generation += 1;
+  ges_asset_prefetch (uris);
+  g_ptr_array_unref (uris);
+
+  g_variant_get (snapshot, "(uua(uv))", &generation, &media_type, &iter);
+  while (g_variant_iter_next (iter, "(u@v)", &id, &object_variant)) {
+    GESObject *object = ges_object_deserialize (object_variant);
+
+    if (object)
+      g_hash_table_insert (objects, GUINT_TO_POINTER (id), g_object_ref_sink (object));
+    g_variant_unref (object_variant);
+  }
+  g_variant_iter_free (iter);
+  g_variant_unref (snapshot);
+
+  while (_replay_journal (directory, generation, objects, NULL))
+    generation += 1;
+
+  timeline = ges_timeline_new (media_type);
+
+  ids = g_list_sort (g_hash_table_get_keys (objects), _compare_ids);
+  for (tmp = ids; tmp; tmp = tmp->next)
+    ges_timeline_add_object (timeline, g_hash_table_lookup (objects, tmp->data));
+  g_list_free (ids);
+
+  g_hash_table_unref (objects);
+
+  return timeline;
+}
+
+/* GObject initialization */
+
+static void
+_dispose (GObject *object)
+{
+  GESJournal *self = GES_JOURNAL (object);
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+  GHashTableIter iter;
+  gpointer tracked;
+
+  if (priv->stream) {
+    ges_journal_flush (self, NULL);
+    _close_journal (self);
+  }
+
+  g_hash_table_iter_init (&iter, priv->ids);
+  while (g_hash_table_iter_next (&iter, &tracked, NULL))
+    g_signal_handlers_disconnect_by_func (tracked, _object_notify_cb, self);
+  g_hash_table_remove_all (priv->ids);
+
+  if (priv->timeline) {
+    g_signal_handler_disconnect (priv->timeline, priv->object_added_id);
+    g_object_unref (priv->timeline);
+    priv->timeline = NULL;
+  }
+
+  G_OBJECT_CLASS (ges_journal_parent_class)->dispose (object);
+}
+
+static void
+_finalize (GObject *object)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (object);
+
+  g_hash_table_unref (priv->ids);
+  g_byte_array_unref (priv->pending);
+  g_free (priv->directory);
+
+  G_OBJECT_CLASS (ges_journal_parent_class)->finalize (object);
+}
+
+static void
+ges_journal_class_init (GESJournalClass *klass)
+{
+  GObjectClass *g_object_class = G_OBJECT_CLASS (klass);
+
+  g_object_class->dispose = _dispose;
+  g_object_class->finalize = _finalize;
+}
+
+static void
+ges_journal_init (GESJournal *self)
+{
+  GESJournalPrivate *priv = GES_JOURNAL_PRIV (self);
+
+  priv->ids = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+  priv->pending = g_byte_array_new ();
+  priv->next_id = 0;
+  priv->n_records = 0;
+  priv->compacting = FALSE;
+}
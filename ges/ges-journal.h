@@ -0,0 +1,26 @@
+#ifndef _GES_JOURNAL
+#define _GES_JOURNAL
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <gst/gst.h>
+#include <ges-timeline.h>
+
+G_BEGIN_DECLS
+
+#define GES_TYPE_JOURNAL (ges_journal_get_type ())
+
+G_DECLARE_FINAL_TYPE(GESJournal, ges_journal, GES, JOURNAL, GObject)
+
+GESJournal *ges_journal_new (GESTimeline *timeline, const gchar *directory, GError **error);
+gboolean ges_journal_flush (GESJournal *self, GError **error);
+void ges_journal_compact_async (GESJournal *self, GCancellable *cancellable,
+    GAsyncReadyCallback callback, gpointer user_data);
+gboolean ges_journal_compact_finish (GESJournal *self, GAsyncResult *result, GError **error);
+guint ges_journal_get_n_records (GESJournal *self);
+
+GESTimeline *ges_journal_recover (const gchar *directory, GError **error);
+
+G_END_DECLS
+
+#endif
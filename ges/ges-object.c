@@ -29,6 +29,14 @@ typedef struct _GESObjectPrivate
   guint audio_track_index;
   GList *children;
   GList *control_sources;
+
+  /* See ges_object_begin_edit */
+  guint edit_depth;
+  guint pending_changes;
+  /* The timings when the edit began, kept when a change gets rejected */
+  GstClockTime edit_inpoint;
+  GstClockTime edit_duration;
+  GstClockTime edit_start;
 } GESObjectPrivate;
 
 static void ges_object_child_proxy_init (GstChildProxyInterface * iface);
@@ -51,6 +59,14 @@ enum
 
 static GParamSpec *properties[PROP_LAST];
 
+/* Timing changes waiting for the end of an edit */
+enum
+{
+  PENDING_INPOINT = 1 << 0,
+  PENDING_DURATION = 1 << 1,
+  PENDING_START = 1 << 2,
+};
+
 /* API */
 
 /**
@@ -73,6 +89,7 @@ ges_object_set_media_type (GESObject *object, GESMediaType media_type)
 
   if (klass->set_media_type && klass->set_media_type (object, media_type)) {
     priv->media_type = media_type;
+    g_object_notify_by_pspec (G_OBJECT (object), properties[PROP_MEDIA_TYPE]);
     return TRUE;
   } else
     GST_ERROR_OBJECT (object, "could not set media type to %d, check your code", media_type);
@@ -97,8 +114,16 @@ ges_object_set_inpoint (GESObject *object, GstClockTime inpoint)
   GESObjectPrivate *priv = GES_OBJECT_PRIV (object);
   GESObjectClass *klass = GES_OBJECT_GET_CLASS (object);
 
+  if (priv->edit_depth && klass->set_inpoint) {
+    priv->inpoint = inpoint;
+    priv->pending_changes |= PENDING_INPOINT;
+    g_object_notify_by_pspec (G_OBJECT (object), properties[PROP_INPOINT]);
+    return TRUE;
+  }
+
   if (klass->set_inpoint && klass->set_inpoint (object, inpoint)) {
     priv->inpoint = inpoint;
+    g_object_notify_by_pspec (G_OBJECT (object), properties[PROP_INPOINT]);
     return TRUE;
   } else
     GST_ERROR_OBJECT (object, "could not set inpoint to %" GST_TIME_FORMAT, GST_TIME_ARGS (inpoint));
@@ -123,8 +148,16 @@ ges_object_set_duration (GESObject *object, GstClockTime duration)
   GESObjectPrivate *priv = GES_OBJECT_PRIV (object);
   GESObjectClass *klass = GES_OBJECT_GET_CLASS (object);
 
+  if (priv->edit_depth && klass->set_duration) {
+    priv->duration = duration;
+    priv->pending_changes |= PENDING_DURATION;
+    g_object_notify_by_pspec (G_OBJECT (object), properties[PROP_DURATION]);
+    return TRUE;
+  }
+
   if (klass->set_duration && klass->set_duration (object, duration)) {
     priv->duration = duration;
+    g_object_notify_by_pspec (G_OBJECT (object), properties[PROP_DURATION]);
     return TRUE;
   } else
     GST_ERROR_OBJECT (object, "could not set duration to %" GST_TIME_FORMAT, GST_TIME_ARGS (duration));
@@ -147,8 +180,16 @@ ges_object_set_start (GESObject *object, GstClockTime start)
   GESObjectPrivate *priv = GES_OBJECT_PRIV (object);
   GESObjectClass *klass = GES_OBJECT_GET_CLASS (object);
 
+  if (priv->edit_depth && klass->set_start) {
+    priv->start = start;
+    priv->pending_changes |= PENDING_START;
+    g_object_notify_by_pspec (G_OBJECT (object), properties[PROP_START]);
+    return TRUE;
+  }
+
   if (klass->set_start && klass->set_start (object, start)) {
     priv->start = start;
+    g_object_notify_by_pspec (G_OBJECT (object), properties[PROP_START]);
     return TRUE;
   } else
     GST_ERROR_OBJECT (object, "could not set start to %" GST_TIME_FORMAT, GST_TIME_ARGS (start));
@@ -263,25 +304,52 @@ _maybe_get_variant_from_tuple (GVariant * tuple, guint index)
   return ret;
 }
 
-static void
-_deserialize_generic (GESObject *object, GVariant *variant)
+GESObject *
+ges_object_new_from_fields (const gchar *type_name, GESMediaType media_type,
+    GstClockTime inpoint, GstClockTime duration, GstClockTime start,
+    guint video_track_index, guint audio_track_index, GVariant *subclass_variant)
 {
-  guint64 inpoint;
-  guint64 duration;
-  guint64 start;
-  guint video_track_index;
-  guint audio_track_index;
+  GESObject *res;
+  GESObjectClass *klass;
+  GType type = g_type_from_name (type_name);
+
+  if (!g_type_is_a (type, GES_TYPE_OBJECT)) {
+    GST_ERROR ("%s is not a known GESObject type", type_name);
+    return NULL;
+  }
 
-  GET_FROM_TUPLE (variant, uint64, 2, &inpoint);
-  GET_FROM_TUPLE (variant, uint64, 3, &duration);
-  GET_FROM_TUPLE (variant, uint64, 4, &start);
-  GET_FROM_TUPLE (variant, uint32, 5, &video_track_index);
-  GET_FROM_TUPLE (variant, uint32, 6, &audio_track_index);
+  res = g_object_new (type, "media-type", media_type, NULL);
 
-  g_object_set (object, "inpoint", inpoint, "duration", duration,
+  klass = GES_OBJECT_GET_CLASS (res);
+  if (klass->deserialize)
+    klass->deserialize (res, subclass_variant);
+
+  g_object_set (res, "inpoint", inpoint, "duration", duration,
       "start", start, NULL);
-  ges_object_set_video_track_index (object, video_track_index);
-  ges_object_set_audio_track_index (object, audio_track_index);
+  ges_object_set_video_track_index (res, video_track_index);
+  ges_object_set_audio_track_index (res, audio_track_index);
+
+  return res;
+}
+
+void
+ges_object_collect_uris (GVariant *object_variant, GPtrArray *uris)
+{
+  GVariant *variant = g_variant_get_variant (object_variant);
+  GVariant *generic;
+  GVariant *subclass_variant;
+  const gchar *object_type_name;
+
+  GET_FROM_TUPLE (variant, variant, 0, &generic);
+  GET_STRING_FROM_TUPLE (generic, 0, &object_type_name);
+
+  subclass_variant = _maybe_get_variant_from_tuple (variant, 1);
+  ges_uri_source_collect_uri (object_type_name, subclass_variant, uris);
+
+  if (subclass_variant)
+    g_variant_unref (subclass_variant);
+  g_variant_unref (generic);
+  g_variant_unref (variant);
 }
 
 GESObject *
@@ -293,20 +361,30 @@ ges_object_deserialize (GVariant *object_variant)
   GESObject *res;
   const gchar *object_type_name;
   GESMediaType media_type;
-  GESObjectClass *klass;
+  guint64 inpoint;
+  guint64 duration;
+  guint64 start;
+  guint video_track_index;
+  guint audio_track_index;
 
   GET_FROM_TUPLE (variant, variant, 0, &generic);
   GET_STRING_FROM_TUPLE (generic, 0, &object_type_name);
   GET_FROM_TUPLE (generic, uint32, 1, &media_type);
-
-  res = g_object_new (g_type_from_name (object_type_name), "media-type", media_type, NULL);
+  GET_FROM_TUPLE (generic, uint64, 2, &inpoint);
+  GET_FROM_TUPLE (generic, uint64, 3, &duration);
+  GET_FROM_TUPLE (generic, uint64, 4, &start);
+  GET_FROM_TUPLE (generic, uint32, 5, &video_track_index);
+  GET_FROM_TUPLE (generic, uint32, 6, &audio_track_index);
 
   subclass_variant = _maybe_get_variant_from_tuple (variant, 1);
-  klass = GES_OBJECT_GET_CLASS (res);
-  if (klass->deserialize)
-    klass->deserialize (res, subclass_variant);
 
-  _deserialize_generic (res, generic);
+  res = ges_object_new_from_fields (object_type_name, media_type, inpoint,
+      duration, start, video_track_index, audio_track_index, subclass_variant);
+
+  if (subclass_variant)
+    g_variant_unref (subclass_variant);
+  g_variant_unref (generic);
+  g_variant_unref (variant);
 
   return res;
 }
@@ -418,6 +496,67 @@ ges_object_get_nle_objects (GESObject *object)
   return NULL;
 }
 
+/* Until the matching ges_object_end_edit, timing changes are only stored,
+ * and their notifications held back. They get forwarded to the subclass
+ * once, with their final values, when the edit ends. */
+void
+ges_object_begin_edit (GESObject *object)
+{
+  GESObjectPrivate *priv = GES_OBJECT_PRIV (object);
+
+  if (priv->edit_depth++)
+    return;
+
+  priv->edit_inpoint = priv->inpoint;
+  priv->edit_duration = priv->duration;
+  priv->edit_start = priv->start;
+  g_object_freeze_notify (G_OBJECT (object));
+}
+
+/* Returns FALSE if the subclass rejected one of the changes, which then
+ * gets reverted to its value from before the edit */
+gboolean
+ges_object_end_edit (GESObject *object)
+{
+  GESObjectPrivate *priv = GES_OBJECT_PRIV (object);
+  GstClockTime inpoint = priv->inpoint;
+  GstClockTime duration = priv->duration;
+  GstClockTime start = priv->start;
+  guint pending_changes = priv->pending_changes;
+  gboolean inpoint_first, res = TRUE;
+
+  g_return_val_if_fail (priv->edit_depth > 0, FALSE);
+
+  if (--priv->edit_depth)
+    return TRUE;
+
+  /* The subclass checks each change against what is applied, as when
+   * not editing */
+  priv->pending_changes = 0;
+  priv->inpoint = priv->edit_inpoint;
+  priv->duration = priv->edit_duration;
+  priv->start = priv->edit_start;
+
+  /* Moving the inpoint back makes room for a longer duration, a shorter
+   * duration makes room for a later inpoint */
+  inpoint_first = inpoint < priv->inpoint;
+
+  if ((pending_changes & PENDING_INPOINT) && inpoint_first &&
+      !ges_object_set_inpoint (object, inpoint))
+    res = FALSE;
+  if ((pending_changes & PENDING_DURATION) && !ges_object_set_duration (object, duration))
+    res = FALSE;
+  if ((pending_changes & PENDING_INPOINT) && !inpoint_first &&
+      !ges_object_set_inpoint (object, inpoint))
+    res = FALSE;
+  if ((pending_changes & PENDING_START) && !ges_object_set_start (object, start))
+    res = FALSE;
+
+  g_object_thaw_notify (G_OBJECT (object));
+
+  return res;
+}
+
 static gchar *
 _get_base_property_name (const gchar * name)
 {
@@ -471,6 +610,43 @@ _lookup_element_for_property (GESObject *self, const gchar *property_name, GPara
   return object;
 }
 
+static void
+_control_points_changed_cb (GObject *element)
+{
+  g_object_set (element, "bake", TRUE, NULL);
+}
+
+/* Makes @source drive @property_name on @element through a direct control
+ * binding */
+gboolean
+ges_object_bind_control_source (GstObject *element, const gchar *property_name,
+    GstControlSource *source, gboolean absolute)
+{
+  GstControlBinding *binding;
+
+  if (absolute)
+    binding = gst_direct_control_binding_new_absolute (element, property_name, source);
+  else
+    binding = gst_direct_control_binding_new (element, property_name, source);
+
+  if (!binding)
+    return FALSE;
+
+  gst_object_add_control_binding (element, binding);
+
+  /* Elements baking their curves need to rebuild them when the points change */
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (element), "bake")) {
+    g_signal_connect_object (source, "value-added",
+        G_CALLBACK (_control_points_changed_cb), element, G_CONNECT_SWAPPED);
+    g_signal_connect_object (source, "value-changed",
+        G_CALLBACK (_control_points_changed_cb), element, G_CONNECT_SWAPPED);
+    g_signal_connect_object (source, "value-removed",
+        G_CALLBACK (_control_points_changed_cb), element, G_CONNECT_SWAPPED);
+  }
+
+  return TRUE;
+}
+
 /**
  * ges_object_get_interpolation_control_source:
  * @object: a #GESObject
@@ -517,16 +693,14 @@ ges_object_get_interpolation_control_source (GESObject * self,
   }
 
   source = gst_interpolation_control_source_new ();
-  binding = gst_direct_control_binding_new (GST_OBJECT (object), base_property_name, source);
 
-  if (!binding) {
+  if (!ges_object_bind_control_source (GST_OBJECT (object), base_property_name, source, FALSE)) {
     g_object_unref (source);
     g_object_unref (object);
     source = NULL;
     goto beach;
   }
 
-  gst_object_add_control_binding (GST_OBJECT (object), binding);
   priv->control_sources = g_list_append (priv->control_sources, source);
   g_object_unref (object);
 
@@ -537,11 +711,22 @@ beach:
 
 /* GstChildProxy implementation */
 
+static void
+_ensure_children (GstChildProxy *proxy)
+{
+  GESObjectClass *klass = GES_OBJECT_GET_CLASS (proxy);
+
+  if (klass->ensure_children)
+    klass->ensure_children (GES_OBJECT (proxy));
+}
+
 static guint
 _get_children_count (GstChildProxy *proxy)
 {
   GESObjectPrivate *priv = GES_OBJECT_PRIV (proxy);
 
+  _ensure_children (proxy);
+
   return g_list_length (priv->children);
 }
 
@@ -550,6 +735,8 @@ _get_child_by_index (GstChildProxy *proxy, guint index)
 {
   GESObjectPrivate *priv = GES_OBJECT_PRIV (proxy);
 
+  _ensure_children (proxy);
+
   return g_object_ref (g_list_nth_data (priv->children, index));
 }
 
@@ -741,6 +928,7 @@ ges_object_class_init (GESObjectClass *klass)
   klass->set_duration = NULL;
   klass->set_start = NULL;
   klass->set_track_index = NULL;
+  klass->ensure_children = NULL;
   klass->serialize = NULL;
   klass->deserialize = NULL;
 }
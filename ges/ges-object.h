@@ -58,6 +58,15 @@ struct _GESObjectClass
    */
   GList *  (*get_nle_objects) (GESObject *object);
 
+  /**
+   * GESObjectClass::ensure_children:
+   *
+   * Implement this method if your subclass only creates the children it
+   * exposes through #GstChildProxy when they are needed, it is called
+   * before any of them gets looked up.
+   */
+  void     (*ensure_children) (GESObject *object);
+
   GVariant * (*serialize) (GESObject *object);
   gboolean   (*deserialize) (GESObject *object, GVariant *variant);
 };
@@ -1,6 +1,9 @@
+#include "gst/controller/controller.h"
 #include "ges-timeline.h"
 #include "ges-source.h"
 #include "ges-playable.h"
+#include "ges-internal.h"
+#include "nle.h"
 
 /* Structure definitions */
 
@@ -15,6 +18,33 @@ typedef struct _GESSourcePrivate
   guint track_index;
   GstElement *playable_bin;
   GESTransition *transition;
+
+  /* The GESEffects, in the order they apply */
+  GList *effects;
+  /* The nleoperations applying them, closest to us first. They follow our
+   * nleobject around, see _sync_effect_operations */
+  GList *effect_operations;
+
+  /* The elements controlled by nleobject are only built when needed,
+   * see _ensure_elements */
+  GMutex lock;
+  GstElement *topbin;
+  GstElement *controller;
+  guint zorder;
+  gint64 last_used;
+  /* What was set on our controller when it got released, applied again
+   * when it gets rebuilt, see _save_controller_state */
+  GstStructure *controller_properties;
+  GList *controller_bindings;
+
+  /* The format of the timeline we output in, see
+   * ges_timeline_set_restriction_caps */
+  GstCaps *restriction_caps;
+  GstElement *restriction_filter;
+  /* Only present when the source doesn't output that format already */
+  GstElement *converter;
+  GstElement *scaler;
+  GstElement *rate;
 } GESSourcePrivate;
 
 static void ges_playable_interface_init (GESPlayableInterface * iface);
@@ -26,77 +56,473 @@ G_DEFINE_TYPE_WITH_CODE (GESSource, ges_source, GES_TYPE_OBJECT,
 
 /* Implementation */
 
+typedef struct
+{
+  gchar *property_name;
+  GstControlSource *source;
+  gboolean absolute;
+} SavedBinding;
+
 static void
-_pad_added_cb (GstElement *element, GstPad *srcpad, GESSource *self)
+_free_saved_binding (SavedBinding *saved)
+{
+  g_free (saved->property_name);
+  gst_object_unref (saved->source);
+  g_slice_free (SavedBinding, saved);
+}
+
+/* The fields of the restriction caps each element of our chain takes care
+ * of converting to */
+static const gchar *video_converter_fields[] = { "format", NULL };
+static const gchar *video_scaler_fields[] = { "width", "height", NULL };
+static const gchar *video_rate_fields[] = { "framerate", NULL };
+static const gchar *audio_converter_fields[] = { "format", "channels", "layout", NULL };
+static const gchar *audio_rate_fields[] = { "rate", NULL };
+
+/* Whether @stream is known to differ from @restriction on any of @fields.
+ * What we know nothing about is assumed to match, the caps probe takes
+ * care of the sources that turn out not to */
+static gboolean
+_differs (GstStructure *restriction, GstStructure *stream, const gchar **fields)
+{
+  guint i;
+
+  if (!restriction || !stream)
+    return FALSE;
+
+  for (i = 0; fields[i]; i++) {
+    const GValue *restricted = gst_structure_get_value (restriction, fields[i]);
+    const GValue *value = gst_structure_get_value (stream, fields[i]);
+
+    if (restricted && value && !gst_value_can_intersect (restricted, value))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Called with the lock taken */
+static GstElement *
+_make_chain_element (GESSource *self, const gchar *factory_name, GstElement **element)
 {
   GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
-  gst_element_no_more_pads (element);
+
+  *element = gst_element_factory_make (factory_name, NULL);
+  gst_bin_add (GST_BIN (priv->topbin), *element);
+
+  return *element;
+}
+
+/* Puts @elements in front of our chain, between @srcpad and the element
+ * it was linked to */
+static void
+_prepend_to_chain (GESSource *self, GstPad *srcpad, GList *elements)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GstElement *first = elements->data;
+  GstPad *sinkpad;
+  GList *tmp;
+
+  if (srcpad)
+    gst_pad_unlink (srcpad, priv->static_sinkpad);
+
+  for (tmp = elements; tmp; tmp = tmp->next) {
+    GstElement *next = tmp->next ? tmp->next->data : NULL;
+    GstPad *pad;
+
+    if (next) {
+      gst_element_link (tmp->data, next);
+      continue;
+    }
+
+    pad = gst_element_get_static_pad (tmp->data, "src");
+    gst_pad_link (pad, priv->static_sinkpad);
+    gst_object_unref (pad);
+  }
+
+  sinkpad = gst_element_get_static_pad (first, "sink");
+  gst_object_unref (priv->static_sinkpad);
+  priv->static_sinkpad = sinkpad;
+
+  if (srcpad) {
+    for (tmp = elements; tmp; tmp = tmp->next)
+      gst_element_sync_state_with_parent (tmp->data);
+    gst_pad_link (srcpad, priv->static_sinkpad);
+  }
+}
+
+/* The elements converting into @restriction that our chain lacks, and
+ * that the source is either known or found to need */
+static GList *
+_make_missing_converters (GESSource *self, GstStructure *restriction, GstStructure *stream)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GList *res = NULL;
+  gboolean video = ges_object_get_media_type (GES_OBJECT (self)) == GES_MEDIA_TYPE_VIDEO;
+
+  /* Without a format to convert to, everything has to stay in */
+  if (!restriction) {
+    if (!priv->converter)
+      res = g_list_append (res, _make_chain_element (self,
+            video ? "videoconvert" : "audioconvert", &priv->converter));
+    if (!priv->rate)
+      res = g_list_append (res, _make_chain_element (self,
+            video ? "videorate" : "audioresample", &priv->rate));
+
+    return res;
+  }
+
+  if (!priv->converter && _differs (restriction, stream,
+        video ? video_converter_fields : audio_converter_fields))
+    res = g_list_append (res, _make_chain_element (self,
+          video ? "videoconvert" : "audioconvert", &priv->converter));
+
+  if (video && !priv->scaler && _differs (restriction, stream, video_scaler_fields))
+    res = g_list_append (res, _make_chain_element (self, "videoscale", &priv->scaler));
+
+  if (!priv->rate && _differs (restriction, stream,
+        video ? video_rate_fields : audio_rate_fields))
+    res = g_list_append (res, _make_chain_element (self,
+          video ? "videorate" : "audioresample", &priv->rate));
+
+  return res;
+}
+
+/* Our chain is built from what we expect the source to output, this
+ * catches the cases where it ends up outputting something else. Our
+ * elements and the chain are only touched with the lock taken, as
+ * restriction caps might be getting set meanwhile */
+static GstPadProbeReturn
+_source_caps_probe_cb (GstPad *srcpad, GstPadProbeInfo *info, GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  GstCaps *caps, *allowed, *restriction_caps;
+  GstPad *sinkpad;
+  gboolean relinked;
+  GList *missing;
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_CAPS)
+    return GST_PAD_PROBE_OK;
+
+  gst_event_parse_caps (event, &caps);
+
+  g_mutex_lock (&priv->lock);
+  if (!priv->topbin || !priv->restriction_filter)
+    goto done;
+
+  /* The query goes downstream, don't hold the lock meanwhile */
+  sinkpad = gst_object_ref (priv->static_sinkpad);
+  g_mutex_unlock (&priv->lock);
+  allowed = gst_pad_query_caps (sinkpad, caps);
+  if (!gst_caps_is_empty (allowed)) {
+    gst_caps_unref (allowed);
+    gst_object_unref (sinkpad);
+    return GST_PAD_PROBE_OK;
+  }
+  gst_caps_unref (allowed);
+
+  g_mutex_lock (&priv->lock);
+  relinked = sinkpad != priv->static_sinkpad;
+  gst_object_unref (sinkpad);
+  /* Released or relinked while we weren't looking */
+  if (!priv->topbin || !priv->restriction_filter || relinked)
+    goto done;
+
+  /* The filter holds the caps our chain was built for */
+  g_object_get (priv->restriction_filter, "caps", &restriction_caps, NULL);
+  missing = _make_missing_converters (self, gst_caps_get_structure (restriction_caps, 0),
+      gst_caps_get_structure (caps, 0));
+  gst_caps_unref (restriction_caps);
+  if (missing) {
+    GST_DEBUG_OBJECT (self, "inserting %d converters for %" GST_PTR_FORMAT,
+        g_list_length (missing), caps);
+    _prepend_to_chain (self, srcpad, missing);
+    g_list_free (missing);
+  } else {
+    GST_WARNING_OBJECT (self, "don't know how to convert %" GST_PTR_FORMAT, caps);
+  }
+
+done:
+  g_mutex_unlock (&priv->lock);
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+_link_source_pad (GESSource *self, GstPad *srcpad)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+
+  if (priv->restriction_filter)
+    gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        (GstPadProbeCallback) _source_caps_probe_cb, self, NULL);
+
   gst_pad_link (srcpad, priv->static_sinkpad);
 }
 
 static void
-_make_nle_object (GESSource *self)
+_pad_added_cb (GstElement *element, GstPad *srcpad, GESSource *self)
+{
+  gst_element_no_more_pads (element);
+  _link_source_pad (self, srcpad);
+}
+
+/* Called with the lock taken. Remembers the properties of our controller
+ * that were changed from their defaults, and the control sources bound to
+ * it. Returns %FALSE if some of it couldn't be, in which case the controller
+ * can't be released */
+static gboolean
+_save_controller_state (GESSource *self)
 {
   GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
-  GstElement *element, *rate, *converter;
-  GstElement *topbin;
+  GstStructure *properties = gst_structure_new_empty ("properties");
+  GList *bindings = NULL;
+  GParamSpec **pspecs;
+  guint n_pspecs, i;
+  gboolean ret = TRUE;
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (priv->controller), &n_pspecs);
+  for (i = 0; i < n_pspecs; i++) {
+    GParamSpec *pspec = pspecs[i];
+    GstControlBinding *binding;
+    GValue value = G_VALUE_INIT;
+
+    /* Ours are set again when building, only the element's own matter */
+    if (pspec->owner_type != G_OBJECT_TYPE (priv->controller) ||
+        (pspec->flags & (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY)) != G_PARAM_READWRITE ||
+        !g_strcmp0 (pspec->name, "zorder") || !g_strcmp0 (pspec->name, "bake"))
+      continue;
+
+    binding = gst_object_get_control_binding (GST_OBJECT (priv->controller), pspec->name);
+    if (binding) {
+      SavedBinding *saved;
+
+      if (!GST_IS_DIRECT_CONTROL_BINDING (binding)) {
+        GST_DEBUG_OBJECT (self, "can't save the binding of %s", pspec->name);
+        gst_object_unref (binding);
+        ret = FALSE;
+        break;
+      }
+
+      saved = g_slice_new0 (SavedBinding);
+      saved->property_name = g_strdup (pspec->name);
+      g_object_get (binding, "control-source", &saved->source,
+          "absolute", &saved->absolute, NULL);
+      bindings = g_list_append (bindings, saved);
+      gst_object_unref (binding);
+      continue;
+    }
+
+    g_value_init (&value, pspec->value_type);
+    g_object_get_property (G_OBJECT (priv->controller), pspec->name, &value);
+    if (!g_param_value_defaults (pspec, &value))
+      gst_structure_set_value (properties, pspec->name, &value);
+    g_value_unset (&value);
+  }
+  g_free (pspecs);
+
+  if (!ret) {
+    gst_structure_free (properties);
+    g_list_free_full (bindings, (GDestroyNotify) _free_saved_binding);
+    return FALSE;
+  }
+
+  priv->controller_properties = properties;
+  priv->controller_bindings = bindings;
+
+  return TRUE;
+}
+
+static gboolean
+_restore_controller_property (GQuark field_id, const GValue *value, GObject *controller)
+{
+  g_object_set_property (controller, g_quark_to_string (field_id), value);
+
+  return TRUE;
+}
+
+/* Called with the lock taken */
+static void
+_restore_controller_state (GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GList *tmp;
+
+  if (priv->controller_properties) {
+    gst_structure_foreach (priv->controller_properties,
+        (GstStructureForeachFunc) _restore_controller_property, priv->controller);
+    gst_structure_free (priv->controller_properties);
+    priv->controller_properties = NULL;
+  }
+
+  for (tmp = priv->controller_bindings; tmp; tmp = tmp->next) {
+    SavedBinding *saved = tmp->data;
+
+    if (!ges_object_bind_control_source (GST_OBJECT (priv->controller),
+          saved->property_name, saved->source, saved->absolute))
+      GST_ERROR_OBJECT (self, "couldn't bind %s again", saved->property_name);
+  }
+  g_list_free_full (priv->controller_bindings, (GDestroyNotify) _free_saved_binding);
+  priv->controller_bindings = NULL;
+}
+
+static gboolean
+_is_opaque_curve (GstControlSource *source)
+{
+  GList *values, *tmp;
+  gboolean ret = GST_IS_TIMED_VALUE_CONTROL_SOURCE (source);
+
+  if (!ret)
+    return FALSE;
+
+  values = gst_timed_value_control_source_get_all (GST_TIMED_VALUE_CONTROL_SOURCE (source));
+  for (tmp = values; tmp && ret; tmp = tmp->next)
+    ret = ((GstTimedValue *) tmp->data)->value >= 1.0;
+  g_list_free (values);
+
+  return ret;
+}
+
+/* Called with the lock taken. Whether @name is at its default on our
+ * controller, whether it is built or got released. A curve is only
+ * considered as such on alpha, when it keeps us opaque */
+static gboolean
+_controller_property_is_default (GESSource *self, const gchar *name)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GstControlSource *source = NULL;
+  gboolean ret;
+  GList *tmp;
+
+  if (priv->controller) {
+    GstControlBinding *binding =
+        gst_object_get_control_binding (GST_OBJECT (priv->controller), name);
+    GParamSpec *pspec;
+    GValue value = G_VALUE_INIT;
+
+    if (binding) {
+      g_object_get (binding, "control-source", &source, NULL);
+      gst_object_unref (binding);
+    } else {
+      pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (priv->controller), name);
+      if (!pspec)
+        return TRUE;
+
+      g_value_init (&value, pspec->value_type);
+      g_object_get_property (G_OBJECT (priv->controller), name, &value);
+      ret = g_param_value_defaults (pspec, &value);
+      g_value_unset (&value);
+
+      return ret;
+    }
+  } else {
+    if (priv->controller_properties && gst_structure_has_field (priv->controller_properties, name))
+      return FALSE;
+
+    for (tmp = priv->controller_bindings; tmp && !source; tmp = tmp->next) {
+      SavedBinding *saved = tmp->data;
+
+      if (!g_strcmp0 (saved->property_name, name))
+        source = gst_object_ref (saved->source);
+    }
+  }
+
+  if (!source)
+    return TRUE;
+
+  ret = !g_strcmp0 (name, "alpha") && _is_opaque_curve (source);
+  gst_object_unref (source);
+
+  return ret;
+}
+
+/* Called with the lock taken */
+static void
+_make_elements (GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GstElement *element;
   GstPad *srcpad, *ghost;
-  GstCaps *caps;
   GESMediaType media_type;
   GESSourceClass *klass = GES_SOURCE_GET_CLASS (self);
+  GstCaps *stream_caps = NULL;
+  GstStructure *restriction = NULL, *stream = NULL;
+  GList *converters;
 
   g_object_get (self, "media-type", &media_type, NULL);
 
-  if (!klass->make_element)
-    return;
-
-  topbin = gst_bin_new (NULL);
-
   element = klass->make_element (self);
   if (!element) {
     GST_ERROR_OBJECT (self, "couldn't make source element");
     return;
   }
 
-  priv->nleobject = gst_element_factory_make ("nlesource", NULL);
+  priv->topbin = gst_bin_new (NULL);
+  gst_bin_add (GST_BIN (priv->topbin), element);
 
   if (media_type == GES_MEDIA_TYPE_VIDEO) {
-    GstElement *framepositioner = gst_element_factory_make ("framepositioner", "framepositioner");
-
-    caps = gst_caps_from_string(GES_RAW_VIDEO_CAPS);
-    converter = gst_element_factory_make ("videoconvert", NULL);
-    rate = gst_element_factory_make ("videorate", NULL);
-    gst_bin_add_many (GST_BIN(topbin), element, converter, rate, framepositioner, NULL);
-    gst_element_link_many (converter, rate, framepositioner, NULL);
-    g_object_set (priv->nleobject, "caps", caps, NULL);
-    srcpad = gst_element_get_static_pad (framepositioner, "src");
-    gst_child_proxy_child_added (GST_CHILD_PROXY (self), G_OBJECT (framepositioner), "framepositioner");
+    priv->controller = gst_element_factory_make ("framepositioner", "framepositioner");
+    g_object_set (priv->controller, "zorder", priv->zorder, NULL);
   } else {
-    GstElement *samplecontroller = gst_element_factory_make ("samplecontroller", "samplecontroller");
+    priv->controller = gst_element_factory_make ("samplecontroller", "samplecontroller");
+    /* Smooth transitions without resorting to tiny buffers */
+    g_object_set (priv->controller, "sample-accurate", TRUE, NULL);
+  }
+  /* Our control points only change through ges_object_get_interpolation_control_source,
+   * which has the curves rebaked */
+  g_object_set (priv->controller, "bake", TRUE, NULL);
+  _restore_controller_state (self);
+  gst_bin_add (GST_BIN (priv->topbin), priv->controller);
+  priv->static_sinkpad = gst_element_get_static_pad (priv->controller, "sink");
+
+  /* Convert straight into the format of the timeline, so that the mixer
+   * doesn't have to */
+  if (priv->restriction_caps) {
+    GList *filter;
+
+    priv->restriction_filter = gst_element_factory_make ("capsfilter", NULL);
+    g_object_set (priv->restriction_filter, "caps", priv->restriction_caps, NULL);
+    filter = g_list_append (NULL, priv->restriction_filter);
+
+    gst_bin_add (GST_BIN (priv->topbin), priv->restriction_filter);
+    _prepend_to_chain (self, NULL, filter);
+    g_list_free (filter);
+
+    restriction = gst_caps_get_structure (priv->restriction_caps, 0);
+  }
 
-    caps = gst_caps_from_string(GES_RAW_AUDIO_CAPS);
-    converter = gst_element_factory_make ("audioconvert", NULL);
-    rate = gst_element_factory_make ("audioresample", NULL);
-    gst_bin_add_many (GST_BIN(topbin), element, converter, rate, samplecontroller, NULL);
-    gst_element_link_many (converter, rate, samplecontroller, NULL);
-    g_object_set (priv->nleobject, "caps", caps, NULL);
-    srcpad = gst_element_get_static_pad (samplecontroller, "src");
-    gst_child_proxy_child_added (GST_CHILD_PROXY (self), G_OBJECT (samplecontroller), "samplecontroller");
+  /* Only convert what we know differs from the timeline format, the caps
+   * probe adds what turns out to be missing */
+  if (klass->get_stream_caps)
+    stream_caps = klass->get_stream_caps (self);
+  if (stream_caps && !gst_caps_is_empty (stream_caps))
+    stream = gst_caps_get_structure (stream_caps, 0);
+
+  converters = _make_missing_converters (self, restriction, stream);
+  if (converters) {
+    _prepend_to_chain (self, NULL, converters);
+    g_list_free (converters);
   }
 
-  priv->static_sinkpad = gst_element_get_static_pad (converter, "sink");
+  if (stream_caps)
+    gst_caps_unref (stream_caps);
+
+  GST_DEBUG_OBJECT (self, "built chain, converter: %d, scaler: %d, rate: %d",
+      priv->converter != NULL, priv->scaler != NULL, priv->rate != NULL);
+
+  srcpad = gst_element_get_static_pad (priv->controller, "src");
+  gst_child_proxy_child_added (GST_CHILD_PROXY (self), G_OBJECT (priv->controller),
+      GST_OBJECT_NAME (priv->controller));
 
   ghost = gst_ghost_pad_new ("src", srcpad);
   gst_pad_set_active (ghost, TRUE);
-  gst_element_add_pad (topbin, ghost);
+  gst_element_add_pad (priv->topbin, ghost);
 
   gst_object_unref (srcpad);
 
-  gst_caps_unref (caps);
-
   srcpad = gst_element_get_static_pad (element, "src");
   if (srcpad) {
-    gst_pad_link (srcpad, priv->static_sinkpad);
+    _link_source_pad (self, srcpad);
     gst_object_unref (srcpad);
   } else {
     g_signal_connect (element, "pad-added",
@@ -104,8 +530,246 @@ _make_nle_object (GESSource *self)
         self);
   }
 
-  if (!gst_bin_add (GST_BIN (priv->nleobject), topbin))
+  if (!gst_bin_add (GST_BIN (priv->nleobject), priv->topbin))
+    GST_ERROR_OBJECT (self, "couldn't add our elements to the nle object");
+}
+
+/* Called with the lock taken. Returns %FALSE if the elements have to be
+ * kept, see _save_controller_state */
+static gboolean
+_release_elements (GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+
+  if (!_save_controller_state (self))
+    return FALSE;
+
+  /* Stops the caps probe before we forget about the chain */
+  gst_element_set_state (priv->topbin, GST_STATE_NULL);
+
+  gst_child_proxy_child_removed (GST_CHILD_PROXY (self), G_OBJECT (priv->controller),
+      GST_OBJECT_NAME (priv->controller));
+  priv->controller = NULL;
+  priv->restriction_filter = NULL;
+  priv->converter = NULL;
+  priv->scaler = NULL;
+  priv->rate = NULL;
+
+  gst_object_unref (priv->static_sinkpad);
+  priv->static_sinkpad = NULL;
+
+  gst_bin_remove (GST_BIN (priv->nleobject), priv->topbin);
+  priv->topbin = NULL;
+
+  return TRUE;
+}
+
+static void
+_ensure_elements (GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+
+  if (!priv->nleobject)
+    return;
+
+  g_mutex_lock (&priv->lock);
+  if (!priv->topbin)
+    _make_elements (self);
+  priv->last_used = g_get_monotonic_time ();
+  g_mutex_unlock (&priv->lock);
+}
+
+/* Our effect operations sit right above our nleobject, and cover the same
+ * time. Their priority is only meaningful once our nleobject is given one
+ * by a timeline, which leaves room for them in the lane of each source, see
+ * SOURCE_PRIORITY_HEIGHT */
+static void
+_sync_effect_operations (GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GstClockTime start;
+  gint64 duration;
+  guint priority, i = 0;
+  gboolean active;
+  GList *tmp;
+
+  g_object_get (priv->nleobject, "start", &start, "duration", &duration,
+      "priority", &priority, "active", &active, NULL);
+
+  for (tmp = priv->effect_operations; tmp; tmp = tmp->next, i++) {
+    g_object_set (tmp->data, "start", start, "duration", duration,
+        "inpoint", (guint64) 0, "active", active,
+        "priority", priority >= i + 1 ? priority - 1 - i : 0, NULL);
+  }
+}
+
+static void
+_nle_object_notify_cb (GstElement *nleobject, GParamSpec *pspec, GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+
+  if (priv->effect_operations)
+    _sync_effect_operations (self);
+}
+
+static GstElement *
+_make_effect_operation (GESSource *self, GstElement *element)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GstElement *operation = gst_object_ref_sink (gst_element_factory_make ("nleoperation", NULL));
+  GstCaps *caps;
+
+  /* Lets the timeline tell which composition it goes in */
+  g_object_get (priv->nleobject, "caps", &caps, NULL);
+  g_object_set (operation, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  gst_bin_add (GST_BIN (operation), element);
+
+  return operation;
+}
+
+static GstElement *
+_make_fused_operation (GESSource *self, const guint8 *curve, gdouble saturation)
+{
+  GstElement *element = gst_element_factory_make ("pixeltransform", NULL);
+  GString *levels = g_string_sized_new (4 * 256);
+  guint i;
+
+  if (!element) {
+    GST_ERROR_OBJECT (self, "pixeltransform missing, can't apply per-pixel effects");
+    g_string_free (levels, TRUE);
+    return NULL;
+  }
+
+  for (i = 0; i < 256; i++)
+    g_string_append_printf (levels, i ? " %u" : "%u", curve[i]);
+  g_object_set (element, "curve", levels->str, "saturation", MIN (saturation, 16.0), NULL);
+  g_string_free (levels, TRUE);
+
+  return _make_effect_operation (self, element);
+}
+
+/* Consecutive per-pixel effects are fused into a single pass over the
+ * frames, with their curves composed and their saturations multiplied,
+ * the other effects get an operation each */
+static GList *
+_make_effect_operations (GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GESMediaType media_type = ges_object_get_media_type (GES_OBJECT (self));
+  GList *tmp, *res = NULL;
+  guint8 curve[256];
+  gdouble saturation = 1.0;
+  gboolean fusing = FALSE;
+  guint i;
+
+  for (tmp = priv->effects; tmp; tmp = tmp->next) {
+    guint8 effect_curve[256];
+    gdouble effect_saturation;
+    GstElement *element;
+
+    if (media_type == GES_MEDIA_TYPE_VIDEO &&
+        ges_effect_get_pixel_transform (tmp->data, effect_curve, &effect_saturation)) {
+      if (!fusing) {
+        for (i = 0; i < 256; i++)
+          curve[i] = i;
+        saturation = 1.0;
+        fusing = TRUE;
+      }
+
+      for (i = 0; i < 256; i++)
+        curve[i] = effect_curve[curve[i]];
+      saturation *= effect_saturation;
+      continue;
+    }
+
+    if (fusing) {
+      res = g_list_append (res, _make_fused_operation (self, curve, saturation));
+      fusing = FALSE;
+    }
+
+    element = ges_effect_make_element (tmp->data, media_type);
+    res = g_list_append (res, element ? _make_effect_operation (self, element) : NULL);
+  }
+
+  if (fusing)
+    res = g_list_append (res, _make_fused_operation (self, curve, saturation));
+
+  /* Effects that couldn't be made are left out */
+  return g_list_remove_all (res, NULL);
+}
+
+static void
+_remove_effect_operation (GstElement *operation)
+{
+  GstObject *parent = gst_object_get_parent (GST_OBJECT (operation));
+
+  if (parent) {
+    gst_bin_remove (GST_BIN (parent), operation);
+    gst_object_unref (parent);
+  }
+  gst_object_unref (operation);
+}
+
+/* Replaces our effect operations with @operations, in the composition our
+ * nleobject is in, if any */
+static void
+_set_effect_operations (GESSource *self, GList *operations)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GstObject *parent = gst_object_get_parent (GST_OBJECT (priv->nleobject));
+  GList *tmp;
+
+  g_list_free_full (priv->effect_operations, (GDestroyNotify) _remove_effect_operation);
+  priv->effect_operations = operations;
+
+  if (parent && NLE_IS_COMPOSITION (parent)) {
+    for (tmp = operations; tmp; tmp = tmp->next)
+      gst_bin_add (GST_BIN (parent), tmp->data);
+  }
+  if (parent)
+    gst_object_unref (parent);
+
+  _sync_effect_operations (self);
+}
+
+static void
+_populate_cb (GstElement *nleobject, GESSource *self)
+{
+  _ensure_elements (self);
+}
+
+static void
+_make_nle_object (GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GstCaps *caps;
+  GESMediaType media_type;
+  GESSourceClass *klass = GES_SOURCE_GET_CLASS (self);
+
+  g_object_get (self, "media-type", &media_type, NULL);
+
+  if (!klass->make_element)
     return;
+
+  priv->nleobject = gst_object_ref_sink (gst_element_factory_make ("nlesource", NULL));
+
+  if (media_type == GES_MEDIA_TYPE_VIDEO)
+    caps = gst_caps_from_string(GES_RAW_VIDEO_CAPS);
+  else
+    caps = gst_caps_from_string(GES_RAW_AUDIO_CAPS);
+
+  g_object_set (priv->nleobject, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  /* The actual elements are only built once the composition needs them */
+  g_signal_connect (priv->nleobject, "populate", G_CALLBACK (_populate_cb), self);
+
+  g_signal_connect (priv->nleobject, "notify::start", G_CALLBACK (_nle_object_notify_cb), self);
+  g_signal_connect (priv->nleobject, "notify::duration", G_CALLBACK (_nle_object_notify_cb), self);
+  g_signal_connect (priv->nleobject, "notify::priority", G_CALLBACK (_nle_object_notify_cb), self);
+  g_signal_connect (priv->nleobject, "notify::active", G_CALLBACK (_nle_object_notify_cb), self);
 }
 
 static void
@@ -114,11 +778,19 @@ _expose_nle_object (GESSource *self)
   GstPad *pad;
   GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
 
+  GList *tmp;
+
   g_object_get (priv->nleobject, "composition", &priv->old_parent, NULL);
 
   if (priv->old_parent) {
     gst_object_ref (priv->nleobject);
     gst_bin_remove (GST_BIN (priv->old_parent), priv->nleobject);
+
+    /* They would apply to whatever else is in there */
+    for (tmp = priv->effect_operations; tmp; tmp = tmp->next) {
+      if (GST_OBJECT_PARENT (tmp->data) == priv->old_parent)
+        gst_bin_remove (GST_BIN (priv->old_parent), tmp->data);
+    }
   }
 
   gst_bin_add (GST_BIN (priv->playable_bin), priv->nleobject);
@@ -133,6 +805,7 @@ static void
 _unexpose_nle_object (GESSource *self)
 {
   GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GList *tmp;
 
   gst_ghost_pad_set_target (GST_GHOST_PAD (priv->ghostpad), NULL);
   gst_pad_set_active (GST_PAD (priv->ghostpad), FALSE);
@@ -141,6 +814,8 @@ _unexpose_nle_object (GESSource *self)
     gst_object_ref (priv->nleobject);
     gst_bin_remove (GST_BIN (priv->playable_bin), priv->nleobject);
     gst_bin_add (GST_BIN (priv->old_parent), priv->nleobject);
+    for (tmp = priv->effect_operations; tmp; tmp = tmp->next)
+      gst_bin_add (GST_BIN (priv->old_parent), tmp->data);
     gst_object_unref (priv->old_parent);
     priv->old_parent = NULL;
   }
@@ -194,6 +869,210 @@ ges_source_get_transition (GESSource *self)
   return priv->transition;
 }
 
+/**
+ * ges_source_add_effect:
+ * @self: a #GESSource
+ * @effect: the #GESEffect to apply after the ones already added
+ *
+ * Effects apply in a nleoperation above the source, for as long as it
+ * lasts. Consecutive per-pixel effects on video, that is videobalance
+ * without hue rotation, gamma and pixeltransform, get fused into a single
+ * operation, which goes over each frame once whatever their number.
+ *
+ * The effects only ever apply to @self, including while it overlaps with
+ * other sources of its track, whether they are mixed or blended by a
+ * transition.
+ *
+ * Returns: %FALSE if @effect deals with another media type than @self,
+ * or if @self would need more than 16 operations for its effects, in
+ * which case @effect isn't added.
+ */
+gboolean
+ges_source_add_effect (GESSource *self, GESEffect *effect)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  GList *operations;
+
+  GESMediaType media_type = ges_effect_get_media_type (effect);
+
+  g_return_val_if_fail (!g_list_find (priv->effects, effect), FALSE);
+
+  if (media_type && !(media_type & ges_object_get_media_type (GES_OBJECT (self))))
+    return FALSE;
+
+  priv->effects = g_list_append (priv->effects, g_object_ref (effect));
+
+  operations = _make_effect_operations (self);
+  if (g_list_length (operations) > MAX_EFFECT_OPERATIONS) {
+    GST_WARNING_OBJECT (self, "too many effects, not adding %s",
+        ges_effect_get_bin_description (effect));
+    g_list_free_full (operations, gst_object_unref);
+    priv->effects = g_list_remove (priv->effects, effect);
+    g_object_unref (effect);
+    return FALSE;
+  }
+
+  _set_effect_operations (self, operations);
+
+  return TRUE;
+}
+
+/**
+ * ges_source_remove_effect:
+ * @self: a #GESSource
+ * @effect: a #GESEffect added to @self
+ *
+ * Returns: %TRUE if @effect was applied to @self.
+ */
+gboolean
+ges_source_remove_effect (GESSource *self, GESEffect *effect)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+
+  if (!g_list_find (priv->effects, effect))
+    return FALSE;
+
+  priv->effects = g_list_remove (priv->effects, effect);
+  g_object_unref (effect);
+  _set_effect_operations (self, _make_effect_operations (self));
+
+  return TRUE;
+}
+
+/**
+ * ges_source_get_effects:
+ * @self: a #GESSource
+ *
+ * Returns: (transfer container) (element-type GESEffect): The effects of
+ * @self, in the order they apply
+ */
+GList *
+ges_source_get_effects (GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+
+  return g_list_copy (priv->effects);
+}
+
+void
+ges_source_set_zorder (GESSource *self, guint zorder)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+
+  g_mutex_lock (&priv->lock);
+  priv->zorder = zorder;
+  if (priv->controller && ges_object_get_media_type (GES_OBJECT (self)) == GES_MEDIA_TYPE_VIDEO)
+    g_object_set (priv->controller, "zorder", zorder, NULL);
+  g_mutex_unlock (&priv->lock);
+}
+
+void
+ges_source_set_restriction_caps (GESSource *self, GstCaps *caps)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  gboolean in_use;
+
+  g_mutex_lock (&priv->lock);
+  if (caps == priv->restriction_caps || (caps && priv->restriction_caps &&
+        gst_caps_is_equal (caps, priv->restriction_caps)))
+    goto done;
+
+  gst_caps_replace (&priv->restriction_caps, caps);
+  if (!priv->topbin)
+    goto done;
+
+  GST_OBJECT_LOCK (priv->nleobject);
+  in_use = GST_STATE (priv->nleobject) > GST_STATE_READY ||
+      GST_STATE_PENDING (priv->nleobject) != GST_STATE_VOID_PENDING;
+  GST_OBJECT_UNLOCK (priv->nleobject);
+
+  /* The elements needed might differ, let them get rebuilt when possible,
+   * otherwise renegotiate with what we have. Transitions hold control
+   * bindings on our elements */
+  if (!in_use && !priv->transition && _release_elements (self))
+    goto done;
+
+  if (priv->restriction_filter)
+    g_object_set (priv->restriction_filter, "caps", caps, NULL);
+  else
+    GST_WARNING_OBJECT (self, "elements in use, new restriction caps will only "
+        "apply once they get rebuilt");
+
+done:
+  g_mutex_unlock (&priv->lock);
+}
+
+/* Whether the frames of @self are shown full size at the origin of the
+ * output, fully opaque, as far as its framepositioner goes */
+gboolean
+ges_source_has_default_geometry (GESSource *self)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  static const gchar *properties[] = { "posx", "posy", "width", "height", "alpha", NULL };
+  gboolean ret = TRUE;
+  guint i;
+
+  g_mutex_lock (&priv->lock);
+  for (i = 0; ret && properties[i]; i++)
+    ret = _controller_property_is_default (self, properties[i]);
+  g_mutex_unlock (&priv->lock);
+
+  return ret;
+}
+
+/**
+ * ges_source_release_elements:
+ * @self: a #GESSource
+ * @idle_time: How long the elements must have been unused before
+ * being released
+ *
+ * The elements of a #GESSource are only built once they are needed,
+ * either because a composition is about to output @self, or because one
+ * of its children was looked up. This tears them down again if they
+ * haven't been in use for at least @idle_time, they will get rebuilt
+ * next time they are needed.
+ *
+ * Sources with a transition are never released. What was set on the
+ * children of @self, properties and control sources, is set again on
+ * the rebuilt ones.
+ *
+ * Returns: %TRUE if the elements were released.
+ */
+gboolean
+ges_source_release_elements (GESSource *self, GstClockTime idle_time)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
+  gboolean in_use, ret = FALSE;
+  gint64 now = g_get_monotonic_time ();
+
+  g_mutex_lock (&priv->lock);
+
+  /* Transitions hold control bindings on our elements */
+  if (!priv->topbin || priv->transition)
+    goto done;
+
+  GST_OBJECT_LOCK (priv->nleobject);
+  in_use = GST_STATE (priv->nleobject) > GST_STATE_READY ||
+      GST_STATE_PENDING (priv->nleobject) != GST_STATE_VOID_PENDING;
+  GST_OBJECT_UNLOCK (priv->nleobject);
+
+  if (in_use) {
+    priv->last_used = now;
+    goto done;
+  }
+
+  if ((now - priv->last_used) * GST_USECOND < idle_time)
+    goto done;
+
+  GST_DEBUG_OBJECT (self, "releasing elements, unused for %" GST_TIME_FORMAT,
+      GST_TIME_ARGS ((now - priv->last_used) * GST_USECOND));
+  ret = _release_elements (self);
+
+done:
+  g_mutex_unlock (&priv->lock);
+  return ret;
+}
+
 /* GESObject implementation */
 
 static gboolean
@@ -244,7 +1123,15 @@ _get_nle_objects (GESObject *object)
 {
   GESSourcePrivate *priv = GES_SOURCE_PRIV (object);
 
-  return g_list_append (NULL, priv->nleobject);
+  /* Our nleobject first, the timeline goes through it for our timings */
+  return g_list_concat (g_list_append (NULL, priv->nleobject),
+      g_list_copy (priv->effect_operations));
+}
+
+static void
+_ensure_children (GESObject *object)
+{
+  _ensure_elements (GES_SOURCE (object));
 }
 
 static gboolean
@@ -278,13 +1165,40 @@ _dispose (GObject *object)
   GESSource *self = GES_SOURCE (object);
   GESSourcePrivate *priv = GES_SOURCE_PRIV (self);
 
-  if (priv->static_sinkpad)
+  if (priv->static_sinkpad) {
     gst_object_unref (priv->static_sinkpad);
+    priv->static_sinkpad = NULL;
+  }
+
+  g_list_free_full (priv->effect_operations, (GDestroyNotify) _remove_effect_operation);
+  priv->effect_operations = NULL;
+  g_list_free_full (priv->effects, g_object_unref);
+  priv->effects = NULL;
+
+  if (priv->nleobject) {
+    g_signal_handlers_disconnect_by_func (priv->nleobject, _populate_cb, self);
+    g_signal_handlers_disconnect_by_func (priv->nleobject, _nle_object_notify_cb, self);
+    gst_object_unref (priv->nleobject);
+    priv->nleobject = NULL;
+  }
 
   gst_object_unref (priv->playable_bin);
   G_OBJECT_CLASS (ges_source_parent_class)->dispose (object);
 }
 
+static void
+_finalize (GObject *object)
+{
+  GESSourcePrivate *priv = GES_SOURCE_PRIV (object);
+
+  g_mutex_clear (&priv->lock);
+  gst_caps_replace (&priv->restriction_caps, NULL);
+  if (priv->controller_properties)
+    gst_structure_free (priv->controller_properties);
+  g_list_free_full (priv->controller_bindings, (GDestroyNotify) _free_saved_binding);
+  G_OBJECT_CLASS (ges_source_parent_class)->finalize (object);
+}
+
 static void
 _constructed (GObject *object)
 {
@@ -299,6 +1213,7 @@ ges_source_class_init (GESSourceClass *klass)
   GESObjectClass *ges_object_class = GES_OBJECT_CLASS (klass);
 
   g_object_class->dispose = _dispose;
+  g_object_class->finalize = _finalize;
   g_object_class->constructed = _constructed;
 
   ges_object_class->set_start = _set_start;
@@ -307,6 +1222,7 @@ ges_source_class_init (GESSourceClass *klass)
   ges_object_class->set_media_type = _set_media_type;
   ges_object_class->set_track_index = _set_track_index;
   ges_object_class->get_nle_objects = _get_nle_objects;
+  ges_object_class->ensure_children = _ensure_children;
 }
 
 static void
@@ -318,6 +1234,17 @@ ges_source_init (GESSource *self)
   priv->old_parent = NULL;
   priv->playable_bin = gst_object_ref_sink (gst_bin_new (NULL));
   priv->transition = NULL;
+  priv->effects = NULL;
+  priv->effect_operations = NULL;
+  priv->topbin = NULL;
+  priv->controller = NULL;
+  priv->zorder = 0;
+  priv->last_used = 0;
+  priv->controller_properties = NULL;
+  priv->controller_bindings = NULL;
+  priv->restriction_caps = NULL;
+  priv->restriction_filter = NULL;
+  g_mutex_init (&priv->lock);
   padname = g_strdup_printf ("source_%p_src", priv->nleobject);
   priv->ghostpad = gst_ghost_pad_new_no_target (padname, GST_PAD_SRC);
   g_free (padname);
@@ -4,6 +4,7 @@
 #include <gst/gst.h>
 #include <ges-object.h>
 #include <ges-transition.h>
+#include <ges-effect.h>
 
 G_BEGIN_DECLS
 
@@ -15,10 +16,17 @@ struct _GESSourceClass
 {
   GESObjectClass parent;
   GstElement *(*make_element) (GESSource *source);
+  /* What the element is expected to output, when known. Lets the source
+   * skip the conversions it doesn't need */
+  GstCaps *(*get_stream_caps) (GESSource *source);
 };
 
 gboolean ges_source_set_transition (GESSource *source, GESTransition *transition);
 GESTransition *ges_source_get_transition (GESSource *source);
+gboolean ges_source_release_elements (GESSource *source, GstClockTime idle_time);
+gboolean ges_source_add_effect (GESSource *source, GESEffect *effect);
+gboolean ges_source_remove_effect (GESSource *source, GESEffect *effect);
+GList *ges_source_get_effects (GESSource *source);
 
 G_END_DECLS
 
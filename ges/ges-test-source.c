@@ -102,6 +102,8 @@ _make_element (GESSource *source)
     return NULL;
   }
 
+  /* Our elements get released when unused, see ges_source_release_elements */
+  g_object_add_weak_pointer (G_OBJECT (priv->testsrc), (gpointer *) &priv->testsrc);
   _set_pattern (GES_TEST_SOURCE (source));
   return priv->testsrc;
 }
@@ -171,6 +173,10 @@ _dispose (GObject *object)
   if (priv->pattern)
     g_free (priv->pattern);
 
+  if (priv->testsrc)
+    g_object_remove_weak_pointer (G_OBJECT (priv->testsrc), (gpointer *) &priv->testsrc);
+  priv->testsrc = NULL;
+
   G_OBJECT_CLASS (ges_test_source_parent_class)->dispose (object);
 }
 
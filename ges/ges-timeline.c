@@ -7,8 +7,30 @@
 #include "ges-source.h"
 #include "ges-internal.h"
 
+#include <string.h>
+#include <gio/gio.h>
+
 /* Structure definitions */
 
+/* Sources whose elements weren't used for that long get them released
+ * on commit, see ges_source_release_elements */
+#define SOURCE_RELEASE_IDLE_TIME (30 * GST_SECOND)
+
+/* See ges_timeline_save_to_file for a description of the format */
+#define PROJECT_FILE_MAGIC "GESPRJ\0\0"
+#define PROJECT_FILE_HEADER_SIZE 8
+#define PROJECT_FORMAT_VERSION 1
+#define PROJECT_FORMAT "(uasa(uutttuu)amv)"
+
+/* What a composition outputs, and the elements that need to know about
+ * it, see ges_timeline_set_restriction_caps */
+typedef struct
+{
+  GstCaps *caps;
+  GstElement *mixer;
+  GstElement *background_filter;
+} OutputFormat;
+
 typedef struct _GESTimelinePrivate
 {
   GList *compositions;
@@ -17,6 +39,35 @@ typedef struct _GESTimelinePrivate
   GESCompositionBin *composition_bin;
   /* Tracks sorted by media-type */
   GHashTable *tracks;
+  /* Nesting level of ges_timeline_begin_edit calls */
+  guint edit_depth;
+  OutputFormat video_format;
+  OutputFormat audio_format;
+
+  /* See ges_timeline_commit_async */
+  GMainContext *commit_context;
+  guint commit_source_id;
+  /* Tasks served by the next commit, and by the one in flight */
+  GList *queued_commits;
+  GList *running_commits;
+  gint64 queued_commit_time;
+  gint64 running_commit_time;
+  GstClockTime last_commit_latency;
+  /* Compositions that didn't report the commit in flight as done yet,
+   * mapped to the serial it got there, and all of them mapped to the
+   * serial of the last commit they reported. Protected by commit_lock as
+   * they report it from their own thread */
+  GMutex commit_lock;
+  GHashTable *committing_compositions;
+  GHashTable *commited_serials;
+
+  /* The timeline we are flattened into, if any, and what gets added to
+   * the priorities of our sources there, see _flatten_nested_timelines */
+  GESTimeline *flattened_into;
+  guint priority_offset;
+  /* The sources of nested timelines inlined in our compositions, mapped
+   * to the timeline they are in */
+  GHashTable *flattened_sources;
 } GESTimelinePrivate;
 
 struct _GESTimeline
@@ -25,13 +76,36 @@ struct _GESTimeline
   GESTimelinePrivate *priv;
 };
 
+/* The part of a nested timeline that is visible in the root timeline */
+typedef struct
+{
+  /* Where the window starts in the root timeline */
+  GstClockTime start;
+  /* Where the window starts in the nested timeline, and its length */
+  GstClockTime inpoint;
+  GstClockTime duration;
+} NestingWindow;
+
+/* State of a pass flattening nested timelines into a root timeline */
+typedef struct
+{
+  GESTimeline *root;
+  /* The sources inlined by the pass, mapped to the timeline they are in */
+  GHashTable *sources;
+  /* Where the priorities of the next nested timeline start */
+  guint next_priority_offset;
+} FlattenPass;
+
 /* Used to create and update transitions */
 typedef struct
 {
   GSequence *objects_by_start;
   GESObject *prev;
   GESTimeline *timeline;
+  GESMediaType media_type;
   guint current_zorder;
+  /* Where the last source of each lane stops */
+  GArray *lane_stops;
 } GESTrack;
 
 enum
@@ -44,10 +118,12 @@ enum
 {
   TRANSITION_ADDED,
   TRANSITION_REMOVED,
+  OBJECT_ADDED,
   LAST_SIGNAL
 };
 
 static void ges_playable_interface_init (GESPlayableInterface * iface);
+static void _composition_commited_cb (GstElement *composition, gboolean changed, GESTimeline *self);
 static guint ges_timeline_signals[LAST_SIGNAL] = { 0 };
 
 G_DEFINE_TYPE_WITH_CODE (GESTimeline, ges_timeline, GES_TYPE_OBJECT,
@@ -96,7 +172,7 @@ _get_first_composition (GESTimeline *self, GESMediaType media_type)
   return res;
 }
 
-static void
+static GstElement *
 _add_expandable_operation (GstElement *composition, const gchar *element_name, guint priority, const gchar *name)
 {
   GstElement *expandable = gst_element_factory_make ("nleoperation", name);
@@ -106,6 +182,8 @@ _add_expandable_operation (GstElement *composition, const gchar *element_name, g
 
   g_object_set (expandable, "expandable", TRUE, "priority", priority, NULL);
   gst_bin_add (GST_BIN (composition), expandable);
+
+  return element;
 }
 
 static void
@@ -132,6 +210,7 @@ _create_composition (GESTimeline *self, const gchar *caps_string, const gchar *n
   gst_caps_unref (caps);
 
   gst_bin_add (GST_BIN (wrapper), composition);
+  g_signal_connect (composition, "commited", G_CALLBACK (_composition_commited_cb), self);
 
   self->priv->compositions = g_list_append (self->priv->compositions, composition);
   self->priv->nleobjects = g_list_append (self->priv->nleobjects, wrapper);
@@ -146,7 +225,9 @@ _add_track (GESTimeline *self, GESMediaType media_type)
   GList *tracks = g_hash_table_lookup (self->priv->tracks, GINT_TO_POINTER (media_type));
 
   track->objects_by_start = g_sequence_new (NULL);
+  track->lane_stops = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
   track->timeline = self;
+  track->media_type = media_type;
   tracks = g_list_append (tracks, track);
   g_hash_table_replace (self->priv->tracks, GINT_TO_POINTER (media_type), tracks);
 }
@@ -155,6 +236,7 @@ static void
 _free_track (GESTrack *track)
 {
   g_sequence_free (track->objects_by_start);
+  g_array_free (track->lane_stops, TRUE);
   g_free (track);
 }
 
@@ -171,30 +253,101 @@ _make_nle_objects (GESTimeline *self, GESMediaType media_type)
 
   if (media_type & GES_MEDIA_TYPE_AUDIO) {
     GstElement *background = gst_parse_bin_from_description (
-        "audiotestsrc ! samplecontroller name=background_audio_controller", TRUE, NULL);
+        "backgroundsrc ! capsfilter name=background_audio_filter ! "
+        "samplecontroller name=background_audio_controller", TRUE, NULL);
     GstElement *samplecontroller = gst_bin_get_by_name (GST_BIN (background), "background_audio_controller");
     g_object_set (samplecontroller, "volume", 0.0, NULL);
     gst_object_unref (samplecontroller);
+    self->priv->audio_format.background_filter = gst_bin_get_by_name (GST_BIN (background),
+        "background_audio_filter");
+    gst_object_unref (self->priv->audio_format.background_filter);
     composition = _create_composition (self, GES_RAW_AUDIO_CAPS, "audio-composition");
-    _add_expandable_operation (composition, "smartaudiomixer", 0, "timeline-audiomixer");
+    self->priv->audio_format.mixer = _add_expandable_operation (composition,
+        "smartaudiomixer", 0, "timeline-audiomixer");
     _add_expandable_source (composition, background, 1, "timeline-audio-background");
     _add_track (self, GES_MEDIA_TYPE_AUDIO);
   }
 
   if (media_type & GES_MEDIA_TYPE_VIDEO) {
     GstElement *background = gst_parse_bin_from_description (
-        "videotestsrc pattern=checkers-8 ! framepositioner name=background_video_positioner", TRUE, NULL);
+        "backgroundsrc ! capsfilter name=background_video_filter ! "
+        "framepositioner name=background_video_positioner", TRUE, NULL);
     GstElement *pos = gst_bin_get_by_name (GST_BIN (background), "background_video_positioner");
     g_object_set (pos, "alpha", 0.0, "zorder", 0, NULL);
     gst_object_unref (pos);
+    self->priv->video_format.background_filter = gst_bin_get_by_name (GST_BIN (background),
+        "background_video_filter");
+    gst_object_unref (self->priv->video_format.background_filter);
     composition = _create_composition (self, GES_RAW_VIDEO_CAPS, "video-composition");
-    _add_expandable_operation (composition, "smartvideomixer", 0, "timeline-videomixer");
+    self->priv->video_format.mixer = _add_expandable_operation (composition,
+        "smartvideomixer", 0, "timeline-videomixer");
     _add_expandable_source (composition, background, 1, "timeline-video-background");
     _add_track (self, GES_MEDIA_TYPE_VIDEO);
   }
 }
 
- static gint
+static OutputFormat *
+_get_output_format (GESTimeline *self, GESMediaType media_type)
+{
+  if (media_type == GES_MEDIA_TYPE_VIDEO)
+    return &self->priv->video_format;
+  else if (media_type == GES_MEDIA_TYPE_AUDIO)
+    return &self->priv->audio_format;
+
+  return NULL;
+}
+
+static void
+_set_sources_restriction_caps (GESTimeline *self, GESMediaType media_type, GstCaps *caps)
+{
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (self->priv->object_by_start);
+      !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+    GESObject *object = g_sequence_get (iter);
+
+    if (GES_IS_SOURCE (object) && ges_object_get_media_type (object) == media_type)
+      ges_source_set_restriction_caps (GES_SOURCE (object), caps);
+  }
+}
+
+/* Makes everything that outputs @media_type in @self agree on its
+ * output format */
+static void
+_apply_output_format (GESTimeline *self, GESMediaType media_type)
+{
+  OutputFormat *format = _get_output_format (self, media_type);
+  GList *compositions = _get_compositions (self, media_type), *tmp;
+  GstCaps *caps;
+
+  if (format->caps)
+    caps = gst_caps_ref (format->caps);
+  else if (media_type == GES_MEDIA_TYPE_VIDEO)
+    caps = gst_caps_from_string (GES_RAW_VIDEO_CAPS);
+  else
+    caps = gst_caps_from_string (GES_RAW_AUDIO_CAPS);
+
+  for (tmp = compositions; tmp; tmp = tmp->next) {
+    GstObject *wrapper = gst_object_get_parent (GST_OBJECT (tmp->data));
+
+    g_object_set (tmp->data, "caps", caps, NULL);
+    if (wrapper) {
+      g_object_set (wrapper, "caps", caps, NULL);
+      gst_object_unref (wrapper);
+    }
+  }
+  g_list_free (compositions);
+
+  if (format->mixer)
+    g_object_set (format->mixer, "caps", format->caps, NULL);
+  if (format->background_filter)
+    g_object_set (format->background_filter, "caps", caps, NULL);
+
+  _set_sources_restriction_caps (self, media_type, format->caps);
+  gst_caps_unref (caps);
+}
+
+static gint
 _compare_starts (GESObject *object1, GESObject *object2, gpointer unused)
 {
   GstClockTime start1, start2;
@@ -225,13 +378,65 @@ _remove_transition (GESTimeline *self, GESSource *source)
   g_object_unref (transition);
 }
 
+/* The composition @prev can be crossfaded to @next in, with a single
+ * blend, or NULL if the crossfade element can't deal with what sources
+ * output, or if they aren't both covering the whole output, opaque, in
+ * which case their alpha or volume has to be animated instead */
+static GstElement *
+_get_crossfade_composition (GESTimeline *self, GESObject *prev, GESObject *next)
+{
+  OutputFormat *format = &self->priv->video_format;
+  GstElementFactory *factory;
+  GstElement *composition = NULL;
+  GList *nleobjects;
+  gboolean supported;
+
+  if (ges_object_get_media_type (prev) != GES_MEDIA_TYPE_VIDEO || !format->caps
+      || !gst_caps_is_fixed (format->caps))
+    return NULL;
+
+  factory = gst_element_factory_find ("crossfade");
+  if (!factory)
+    return NULL;
+  supported = gst_element_factory_can_sink_all_caps (factory, format->caps);
+  gst_object_unref (factory);
+  if (!supported)
+    return NULL;
+
+  if (!ges_source_has_default_geometry (GES_SOURCE (prev)) ||
+      !ges_source_has_default_geometry (GES_SOURCE (next)))
+    return NULL;
+
+  nleobjects = ges_object_get_nle_objects (prev);
+  if (nleobjects)
+    g_object_get (nleobjects->data, "composition", &composition, NULL);
+  g_list_free (nleobjects);
+
+  return composition;
+}
+
+static GESTransition *
+_new_transition (GESTimeline *self, GESObject *prev, GESObject *next)
+{
+  GstElement *composition = _get_crossfade_composition (self, prev, next);
+  GESTransition *transition;
+
+  if (!composition)
+    return ges_transition_new (prev, next);
+
+  transition = ges_transition_new_crossfade (prev, next, composition);
+  gst_object_unref (composition);
+
+  return transition;
+}
+
 static void
 _create_or_update_transition (GESTimeline *self, GESObject *prev, GESObject *next)
 {
   GESTransition *transition = ges_source_get_transition (GES_SOURCE (prev));
 
   if (!transition) {
-    transition = ges_transition_new (prev, next);
+    transition = _new_transition (self, prev, next);
 
     ges_source_set_transition (GES_SOURCE (prev), transition);
     GST_ERROR_OBJECT (self, "added a transition");
@@ -239,13 +444,17 @@ _create_or_update_transition (GESTimeline *self, GESObject *prev, GESObject *nex
         transition);
   } else {
     GESObject *faded_in_source;
+    GstElement *composition, *crossfade_composition;
 
-    g_object_get (transition, "faded-in-source", &faded_in_source, NULL);
+    g_object_get (transition, "faded-in-source", &faded_in_source,
+        "composition", &composition, NULL);
+    crossfade_composition = _get_crossfade_composition (self, prev, next);
 
-    if (faded_in_source != next)  {
+    /* Also recreated when the output format changed what it can use */
+    if (faded_in_source != next || composition != crossfade_composition)  {
       _remove_transition (self, GES_SOURCE (prev));
 
-      transition = ges_transition_new (prev, next);
+      transition = _new_transition (self, prev, next);
       ges_source_set_transition (GES_SOURCE (prev), transition);
       g_signal_emit (self, ges_timeline_signals[TRANSITION_ADDED], 0,
           transition);
@@ -253,6 +462,10 @@ _create_or_update_transition (GESTimeline *self, GESObject *prev, GESObject *nex
       ges_transition_update (transition);
     }
     g_object_unref (faded_in_source);
+    if (composition)
+      gst_object_unref (composition);
+    if (crossfade_composition)
+      gst_object_unref (crossfade_composition);
   }
 }
 
@@ -265,15 +478,92 @@ _set_zorder (GESObject *object, guint zorder)
   if (ges_object_get_media_type (object) != GES_MEDIA_TYPE_VIDEO)
     return;
 
+  /* Don't force sources to build their elements just for that */
+  if (GES_IS_SOURCE (object)) {
+    ges_source_set_zorder (GES_SOURCE (object), zorder);
+    return;
+  }
+
   gst_child_proxy_lookup (GST_CHILD_PROXY (object),
         "framepositioner::alpha", &pos, &pspec);
 
   g_object_set (pos, "zorder", zorder, NULL);
 }
 
+static guint
+_get_track_priority (GESObject *object, GESMediaType media_type)
+{
+  guint track_index = media_type == GES_MEDIA_TYPE_AUDIO ?
+      ges_object_get_audio_track_index (object) :
+      ges_object_get_video_track_index (object);
+
+  return (TRACK_PRIORITY_HEIGHT * track_index) + TIMELINE_PRIORITY_OFFSET;
+}
+
+/* Puts @object in the first lane of @track that is free at its start, so
+ * that the operations of overlapping sources never stack on each other */
+static void
+_assign_lane (GESObject *object, GESTrack *track)
+{
+  GESMediaType media_type = ges_object_get_media_type (object);
+  GstClockTime start = ges_object_get_start (object);
+  GList *nleobjects = ges_object_get_nle_objects (object);
+  guint lane, priority, new_priority;
+
+  for (lane = 0; lane < track->lane_stops->len; lane++) {
+    if (g_array_index (track->lane_stops, GstClockTime, lane) <= start)
+      break;
+  }
+
+  if (lane >= MAX_SOURCE_LANES) {
+    GST_WARNING_OBJECT (track->timeline, "more than %d sources overlapping, "
+        "their effects will get mixed up", MAX_SOURCE_LANES);
+    lane = MAX_SOURCE_LANES - 1;
+  }
+
+  if (lane == track->lane_stops->len)
+    g_array_set_size (track->lane_stops, lane + 1);
+  g_array_index (track->lane_stops, GstClockTime, lane) =
+      start + ges_object_get_duration (object);
+
+  if (!nleobjects)
+    return;
+
+  /* Our effect operations follow */
+  new_priority = track->timeline->priv->priority_offset +
+      _get_track_priority (object, media_type) + lane * SOURCE_PRIORITY_HEIGHT;
+  g_object_get (nleobjects->data, "priority", &priority, NULL);
+  if (priority != new_priority)
+    g_object_set (nleobjects->data, "priority", new_priority, NULL);
+  g_list_free (nleobjects);
+}
+
+static guint _update_transitions_for_media_type (GESTimeline *self,
+    GESMediaType media_type, guint zorder);
+
 static void
 _check_transition (GESObject *object, GESTrack *track)
 {
+  /* The sources of flattened timelines stack where the timeline is */
+  if (GES_IS_TIMELINE (object)) {
+    GESTimeline *nested = GES_TIMELINE (object);
+
+    if (nested->priv->flattened_into)
+      track->current_zorder = _update_transitions_for_media_type (nested,
+          track->media_type, track->current_zorder);
+    return;
+  }
+
+  if (!GES_IS_SOURCE (object))
+    return;
+
+  /* Not visible where we are flattened */
+  if (track->timeline->priv->flattened_into && !g_hash_table_contains (
+        track->timeline->priv->flattened_into->priv->flattened_sources, object))
+    return;
+
+  _assign_lane (object, track);
+
   track->current_zorder -= 1;
   _set_zorder (object, track->current_zorder);
   if (!track->prev) {
@@ -292,41 +582,255 @@ _check_transition (GESObject *object, GESTrack *track)
   track->prev = object;
 }
 
-static void
-_update_transitions_for_track (GESTrack *track, guint track_index)
+/* Returns the last zorder given to the sources of @track */
+static guint
+_update_transitions_for_track (GESTrack *track, guint zorder)
 {
   GST_ERROR ("updating transitions for one track");
 
   g_sequence_sort (track->objects_by_start, (GCompareDataFunc) _compare_starts, NULL);
   track->prev = NULL;
-  track->current_zorder = G_MAXUINT - (track_index * 10000) - 1;
+  track->current_zorder = zorder;
+  g_array_set_size (track->lane_stops, 0);
   g_sequence_foreach (track->objects_by_start, (GFunc) _check_transition, track);
   if (track->prev)
     _remove_transition (track->timeline, GES_SOURCE (track->prev));
+
+  return track->current_zorder;
 }
 
-static void
-_update_transitions_for_media_type (GESTimeline *self, GESMediaType media_type)
+/* The tracks of the root timeline each get a range of zorders, the ones of
+ * flattened timelines follow each other from @zorder down */
+static guint
+_update_transitions_for_media_type (GESTimeline *self, GESMediaType media_type, guint zorder)
 {
   GList *tracks = g_hash_table_lookup (self->priv->tracks, GINT_TO_POINTER (media_type));
   guint track_index = 0;
 
-  if (!tracks)
-    return;
-
   for (; tracks; tracks = tracks->next) {
     GESTrack *track = (GESTrack *) tracks->data;
 
-    _update_transitions_for_track (track, track_index);
+    if (!self->priv->flattened_into)
+      zorder = G_MAXUINT - (track_index * 10000) - 1;
+    zorder = _update_transitions_for_track (track, zorder);
     track_index += 1;
   }
+
+  return zorder;
 }
 
 static void
 _update_transitions (GESTimeline *self)
 {
-  _update_transitions_for_media_type (self, GES_MEDIA_TYPE_VIDEO);
-  _update_transitions_for_media_type (self, GES_MEDIA_TYPE_AUDIO);
+  _update_transitions_for_media_type (self, GES_MEDIA_TYPE_VIDEO, G_MAXUINT - 1);
+  _update_transitions_for_media_type (self, GES_MEDIA_TYPE_AUDIO, G_MAXUINT - 1);
+}
+
+/* Returns FALSE if @object is entirely outside of @parent */
+static gboolean
+_get_nesting_window (GESObject *object, NestingWindow *parent, NestingWindow *window)
+{
+  GstClockTime start = ges_object_get_start (object);
+  GstClockTime stop = start + ges_object_get_duration (object);
+  GstClockTime inpoint = ges_object_get_inpoint (object);
+  GstClockTime visible_start = MAX (start, parent->inpoint);
+  GstClockTime visible_stop = MIN (stop, parent->inpoint + parent->duration);
+
+  if (visible_start >= visible_stop)
+    return FALSE;
+
+  if (!GST_CLOCK_TIME_IS_VALID (inpoint))
+    inpoint = 0;
+
+  window->start = parent->start + (visible_start - parent->inpoint);
+  window->inpoint = inpoint + (visible_start - start);
+  window->duration = visible_stop - visible_start;
+
+  return TRUE;
+}
+
+static void
+_set_nle_objects_active (GESObject *object, gboolean active)
+{
+  GList *nleobjects = ges_object_get_nle_objects (object), *tmp;
+
+  for (tmp = nleobjects; tmp; tmp = tmp->next)
+    g_object_set (tmp->data, "active", active, NULL);
+
+  g_list_free (nleobjects);
+}
+
+/* Its effect operations come along */
+static void
+_move_nle_objects (GList *nleobjects, GstElement *composition)
+{
+  GstElement *parent;
+
+  for (; nleobjects; nleobjects = nleobjects->next) {
+    g_object_get (nleobjects->data, "composition", &parent, NULL);
+    if (parent != composition) {
+      GST_DEBUG_OBJECT (composition, "moving %" GST_PTR_FORMAT, nleobjects->data);
+      gst_object_ref (nleobjects->data);
+      if (parent)
+        gst_bin_remove (GST_BIN (parent), nleobjects->data);
+      gst_bin_add (GST_BIN (composition), nleobjects->data);
+      gst_object_unref (nleobjects->data);
+    }
+    if (parent)
+      gst_object_unref (parent);
+  }
+}
+
+static void
+_flatten_source (FlattenPass *pass, GESTimeline *nested, GESSource *source,
+    NestingWindow *window)
+{
+  GESMediaType media_type = ges_object_get_media_type (GES_OBJECT (source));
+  GList *nleobjects = ges_object_get_nle_objects (GES_OBJECT (source));
+  GstElement *composition;
+
+  composition = _get_first_composition (pass->root, media_type);
+  if (!nleobjects || !composition) {
+    g_list_free (nleobjects);
+    return;
+  }
+
+  /* It gets mixed with our sources, so it has to output what they do */
+  ges_source_set_restriction_caps (source, _get_output_format (pass->root, media_type)->caps);
+  _move_nle_objects (nleobjects, composition);
+
+  /* Its priority and zorder are set by the transition pass of @nested */
+  g_object_set (nleobjects->data, "start", window->start, "inpoint", window->inpoint,
+      "duration", window->duration, "active", TRUE, NULL);
+  g_list_free (nleobjects);
+
+  g_hash_table_insert (pass->sources, g_object_ref (source), g_object_ref (nested));
+}
+
+/* Gives @source back to @owner, the timeline it is in, once it stopped
+ * being flattened */
+static void
+_restore_source (GESSource *source, GESTimeline *owner)
+{
+  GESObject *object = GES_OBJECT (source);
+  GESMediaType media_type = ges_object_get_media_type (object);
+  GList *nleobjects = ges_object_get_nle_objects (object);
+  GstElement *composition = _get_first_composition (owner, media_type);
+  GstClockTime inpoint = ges_object_get_inpoint (object);
+
+  if (!nleobjects || !composition) {
+    g_list_free (nleobjects);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (owner, "restoring %" GST_PTR_FORMAT, source);
+
+  /* Its crossfade operation was added to the composition it was in */
+  _remove_transition (owner, source);
+  ges_source_set_restriction_caps (source, _get_output_format (owner, media_type)->caps);
+  _move_nle_objects (nleobjects, composition);
+
+  if (!GST_CLOCK_TIME_IS_VALID (inpoint))
+    inpoint = 0;
+  g_object_set (nleobjects->data, "start", ges_object_get_start (object),
+      "inpoint", inpoint, "duration", ges_object_get_duration (object),
+      "priority", _get_track_priority (object, media_type), "active", TRUE, NULL);
+  g_list_free (nleobjects);
+}
+
+static void
+_unset_flattened (GESTimeline *self)
+{
+  self->priv->flattened_into = NULL;
+  self->priv->priority_offset = 0;
+}
+
+static guint
+_get_n_tracks (GESTimeline *self)
+{
+  GList *video_tracks = g_hash_table_lookup (self->priv->tracks, GINT_TO_POINTER (GES_MEDIA_TYPE_VIDEO));
+  GList *audio_tracks = g_hash_table_lookup (self->priv->tracks, GINT_TO_POINTER (GES_MEDIA_TYPE_AUDIO));
+
+  return MAX (g_list_length (video_tracks), g_list_length (audio_tracks));
+}
+
+/* Moves the sources of @nested, and of the timelines nested in it, into
+ * the compositions of the root timeline, with their timings mapped through
+ * @window and their priorities in a range @nested reserves for its tracks */
+static void
+_flatten_timeline (FlattenPass *pass, GESTimeline *nested, NestingWindow *window)
+{
+  GSequenceIter *iter;
+
+  nested->priv->flattened_into = pass->root;
+  nested->priv->priority_offset = pass->next_priority_offset;
+  pass->next_priority_offset += _get_n_tracks (nested) * TRACK_PRIORITY_HEIGHT;
+
+  /* Its own compositions are left with nothing but the background */
+  _set_nle_objects_active (GES_OBJECT (nested), FALSE);
+
+  for (iter = g_sequence_get_begin_iter (nested->priv->object_by_start);
+      !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+    GESObject *object = g_sequence_get (iter);
+    NestingWindow object_window;
+
+    if (!_get_nesting_window (object, window, &object_window)) {
+      /* Sources are given back to @nested after the pass */
+      if (GES_IS_TIMELINE (object)) {
+        _unset_flattened (GES_TIMELINE (object));
+        _set_nle_objects_active (object, FALSE);
+      }
+      continue;
+    }
+
+    if (GES_IS_TIMELINE (object))
+      _flatten_timeline (pass, GES_TIMELINE (object), &object_window);
+    else if (GES_IS_SOURCE (object))
+      _flatten_source (pass, nested, GES_SOURCE (object), &object_window);
+  }
+}
+
+/* Each nested timeline gets a range of priorities above ours, so that the
+ * effect operations of its sources stay on them, and gets its transitions
+ * updated when we update ours. The sources that aren't visible anymore
+ * go back to the timeline they are in */
+static void
+_flatten_nested_timelines (GESTimeline *self)
+{
+  GSequenceIter *iter;
+  GHashTableIter sources_iter;
+  gpointer source, owner;
+  NestingWindow root = { 0, 0, G_MAXUINT64 };
+  FlattenPass pass;
+
+  pass.root = self;
+  pass.sources = g_hash_table_new_full (NULL, NULL, g_object_unref, g_object_unref);
+  pass.next_priority_offset = _get_n_tracks (self) * TRACK_PRIORITY_HEIGHT;
+
+  for (iter = g_sequence_get_begin_iter (self->priv->object_by_start);
+      !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+    GESObject *object = g_sequence_get (iter);
+    NestingWindow window;
+
+    if (!GES_IS_TIMELINE (object))
+      continue;
+
+    if (_get_nesting_window (object, &root, &window)) {
+      _flatten_timeline (&pass, GES_TIMELINE (object), &window);
+    } else {
+      _unset_flattened (GES_TIMELINE (object));
+      _set_nle_objects_active (object, FALSE);
+    }
+  }
+
+  g_hash_table_iter_init (&sources_iter, self->priv->flattened_sources);
+  while (g_hash_table_iter_next (&sources_iter, &source, &owner)) {
+    if (!g_hash_table_contains (pass.sources, source))
+      _restore_source (GES_SOURCE (source), GES_TIMELINE (owner));
+  }
+
+  g_hash_table_unref (self->priv->flattened_sources);
+  self->priv->flattened_sources = pass.sources;
 }
 
 typedef struct
@@ -482,6 +986,147 @@ _set_media_type (GESObject *object, GESMediaType media_type)
   return TRUE;
 }
 
+static GVariant *
+_serialize (GESObject *object)
+{
+  GESTimeline *self = GES_TIMELINE (object);
+  GVariantBuilder type_names, objects, subclass_variants;
+  GHashTable *type_indexes = g_hash_table_new (g_str_hash, g_str_equal);
+  GSequenceIter *iter;
+  guint n_types = 0;
+
+  g_variant_builder_init (&type_names, G_VARIANT_TYPE_STRING_ARRAY);
+  g_variant_builder_init (&objects, G_VARIANT_TYPE ("a(uutttuu)"));
+  g_variant_builder_init (&subclass_variants, G_VARIANT_TYPE ("amv"));
+
+  for (iter = g_sequence_get_begin_iter (self->priv->object_by_start);
+      !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+    GESObject *child = g_sequence_get (iter);
+    GESObjectClass *klass = GES_OBJECT_GET_CLASS (child);
+    const gchar *type_name = G_OBJECT_TYPE_NAME (child);
+    gpointer type_index;
+
+    if (!g_hash_table_lookup_extended (type_indexes, type_name, NULL, &type_index)) {
+      type_index = GUINT_TO_POINTER (n_types++);
+      g_hash_table_insert (type_indexes, (gpointer) type_name, type_index);
+      g_variant_builder_add (&type_names, "s", type_name);
+    }
+
+    g_variant_builder_add (&objects, "(uutttuu)",
+        GPOINTER_TO_UINT (type_index),
+        ges_object_get_media_type (child),
+        ges_object_get_inpoint (child),
+        ges_object_get_duration (child),
+        ges_object_get_start (child),
+        ges_object_get_video_track_index (child),
+        ges_object_get_audio_track_index (child));
+    g_variant_builder_add (&subclass_variants, "mv",
+        klass->serialize ? klass->serialize (child) : NULL);
+  }
+
+  g_hash_table_unref (type_indexes);
+
+  return g_variant_new (PROJECT_FORMAT, PROJECT_FORMAT_VERSION,
+      &type_names, &objects, &subclass_variants);
+}
+
+static GVariant *
+_get_subclass_variant (GVariant *subclass_variants, gsize index)
+{
+  GVariant *maybe, *res = NULL;
+
+  maybe = g_variant_get_child_value (subclass_variants, index);
+  if (g_variant_n_children (maybe)) {
+    GVariant *boxed = g_variant_get_child_value (maybe, 0);
+    res = g_variant_get_variant (boxed);
+    g_variant_unref (boxed);
+  }
+  g_variant_unref (maybe);
+
+  return res;
+}
+
+static gboolean
+_deserialize (GESObject *object, GVariant *variant)
+{
+  GESTimeline *self = GES_TIMELINE (object);
+  GVariant *type_names_variant, *objects, *subclass_variants;
+  const gchar **type_names;
+  gsize n_types, n_objects, i;
+  GPtrArray *uris;
+  guint version;
+
+  if (!variant || !g_variant_is_of_type (variant, G_VARIANT_TYPE (PROJECT_FORMAT))) {
+    GST_ERROR_OBJECT (self, "not a serialized timeline");
+    return FALSE;
+  }
+
+  GET_FROM_TUPLE (variant, uint32, 0, &version);
+  if (version != PROJECT_FORMAT_VERSION) {
+    GST_ERROR_OBJECT (self, "unsupported project format version %u", version);
+    return FALSE;
+  }
+
+  type_names_variant = g_variant_get_child_value (variant, 1);
+  objects = g_variant_get_child_value (variant, 2);
+  subclass_variants = g_variant_get_child_value (variant, 3);
+
+  /* Only the rows themselves get read, in place, as objects are created */
+  type_names = g_variant_get_strv (type_names_variant, &n_types);
+  n_objects = MIN (g_variant_n_children (objects), g_variant_n_children (subclass_variants));
+
+  /* Discover all the media at once before creating the objects */
+  uris = g_ptr_array_new_with_free_func (g_free);
+  for (i = 0; i < n_objects; i++) {
+    GVariant *subclass_variant;
+    guint type_index;
+
+    g_variant_get_child (objects, i, "(uutttuu)", &type_index, NULL, NULL,
+        NULL, NULL, NULL, NULL);
+    if (type_index >= n_types)
+      continue;
+
+    subclass_variant = _get_subclass_variant (subclass_variants, i);
+    ges_uri_source_collect_uri (type_names[type_index], subclass_variant, uris);
+    if (subclass_variant)
+      g_variant_unref (subclass_variant);
+  }
+  ges_asset_prefetch (uris);
+  g_ptr_array_unref (uris);
+
+  for (i = 0; i < n_objects; i++) {
+    GVariant *subclass_variant;
+    guint type_index, media_type, video_track_index, audio_track_index;
+    guint64 inpoint, duration, start;
+    GESObject *child;
+
+    g_variant_get_child (objects, i, "(uutttuu)", &type_index, &media_type,
+        &inpoint, &duration, &start, &video_track_index, &audio_track_index);
+
+    if (type_index >= n_types) {
+      GST_ERROR_OBJECT (self, "invalid type index %u for object %" G_GSIZE_FORMAT, type_index, i);
+      continue;
+    }
+
+    subclass_variant = _get_subclass_variant (subclass_variants, i);
+    child = ges_object_new_from_fields (type_names[type_index], media_type, inpoint,
+        duration, start, video_track_index, audio_track_index, subclass_variant);
+
+    if (subclass_variant)
+      g_variant_unref (subclass_variant);
+
+    if (child)
+      ges_timeline_add_object (self, child);
+  }
+
+  g_free (type_names);
+  g_variant_unref (type_names_variant);
+  g_variant_unref (objects);
+  g_variant_unref (subclass_variants);
+
+  return TRUE;
+}
+
 /* GESPlayable implementation */
 
 static GstBin *
@@ -534,7 +1179,9 @@ ges_timeline_add_object (GESTimeline *self, GESObject *object)
     if (!composition)
       continue;
 
-    g_object_set (tmp->data, "priority", 2, NULL);
+    /* Operations are kept above the source they belong to by the source */
+    if (NLE_IS_SOURCE (tmp->data))
+      g_object_set (tmp->data, "priority", TIMELINE_PRIORITY_OFFSET, NULL);
     if (parent) {
       gst_object_ref (tmp->data);
       gst_bin_remove (GST_BIN (parent), GST_ELEMENT (tmp->data));
@@ -549,8 +1196,18 @@ ges_timeline_add_object (GESTimeline *self, GESObject *object)
   if (ges_object_get_media_type (object) & GES_MEDIA_TYPE_AUDIO)
     _add_object_to_track (self, object, GES_MEDIA_TYPE_AUDIO);
 
+  if (GES_IS_SOURCE (object)) {
+    OutputFormat *format = _get_output_format (self, ges_object_get_media_type (object));
+
+    if (format)
+      ges_source_set_restriction_caps (GES_SOURCE (object), format->caps);
+  }
+
   g_sequence_insert_sorted (self->priv->object_by_start, g_object_ref_sink (object), (GCompareDataFunc) _compare_starts, NULL);
+  if (self->priv->edit_depth)
+    ges_object_begin_edit (object);
   g_list_free (nleobjects);
+  g_signal_emit (self, ges_timeline_signals[OBJECT_ADDED], 0, object);
   return TRUE;
 }
 
@@ -560,29 +1217,520 @@ ges_timeline_new (GESMediaType media_type)
   return g_object_new (GES_TYPE_TIMELINE, "media-type", media_type, NULL);
 }
 
-gboolean
-ges_timeline_commit (GESTimeline *self)
+static void
+_release_idle_elements (GESObject *object, gpointer unused)
+{
+  if (GES_IS_SOURCE (object))
+    ges_source_release_elements (GES_SOURCE (object), SOURCE_RELEASE_IDLE_TIME);
+}
+
+/* The serials the compositions assigned to this commit are stored in
+ * @serials if it is not %NULL */
+static void
+_commit_nle_objects (GESTimeline *self, GHashTable *serials)
 {
   GList *tmp;
 
+  /* We are the root of this commit */
+  _unset_flattened (self);
+  _flatten_nested_timelines (self);
   _update_transitions (self);
+  g_sequence_foreach (self->priv->object_by_start, (GFunc) _release_idle_elements, NULL);
 
   for (tmp = self->priv->compositions; tmp; tmp = tmp->next) {
-    nle_object_commit (NLE_OBJECT(tmp->data), TRUE);
+    guint serial = nle_composition_commit (NLE_COMPOSITION (tmp->data));
+
+    if (serials)
+      g_hash_table_insert (serials, tmp->data, GUINT_TO_POINTER (serial));
   }
 
   for (tmp = self->priv->nleobjects; tmp; tmp = tmp->next) {
     nle_object_commit (NLE_OBJECT(tmp->data), TRUE);
   }
+}
+
+static void _schedule_commit (GESTimeline *self);
+
+static gboolean
+_commit_done_cb (GESTimeline *self)
+{
+  GESTimelinePrivate *priv = self->priv;
+  GList *tasks = priv->running_commits, *tmp;
+
+  priv->running_commits = NULL;
+  priv->last_commit_latency = (g_get_monotonic_time () - priv->running_commit_time) * GST_USECOND;
+  GST_DEBUG_OBJECT (self, "commit done after %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (priv->last_commit_latency));
+
+  for (tmp = tasks; tmp; tmp = tmp->next)
+    g_task_return_boolean (tmp->data, TRUE);
+  g_list_free_full (tasks, g_object_unref);
+
+  if (priv->queued_commits)
+    _schedule_commit (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Called from the streaming thread of the composition. Commits made
+ * meanwhile with ges_timeline_commit, or by anyone else, get reported
+ * too: only the commit in flight, or one requested after it, counts */
+static void
+_composition_commited_cb (GstElement *composition, gboolean changed, GESTimeline *self)
+{
+  GESTimelinePrivate *priv = self->priv;
+  guint serial = nle_composition_get_commited_serial (NLE_COMPOSITION (composition));
+  gboolean done = FALSE;
+  gpointer target;
+
+  g_mutex_lock (&priv->commit_lock);
+  g_hash_table_insert (priv->commited_serials, composition, GUINT_TO_POINTER (serial));
+  if (g_hash_table_lookup_extended (priv->committing_compositions, composition, NULL, &target)
+      && serial >= GPOINTER_TO_UINT (target)) {
+    g_hash_table_remove (priv->committing_compositions, composition);
+    done = !g_hash_table_size (priv->committing_compositions);
+  }
+  g_mutex_unlock (&priv->commit_lock);
+
+  if (done)
+    g_main_context_invoke_full (priv->commit_context, G_PRIORITY_DEFAULT,
+        (GSourceFunc) _commit_done_cb, g_object_ref (self), g_object_unref);
+}
+
+static gboolean
+_start_commit_cb (GESTimeline *self)
+{
+  GESTimelinePrivate *priv = self->priv;
+  GHashTable *serials = g_hash_table_new (NULL, NULL);
+  gboolean waiting = FALSE;
+  GList *tmp;
+
+  priv->commit_source_id = 0;
+  priv->running_commits = priv->queued_commits;
+  priv->running_commit_time = priv->queued_commit_time;
+  priv->queued_commits = NULL;
+
+  _commit_nle_objects (self, serials);
+
+  /* Compositions only process commits once their task runs, from READY
+   * on, don't wait for the others. The ones that were quick enough to
+   * report the serial they gave us already are done too */
+  g_mutex_lock (&priv->commit_lock);
+  for (tmp = priv->compositions; tmp; tmp = tmp->next) {
+    guint serial = GPOINTER_TO_UINT (g_hash_table_lookup (serials, tmp->data));
+    guint commited = GPOINTER_TO_UINT (g_hash_table_lookup (priv->commited_serials, tmp->data));
+
+    if (GST_STATE (tmp->data) > GST_STATE_NULL && commited < serial) {
+      g_hash_table_insert (priv->committing_compositions, tmp->data, GUINT_TO_POINTER (serial));
+      waiting = TRUE;
+    }
+  }
+  g_mutex_unlock (&priv->commit_lock);
+  g_hash_table_unref (serials);
+
+  if (!waiting)
+    _commit_done_cb (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+_schedule_commit (GESTimeline *self)
+{
+  GESTimelinePrivate *priv = self->priv;
+  GSource *source;
+
+  if (priv->commit_source_id || priv->running_commits)
+    return;
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, (GSourceFunc) _start_commit_cb, g_object_ref (self), g_object_unref);
+  priv->commit_source_id = g_source_attach (source, priv->commit_context);
+  g_source_unref (source);
+}
+
+/**
+ * ges_timeline_commit:
+ * @timeline: a #GESTimeline
+ *
+ * Applies the changes made to @timeline and to the objects it contains.
+ *
+ * The sources of the timelines nested in @timeline get moved into its own
+ * compositions, with their timings mapped to @timeline. Each nested
+ * timeline gets a range of priorities of its own, its transitions are
+ * updated along with the ones of @timeline and its sources stack where it
+ * is in its track. Nested sequences thus cost no extra composition, mixer
+ * or background. The sources that aren't visible anymore are given back
+ * to the compositions of their timeline. Changes made to a nested timeline
+ * are applied by committing the timeline it is nested in.
+ *
+ * Returns: %TRUE
+ */
+gboolean
+ges_timeline_commit (GESTimeline *self)
+{
+  _commit_nle_objects (self, NULL);
 
   return TRUE;
 }
 
+/**
+ * ges_timeline_commit_async:
+ * @timeline: a #GESTimeline
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @callback: a #GAsyncReadyCallback to call when the commit is done
+ * @user_data: the data to pass to callback function
+ *
+ * Like ges_timeline_commit(), but returns right away. The commit happens
+ * from an idle source in the thread-default main context, and @callback
+ * is called once every composition of @timeline has applied it. When
+ * @timeline is playing, compositions only report a commit as applied once
+ * they output data reflecting it.
+ *
+ * Commits requested before the previous one started, or while one is in
+ * flight, are coalesced into a single commit, after which all of their
+ * callbacks are called.
+ */
+void
+ges_timeline_commit_async (GESTimeline *self, GCancellable *cancellable,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  GESTimelinePrivate *priv = self->priv;
+  GTask *task = g_task_new (self, cancellable, callback, user_data);
+
+  if (!priv->queued_commits) {
+    if (!priv->running_commits) {
+      if (priv->commit_context)
+        g_main_context_unref (priv->commit_context);
+      priv->commit_context = g_main_context_ref_thread_default ();
+    }
+    priv->queued_commit_time = g_get_monotonic_time ();
+  }
+
+  priv->queued_commits = g_list_append (priv->queued_commits, task);
+  _schedule_commit (self);
+}
+
+/**
+ * ges_timeline_commit_finish:
+ * @timeline: a #GESTimeline
+ * @result: The #GAsyncResult passed to the callback of
+ * ges_timeline_commit_async()
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Returns: %TRUE if the commit was applied, %FALSE otherwise
+ */
+gboolean
+ges_timeline_commit_finish (GESTimeline *self, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, self), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/**
+ * ges_timeline_get_last_commit_latency:
+ * @timeline: a #GESTimeline
+ *
+ * Returns: The time between the earliest request coalesced into the last
+ * commit done with ges_timeline_commit_async() and all compositions
+ * applying it, or #GST_CLOCK_TIME_NONE if no such commit completed yet
+ */
+GstClockTime
+ges_timeline_get_last_commit_latency (GESTimeline *self)
+{
+  return self->priv->last_commit_latency;
+}
+
+/**
+ * ges_timeline_begin_edit:
+ * @timeline: a #GESTimeline
+ *
+ * Starts a batch of changes to the objects of @timeline, for example all
+ * the objects moved by a single gesture in an editor.
+ *
+ * Until ges_timeline_end_edit() is called, the timing properties of the
+ * objects in @timeline, including those added in the meantime, are only
+ * recorded: getters return the new values, but neither the underlying
+ * NLE objects nor notify handlers are updated yet.
+ *
+ * Calls can be nested, only the outermost one has an effect.
+ */
+void
+ges_timeline_begin_edit (GESTimeline *self)
+{
+  if (self->priv->edit_depth++)
+    return;
+
+  g_sequence_foreach (self->priv->object_by_start, (GFunc) ges_object_begin_edit, NULL);
+}
+
+/**
+ * ges_timeline_end_edit:
+ * @timeline: a #GESTimeline
+ *
+ * Ends a batch of changes started with ges_timeline_begin_edit(). The
+ * final value of each changed property is applied in a single pass over
+ * the objects, with one notification per property, then @timeline gets
+ * committed once.
+ *
+ * The changes an object rejects, for example an inpoint past the end of
+ * its media, are reverted to the value the property had when the batch
+ * started, the others are still applied.
+ *
+ * Returns: %TRUE if @timeline was committed with all the changes, or if
+ * this ended a nested batch, %FALSE otherwise
+ */
+gboolean
+ges_timeline_end_edit (GESTimeline *self)
+{
+  GSequenceIter *iter;
+  gboolean res = TRUE;
+
+  g_return_val_if_fail (self->priv->edit_depth > 0, FALSE);
+
+  if (--self->priv->edit_depth)
+    return TRUE;
+
+  for (iter = g_sequence_get_begin_iter (self->priv->object_by_start);
+      !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+    if (!ges_object_end_edit (g_sequence_get (iter)))
+      res = FALSE;
+  }
+
+  return ges_timeline_commit (self) && res;
+}
+
+/**
+ * ges_timeline_save_to_file:
+ * @timeline: a #GESTimeline
+ * @path: The file to write to
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Saves @timeline and all the objects it contains to @path, as a single
+ * blob that can be loaded back with ges_timeline_load_from_file().
+ *
+ * The file starts with an 8 bytes header, "GESPRJ" followed by two nul
+ * bytes, then contains the little-endian, normal form serialization of the
+ * #GVariant returned by ges_object_serialize() for @timeline. The
+ * subclass data of that variant is of type "(uasa(uutttuu)amv)": the
+ * version of the format, the type names of the objects, then for each
+ * object, sorted by start, the index of its type name, its media type,
+ * inpoint, duration, start, video and audio track indexes, and finally
+ * the subclass data of each object, in the same order.
+ *
+ * All the fixed-size fields of the objects live in a single array, which
+ * means the file can be mapped and each object read in place.
+ *
+ * Returns: %TRUE if @timeline was saved, %FALSE otherwise
+ */
+gboolean
+ges_timeline_save_to_file (GESTimeline *self, const gchar *path, GError **error)
+{
+  GVariant *variant = g_variant_ref_sink (ges_object_serialize (GES_OBJECT (self)));
+  gsize size = g_variant_get_size (variant);
+  gchar *contents = g_malloc (PROJECT_FILE_HEADER_SIZE + size);
+  gboolean ret;
+
+  if (G_BYTE_ORDER == G_BIG_ENDIAN) {
+    GVariant *swapped = g_variant_byteswap (variant);
+    g_variant_unref (variant);
+    variant = swapped;
+  }
+
+  memcpy (contents, PROJECT_FILE_MAGIC, PROJECT_FILE_HEADER_SIZE);
+  g_variant_store (variant, contents + PROJECT_FILE_HEADER_SIZE);
+  ret = g_file_set_contents (path, contents, PROJECT_FILE_HEADER_SIZE + size, error);
+
+  g_free (contents);
+  g_variant_unref (variant);
+
+  return ret;
+}
+
+/**
+ * ges_timeline_load_from_file:
+ * @path: A file written by ges_timeline_save_to_file()
+ * @error: (allow-none): return location for a #GError, or %NULL
+ *
+ * Loads a timeline saved with ges_timeline_save_to_file(). The file is
+ * mapped rather than read, and objects are created straight from the
+ * mapped data, without any intermediate parsing of the whole project.
+ *
+ * Returns: (transfer floating): A new #GESTimeline, or %NULL if @path
+ * could not be loaded.
+ */
+GESTimeline *
+ges_timeline_load_from_file (const gchar *path, GError **error)
+{
+  GMappedFile *file = g_mapped_file_new (path, FALSE, error);
+  GBytes *bytes, *data;
+  GVariant *variant;
+  GESObject *res;
+
+  if (!file)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (file);
+  g_mapped_file_unref (file);
+
+  if (g_bytes_get_size (bytes) < PROJECT_FILE_HEADER_SIZE ||
+      memcmp (g_bytes_get_data (bytes, NULL), PROJECT_FILE_MAGIC, PROJECT_FILE_HEADER_SIZE)) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "%s is not a GES project file", path);
+    g_bytes_unref (bytes);
+    return NULL;
+  }
+
+  /* The header keeps the variant data 8 bytes aligned, so it isn't copied */
+  data = g_bytes_new_from_bytes (bytes, PROJECT_FILE_HEADER_SIZE,
+      g_bytes_get_size (bytes) - PROJECT_FILE_HEADER_SIZE);
+  g_bytes_unref (bytes);
+
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE_VARIANT, data, FALSE));
+  g_bytes_unref (data);
+
+  if (G_BYTE_ORDER == G_BIG_ENDIAN) {
+    GVariant *swapped = g_variant_byteswap (variant);
+    g_variant_unref (variant);
+    variant = swapped;
+  }
+
+  res = ges_object_deserialize (variant);
+  g_variant_unref (variant);
+
+  if (res && !GES_IS_TIMELINE (res)) {
+    g_object_unref (g_object_ref_sink (res));
+    res = NULL;
+  }
+
+  if (!res)
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "%s does not contain a timeline", path);
+
+  return (GESTimeline *) res;
+}
+
+/**
+ * ges_timeline_get_objects:
+ * @timeline: a #GESTimeline
+ *
+ * Returns: (transfer container) (element-type GESObject): The objects that
+ * were added to @timeline
+ */
+GList *
+ges_timeline_get_objects (GESTimeline *self)
+{
+  GList *res = NULL;
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (self->priv->object_by_start);
+      !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter))
+    res = g_list_prepend (res, g_sequence_get (iter));
+
+  return g_list_reverse (res);
+}
+
 GList *ges_timeline_get_compositions_by_media_type (GESTimeline *self, GESMediaType media_type)
 {
   return _get_compositions (self, media_type);
 }
 
+/**
+ * ges_timeline_set_restriction_caps:
+ * @timeline: a #GESTimeline
+ * @media_type: %GES_MEDIA_TYPE_VIDEO or %GES_MEDIA_TYPE_AUDIO
+ * @caps: (allow-none): raw caps describing the output format, or %NULL
+ * to let it get negotiated
+ *
+ * Declares what @timeline outputs for @media_type, for example
+ * "video/x-raw,format=I420,width=1920,height=1080,framerate=30/1" or
+ * "audio/x-raw,format=F32LE,rate=48000,channels=2".
+ *
+ * Each source then converts once, straight into that format, and when
+ * @caps are fixed the mixers don't convert their inputs again. This is
+ * best done before the first commit, as sources that are in use only get
+ * their elements rebuilt for the new format once they're released.
+ *
+ * Returns: %TRUE if @caps could be used for @media_type
+ */
+gboolean
+ges_timeline_set_restriction_caps (GESTimeline *self, GESMediaType media_type, GstCaps *caps)
+{
+  OutputFormat *format = _get_output_format (self, media_type);
+  const gchar *raw_caps = media_type == GES_MEDIA_TYPE_VIDEO ? GES_RAW_VIDEO_CAPS : GES_RAW_AUDIO_CAPS;
+
+  if (!format) {
+    GST_ERROR_OBJECT (self, "restriction caps need a single media type");
+    return FALSE;
+  }
+
+  if (caps && (gst_caps_get_size (caps) != 1 ||
+        !gst_structure_has_name (gst_caps_get_structure (caps, 0), raw_caps))) {
+    GST_ERROR_OBJECT (self, "%" GST_PTR_FORMAT " aren't %s caps", caps, raw_caps);
+    return FALSE;
+  }
+
+  gst_caps_replace (&format->caps, caps);
+  _apply_output_format (self, media_type);
+
+  return TRUE;
+}
+
+/**
+ * ges_timeline_get_restriction_caps:
+ * @timeline: a #GESTimeline
+ * @media_type: %GES_MEDIA_TYPE_VIDEO or %GES_MEDIA_TYPE_AUDIO
+ *
+ * Returns: (transfer full) (nullable): The caps set with
+ * ges_timeline_set_restriction_caps()
+ */
+GstCaps *
+ges_timeline_get_restriction_caps (GESTimeline *self, GESMediaType media_type)
+{
+  OutputFormat *format = _get_output_format (self, media_type);
+
+  if (!format || !format->caps)
+    return NULL;
+
+  return gst_caps_ref (format->caps);
+}
+
+/**
+ * ges_timeline_set_mixing:
+ * @timeline: a #GESTimeline
+ * @mixing: whether to blend the video layers together
+ *
+ * When @mixing is %FALSE, only the top video layer shows, and its frames
+ * get output as they are whenever they are in the output format, without
+ * any blending. Mostly useful to preview or render a timeline made of a
+ * single layer as fast as possible.
+ */
+void
+ges_timeline_set_mixing (GESTimeline *self, gboolean mixing)
+{
+  if (self->priv->video_format.mixer)
+    g_object_set (self->priv->video_format.mixer, "mixing", mixing, NULL);
+}
+
+/**
+ * ges_timeline_get_mixing:
+ * @timeline: a #GESTimeline
+ *
+ * Returns: whether the video layers of @timeline get blended together,
+ * see ges_timeline_set_mixing()
+ */
+gboolean
+ges_timeline_get_mixing (GESTimeline *self)
+{
+  gboolean mixing = TRUE;
+
+  if (self->priv->video_format.mixer)
+    g_object_get (self->priv->video_format.mixer, "mixing", &mixing, NULL);
+
+  return mixing;
+}
+
 /* GObject initialization */
 
 static void
@@ -615,11 +1763,15 @@ static void
 _dispose (GObject *object)
 {
   GESTimeline *self = GES_TIMELINE (object);
+  GList *tmp;
 
   GST_ERROR ("timeline disposed");
+  for (tmp = self->priv->compositions; tmp; tmp = tmp->next)
+    g_signal_handlers_disconnect_by_func (tmp->data, _composition_commited_cb, self);
   g_sequence_free (self->priv->object_by_start);
   g_hash_table_foreach (self->priv->tracks, (GHFunc) _free_tracks, NULL);
   g_hash_table_unref (self->priv->tracks);
+  g_hash_table_unref (self->priv->flattened_sources);
   g_list_free_full (self->priv->nleobjects, gst_object_unref);
   g_list_free (self->priv->compositions);
   gst_object_unref (self->priv->composition_bin);
@@ -627,6 +1779,22 @@ _dispose (GObject *object)
   G_OBJECT_CLASS (ges_timeline_parent_class)->dispose (object);
 }
 
+static void
+_finalize (GObject *object)
+{
+  GESTimeline *self = GES_TIMELINE (object);
+
+  g_mutex_clear (&self->priv->commit_lock);
+  gst_caps_replace (&self->priv->video_format.caps, NULL);
+  gst_caps_replace (&self->priv->audio_format.caps, NULL);
+  g_hash_table_unref (self->priv->committing_compositions);
+  g_hash_table_unref (self->priv->commited_serials);
+  if (self->priv->commit_context)
+    g_main_context_unref (self->priv->commit_context);
+
+  G_OBJECT_CLASS (ges_timeline_parent_class)->finalize (object);
+}
+
 static void
 ges_timeline_class_init (GESTimelineClass *klass)
 {
@@ -638,6 +1806,7 @@ ges_timeline_class_init (GESTimelineClass *klass)
   g_object_class->set_property = _set_property;
   g_object_class->get_property = _get_property;
   g_object_class->dispose = _dispose;
+  g_object_class->finalize = _finalize;
 
   ges_timeline_signals[TRANSITION_ADDED] =
       g_signal_new ("transition-added", G_TYPE_FROM_CLASS (klass),
@@ -649,12 +1818,26 @@ ges_timeline_class_init (GESTimelineClass *klass)
       G_SIGNAL_RUN_FIRST, 0, NULL, NULL, g_cclosure_marshal_generic,
       G_TYPE_NONE, 1, GES_TYPE_TRANSITION);
 
+  /**
+   * GESTimeline::object-added:
+   * @timeline: a #GESTimeline
+   * @object: the #GESObject that was added
+   *
+   * Emitted after @object was added with ges_timeline_add_object()
+   */
+  ges_timeline_signals[OBJECT_ADDED] =
+      g_signal_new ("object-added", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_FIRST, 0, NULL, NULL, g_cclosure_marshal_generic,
+      G_TYPE_NONE, 1, GES_TYPE_OBJECT);
+
   ges_object_class->set_inpoint = _set_inpoint;
   ges_object_class->set_duration = _set_duration;
   ges_object_class->set_start = _set_start;
   ges_object_class->set_track_index = _set_track_index;
   ges_object_class->get_nle_objects = _get_nle_objects;
   ges_object_class->set_media_type = _set_media_type;
+  ges_object_class->serialize = _serialize;
+  ges_object_class->deserialize = _deserialize;
 }
 
 static void
@@ -668,4 +1851,11 @@ ges_timeline_init (GESTimeline *self)
   self->priv->composition_bin = gst_object_ref_sink (ges_composition_bin_new ());
   self->priv->object_by_start = g_sequence_new (g_object_unref);
   self->priv->tracks = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_mutex_init (&self->priv->commit_lock);
+  self->priv->committing_compositions = g_hash_table_new (NULL, NULL);
+  self->priv->commited_serials = g_hash_table_new (NULL, NULL);
+  self->priv->last_commit_latency = GST_CLOCK_TIME_NONE;
+  self->priv->flattened_into = NULL;
+  self->priv->priority_offset = 0;
+  self->priv->flattened_sources = g_hash_table_new_full (NULL, NULL, g_object_unref, g_object_unref);
 }
@@ -2,21 +2,47 @@
 #define _GES_TIMELINE
 
 #include <gst/gst.h>
+#include <gio/gio.h>
 #include <ges-object.h>
 
 G_BEGIN_DECLS
 
 #define GES_TYPE_TIMELINE (ges_timeline_get_type ())
 
-#define TIMELINE_PRIORITY_OFFSET 2
+/* How many operations the effects of a source can end up in, see
+ * ges_source_add_effect */
+#define MAX_EFFECT_OPERATIONS 16
+/* 0 is the mixer, 1 the background. Sources overlapping in a track each
+ * get a lane of their own, made of the source, the operations applying its
+ * effects right above it, then the one blending its transition, see
+ * _update_transitions. This is the priority of the sources in the first
+ * lane of the first track. Flattened nested timelines each lay their
+ * tracks out the same way, in a range of their own after ours, see
+ * _flatten_nested_timelines */
+#define TIMELINE_PRIORITY_OFFSET (3 + MAX_EFFECT_OPERATIONS)
+#define SOURCE_PRIORITY_HEIGHT (2 + MAX_EFFECT_OPERATIONS)
 #define TRACK_PRIORITY_HEIGHT 1000
+#define MAX_SOURCE_LANES ((TRACK_PRIORITY_HEIGHT - 1) / SOURCE_PRIORITY_HEIGHT)
 
 G_DECLARE_FINAL_TYPE(GESTimeline, ges_timeline, GES, TIMELINE, GESObject)
 
 GESTimeline *ges_timeline_new (GESMediaType media_type);
 gboolean ges_timeline_add_object (GESTimeline *self, GESObject *object);
 gboolean ges_timeline_commit (GESTimeline *timeline);
+void ges_timeline_commit_async (GESTimeline *timeline, GCancellable *cancellable,
+    GAsyncReadyCallback callback, gpointer user_data);
+gboolean ges_timeline_commit_finish (GESTimeline *timeline, GAsyncResult *result, GError **error);
+GstClockTime ges_timeline_get_last_commit_latency (GESTimeline *timeline);
+void ges_timeline_begin_edit (GESTimeline *timeline);
+gboolean ges_timeline_end_edit (GESTimeline *timeline);
+gboolean ges_timeline_save_to_file (GESTimeline *timeline, const gchar *path, GError **error);
+GESTimeline *ges_timeline_load_from_file (const gchar *path, GError **error);
+GList *ges_timeline_get_objects (GESTimeline *timeline);
 GList *ges_timeline_get_compositions_by_media_type (GESTimeline *timeline, GESMediaType media_type);
+gboolean ges_timeline_set_restriction_caps (GESTimeline *timeline, GESMediaType media_type, GstCaps *caps);
+GstCaps *ges_timeline_get_restriction_caps (GESTimeline *timeline, GESMediaType media_type);
+void ges_timeline_set_mixing (GESTimeline *timeline, gboolean mixing);
+gboolean ges_timeline_get_mixing (GESTimeline *timeline);
 
 G_END_DECLS
 
@@ -1,7 +1,9 @@
 #include <gst/controller/controller.h>
 
+#include "ges-timeline.h"
 #include "ges-transition.h"
 #include "ges-source.h"
+#include "ges-internal.h"
 
 typedef struct _GESTransitionPrivate
 {
@@ -9,6 +11,12 @@ typedef struct _GESTransitionPrivate
   GESObject *fadein_source;
   GstControlSource *fadeout_control_source;
   GstControlSource *fadein_control_source;
+
+  /* When set, the sources are blended by a crossfade operation added
+   * there instead of having their alpha animated */
+  GstElement *composition;
+  GstElement *operation;
+  GstElement *crossfade;
 } GESTransitionPrivate;
 
 struct _GESTransition
@@ -27,8 +35,45 @@ enum
   PROP_TRANSITION_TYPE,
   PROP_FADEDOUT_SOURCE,
   PROP_FADEDIN_SOURCE,
+  PROP_COMPOSITION,
 };
 
+/* The crossfade operation covers the overlap of the sources' nleobjects,
+ * right above the lanes of both sources and their effects, so that it
+ * blends their outputs */
+static void
+_update_operation (GESTransition *self)
+{
+  GList *fadeout_objects, *fadein_objects;
+  GstClockTime start, fadeout_start;
+  gint64 fadeout_duration;
+  guint priority, fadein_priority;
+
+  fadeout_objects = ges_object_get_nle_objects (self->priv->fadeout_source);
+  fadein_objects = ges_object_get_nle_objects (self->priv->fadein_source);
+
+  if (!fadeout_objects || !fadein_objects)
+    goto done;
+
+  g_object_get (fadein_objects->data, "start", &start, "priority", &fadein_priority, NULL);
+  g_object_get (fadeout_objects->data, "start", &fadeout_start,
+      "duration", &fadeout_duration, "priority", &priority, NULL);
+  priority = MIN (priority, fadein_priority);
+
+  if (fadeout_start + fadeout_duration <= start || priority <= MAX_EFFECT_OPERATIONS)
+    goto done;
+
+  g_object_set (self->priv->operation, "start", start,
+      "duration", (gint64) (fadeout_start + fadeout_duration - start),
+      "inpoint", (guint64) 0, "priority", priority - 1 - MAX_EFFECT_OPERATIONS, NULL);
+  g_object_set (self->priv->crossfade, "duration",
+      (guint64) (fadeout_start + fadeout_duration - start), NULL);
+
+done:
+  g_list_free (fadeout_objects);
+  g_list_free (fadein_objects);
+}
+
 void
 ges_transition_update (GESTransition *self)
 {
@@ -39,6 +84,11 @@ ges_transition_update (GESTransition *self)
   if (!self->priv->fadeout_source || !self->priv->fadein_source)
     return;
 
+  if (self->priv->operation) {
+    _update_operation (self);
+    return;
+  }
+
   source = GST_TIMED_VALUE_CONTROL_SOURCE (self->priv->fadeout_control_source);
 
   transition_start = ges_object_get_inpoint (self->priv->fadeout_source) +
@@ -66,6 +116,17 @@ ges_transition_update (GESTransition *self)
       ges_object_get_duration (self->priv->fadein_source), 1.0);
 }
 
+static void
+_create_operation (GESTransition *self)
+{
+  self->priv->operation = gst_element_factory_make ("nleoperation", NULL);
+  self->priv->crossfade = gst_element_factory_make ("crossfade", NULL);
+
+  gst_object_ref_sink (self->priv->operation);
+  gst_bin_add (GST_BIN (self->priv->operation), self->priv->crossfade);
+  gst_bin_add (GST_BIN (self->priv->composition), self->priv->operation);
+}
+
 static void
 _create_control_sources (GESTransition *self)
 {
@@ -98,6 +159,14 @@ ges_transition_reset (GESTransition *self)
   if (!self->priv->fadeout_source || !self->priv->fadein_source)
     return;
 
+  if (self->priv->operation) {
+    gst_bin_remove (GST_BIN (self->priv->composition), self->priv->operation);
+    gst_object_unref (self->priv->operation);
+    self->priv->operation = NULL;
+    self->priv->crossfade = NULL;
+    goto done;
+  }
+
   source = GST_TIMED_VALUE_CONTROL_SOURCE (self->priv->fadeout_control_source);
 
   end = ges_object_get_inpoint (GES_OBJECT (self->priv->fadeout_source)) +
@@ -116,6 +185,7 @@ ges_transition_reset (GESTransition *self)
       ges_object_get_inpoint (GES_OBJECT (self->priv->fadein_source)), 1.0);
   gst_timed_value_control_source_set (source, end, 1.0);
 
+done:
   self->priv->fadein_source = NULL;
   self->priv->fadeout_source = NULL;
 }
@@ -133,6 +203,9 @@ _set_property (GObject * object, guint property_id,
     case PROP_FADEDIN_SOURCE:
       self->priv->fadein_source = g_value_get_object (value);
       break;
+    case PROP_COMPOSITION:
+      self->priv->composition = g_value_dup_object (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       return;
@@ -152,6 +225,9 @@ _get_property (GObject * object, guint property_id,
     case PROP_FADEDIN_SOURCE:
       g_value_set_object (value, priv->fadein_source);
       break;
+    case PROP_COMPOSITION:
+      g_value_set_object (value, priv->composition);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -161,7 +237,11 @@ static void
 _constructed (GObject *object)
 {
   GESTransition *self = GES_TRANSITION (object);
-  _create_control_sources (self);
+
+  if (self->priv->composition)
+    _create_operation (self);
+  else
+    _create_control_sources (self);
   ges_transition_update (self);
 
   G_OBJECT_CLASS (ges_transition_parent_class)->constructed (object);
@@ -170,7 +250,15 @@ _constructed (GObject *object)
 static void
 _dispose (GObject *object)
 {
-  ges_transition_reset (GES_TRANSITION (object));
+  GESTransition *self = GES_TRANSITION (object);
+
+  ges_transition_reset (self);
+  if (self->priv->composition) {
+    gst_object_unref (self->priv->composition);
+    self->priv->composition = NULL;
+  }
+
+  G_OBJECT_CLASS (ges_transition_parent_class)->dispose (object);
 }
 
 static void
@@ -192,6 +280,11 @@ ges_transition_class_init (GESTransitionClass *klass)
   g_object_class_install_property (g_object_class, PROP_FADEDIN_SOURCE,
       g_param_spec_object ("faded-in-source", "faded-in-source", "The source to fade in",
         GES_TYPE_OBJECT, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (g_object_class, PROP_COMPOSITION,
+      g_param_spec_object ("composition", "composition",
+        "The composition to add a crossfade operation to, NULL to animate the sources instead",
+        GST_TYPE_ELEMENT, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
 }
 
 static void
@@ -204,6 +297,9 @@ ges_transition_init (GESTransition *self)
   self->priv->fadeout_source = NULL;
   self->priv->fadeout_control_source = NULL;
   self->priv->fadein_control_source = NULL;
+  self->priv->composition = NULL;
+  self->priv->operation = NULL;
+  self->priv->crossfade = NULL;
 }
 
 GESTransition *
@@ -214,3 +310,15 @@ ges_transition_new (GESObject *fadeout_source, GESObject *fadein_source)
       "faded-in-source", fadein_source,
       NULL);
 }
+
+/* Blends the sources with a single crossfade operation in @composition */
+GESTransition *
+ges_transition_new_crossfade (GESObject *fadeout_source, GESObject *fadein_source,
+    GstElement *composition)
+{
+  return g_object_new (GES_TYPE_TRANSITION,
+      "faded-out-source", fadeout_source,
+      "faded-in-source", fadein_source,
+      "composition", composition,
+      NULL);
+}
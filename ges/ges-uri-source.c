@@ -1,8 +1,6 @@
-#include <grilo.h>
-#include <gst/pbutils/gstdiscoverer.h>
-
 #include "ges-timeline.h"
 #include "ges-uri-source.h"
+#include "ges-asset.h"
 #include "ges-internal.h"
 
 /* Structure definitions */
@@ -12,9 +10,8 @@
 typedef struct _GESUriSourcePrivate
 {
   gchar *uri;
-  gchar *original_uri;
   GstElement *decodebin;
-  GstDiscovererInfo *info;
+  GESAsset *asset;
 } GESUriSourcePrivate;
 
 struct _GESUriSource
@@ -40,106 +37,126 @@ ges_uri_source_set_uri (GESUriSource *self, const gchar *uri)
   priv->uri = g_strdup (uri);
 }
 
-static GrlMedia *
-grl_media_from_uri (const gchar * uri)
+static GESSource *
+_new_from_asset (const gchar *uri, GESAsset *asset, GESMediaType media_type)
 {
-  GrlMedia *media = NULL;
-  GError *error = NULL;
-  GList *tmp;
-  GrlOperationOptions *options;
-  GrlRegistry *registry = grl_registry_get_default ();
-  GrlSource *source;
-  GrlKeyID disco_key_id =
-    grl_registry_lookup_metadata_key (registry, "discovery");
-  GList *keys = grl_metadata_key_list_new (GRL_METADATA_KEY_EXTERNAL_URL,
-      GRL_METADATA_KEY_URL,
-      disco_key_id,
-      GRL_METADATA_KEY_INVALID);
-
-  if (disco_key_id == GRL_METADATA_KEY_INVALID)
-    return NULL;
+  GESSource *res;
+  GESUriSourcePrivate *priv;
 
-  registry = grl_registry_get_default ();
-
-  options = grl_operation_options_new (NULL);
-  grl_operation_options_set_count (options, 1);
-  grl_operation_options_set_resolution_flags (options, GRL_RESOLVE_FULL);
-
-  for (tmp = grl_registry_get_sources_by_operations (registry, GRL_OP_MEDIA_FROM_URI, TRUE); tmp; tmp=tmp->next)  {
-    source = GRL_SOURCE (tmp->data);
-    if (grl_source_test_media_from_uri (source, uri)) {
-      error = NULL;
-      media = grl_source_get_media_from_uri_sync (source,
-          uri, keys, options, &error);
-      if (media) {
-        break;
-      }
-    }
+  if (!asset) {
+    GST_WARNING ("We couldn't recognize this uri with grilo : %s, beware", uri);
+    /* We still return a source, the user might have its own asset management
+     * tools, but he will need to set the duration himself */
+    return g_object_new (GES_TYPE_URI_SOURCE, "uri", uri, "media-type", media_type, NULL);
   }
 
-  return media;
+  if (!ges_asset_has_media_type (asset, media_type))
+    return NULL;
+
+  res = g_object_new (GES_TYPE_URI_SOURCE, "uri", ges_asset_get_url (asset), "media-type", media_type, NULL);
+
+  priv = GES_URI_SOURCE_PRIV (res);
+  priv->asset = g_object_ref (asset);
+  GST_DEBUG_OBJECT (res, "Actual media uri : %s", ges_asset_get_url (asset));
+  g_object_set (res, "duration", ges_asset_get_duration (asset), NULL);
+
+  return res;
 }
 
-static GstDiscovererInfo *
-_get_discoverer_info_from_grl_media (GrlMedia *media)
+GESSource *
+ges_uri_source_new (const gchar *uri, GESMediaType media_type)
 {
-  GrlRegistry *registry = grl_registry_get_default ();
-  const GValue *info_value;
-  GstDiscovererInfo *info;
+  GESAsset *asset = ges_asset_request (uri);
+  GESSource *res = _new_from_asset (uri, asset, media_type);
 
-  GrlKeyID disco_key_id =
-    grl_registry_lookup_metadata_key (registry, "discovery");
+  if (asset)
+    g_object_unref (asset);
 
-  info_value = grl_data_get (GRL_DATA (media), disco_key_id);
-  info = g_value_get_object (info_value);
+  return res;
+}
 
-  return info;
+typedef struct
+{
+  gchar *uri;
+  GESMediaType media_type;
+} NewSourceData;
+
+static void
+_free_new_source_data (NewSourceData *data)
+{
+  g_free (data->uri);
+  g_slice_free (NewSourceData, data);
 }
 
-GESSource *
-ges_uri_source_new (const gchar *uri, GESMediaType media_type)
+static void
+_asset_requested_cb (GObject *unused, GAsyncResult *result, GTask *task)
 {
-  GrlMedia *media = grl_media_from_uri (uri);
-  GstDiscovererInfo *info;
-  GList *streams;
+  NewSourceData *data = g_task_get_task_data (task);
+  GError *error = NULL;
+  GESAsset *asset = ges_asset_request_finish (result, &error);
   GESSource *res;
-  GESUriSourcePrivate *priv;
 
-  if (!media) {
-    GST_WARNING ("We couldn't recognize this uri with grilo : %s, beware", uri);
-    /* We still return a source, the user might have its own asset management
-     * tools, but he will need to set the duration himself */
-    return g_object_new (GES_TYPE_URI_SOURCE, "uri", uri, "media-type", media_type, NULL);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+    g_task_return_error (task, error);
+    g_object_unref (task);
+    return;
   }
+  g_clear_error (&error);
 
-  info = _get_discoverer_info_from_grl_media (media);
-  if (media_type == GES_MEDIA_TYPE_AUDIO) {
-    streams = gst_discoverer_info_get_audio_streams (info);
-    if (!streams) {
-      gst_discoverer_info_unref (info);
-      return NULL;
-    }
-  } else if (media_type == GES_MEDIA_TYPE_VIDEO) {
-    streams = gst_discoverer_info_get_video_streams (info);
-    if (!streams) {
-      gst_discoverer_info_unref (info);
-      return NULL;
-    }
-  } else {
-    return NULL;
-  }
+  /* We are back in the context of the caller, elements can be built here */
+  res = _new_from_asset (data->uri, asset, data->media_type);
 
-  gst_discoverer_stream_info_list_free (streams);
+  if (res)
+    g_task_return_pointer (task, res, g_object_unref);
+  else
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+        "%s has no stream of the requested media type", data->uri);
 
-  res = g_object_new (GES_TYPE_URI_SOURCE, "uri", grl_media_get_url (media), "media-type", media_type, NULL);
+  if (asset)
+    g_object_unref (asset);
+  g_object_unref (task);
+}
 
-  priv = GES_URI_SOURCE_PRIV (res);
-  priv->info = info;
-  priv->original_uri = g_strdup (uri);
-  GST_DEBUG_OBJECT (res, "Actual media uri : %s", grl_media_get_url (media));
-  g_object_set (res, "duration", gst_discoverer_info_get_duration (info), NULL);
+/**
+ * ges_uri_source_new_async:
+ * @uri: The URI of the media
+ * @media_type: The #GESMediaType of the source to create
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): callback to call when the source is ready
+ * @user_data: the data to pass to @callback
+ *
+ * Asynchronous version of ges_uri_source_new(), the media is discovered
+ * with ges_asset_request_async() so that many sources can be created in
+ * parallel. @callback is called in the thread-default main context of
+ * the caller, call ges_uri_source_new_finish() from it to get the source.
+ */
+void
+ges_uri_source_new_async (const gchar *uri, GESMediaType media_type,
+    GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data)
+{
+  GTask *task = g_task_new (NULL, cancellable, callback, user_data);
+  NewSourceData *data = g_slice_new0 (NewSourceData);
 
-  return res;
+  data->uri = g_strdup (uri);
+  data->media_type = media_type;
+  g_task_set_task_data (task, data, (GDestroyNotify) _free_new_source_data);
+
+  ges_asset_request_async (uri, cancellable,
+      (GAsyncReadyCallback) _asset_requested_cb, task);
+}
+
+/**
+ * ges_uri_source_new_finish:
+ * @result: The #GAsyncResult passed to the callback of ges_uri_source_new_async()
+ * @error: return location for a #GError, or %NULL
+ *
+ * Returns: (transfer full) (allow-none): The new #GESUriSource, %NULL if
+ * it could not be created, in which case @error is set.
+ */
+GESSource *
+ges_uri_source_new_finish (GAsyncResult *result, GError **error)
+{
+  return g_task_propagate_pointer (G_TASK (result), error);
 }
 
 static GstElement *
@@ -168,19 +185,74 @@ _make_element (GESSource *source)
   g_object_set (priv->decodebin, "use-buffering", FALSE, "download", TRUE, "buffer-size", 10 * 1024 * 1024, NULL);
   gst_caps_unref (caps);
 
+  /* Our elements get released when unused, see ges_source_release_elements */
+  g_object_add_weak_pointer (G_OBJECT (priv->decodebin), (gpointer *) &priv->decodebin);
+
   return priv->decodebin;
 }
 
+/* Decoded caps matching what was discovered, the format of the raw data is
+ * only known once the decoder outputs it */
+static GstCaps *
+_get_stream_caps (GESSource *source)
+{
+  GESUriSourcePrivate *priv = GES_URI_SOURCE_PRIV (source);
+  GESMediaType media_type = ges_object_get_media_type (GES_OBJECT (source));
+  GstDiscovererInfo *info;
+  GstCaps *res = NULL;
+  GList *streams;
+
+  if (!priv->asset || !(info = ges_asset_get_info (priv->asset)))
+    return NULL;
+
+  if (media_type == GES_MEDIA_TYPE_VIDEO) {
+    GstDiscovererVideoInfo *video_info;
+
+    streams = gst_discoverer_info_get_video_streams (info);
+    if (!streams)
+      return NULL;
+
+    video_info = streams->data;
+    res = gst_caps_new_simple (GES_RAW_VIDEO_CAPS,
+        "width", G_TYPE_INT, gst_discoverer_video_info_get_width (video_info),
+        "height", G_TYPE_INT, gst_discoverer_video_info_get_height (video_info),
+        NULL);
+    /* Images and variable framerate streams don't have one */
+    if (gst_discoverer_video_info_get_framerate_num (video_info))
+      gst_caps_set_simple (res, "framerate", GST_TYPE_FRACTION,
+          gst_discoverer_video_info_get_framerate_num (video_info),
+          gst_discoverer_video_info_get_framerate_denom (video_info), NULL);
+  } else if (media_type == GES_MEDIA_TYPE_AUDIO) {
+    GstDiscovererAudioInfo *audio_info;
+
+    streams = gst_discoverer_info_get_audio_streams (info);
+    if (!streams)
+      return NULL;
+
+    audio_info = streams->data;
+    res = gst_caps_new_simple (GES_RAW_AUDIO_CAPS,
+        "rate", G_TYPE_INT, gst_discoverer_audio_info_get_sample_rate (audio_info),
+        "channels", G_TYPE_INT, gst_discoverer_audio_info_get_channels (audio_info),
+        NULL);
+  } else {
+    return NULL;
+  }
+
+  gst_discoverer_stream_info_list_free (streams);
+
+  return res;
+}
+
 static gboolean
 _set_inpoint (GESObject *object, GstClockTime inpoint)
 {
   GESUriSourcePrivate *priv = GES_URI_SOURCE_PRIV (object);
   GstClockTime media_duration;
 
-  if (!priv->info)
+  if (!priv->asset)
     goto chain_up;
 
-  media_duration = gst_discoverer_info_get_duration (priv->info);
+  media_duration = ges_asset_get_duration (priv->asset);
 
   if (inpoint >= media_duration) {
     GST_WARNING_OBJECT (object, "Cannot set an inpoint superior to the media duration");
@@ -200,10 +272,10 @@ _set_duration (GESObject *object, GstClockTime duration)
   GESUriSourcePrivate *priv = GES_URI_SOURCE_PRIV (object);
   GstClockTime media_duration;
 
-  if (!priv->info)
+  if (!priv->asset)
     goto chain_up;
 
-  media_duration = gst_discoverer_info_get_duration (priv->info);
+  media_duration = ges_asset_get_duration (priv->asset);
 
   if (ges_object_get_inpoint (object) + duration > media_duration) {
     GST_WARNING_OBJECT (object, "Cannot set a duration which, added to the"
@@ -220,30 +292,46 @@ _serialize (GESObject *object)
 {
   GESUriSourcePrivate *priv = GES_URI_SOURCE_PRIV (object);
 
-  if (priv->original_uri)
-    return g_variant_new ("(ms)", priv->original_uri);
+  if (priv->asset)
+    return g_variant_new ("(ms)", ges_asset_get_uri (priv->asset));
   return g_variant_new ("(ms)", priv->uri);
 }
 
+void
+ges_uri_source_collect_uri (const gchar *type_name, GVariant *subclass_variant,
+    GPtrArray *uris)
+{
+  const gchar *uri;
+
+  if (!subclass_variant || !g_type_is_a (g_type_from_name (type_name), GES_TYPE_URI_SOURCE))
+    return;
+
+  uri = _maybe_get_string_from_tuple (subclass_variant, 0);
+  if (uri)
+    g_ptr_array_add (uris, g_strdup (uri));
+}
+
 static gboolean
 _deserialize (GESObject *object, GVariant *variant)
 {
   GESUriSourcePrivate *priv = GES_URI_SOURCE_PRIV (object);
-  GrlMedia *media;
-  gchar *uri;
+  const gchar *uri = _maybe_get_string_from_tuple (variant, 0);
 
-  uri = g_strdup (_maybe_get_string_from_tuple (variant, 0));
-  media = grl_media_from_uri (uri);
+  if (!uri)
+    return TRUE;
+
+  g_clear_object (&priv->asset);
+  priv->asset = ges_asset_request (uri);
 
-  if (!media) {
+  if (!priv->asset) {
     return TRUE;
   }
 
-  priv->info = _get_discoverer_info_from_grl_media (media);
-  priv->original_uri = uri;
-  priv->uri = g_strdup (grl_media_get_url (media));
-  g_object_set (object, "duration", gst_discoverer_info_get_duration (priv->info), NULL);
-  g_object_set (priv->decodebin, "uri", priv->uri, NULL);
+  g_free (priv->uri);
+  priv->uri = g_strdup (ges_asset_get_url (priv->asset));
+  g_object_set (object, "duration", ges_asset_get_duration (priv->asset), NULL);
+  if (priv->decodebin)
+    g_object_set (priv->decodebin, "uri", priv->uri, NULL);
   GST_ERROR ("I've set uri to %s", priv->uri);
 
   return TRUE;
@@ -294,6 +382,15 @@ _dispose (GObject *object)
 
   if (priv->uri)
     g_free (priv->uri);
+  priv->uri = NULL;
+
+  if (priv->asset)
+    g_object_unref (priv->asset);
+  priv->asset = NULL;
+
+  if (priv->decodebin)
+    g_object_remove_weak_pointer (G_OBJECT (priv->decodebin), (gpointer *) &priv->decodebin);
+  priv->decodebin = NULL;
 
   G_OBJECT_CLASS (ges_uri_source_parent_class)->dispose (object);
 }
@@ -318,6 +415,7 @@ ges_uri_source_class_init (GESUriSourceClass *klass)
   ges_object_class->serialize = _serialize;
   ges_object_class->deserialize = _deserialize;
   source_class->make_element = _make_element;
+  source_class->get_stream_caps = _get_stream_caps;
 }
 
 static void
@@ -326,5 +424,5 @@ ges_uri_source_init (GESUriSource *self)
   GESUriSourcePrivate *priv = GES_URI_SOURCE_PRIV (self);
 
   priv->uri = NULL;
-  priv->info = NULL;
+  priv->asset = NULL;
 }
@@ -1,6 +1,7 @@
 #ifndef _GES_URI_SOURCE
 #define _GES_URI_SOURCE
 
+#include <gio/gio.h>
 #include <gst/gst.h>
 #include <ges-source.h>
 
@@ -11,6 +12,9 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE(GESUriSource, ges_uri_source, GES, URI_SOURCE, GESSource)
 
 GESSource *ges_uri_source_new (const gchar *uri, GESMediaType media_type);
+void ges_uri_source_new_async (const gchar *uri, GESMediaType media_type,
+    GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+GESSource *ges_uri_source_new_finish (GAsyncResult *result, GError **error);
 void ges_uri_source_set_uri (GESUriSource *self, const gchar *uri);
 
 G_END_DECLS
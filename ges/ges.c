@@ -65,6 +65,11 @@ ges_init (void)
 
   nle_init_ghostpad_category ();
 
+  /* Deserializing looks object types up by name */
+  g_type_ensure (GES_TYPE_TIMELINE);
+  g_type_ensure (GES_TYPE_URI_SOURCE);
+  g_type_ensure (GES_TYPE_TEST_SOURCE);
+
   initialize_grilo ();
   return TRUE;
 }
@@ -6,8 +6,13 @@
 #include <ges-playable.h>
 #include <ges-timeline.h>
 #include <ges-source.h>
+#include <ges-effect.h>
 #include <ges-uri-source.h>
 #include <ges-test-source.h>
+#include <ges-discovery-cache.h>
+#include <ges-asset.h>
+#include <ges-clip-table.h>
+#include <ges-journal.h>
 
 G_BEGIN_DECLS
 
@@ -38,12 +38,22 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink_%u",
     GST_STATIC_CAPS ("audio/x-raw")
     );
 
+enum
+{
+  PROP_0,
+  PROP_CAPS,
+};
+
 typedef struct _PadInfos
 {
   GESSmartAudioMixer *self;
   GstPad *mixer_pad;
   GstElement *bin;
   gulong probe_id;
+
+  /* What was last set on mixer_pad, only touched from its streaming thread */
+  gboolean applied;
+  gdouble applied_volume;
 } PadInfos;
 
 static void
@@ -68,7 +78,7 @@ destroy_pad (PadInfos * infos)
 /* These metadata will get set by the upstream framepositionner element,
    added in the video sources' bin */
 static GstPadProbeReturn
-parse_metadata (GstPad * mixer_pad, GstPadProbeInfo * info, gpointer unused)
+parse_metadata (GstPad * mixer_pad, GstPadProbeInfo * info, PadInfos * infos)
 {
   GstSampleControllerMeta *meta;
 
@@ -81,11 +91,61 @@ parse_metadata (GstPad * mixer_pad, GstPadProbeInfo * info, gpointer unused)
     return GST_PAD_PROBE_OK;
   }
 
-  g_object_set (mixer_pad, "volume", meta->volume, NULL);
+  /* Setting it for every buffer is costly, and it rarely changes */
+  if (!infos->applied || infos->applied_volume != meta->volume) {
+    g_object_set (mixer_pad, "volume", meta->volume, NULL);
+    infos->applied_volume = meta->volume;
+    infos->applied = TRUE;
+  }
 
   return GST_PAD_PROBE_OK;
 }
 
+/* Whether our inputs are already in the format we output, see the caps
+ * property */
+static gboolean
+_inputs_are_converted (GESSmartAudioMixer * self)
+{
+  gboolean ret;
+
+  LOCK (self);
+  ret = self->caps && gst_caps_is_fixed (self->caps);
+  UNLOCK (self);
+
+  return ret;
+}
+
+/* Puts audioconvert in front of @infos->mixer_pad, returns the pad
+ * upstream should link to */
+static GstPad *
+_make_converter (GESSmartAudioMixer * self, PadInfos * infos)
+{
+  GstPad *audioconvert_srcpad, *audioconvert_sinkpad, *sinkghost, *srcghost;
+  GstElement *audioconvert;
+
+  infos->bin = gst_bin_new (NULL);
+  audioconvert = gst_element_factory_make ("audioconvert", NULL);
+
+  gst_bin_add (GST_BIN (infos->bin), audioconvert);
+
+  audioconvert_sinkpad = gst_element_get_static_pad (audioconvert, "sink");
+  sinkghost = GST_PAD (gst_ghost_pad_new (NULL, audioconvert_sinkpad));
+  gst_object_unref (audioconvert_sinkpad);
+  gst_pad_set_active (sinkghost, TRUE);
+  gst_element_add_pad (GST_ELEMENT (infos->bin), sinkghost);
+
+  gst_bin_add (GST_BIN (self), infos->bin);
+
+  audioconvert_srcpad = gst_element_get_static_pad (audioconvert, "src");
+  srcghost = GST_PAD (gst_ghost_pad_new (NULL, audioconvert_srcpad));
+  gst_object_unref (audioconvert_srcpad);
+  gst_pad_set_active (srcghost, TRUE);
+  gst_element_add_pad (GST_ELEMENT (infos->bin), srcghost);
+  gst_pad_link (srcghost, infos->mixer_pad);
+
+  return sinkghost;
+}
+
 /****************************************************
  *              GstElement vmetods                  *
  ****************************************************/
@@ -93,11 +153,9 @@ static GstPad *
 _request_new_pad (GstElement * element, GstPadTemplate * templ,
     const gchar * name, const GstCaps * caps)
 {
-  GstPad *audioconvert_srcpad, *audioconvert_sinkpad, *tmpghost;
   PadInfos *infos = g_slice_new0 (PadInfos);
   GESSmartAudioMixer *self = GES_SMART_AUDIO_MIXER (element);
-  GstPad *ghost;
-  GstElement *audioconvert;
+  GstPad *ghost, *target;
 
   infos->mixer_pad = gst_element_request_pad (self->mixer,
       gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (self->mixer),
@@ -112,33 +170,20 @@ _request_new_pad (GstElement * element, GstPadTemplate * templ,
 
   infos->self = self;
 
-  infos->bin = gst_bin_new (NULL);
-  audioconvert = gst_element_factory_make ("audioconvert", NULL);
-
-  gst_bin_add (GST_BIN (infos->bin), audioconvert);
-
-  audioconvert_sinkpad = gst_element_get_static_pad (audioconvert, "sink");
-  tmpghost = GST_PAD (gst_ghost_pad_new (NULL, audioconvert_sinkpad));
-  gst_object_unref (audioconvert_sinkpad);
-  gst_pad_set_active (tmpghost, TRUE);
-  gst_element_add_pad (GST_ELEMENT (infos->bin), tmpghost);
+  /* Sources convert into our format themselves, no need to do it twice */
+  if (_inputs_are_converted (self))
+    target = infos->mixer_pad;
+  else
+    target = _make_converter (self, infos);
 
-  gst_bin_add (GST_BIN (self), infos->bin);
-  ghost = gst_ghost_pad_new (NULL, tmpghost);
+  ghost = gst_ghost_pad_new (NULL, target);
   gst_pad_set_active (ghost, TRUE);
   if (!gst_element_add_pad (GST_ELEMENT (self), ghost))
     goto could_not_add;
 
-  audioconvert_srcpad = gst_element_get_static_pad (audioconvert, "src");
-  tmpghost = GST_PAD (gst_ghost_pad_new (NULL, audioconvert_srcpad));
-  gst_object_unref (audioconvert_srcpad);
-  gst_pad_set_active (tmpghost, TRUE);
-  gst_element_add_pad (GST_ELEMENT (infos->bin), tmpghost);
-  gst_pad_link (tmpghost, infos->mixer_pad);
-
   infos->probe_id =
       gst_pad_add_probe (infos->mixer_pad, GST_PAD_PROBE_TYPE_BUFFER,
-      (GstPadProbeCallback) parse_metadata, NULL, NULL);
+      (GstPadProbeCallback) parse_metadata, infos, NULL);
 
   LOCK (self);
   g_hash_table_insert (self->pads_infos, ghost, infos);
@@ -168,6 +213,42 @@ _release_pad (GstElement * element, GstPad * pad)
 /****************************************************
  *              GObject vmethods                    *
  ****************************************************/
+static void
+ges_smart_audio_mixer_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GESSmartAudioMixer *self = GES_SMART_AUDIO_MIXER (object);
+
+  switch (property_id) {
+    case PROP_CAPS:
+      LOCK (self);
+      gst_caps_replace (&self->caps, gst_value_get_caps (value));
+      UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+ges_smart_audio_mixer_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GESSmartAudioMixer *self = GES_SMART_AUDIO_MIXER (object);
+
+  switch (property_id) {
+    case PROP_CAPS:
+      LOCK (self);
+      gst_value_set_caps (value, self->caps);
+      UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
 static void
 ges_smart_audio_mixer_dispose (GObject * object)
 {
@@ -187,6 +268,7 @@ ges_smart_audio_mixer_finalize (GObject * object)
   GESSmartAudioMixer *self = GES_SMART_AUDIO_MIXER (object);
 
   g_mutex_clear (&self->lock);
+  gst_caps_replace (&self->caps, NULL);
 
   G_OBJECT_CLASS (ges_smart_audio_mixer_parent_class)->finalize (object);
 }
@@ -212,8 +294,21 @@ ges_smart_audio_mixer_class_init (GESSmartAudioMixerClass * klass)
   element_class->request_new_pad = GST_DEBUG_FUNCPTR (_request_new_pad);
   element_class->release_pad = GST_DEBUG_FUNCPTR (_release_pad);
 
+  object_class->set_property = ges_smart_audio_mixer_set_property;
+  object_class->get_property = ges_smart_audio_mixer_get_property;
   object_class->dispose = ges_smart_audio_mixer_dispose;
   object_class->finalize = ges_smart_audio_mixer_finalize;
+
+  /**
+   * GESSmartAudioMixer:caps:
+   *
+   * The format the sources of the composition output. Once fixed, they
+   * are expected to convert into it themselves, and new pads get linked
+   * to the audiomixer without any audioconvert in between.
+   */
+  g_object_class_install_property (object_class, PROP_CAPS,
+      g_param_spec_boxed ("caps", "Caps", "Format of the mixed streams",
+          GST_TYPE_CAPS, G_PARAM_READWRITE));
 }
 
 static void
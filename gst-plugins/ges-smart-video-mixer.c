@@ -17,8 +17,12 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
  */
 
+#include <gst/video/video.h>
+#include <gst/controller/controller.h>
+
 #include "ges-smart-video-mixer.h"
 #include "gstframepositioner.h"
+#include "gstsharedpool.h"
 
 G_DEFINE_TYPE (GESSmartMixer, ges_smart_mixer, GST_TYPE_BIN);
 
@@ -38,22 +42,123 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink_%u",
     GST_STATIC_CAPS ("video/x-raw")
     );
 
+enum
+{
+  PROP_0,
+  PROP_CAPS,
+  PROP_THREADS,
+  PROP_ALLOCATED_BUFFERS,
+  PROP_MIXING,
+  PROP_BYPASSED_FRAMES,
+};
+
+#define DEFAULT_THREADS 1
+#define DEFAULT_MIXING TRUE
+
+/* Bypassed frames kept around until the compositor outputs for their time,
+ * streaming threads don't run much further ahead */
+#define MAX_BYPASSED_FRAMES 8
+/* Same for the alpha values decided for the frames not blended yet */
+#define MAX_PENDING_ALPHAS 8
+
+/* Row granularity of the stripes, so that they don't split subsampled
+ * chroma lines */
+#define STRIPE_ALIGN 16
+
+typedef struct _Stripe
+{
+  GstElement *compositor;
+  gint y;
+} Stripe;
+
+typedef struct _BypassedFrame
+{
+  GstBuffer *buffer;
+  GstClockTime start;
+  GstClockTime end;
+} BypassedFrame;
+
 typedef struct _PadInfos
 {
   GESSmartMixer *self;
   GstPad *mixer_pad;
   GstElement *bin;
+  /* Where the buffers get inspected, mixer_pad or the sink pad of the tee
+   * feeding the stripes */
+  GstPad *probe_pad;
   gulong probe_id;
+  /* Our pads on each of the stripes' compositors, when splitting */
+  GPtrArray *stripe_pads;
+
+  /* What the last buffer of the pad looked like, to tell whether
+   * it hides the others. Protected by the mixer lock */
+  GstSegment segment;
+  gdouble alpha;
+  gint posx;
+  gint posy;
+  guint zorder;
+  /* Size of the incoming frames, and of what gets blended once scaled */
+  gint in_width;
+  gint in_height;
+  gint width;
+  gint height;
+  GstVideoFormat format;
+  gboolean opaque;
+  GstClockTime start;
+  GstClockTime end;
+  /* Running time since which the pad has been fully opaque at the same
+   * place, GST_CLOCK_TIME_NONE if it currently isn't */
+  GstClockTime opaque_since;
+  /* Frames the compositor skips, as they get output as they are in place
+   * of what it blends, oldest first */
+  GQueue bypassed;
+
+  /* The alpha decided for each frame, at its stream time, that the
+   * compositors sync their pads to when blending it. Only set when it
+   * changes, it holds until the next value */
+  GstControlSource *alpha_source;
+  gboolean alpha_applied;
+  gdouble applied_alpha;
+
+  /* What was last set on mixer_pad, only touched from its streaming thread */
+  gboolean applied;
+  gint applied_xpos;
+  gint applied_ypos;
+  guint applied_zorder;
+  gint applied_width;
+  gint applied_height;
 } PadInfos;
 
+static void
+_free_bypassed_frame (BypassedFrame * frame)
+{
+  gst_buffer_unref (frame->buffer);
+  g_slice_free (BypassedFrame, frame);
+}
+
+/* Called with the lock taken */
+static void
+_clear_bypassed_frames (PadInfos * infos)
+{
+  BypassedFrame *frame;
+
+  while ((frame = g_queue_pop_head (&infos->bypassed)))
+    _free_bypassed_frame (frame);
+}
+
 static void
 destroy_pad (PadInfos * infos)
 {
-  gst_pad_remove_probe (infos->mixer_pad, infos->probe_id);
+  guint i;
+
+  if (infos->probe_id)
+    gst_pad_remove_probe (infos->probe_pad, infos->probe_id);
+  gst_object_replace ((GstObject **) & infos->probe_pad, NULL);
 
   if (G_LIKELY (infos->bin)) {
     gst_element_set_state (infos->bin, GST_STATE_NULL);
-    gst_element_unlink (infos->bin, infos->self->mixer);
+    if (infos->mixer_pad)
+      gst_element_unlink (infos->bin, infos->self->mixer);
     gst_bin_remove (GST_BIN (infos->self), infos->bin);
   }
 
@@ -62,18 +167,298 @@ destroy_pad (PadInfos * infos)
     gst_object_unref (infos->mixer_pad);
   }
 
+  if (infos->stripe_pads) {
+    for (i = 0; i < infos->stripe_pads->len; i++) {
+      GstPad *pad = g_ptr_array_index (infos->stripe_pads, i);
+
+      gst_element_release_request_pad (g_array_index (infos->self->stripes,
+              Stripe, i).compositor, pad);
+      gst_object_unref (pad);
+    }
+    g_ptr_array_free (infos->stripe_pads, TRUE);
+  }
+
+  _clear_bypassed_frames (infos);
+  gst_object_unref (infos->alpha_source);
   g_slice_free (PadInfos, infos);
 }
 
+/* Whether @other covers the part of the output @infos would be blended in,
+ * during the whole of its current frame. Called with the lock taken */
+static gboolean
+_hides (PadInfos * other, PadInfos * infos)
+{
+  GESSmartMixer *self = infos->self;
+  gint x0, y0, x1, y1;
+
+  if (other->zorder <= infos->zorder || !GST_CLOCK_TIME_IS_VALID (other->opaque_since))
+    return FALSE;
+
+  /* Streaming threads run ahead of the compositor, @other may already be a
+   * few frames further, it only matters that it didn't change since */
+  if (other->opaque_since > infos->start || !GST_CLOCK_TIME_IS_VALID (other->end)
+      || !GST_CLOCK_TIME_IS_VALID (infos->end) || other->end < infos->end)
+    return FALSE;
+
+  x0 = MAX (infos->posx, 0);
+  y0 = MAX (infos->posy, 0);
+  x1 = infos->posx + infos->width;
+  y1 = infos->posy + infos->height;
+  if (self->out_width && self->out_height) {
+    x1 = MIN (x1, self->out_width);
+    y1 = MIN (y1, self->out_height);
+  }
+
+  return other->posx <= x0 && other->posy <= y0 &&
+      other->posx + other->width >= x1 && other->posy + other->height >= y1;
+}
+
+/* Called with the lock taken */
+static gboolean
+_is_visible (GESSmartMixer * self, PadInfos * infos)
+{
+  GHashTableIter iter;
+  PadInfos *other;
+
+  if (infos->alpha == 0.0)
+    return FALSE;
+
+  /* No telling when it shows */
+  if (!GST_CLOCK_TIME_IS_VALID (infos->start))
+    return TRUE;
+
+  g_hash_table_iter_init (&iter, self->pads_infos);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & other)) {
+    if (other == infos)
+      continue;
+
+    /* Only the top layer shows when not mixing */
+    if (_hides (other, infos) || (!self->mixing && other->zorder > infos->zorder))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Whether the current frame of @infos can be output as it is instead of
+ * what the compositor would blend: it is the top layer and covers the whole
+ * output, opaque unless not mixing, in the output format and size.
+ * Called with the lock taken */
+static gboolean
+_can_bypass (GESSmartMixer * self, PadInfos * infos)
+{
+  GHashTableIter iter;
+  PadInfos *other;
+
+  if (!self->out_width || !self->out_height
+      || !GST_CLOCK_TIME_IS_VALID (infos->start)
+      || !GST_CLOCK_TIME_IS_VALID (infos->end))
+    return FALSE;
+
+  if (infos->format != self->out_format || infos->posx || infos->posy
+      || infos->in_width != self->out_width || infos->in_height != self->out_height
+      || infos->width != self->out_width || infos->height != self->out_height)
+    return FALSE;
+
+  if (self->mixing && (!infos->opaque || infos->alpha < 1.0))
+    return FALSE;
+
+  /* Layers only get added with stack changes, one above now could show
+   * at any time */
+  g_hash_table_iter_init (&iter, self->pads_infos);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & other)) {
+    if (other != infos && other->zorder > infos->zorder)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Called with the lock taken */
+static void
+_queue_bypassed_frame (PadInfos * infos, GstBuffer * buffer)
+{
+  BypassedFrame *frame = g_slice_new (BypassedFrame);
+
+  frame->buffer = gst_buffer_ref (buffer);
+  frame->start = infos->start;
+  frame->end = infos->end;
+  g_queue_push_tail (&infos->bypassed, frame);
+
+  if (g_queue_get_length (&infos->bypassed) > MAX_BYPASSED_FRAMES)
+    _free_bypassed_frame (g_queue_pop_head (&infos->bypassed));
+}
+
+/* The bypassed frame of @infos showing at the running time @start, if
+ * any, dropping the ones that are over. Called with the lock taken */
+static GstBuffer *
+_get_bypassed_frame (PadInfos * infos, GstClockTime start)
+{
+  BypassedFrame *frame;
+
+  while ((frame = g_queue_peek_head (&infos->bypassed)) && frame->end <= start)
+    _free_bypassed_frame (g_queue_pop_head (&infos->bypassed));
+
+  if (!frame || frame->start > start)
+    return NULL;
+
+  return gst_buffer_ref (frame->buffer);
+}
+
+static void
+_parse_caps (PadInfos * infos, GstCaps * caps)
+{
+  GstVideoInfo info;
+
+  if (!gst_video_info_from_caps (&info, caps))
+    return;
+
+  LOCK (infos->self);
+  infos->in_width = GST_VIDEO_INFO_WIDTH (&info);
+  infos->in_height = GST_VIDEO_INFO_HEIGHT (&info);
+  infos->format = GST_VIDEO_INFO_FORMAT (&info);
+  infos->opaque = !GST_VIDEO_INFO_HAS_ALPHA (&info);
+  infos->opaque_since = GST_CLOCK_TIME_NONE;
+  UNLOCK (infos->self);
+}
+
+/* Sets on @pad the values of @meta that differ from the ones last applied,
+ * with the ypos relative to @y_offset */
+static void
+_set_pad_values (PadInfos * infos, GstPad * pad, gint y_offset,
+    GstFramePositionnerMeta * meta)
+{
+  if (!infos->applied || infos->applied_xpos != meta->posx)
+    g_object_set (pad, "xpos", meta->posx, NULL);
+
+  if (!infos->applied || infos->applied_ypos != meta->posy)
+    g_object_set (pad, "ypos", meta->posy - y_offset, NULL);
+
+  if (!infos->applied || infos->applied_zorder != meta->zorder)
+    g_object_set (pad, "zorder", meta->zorder, NULL);
+
+  if (!infos->applied || infos->applied_width != meta->width
+      || infos->applied_height != meta->height)
+    g_object_set (pad, "width", meta->width, "height", meta->height, NULL);
+}
+
+/* Setting properties for every buffer is costly, and mostly useless as they
+ * rarely change, only set those that did */
+static void
+_apply_values (PadInfos * infos, GstFramePositionnerMeta * meta)
+{
+  guint i;
+
+  if (infos->applied && infos->applied_xpos == meta->posx && infos->applied_ypos == meta->posy
+      && infos->applied_zorder == meta->zorder
+      && infos->applied_width == meta->width
+      && infos->applied_height == meta->height)
+    return;
+
+  if (infos->mixer_pad)
+    _set_pad_values (infos, infos->mixer_pad, 0, meta);
+
+  for (i = 0; infos->stripe_pads && i < infos->stripe_pads->len; i++)
+    _set_pad_values (infos, g_ptr_array_index (infos->stripe_pads, i),
+        g_array_index (infos->self->stripes, Stripe, i).y, meta);
+
+  infos->applied = TRUE;
+  infos->applied_xpos = meta->posx;
+  infos->applied_ypos = meta->posy;
+  infos->applied_zorder = meta->zorder;
+  infos->applied_width = meta->width;
+  infos->applied_height = meta->height;
+}
+
+static void
+_bind_alpha (PadInfos * infos, GstPad * pad)
+{
+  gst_object_add_control_binding (GST_OBJECT (pad),
+      gst_direct_control_binding_new_absolute (GST_OBJECT (pad), "alpha",
+          infos->alpha_source));
+}
+
+/* Whether the frame at @stream_time gets blended, and with which alpha,
+ * depends on the frames of the other pads at that time. Deciding it here
+ * and setting it on the pads right away would apply it to the frames they
+ * are still blending, so it gets recorded for the compositors to pick up
+ * when they blend that very frame */
+static void
+_set_alpha (PadInfos * infos, GstClockTime stream_time, gdouble alpha)
+{
+  GstTimedValueControlSource *source =
+      GST_TIMED_VALUE_CONTROL_SOURCE (infos->alpha_source);
+  GList *values, *oldest;
+  guint i;
+
+  if (infos->alpha_applied && infos->applied_alpha == alpha)
+    return;
+
+  /* No telling when it gets blended, nor will the compositors */
+  if (!GST_CLOCK_TIME_IS_VALID (stream_time)) {
+    if (infos->mixer_pad)
+      g_object_set (infos->mixer_pad, "alpha", alpha, NULL);
+    for (i = 0; infos->stripe_pads && i < infos->stripe_pads->len; i++)
+      g_object_set (g_ptr_array_index (infos->stripe_pads, i), "alpha", alpha, NULL);
+    return;
+  }
+
+  gst_timed_value_control_source_set (source, stream_time, alpha);
+  infos->alpha_applied = TRUE;
+  infos->applied_alpha = alpha;
+
+  if (gst_timed_value_control_source_get_count (source) <= MAX_PENDING_ALPHAS)
+    return;
+
+  /* The compositors are past the first value set when playing backward */
+  values = gst_timed_value_control_source_get_all (source);
+  oldest = infos->segment.rate < 0.0 ? g_list_last (values) : values;
+  gst_timed_value_control_source_unset (source,
+      ((GstTimedValue *) oldest->data)->timestamp);
+  g_list_free (values);
+}
+
 /* These metadata will get set by the upstream framepositionner element,
-   added in the video sources' bin */
+   added in the video sources' bin.
+
+   Frames that won't show in the output, because they are fully transparent
+   or hidden by an opaque frame on top of them, get their alpha set to 0 so
+   that the compositor doesn't convert nor blend them. So do frames that
+   are all that shows, those get output as they are instead, see
+   _mixer_src_buffer_probe */
 static GstPadProbeReturn
-parse_metadata (GstPad * mixer_pad, GstPadProbeInfo * info, gpointer unused)
+parse_metadata (GstPad * mixer_pad, GstPadProbeInfo * info, PadInfos * infos)
 {
   GstFramePositionnerMeta *meta;
+  GstBuffer *buffer;
+  GstClockTime pts, start, stream_time;
+  gboolean visible, bypass, opaque;
+  gint width, height;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+    GstCaps *caps;
 
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+      gst_event_parse_caps (event, &caps);
+      _parse_caps (infos, caps);
+    } else if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT) {
+      LOCK (infos->self);
+      gst_event_copy_segment (event, &infos->segment);
+      infos->opaque_since = GST_CLOCK_TIME_NONE;
+      _clear_bypassed_frames (infos);
+      UNLOCK (infos->self);
+      gst_timed_value_control_source_unset_all (GST_TIMED_VALUE_CONTROL_SOURCE
+          (infos->alpha_source));
+      infos->alpha_applied = FALSE;
+    }
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
   meta =
-      (GstFramePositionnerMeta *) gst_buffer_get_meta ((GstBuffer *) info->data,
+      (GstFramePositionnerMeta *) gst_buffer_get_meta (buffer,
       gst_frame_positionner_meta_api_get_type ());
 
   if (!meta) {
@@ -81,12 +466,335 @@ parse_metadata (GstPad * mixer_pad, GstPadProbeInfo * info, gpointer unused)
     return GST_PAD_PROBE_OK;
   }
 
-  g_object_set (mixer_pad, "alpha", meta->alpha, "xpos", meta->posx, "ypos",
-      meta->posy, "zorder", meta->zorder, NULL);
+  pts = GST_BUFFER_PTS (buffer);
+
+  LOCK (infos->self);
+  start = gst_segment_to_running_time (&infos->segment, GST_FORMAT_TIME, pts);
+  stream_time = gst_segment_to_stream_time (&infos->segment, GST_FORMAT_TIME, pts);
+  width = meta->width ? meta->width : infos->in_width;
+  height = meta->height ? meta->height : infos->in_height;
+  opaque = infos->opaque && meta->alpha >= 1.0 && GST_CLOCK_TIME_IS_VALID (start);
+  if (!opaque)
+    infos->opaque_since = GST_CLOCK_TIME_NONE;
+  else if (!GST_CLOCK_TIME_IS_VALID (infos->opaque_since) || infos->posx != meta->posx
+      || infos->posy != meta->posy || infos->zorder != meta->zorder
+      || infos->width != width || infos->height != height)
+    infos->opaque_since = start;
+
+  infos->alpha = meta->alpha;
+  infos->posx = meta->posx;
+  infos->posy = meta->posy;
+  infos->zorder = meta->zorder;
+  infos->width = width;
+  infos->height = height;
+  infos->start = start;
+  infos->end = GST_CLOCK_TIME_NONE;
+  if (GST_CLOCK_TIME_IS_VALID (pts) && GST_BUFFER_DURATION_IS_VALID (buffer))
+    infos->end = gst_segment_to_running_time (&infos->segment, GST_FORMAT_TIME,
+        pts + GST_BUFFER_DURATION (buffer));
+  visible = _is_visible (infos->self, infos);
+  bypass = visible && _can_bypass (infos->self, infos);
+  if (bypass)
+    _queue_bypassed_frame (infos, buffer);
+  UNLOCK (infos->self);
+
+  if (!visible)
+    GST_LOG_OBJECT (mixer_pad, "culling frame at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (pts));
+  else if (bypass)
+    GST_LOG_OBJECT (mixer_pad, "bypassing the compositor at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (pts));
+
+  _set_alpha (infos, stream_time, visible && !bypass ? meta->alpha : 0.0);
+  _apply_values (infos, meta);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* The output format, to know what covers it and what can replace it, and
+ * the segment to tell the running time of the output frames */
+static GstPadProbeReturn
+_mixer_src_event_probe (GstPad * srcpad, GstPadProbeInfo * info,
+    GESSmartMixer * self)
+{
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  GstVideoInfo video_info;
+  GstCaps *caps;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT) {
+    LOCK (self);
+    gst_event_copy_segment (event, &self->out_segment);
+    UNLOCK (self);
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_CAPS)
+    return GST_PAD_PROBE_OK;
+
+  gst_event_parse_caps (event, &caps);
+  if (gst_video_info_from_caps (&video_info, caps)) {
+    LOCK (self);
+    self->out_width = GST_VIDEO_INFO_WIDTH (&video_info);
+    self->out_height = GST_VIDEO_INFO_HEIGHT (&video_info);
+    self->out_format = GST_VIDEO_INFO_FORMAT (&video_info);
+    UNLOCK (self);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* When a single frame is all that shows, the compositor blended nothing
+ * and its output gets replaced by that frame, without any copy. It still
+ * allocated and filled the background of the frame dropped here */
+static GstPadProbeReturn
+_mixer_src_buffer_probe (GstPad * srcpad, GstPadProbeInfo * info,
+    GESSmartMixer * self)
+{
+  GstBuffer *outbuf = GST_PAD_PROBE_INFO_BUFFER (info), *buffer = NULL;
+  GHashTableIter iter;
+  GstClockTime start;
+  PadInfos *infos;
+
+  LOCK (self);
+  start = gst_segment_to_running_time (&self->out_segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (outbuf));
+  if (GST_CLOCK_TIME_IS_VALID (start)) {
+    g_hash_table_iter_init (&iter, self->pads_infos);
+    while (!buffer && g_hash_table_iter_next (&iter, NULL, (gpointer *) & infos))
+      buffer = _get_bypassed_frame (infos, start);
+  }
+  if (buffer)
+    self->n_bypassed++;
+  UNLOCK (self);
+
+  if (!buffer)
+    return GST_PAD_PROBE_OK;
+
+  /* Only copies the metadata, the frame is shared */
+  buffer = gst_buffer_make_writable (buffer);
+  GST_BUFFER_PTS (buffer) = GST_BUFFER_PTS (outbuf);
+  GST_BUFFER_DTS (buffer) = GST_BUFFER_DTS (outbuf);
+  GST_BUFFER_DURATION (buffer) = GST_BUFFER_DURATION (outbuf);
+  GST_BUFFER_OFFSET (buffer) = GST_BUFFER_OFFSET (outbuf);
+  GST_BUFFER_OFFSET_END (buffer) = GST_BUFFER_OFFSET_END (outbuf);
+
+  gst_buffer_unref (outbuf);
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Whether our inputs are already in the format we output, see the caps
+ * property */
+static gboolean
+_inputs_are_converted (GESSmartMixer * self)
+{
+  gboolean ret;
+
+  LOCK (self);
+  ret = self->caps && gst_caps_is_fixed (self->caps);
+  UNLOCK (self);
+
+  return ret;
+}
+
+/* Puts videoconvert in front of @infos->mixer_pad, returns the pad
+ * upstream should link to */
+static GstPad *
+_make_converter (GESSmartMixer * self, PadInfos * infos)
+{
+  GstPad *videoconvert_srcpad, *videoconvert_sinkpad, *sinkghost, *srcghost;
+  GstElement *videoconvert;
+
+  infos->bin = gst_bin_new (NULL);
+  videoconvert = gst_element_factory_make ("videoconvert", NULL);
+
+  gst_bin_add (GST_BIN (infos->bin), videoconvert);
+
+  videoconvert_sinkpad = gst_element_get_static_pad (videoconvert, "sink");
+  sinkghost = GST_PAD (gst_ghost_pad_new (NULL, videoconvert_sinkpad));
+  gst_object_unref (videoconvert_sinkpad);
+  gst_pad_set_active (sinkghost, TRUE);
+  gst_element_add_pad (GST_ELEMENT (infos->bin), sinkghost);
+
+  gst_bin_add (GST_BIN (self), infos->bin);
+
+  videoconvert_srcpad = gst_element_get_static_pad (videoconvert, "src");
+  srcghost = GST_PAD (gst_ghost_pad_new (NULL, videoconvert_srcpad));
+  gst_object_unref (videoconvert_srcpad);
+  gst_pad_set_active (srcghost, TRUE);
+  gst_element_add_pad (GST_ELEMENT (infos->bin), srcghost);
+  gst_pad_link (srcghost, infos->mixer_pad);
+
+  return sinkghost;
+}
+
+/* Splits the output in horizontal stripes, each blended by a compositor of
+ * its own, and so on its own thread, that mixer then stitches together.
+ * Only possible once the output size is known, and has to happen before
+ * any pad gets linked */
+static void
+_setup_stripes (GESSmartMixer * self)
+{
+  GstVideoInfo info;
+  GstCaps *out_caps = NULL;
+  guint n_stripes;
+  gint height, y = 0;
+  guint i;
+
+  LOCK (self);
+  n_stripes = self->n_threads ? self->n_threads : g_get_num_processors ();
+  if (n_stripes > 1 && !self->stripes && !g_hash_table_size (self->pads_infos)
+      && self->caps && gst_caps_is_fixed (self->caps))
+    out_caps = gst_caps_ref (self->caps);
+  UNLOCK (self);
+
+  if (!out_caps || !gst_video_info_from_caps (&info, out_caps))
+    goto done;
+
+  height = GST_ROUND_UP_N ((GST_VIDEO_INFO_HEIGHT (&info) + n_stripes - 1) /
+      n_stripes, STRIPE_ALIGN);
+  if (height >= GST_VIDEO_INFO_HEIGHT (&info))
+    goto done;
+
+  self->stripes = g_array_new (FALSE, FALSE, sizeof (Stripe));
+
+  for (i = 0; y < GST_VIDEO_INFO_HEIGHT (&info); i++, y += height) {
+    Stripe stripe = { NULL, y };
+    GstElement *capsfilter = gst_element_factory_make ("capsfilter", NULL);
+    GstCaps *caps = gst_caps_copy (out_caps);
+    GstPad *srcpad, *stitch_pad;
+
+    stripe.compositor = gst_element_factory_make ("compositor", NULL);
+    g_object_set (stripe.compositor, "background", 1, NULL);
+
+    gst_caps_set_simple (caps, "height", G_TYPE_INT,
+        MIN (height, GST_VIDEO_INFO_HEIGHT (&info) - y), NULL);
+    g_object_set (capsfilter, "caps", caps, NULL);
+    gst_caps_unref (caps);
+
+    gst_bin_add_many (GST_BIN (self), stripe.compositor, capsfilter, NULL);
+    gst_element_link (stripe.compositor, capsfilter);
+
+    stitch_pad = gst_element_request_pad (self->mixer,
+        gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (self->mixer),
+            "sink_%u"), NULL, NULL);
+    g_object_set (stitch_pad, "ypos", y, "zorder", i, NULL);
+    srcpad = gst_element_get_static_pad (capsfilter, "src");
+    gst_pad_link (srcpad, stitch_pad);
+    gst_object_unref (srcpad);
+    gst_object_unref (stitch_pad);
+
+    gst_element_sync_state_with_parent (capsfilter);
+    gst_element_sync_state_with_parent (stripe.compositor);
+
+    g_array_append_val (self->stripes, stripe);
+  }
+
+  GST_INFO_OBJECT (self, "blending in %u stripes of %d lines",
+      self->stripes->len, height);
+
+done:
+  if (out_caps)
+    gst_caps_unref (out_caps);
+}
+
+/* All the stripes forward seeks upstream, one is enough */
+static GstPadProbeReturn
+_drop_seeks_probe (GstPad * pad, GstPadProbeInfo * info, gpointer unused)
+{
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_SEEK)
+    return GST_PAD_PROBE_DROP;
 
   return GST_PAD_PROBE_OK;
 }
 
+/* Puts a tee in front of a new pad on each stripe, returns the pad upstream
+ * should link to */
+static GstPad *
+_make_stripes_tee (GESSmartMixer * self, PadInfos * infos)
+{
+  guint i;
+
+  infos->bin = gst_element_factory_make ("tee", NULL);
+  g_object_set (infos->bin, "allow-not-linked", TRUE, NULL);
+  gst_bin_add (GST_BIN (self), infos->bin);
+  infos->stripe_pads = g_ptr_array_new ();
+
+  for (i = 0; i < self->stripes->len; i++) {
+    GstElement *compositor = g_array_index (self->stripes, Stripe, i).compositor;
+    GstPad *srcpad, *mixer_pad;
+
+    mixer_pad = gst_element_request_pad (compositor,
+        gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (compositor),
+            "sink_%u"), NULL, NULL);
+    srcpad = gst_element_get_request_pad (infos->bin, "src_%u");
+    gst_pad_link (srcpad, mixer_pad);
+    if (i > 0)
+      gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+          (GstPadProbeCallback) _drop_seeks_probe, NULL, NULL);
+    gst_object_unref (srcpad);
+
+    _bind_alpha (infos, mixer_pad);
+    g_ptr_array_add (infos->stripe_pads, mixer_pad);
+  }
+
+  gst_element_sync_state_with_parent (infos->bin);
+
+  return gst_element_get_static_pad (infos->bin, "sink");
+}
+
+/* Lends the buffers of a pool shared by everything feeding us in the same
+ * format, so that sources don't each allocate their own, and keep them
+ * across stack changes */
+static GstPadProbeReturn
+_allocation_query_probe (GstPad * pad, GstPadProbeInfo * info,
+    GESSmartMixer * self)
+{
+  GstQuery *query = GST_PAD_PROBE_INFO_QUERY (info);
+  GstBufferPool *pool = NULL, *client;
+  GstVideoInfo video_info;
+  gboolean need_pool;
+  GstCaps *caps;
+  GList *tmp;
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_ALLOCATION
+      || !(GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_PUSH))
+    return GST_PAD_PROBE_OK;
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+  if (!caps || !need_pool || !gst_video_info_from_caps (&video_info, caps))
+    return GST_PAD_PROBE_OK;
+
+  LOCK (self);
+  for (tmp = self->pools; tmp; tmp = tmp->next) {
+    if (gst_shared_pool_has_caps (tmp->data, caps)) {
+      pool = tmp->data;
+      break;
+    }
+  }
+
+  if (!pool) {
+    pool = gst_shared_pool_new (caps);
+    if (pool)
+      self->pools = g_list_prepend (self->pools, pool);
+  }
+
+  client = pool ? gst_shared_pool_new_client (pool) : NULL;
+  UNLOCK (self);
+
+  if (!client)
+    return GST_PAD_PROBE_OK;
+
+  GST_DEBUG_OBJECT (pad, "proposing the shared pool for %" GST_PTR_FORMAT, caps);
+  gst_query_add_allocation_pool (query, client,
+      GST_VIDEO_INFO_SIZE (&video_info), 0, 0);
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+  gst_object_unref (client);
+
+  return GST_PAD_PROBE_HANDLED;
+}
+
 /****************************************************
  *              GstElement vmetods                  *
  ****************************************************/
@@ -94,52 +802,63 @@ static GstPad *
 _request_new_pad (GstElement * element, GstPadTemplate * templ,
     const gchar * name, const GstCaps * caps)
 {
-  GstPad *videoconvert_srcpad, *videoconvert_sinkpad, *tmpghost;
   PadInfos *infos = g_slice_new0 (PadInfos);
   GESSmartMixer *self = GES_SMART_MIXER (element);
-  GstPad *ghost;
-  GstElement *videoconvert;
+  GstPad *ghost, *target;
 
-  infos->mixer_pad = gst_element_request_pad (self->mixer,
-      gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (self->mixer),
-          "sink_%u"), NULL, NULL);
+  infos->self = self;
+  gst_segment_init (&infos->segment, GST_FORMAT_TIME);
+  infos->alpha = 1.0;
+  infos->start = GST_CLOCK_TIME_NONE;
+  infos->end = GST_CLOCK_TIME_NONE;
+  infos->opaque_since = GST_CLOCK_TIME_NONE;
+  g_queue_init (&infos->bypassed);
+  infos->alpha_source = gst_interpolation_control_source_new ();
+  g_object_set (infos->alpha_source, "mode", GST_INTERPOLATION_MODE_NONE, NULL);
 
-  if (infos->mixer_pad == NULL) {
-    GST_WARNING_OBJECT (element, "Could not get any pad from GstMixer");
-    g_slice_free (PadInfos, infos);
+  _setup_stripes (self);
 
-    return NULL;
-  }
+  if (self->stripes) {
+    /* Sources convert into our format themselves when splitting */
+    target = infos->probe_pad = _make_stripes_tee (self, infos);
+  } else {
+    infos->mixer_pad = gst_element_request_pad (self->mixer,
+        gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (self->mixer),
+            "sink_%u"), NULL, NULL);
 
-  infos->self = self;
+    if (infos->mixer_pad == NULL) {
+      GST_WARNING_OBJECT (element, "Could not get any pad from GstMixer");
+      gst_object_unref (infos->alpha_source);
+      g_slice_free (PadInfos, infos);
 
-  infos->bin = gst_bin_new (NULL);
-  videoconvert = gst_element_factory_make ("videoconvert", NULL);
+      return NULL;
+    }
 
-  gst_bin_add (GST_BIN (infos->bin), videoconvert);
+    _bind_alpha (infos, infos->mixer_pad);
+    infos->probe_pad = gst_object_ref (infos->mixer_pad);
 
-  videoconvert_sinkpad = gst_element_get_static_pad (videoconvert, "sink");
-  tmpghost = GST_PAD (gst_ghost_pad_new (NULL, videoconvert_sinkpad));
-  gst_object_unref (videoconvert_sinkpad);
-  gst_pad_set_active (tmpghost, TRUE);
-  gst_element_add_pad (GST_ELEMENT (infos->bin), tmpghost);
+    /* Sources convert into our format themselves, no need to do it twice */
+    if (_inputs_are_converted (self))
+      target = infos->mixer_pad;
+    else
+      target = _make_converter (self, infos);
+  }
 
-  gst_bin_add (GST_BIN (self), infos->bin);
-  ghost = gst_ghost_pad_new (NULL, tmpghost);
+  ghost = gst_ghost_pad_new (NULL, target);
   gst_pad_set_active (ghost, TRUE);
   if (!gst_element_add_pad (GST_ELEMENT (self), ghost))
     goto could_not_add;
 
-  videoconvert_srcpad = gst_element_get_static_pad (videoconvert, "src");
-  tmpghost = GST_PAD (gst_ghost_pad_new (NULL, videoconvert_srcpad));
-  gst_object_unref (videoconvert_srcpad);
-  gst_pad_set_active (tmpghost, TRUE);
-  gst_element_add_pad (GST_ELEMENT (infos->bin), tmpghost);
-  gst_pad_link (tmpghost, infos->mixer_pad);
-
   infos->probe_id =
-      gst_pad_add_probe (infos->mixer_pad, GST_PAD_PROBE_TYPE_BUFFER,
-      (GstPadProbeCallback) parse_metadata, NULL, NULL);
+      gst_pad_add_probe (infos->probe_pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) parse_metadata, infos, NULL);
+
+  gst_pad_add_probe (ghost, GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM,
+      (GstPadProbeCallback) _allocation_query_probe, self, NULL);
+  if (infos->bin && infos->mixer_pad)
+    gst_pad_add_probe (infos->mixer_pad, GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM,
+        (GstPadProbeCallback) _allocation_query_probe, self, NULL);
 
   LOCK (self);
   g_hash_table_insert (self->pads_infos, ghost, infos);
@@ -159,16 +878,98 @@ could_not_add:
 static void
 _release_pad (GstElement * element, GstPad * pad)
 {
+  GESSmartMixer *self = GES_SMART_MIXER (element);
+  PadInfos *infos;
+
   GST_DEBUG_OBJECT (element, "Releasing pad %" GST_PTR_FORMAT, pad);
 
+  /* The streaming threads of the other pads take the lock, tearing down
+   * the pad has to happen without it */
   LOCK (element);
-  g_hash_table_remove (GES_SMART_MIXER (element)->pads_infos, pad);
+  infos = g_hash_table_lookup (self->pads_infos, pad);
+  g_hash_table_steal (self->pads_infos, pad);
   UNLOCK (element);
+
+  if (infos)
+    destroy_pad (infos);
 }
 
 /****************************************************
  *              GObject vmethods                    *
  ****************************************************/
+static void
+ges_smart_mixer_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GESSmartMixer *self = GES_SMART_MIXER (object);
+
+  switch (property_id) {
+    case PROP_CAPS:
+      LOCK (self);
+      gst_caps_replace (&self->caps, gst_value_get_caps (value));
+      UNLOCK (self);
+      break;
+    case PROP_THREADS:
+      LOCK (self);
+      self->n_threads = g_value_get_uint (value);
+      UNLOCK (self);
+      break;
+    case PROP_MIXING:
+      LOCK (self);
+      self->mixing = g_value_get_boolean (value);
+      UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+ges_smart_mixer_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GESSmartMixer *self = GES_SMART_MIXER (object);
+
+  switch (property_id) {
+    case PROP_CAPS:
+      LOCK (self);
+      gst_value_set_caps (value, self->caps);
+      UNLOCK (self);
+      break;
+    case PROP_THREADS:
+      LOCK (self);
+      g_value_set_uint (value, self->n_threads);
+      UNLOCK (self);
+      break;
+    case PROP_MIXING:
+      LOCK (self);
+      g_value_set_boolean (value, self->mixing);
+      UNLOCK (self);
+      break;
+    case PROP_BYPASSED_FRAMES:
+      LOCK (self);
+      g_value_set_uint (value, self->n_bypassed);
+      UNLOCK (self);
+      break;
+    case PROP_ALLOCATED_BUFFERS:
+    {
+      guint n_allocated = 0;
+      GList *tmp;
+
+      LOCK (self);
+      for (tmp = self->pools; tmp; tmp = tmp->next)
+        n_allocated += gst_shared_pool_get_n_allocated (tmp->data);
+      UNLOCK (self);
+      g_value_set_uint (value, n_allocated);
+      break;
+    }
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
 static void
 ges_smart_mixer_dispose (GObject * object)
 {
@@ -182,12 +983,23 @@ ges_smart_mixer_dispose (GObject * object)
   G_OBJECT_CLASS (ges_smart_mixer_parent_class)->dispose (object);
 }
 
+static void
+_free_pool (GstBufferPool * pool)
+{
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
 static void
 ges_smart_mixer_finalize (GObject * object)
 {
   GESSmartMixer *self = GES_SMART_MIXER (object);
 
   g_mutex_clear (&self->lock);
+  gst_caps_replace (&self->caps, NULL);
+  if (self->stripes)
+    g_array_free (self->stripes, TRUE);
+  g_list_free_full (self->pools, (GDestroyNotify) _free_pool);
 
   G_OBJECT_CLASS (ges_smart_mixer_parent_class)->finalize (object);
 }
@@ -213,8 +1025,70 @@ ges_smart_mixer_class_init (GESSmartMixerClass * klass)
   element_class->request_new_pad = GST_DEBUG_FUNCPTR (_request_new_pad);
   element_class->release_pad = GST_DEBUG_FUNCPTR (_release_pad);
 
+  object_class->set_property = ges_smart_mixer_set_property;
+  object_class->get_property = ges_smart_mixer_get_property;
   object_class->dispose = ges_smart_mixer_dispose;
   object_class->finalize = ges_smart_mixer_finalize;
+
+  /**
+   * GESSmartMixer:caps:
+   *
+   * The format the sources of the composition output. Once fixed, they
+   * are expected to convert into it themselves, and new pads get linked
+   * to the compositor without any videoconvert in between.
+   */
+  g_object_class_install_property (object_class, PROP_CAPS,
+      g_param_spec_boxed ("caps", "Caps", "Format of the mixed streams",
+          GST_TYPE_CAPS, G_PARAM_READWRITE));
+
+  /**
+   * GESSmartMixer:threads:
+   *
+   * How many threads to blend with, 0 meaning one per processor. The
+   * output gets split in that many horizontal stripes, each blended on its
+   * own thread with all the layers in order, and then stitched together.
+   * Only applies if caps are fixed by the time the first pad is requested.
+   */
+  g_object_class_install_property (object_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads", "Number of blending threads, "
+          "0 for one per processor", 0, 64, DEFAULT_THREADS,
+          G_PARAM_READWRITE));
+
+  /**
+   * GESSmartMixer:allocated-buffers:
+   *
+   * How many buffers were allocated by the pools the mixer shares between
+   * the elements feeding it. Those live as long as the mixer, and get
+   * reused across stack changes.
+   */
+  g_object_class_install_property (object_class, PROP_ALLOCATED_BUFFERS,
+      g_param_spec_uint ("allocated-buffers", "Allocated buffers",
+          "Buffers allocated by the shared pools", 0, G_MAXUINT, 0,
+          G_PARAM_READABLE));
+
+  /**
+   * GESSmartMixer:mixing:
+   *
+   * Whether to blend the layers together. When %FALSE only the top layer
+   * shows, as if it was opaque and hid all the others.
+   *
+   * Either way, frames of the top layer that are all that shows, in the
+   * output format and size, get output as they are instead of being
+   * blended over the background.
+   */
+  g_object_class_install_property (object_class, PROP_MIXING,
+      g_param_spec_boolean ("mixing", "Mixing", "Blend the layers together",
+          DEFAULT_MIXING, G_PARAM_READWRITE));
+
+  /**
+   * GESSmartMixer:bypassed-frames:
+   *
+   * How many frames were output as they came in, without blending.
+   */
+  g_object_class_install_property (object_class, PROP_BYPASSED_FRAMES,
+      g_param_spec_uint ("bypassed-frames", "Bypassed frames",
+          "Frames output without blending", 0, G_MAXUINT, 0,
+          G_PARAM_READABLE));
 }
 
 static void
@@ -222,6 +1096,10 @@ ges_smart_mixer_init (GESSmartMixer * self)
 {
   GstPad *pad;
   g_mutex_init (&self->lock);
+  self->n_threads = DEFAULT_THREADS;
+  self->mixing = DEFAULT_MIXING;
+  self->out_format = GST_VIDEO_FORMAT_UNKNOWN;
+  gst_segment_init (&self->out_segment, GST_FORMAT_TIME);
 
   self->mixer = gst_element_factory_make ("compositor",
       "smart-mixer-mixer");
@@ -229,6 +1107,10 @@ ges_smart_mixer_init (GESSmartMixer * self)
   gst_bin_add (GST_BIN (self), self->mixer);
 
   pad = gst_element_get_static_pad (self->mixer, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) _mixer_src_event_probe, self, NULL);
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) _mixer_src_buffer_probe, self, NULL);
   self->srcpad = gst_ghost_pad_new ("src", pad);
   gst_pad_set_active (self->srcpad, TRUE);
   gst_object_unref (pad);
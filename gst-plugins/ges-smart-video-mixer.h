@@ -22,6 +22,7 @@
 
 #include <glib-object.h>
 #include <gst/gst.h>
+#include <gst/video/video.h>
 
 G_BEGIN_DECLS
 
@@ -50,6 +51,23 @@ struct _GESSmartMixer
   GMutex lock;
 
   GstCaps *caps;
+  /* Size of the mixed frames, 0 until negotiated */
+  gint out_width;
+  gint out_height;
+  GstVideoFormat out_format;
+  GstSegment out_segment;
+
+  /* See the mixing property */
+  gboolean mixing;
+  guint n_bypassed;
+
+  /* See the threads property. When splitting, mixer only stitches the
+   * horizontal stripes blended by the compositors in stripes */
+  guint n_threads;
+  GArray *stripes;
+
+  /* Buffer pools lent to whatever feeds us, one per format */
+  GList *pools;
 };
 
 GType         ges_smart_mixer_get_type (void) G_GNUC_CONST;
@@ -0,0 +1,314 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+/* backgroundsrc outputs black frames or silence, to fill the gaps of the
+ * timeline compositions. The data is generated once when the caps are set,
+ * then the same read-only buffer is pushed over and over again, only its
+ * timestamps change. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+
+#include "gstbackgroundsrc.h"
+
+/* Same defaults as videotestsrc and audiotestsrc, which we replace */
+#define DEFAULT_WIDTH 320
+#define DEFAULT_HEIGHT 240
+#define DEFAULT_FPS_N 30
+#define DEFAULT_FPS_D 1
+#define DEFAULT_RATE 44100
+#define DEFAULT_CHANNELS 1
+#define DEFAULT_SAMPLES_PER_BUFFER 1024
+
+static GstStaticPadTemplate gst_background_src_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{ AYUV, BGRA, ARGB, RGBA, ABGR, "
+            "I420, YV12, NV12, NV21, Y444, Y42B, YUY2, UYVY, xRGB, BGRx, "
+            "RGBx, xBGR, RGB, BGR }") "; "
+        GST_AUDIO_CAPS_MAKE (GST_AUDIO_FORMATS_ALL))
+    );
+
+G_DEFINE_TYPE (GstBackgroundSrc, gst_background_src, GST_TYPE_BASE_SRC);
+
+/* Fills @buffer with black, line by line through the pack function of its
+ * format so that we don't need to know about each of them */
+static gboolean
+gst_background_src_fill_black (GstBackgroundSrc * self, GstBuffer * buffer)
+{
+  const GstVideoFormatInfo *finfo = self->video_info.finfo;
+  gint width = GST_VIDEO_INFO_WIDTH (&self->video_info);
+  gint height = GST_VIDEO_INFO_HEIGHT (&self->video_info);
+  gboolean is_64 = finfo->unpack_format == GST_VIDEO_FORMAT_AYUV64 ||
+      finfo->unpack_format == GST_VIDEO_FORMAT_ARGB64;
+  gboolean is_yuv = GST_VIDEO_FORMAT_INFO_IS_YUV (finfo) ||
+      GST_VIDEO_FORMAT_INFO_IS_GRAY (finfo);
+  gint sstride = width * (is_64 ? 8 : 4);
+  GstVideoFrame frame;
+  guint8 *lines;
+  gint x, y;
+
+  if (!finfo->pack_func)
+    return FALSE;
+
+  if (!gst_video_frame_map (&frame, &self->video_info, buffer, GST_MAP_WRITE))
+    return FALSE;
+
+  lines = g_malloc (sstride * finfo->pack_lines);
+
+  for (x = 0; x < width * finfo->pack_lines; x++) {
+    /* Opaque black, with limited range luma for YUV */
+    guint16 pixel[4] = { 0xffff, is_yuv ? 16 << 8 : 0, is_yuv ? 128 << 8 : 0,
+      is_yuv ? 128 << 8 : 0
+    };
+    gint c;
+
+    for (c = 0; c < 4; c++) {
+      if (is_64)
+        ((guint16 *) lines)[x * 4 + c] = pixel[c];
+      else
+        lines[x * 4 + c] = pixel[c] >> 8;
+    }
+  }
+
+  for (y = 0; y < height; y += finfo->pack_lines)
+    finfo->pack_func (finfo, GST_VIDEO_PACK_FLAG_NONE, lines, sstride,
+        frame.data, frame.info.stride, frame.info.chroma_site, y, width);
+
+  g_free (lines);
+  gst_video_frame_unmap (&frame);
+
+  return TRUE;
+}
+
+static gboolean
+gst_background_src_set_caps (GstBaseSrc * basesrc, GstCaps * caps)
+{
+  GstBackgroundSrc *self = GST_BACKGROUND_SRC (basesrc);
+  GstStructure *structure = gst_caps_get_structure (caps, 0);
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gsize size;
+  guint i;
+
+  self->is_video = gst_structure_has_name (structure, "video/x-raw");
+
+  if (self->is_video) {
+    if (!gst_video_info_from_caps (&self->video_info, caps))
+      goto invalid_caps;
+    size = GST_VIDEO_INFO_SIZE (&self->video_info);
+  } else {
+    if (!gst_audio_info_from_caps (&self->audio_info, caps))
+      goto invalid_caps;
+    size = self->samples_per_buffer * GST_AUDIO_INFO_BPF (&self->audio_info);
+  }
+
+  buffer = gst_buffer_new_allocate (NULL, size, NULL);
+
+  if (self->is_video) {
+    if (!gst_background_src_fill_black (self, buffer)) {
+      gst_buffer_unref (buffer);
+      goto invalid_caps;
+    }
+  } else {
+    gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+    gst_audio_format_fill_silence (self->audio_info.finfo, map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+
+    /* Lets mixers skip it instead of adding silence */
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
+  }
+
+  /* Downstream has to copy it before writing to it */
+  for (i = 0; i < gst_buffer_n_memory (buffer); i++)
+    GST_MINI_OBJECT_FLAG_SET (gst_buffer_peek_memory (buffer, i),
+        GST_MEMORY_FLAG_READONLY);
+
+  gst_buffer_replace (&self->buffer, buffer);
+  gst_buffer_unref (buffer);
+
+  GST_DEBUG_OBJECT (self, "prepared our %" G_GSIZE_FORMAT " bytes of background"
+      " for %" GST_PTR_FORMAT, size, caps);
+
+  return TRUE;
+
+invalid_caps:
+  {
+    GST_ERROR_OBJECT (self, "can't output %" GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+}
+
+static GstCaps *
+gst_background_src_fixate (GstBaseSrc * basesrc, GstCaps * caps)
+{
+  GstStructure *structure;
+  gint channels;
+
+  caps = gst_caps_truncate (gst_caps_make_writable (caps));
+  structure = gst_caps_get_structure (caps, 0);
+
+  if (gst_structure_has_name (structure, "video/x-raw")) {
+    gst_structure_fixate_field_nearest_int (structure, "width", DEFAULT_WIDTH);
+    gst_structure_fixate_field_nearest_int (structure, "height", DEFAULT_HEIGHT);
+    gst_structure_fixate_field_nearest_fraction (structure, "framerate",
+        DEFAULT_FPS_N, DEFAULT_FPS_D);
+  } else {
+    gst_structure_fixate_field_nearest_int (structure, "rate", DEFAULT_RATE);
+    gst_structure_fixate_field_nearest_int (structure, "channels",
+        DEFAULT_CHANNELS);
+
+    if (gst_structure_get_int (structure, "channels", &channels) && channels > 2
+        && !gst_structure_has_field (structure, "channel-mask"))
+      gst_structure_set (structure, "channel-mask", GST_TYPE_BITMASK,
+          gst_audio_channel_get_fallback_mask (channels), NULL);
+  }
+
+  return GST_BASE_SRC_CLASS (gst_background_src_parent_class)->fixate (basesrc,
+      caps);
+}
+
+static gboolean
+gst_background_src_is_seekable (GstBaseSrc * basesrc)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_background_src_do_seek (GstBaseSrc * basesrc, GstSegment * segment)
+{
+  GstBackgroundSrc *self = GST_BACKGROUND_SRC (basesrc);
+
+  segment->time = segment->start;
+  self->start_time = segment->start;
+  self->n_units = 0;
+
+  return TRUE;
+}
+
+static GstClockTime
+gst_background_src_get_time (GstBackgroundSrc * self, guint64 n_units)
+{
+  if (self->is_video)
+    return self->start_time + gst_util_uint64_scale (n_units,
+        self->video_info.fps_d * GST_SECOND, self->video_info.fps_n);
+
+  return self->start_time + gst_util_uint64_scale (n_units, GST_SECOND,
+      GST_AUDIO_INFO_RATE (&self->audio_info));
+}
+
+static GstFlowReturn
+gst_background_src_create (GstBaseSrc * basesrc, guint64 offset,
+    guint length, GstBuffer ** ret)
+{
+  GstBackgroundSrc *self = GST_BACKGROUND_SRC (basesrc);
+  guint64 n_units = self->is_video ? 1 : self->samples_per_buffer;
+  GstClockTime pts, next_pts;
+  GstBuffer *buffer;
+
+  if (!self->buffer)
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  /* Still images get pushed once */
+  if (self->is_video && self->video_info.fps_n == 0) {
+    if (self->n_units)
+      return GST_FLOW_EOS;
+    pts = self->start_time;
+    next_pts = GST_CLOCK_TIME_NONE;
+  } else {
+    pts = gst_background_src_get_time (self, self->n_units);
+    next_pts = gst_background_src_get_time (self, self->n_units + n_units);
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (basesrc->segment.stop)
+      && pts >= basesrc->segment.stop)
+    return GST_FLOW_EOS;
+
+  /* Our buffer is only writable again once downstream is done with it,
+   * otherwise share its memory with a new one */
+  if (gst_buffer_is_writable (self->buffer))
+    buffer = gst_buffer_ref (self->buffer);
+  else
+    buffer = gst_buffer_copy (self->buffer);
+
+  GST_BUFFER_PTS (buffer) = pts;
+  GST_BUFFER_DTS (buffer) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (buffer) = GST_CLOCK_TIME_IS_VALID (next_pts) ?
+      next_pts - pts : GST_CLOCK_TIME_NONE;
+  GST_BUFFER_OFFSET (buffer) = self->n_units;
+  GST_BUFFER_OFFSET_END (buffer) = self->n_units + n_units;
+  if (self->n_units)
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DISCONT);
+  else
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+
+  self->n_units += n_units;
+  *ret = buffer;
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_background_src_stop (GstBaseSrc * basesrc)
+{
+  GstBackgroundSrc *self = GST_BACKGROUND_SRC (basesrc);
+
+  gst_buffer_replace (&self->buffer, NULL);
+  self->start_time = 0;
+  self->n_units = 0;
+
+  return TRUE;
+}
+
+static void
+gst_background_src_class_init (GstBackgroundSrcClass * klass)
+{
+  GstBaseSrcClass *base_src_class = GST_BASE_SRC_CLASS (klass);
+
+  gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
+      gst_static_pad_template_get (&gst_background_src_src_template));
+
+  base_src_class->set_caps = GST_DEBUG_FUNCPTR (gst_background_src_set_caps);
+  base_src_class->fixate = GST_DEBUG_FUNCPTR (gst_background_src_fixate);
+  base_src_class->is_seekable =
+      GST_DEBUG_FUNCPTR (gst_background_src_is_seekable);
+  base_src_class->do_seek = GST_DEBUG_FUNCPTR (gst_background_src_do_seek);
+  base_src_class->create = GST_DEBUG_FUNCPTR (gst_background_src_create);
+  base_src_class->stop = GST_DEBUG_FUNCPTR (gst_background_src_stop);
+
+  gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
+      "background source", "Source/Video/Audio",
+      "Outputs black frames or silence at no cost",
+      "mduponchelle1@gmail.com");
+}
+
+static void
+gst_background_src_init (GstBackgroundSrc * self)
+{
+  self->buffer = NULL;
+  self->samples_per_buffer = DEFAULT_SAMPLES_PER_BUFFER;
+  self->start_time = 0;
+  self->n_units = 0;
+
+  gst_base_src_set_format (GST_BASE_SRC (self), GST_FORMAT_TIME);
+}
@@ -0,0 +1,66 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_BACKGROUND_SRC_H_
+#define _GST_BACKGROUND_SRC_H_
+
+#include <gst/base/gstbasesrc.h>
+#include <gst/video/video.h>
+#include <gst/audio/audio.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_BACKGROUND_SRC   (gst_background_src_get_type())
+#define GST_BACKGROUND_SRC(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_BACKGROUND_SRC,GstBackgroundSrc))
+#define GST_BACKGROUND_SRC_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_BACKGROUND_SRC,GstBackgroundSrcClass))
+#define GST_IS_BACKGROUND_SRC(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_BACKGROUND_SRC))
+#define GST_IS_BACKGROUND_SRC_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_BACKGROUND_SRC))
+
+typedef struct _GstBackgroundSrc GstBackgroundSrc;
+typedef struct _GstBackgroundSrcClass GstBackgroundSrcClass;
+
+struct _GstBackgroundSrc
+{
+  GstBaseSrc parent;
+
+  /* Black frame or silence, the only data we ever output */
+  GstBuffer *buffer;
+
+  gboolean is_video;
+  GstVideoInfo video_info;
+  GstAudioInfo audio_info;
+  guint samples_per_buffer;
+
+  /* Frames or samples output since start_time */
+  GstClockTime start_time;
+  guint64 n_units;
+
+  /*  This should never be made public, no padding needed */
+};
+
+struct _GstBackgroundSrcClass
+{
+  GstBaseSrcClass parent_class;
+};
+
+GType gst_background_src_get_type (void);
+
+G_END_DECLS
+
+#endif
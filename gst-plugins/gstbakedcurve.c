@@ -0,0 +1,185 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstbakedcurve.h"
+
+/* How much gets computed at once */
+#define CHUNK_DURATION GST_SECOND
+#define DEFAULT_INTERVAL (40 * GST_MSECOND)
+
+struct _GstBakedCurve
+{
+  /* Not reffed, owns us */
+  GstObject *object;
+  gchar *property;
+  GstClockTime interval;
+
+  /* Set from any thread to have the table rebuilt */
+  gint dirty;
+
+  /* Whether the property is controlled at all, checked once per bake */
+  gboolean controlled;
+  GstClockTime start;
+  guint n_values;
+  gdouble *values;
+};
+
+GstBakedCurve *
+gst_baked_curve_new (GstObject * object, const gchar * property)
+{
+  GstBakedCurve *curve = g_slice_new0 (GstBakedCurve);
+
+  curve->object = object;
+  curve->property = g_strdup (property);
+  curve->interval = DEFAULT_INTERVAL;
+  curve->dirty = TRUE;
+
+  return curve;
+}
+
+void
+gst_baked_curve_free (GstBakedCurve * curve)
+{
+  g_free (curve->values);
+  g_free (curve->property);
+  g_slice_free (GstBakedCurve, curve);
+}
+
+void
+gst_baked_curve_set_interval (GstBakedCurve * curve, GstClockTime interval)
+{
+  curve->interval = interval ? interval : DEFAULT_INTERVAL;
+  gst_baked_curve_invalidate (curve);
+}
+
+void
+gst_baked_curve_invalidate (GstBakedCurve * curve)
+{
+  g_atomic_int_set (&curve->dirty, TRUE);
+}
+
+/* Fills the table from @timestamp on, returns FALSE if the property isn't
+ * controlled */
+static gboolean
+_bake (GstBakedCurve * curve, GstClockTime timestamp)
+{
+  GstControlBinding *binding;
+  GValue current = G_VALUE_INIT;
+  GType type;
+  gpointer values;
+  gboolean ret;
+  guint i, n_values = CHUNK_DURATION / curve->interval + 2;
+
+  curve->n_values = 0;
+  curve->controlled = FALSE;
+
+  binding = gst_object_get_control_binding (curve->object, curve->property);
+  if (!binding)
+    return FALSE;
+
+  type = G_PARAM_SPEC_VALUE_TYPE (binding->pspec);
+  if (type == G_TYPE_DOUBLE)
+    values = g_new (gdouble, n_values);
+  else if (type == G_TYPE_INT || type == G_TYPE_UINT)
+    values = g_new (gint, n_values);
+  else {
+    GST_WARNING_OBJECT (curve->object, "can't bake %s curves", g_type_name (type));
+    gst_object_unref (binding);
+    return FALSE;
+  }
+
+  /* The binding leaves the entries it has no value for alone, before the
+   * first keyframe for example, where the property keeps its value */
+  g_value_init (&current, type);
+  g_object_get_property (G_OBJECT (curve->object), binding->pspec->name, &current);
+  for (i = 0; i < n_values; i++) {
+    if (type == G_TYPE_DOUBLE)
+      ((gdouble *) values)[i] = g_value_get_double (&current);
+    else if (type == G_TYPE_INT)
+      ((gint *) values)[i] = g_value_get_int (&current);
+    else
+      ((guint *) values)[i] = g_value_get_uint (&current);
+  }
+  g_value_unset (&current);
+
+  ret = gst_control_binding_get_value_array (binding, timestamp, curve->interval,
+      n_values, values);
+  gst_object_unref (binding);
+
+  if (!ret) {
+    g_free (values);
+    return FALSE;
+  }
+
+  curve->values = g_renew (gdouble, curve->values, n_values);
+  for (i = 0; i < n_values; i++) {
+    if (type == G_TYPE_DOUBLE)
+      curve->values[i] = ((gdouble *) values)[i];
+    else if (type == G_TYPE_INT)
+      curve->values[i] = ((gint *) values)[i];
+    else
+      curve->values[i] = ((guint *) values)[i];
+  }
+  g_free (values);
+
+  curve->start = timestamp;
+  curve->n_values = n_values;
+  curve->controlled = TRUE;
+
+  GST_LOG_OBJECT (curve->object, "baked %u values of %s from %" GST_TIME_FORMAT,
+      n_values, curve->property, GST_TIME_ARGS (timestamp));
+
+  return TRUE;
+}
+
+/* The value at @timestamp, linearly interpolated between the baked ones.
+ * Returns FALSE if the property isn't controlled */
+gboolean
+gst_baked_curve_get_value (GstBakedCurve * curve, GstClockTime timestamp,
+    gdouble * value)
+{
+  GstClockTime offset;
+  guint index;
+  gdouble frac;
+
+  if (g_atomic_int_compare_and_exchange (&curve->dirty, TRUE, FALSE)) {
+    if (!_bake (curve, timestamp))
+      return FALSE;
+  } else if (!curve->controlled) {
+    return FALSE;
+  }
+
+  if (timestamp < curve->start
+      || timestamp >= curve->start + (curve->n_values - 1) * curve->interval) {
+    if (!_bake (curve, timestamp))
+      return FALSE;
+  }
+
+  offset = timestamp - curve->start;
+  index = offset / curve->interval;
+  frac = (gdouble) (offset % curve->interval) / curve->interval;
+  *value = curve->values[index] + frac * (curve->values[index + 1] -
+      curve->values[index]);
+
+  return TRUE;
+}
@@ -0,0 +1,44 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_BAKED_CURVE_H_
+#define _GST_BAKED_CURVE_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* The values of a controlled property of an element precomputed a chunk at
+ * a time, every interval, so that looking one up is an indexed read
+ * instead of walking the control binding and source.
+ *
+ * Looking up values is meant to be done from the streaming thread only,
+ * invalidating from anywhere. */
+typedef struct _GstBakedCurve GstBakedCurve;
+
+GstBakedCurve * gst_baked_curve_new          (GstObject * object, const gchar * property);
+void            gst_baked_curve_free         (GstBakedCurve * curve);
+void            gst_baked_curve_set_interval (GstBakedCurve * curve, GstClockTime interval);
+void            gst_baked_curve_invalidate   (GstBakedCurve * curve);
+gboolean        gst_baked_curve_get_value    (GstBakedCurve * curve, GstClockTime timestamp,
+                                              gdouble * value);
+
+G_END_DECLS
+
+#endif
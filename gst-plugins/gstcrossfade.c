@@ -0,0 +1,497 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcrossfade.h"
+#include "gstframepositioner.h"
+
+#if defined(__SSE2__)
+#define HAVE_SSE2_BLEND
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_NEON_BLEND
+#include <arm_neon.h>
+#endif
+
+/* Formats with 8 bits per component, blending them byte per byte is a
+ * crossfade whatever the components are */
+#define CROSSFADE_CAPS GST_VIDEO_CAPS_MAKE ("{ AYUV, ARGB, BGRA, RGBA, ABGR, " \
+    "xRGB, RGBx, xBGR, BGRx, RGB, BGR, Y444, Y42B, I420, YV12, NV12, NV21, " \
+    "YUY2, UYVY, GRAY8 }")
+
+enum
+{
+  PROP_0,
+  PROP_DURATION,
+};
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (CROSSFADE_CAPS)
+    );
+
+static GstStaticPadTemplate sink_0_template =
+GST_STATIC_PAD_TEMPLATE ("sink_0",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (CROSSFADE_CAPS)
+    );
+
+static GstStaticPadTemplate sink_1_template =
+GST_STATIC_PAD_TEMPLATE ("sink_1",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (CROSSFADE_CAPS)
+    );
+
+G_DEFINE_TYPE (GstCrossfade, gst_crossfade, GST_TYPE_ELEMENT);
+
+/**
+ * gst_crossfade_blend_line:
+ * @dest: the bytes fading out, overwritten with the result
+ * @src: the bytes fading in
+ * @n_bytes: how many bytes to blend
+ * @weight: the weight of @src, out of 256
+ */
+void
+gst_crossfade_blend_line (guint8 * dest, const guint8 * src, guint n_bytes,
+    guint weight)
+{
+  guint inv = 256 - weight;
+  guint i = 0;
+
+#if defined(HAVE_SSE2_BLEND)
+  __m128i w = _mm_set1_epi16 (weight), iw = _mm_set1_epi16 (inv);
+  __m128i zero = _mm_setzero_si128 ();
+
+  /* The sums fit in unsigned 16 bits, the shift brings them back to 8 */
+  for (; i + 16 <= n_bytes; i += 16) {
+    __m128i d = _mm_loadu_si128 ((const __m128i *) (dest + i));
+    __m128i s = _mm_loadu_si128 ((const __m128i *) (src + i));
+    __m128i lo = _mm_add_epi16 (_mm_mullo_epi16 (_mm_unpacklo_epi8 (d, zero),
+            iw), _mm_mullo_epi16 (_mm_unpacklo_epi8 (s, zero), w));
+    __m128i hi = _mm_add_epi16 (_mm_mullo_epi16 (_mm_unpackhi_epi8 (d, zero),
+            iw), _mm_mullo_epi16 (_mm_unpackhi_epi8 (s, zero), w));
+
+    _mm_storeu_si128 ((__m128i *) (dest + i),
+        _mm_packus_epi16 (_mm_srli_epi16 (lo, 8), _mm_srli_epi16 (hi, 8)));
+  }
+#elif defined(HAVE_NEON_BLEND)
+  for (; i + 16 <= n_bytes; i += 16) {
+    uint8x16_t d = vld1q_u8 (dest + i);
+    uint8x16_t s = vld1q_u8 (src + i);
+    uint16x8_t lo = vmulq_n_u16 (vmovl_u8 (vget_low_u8 (d)), inv);
+    uint16x8_t hi = vmulq_n_u16 (vmovl_u8 (vget_high_u8 (d)), inv);
+
+    lo = vmlaq_n_u16 (lo, vmovl_u8 (vget_low_u8 (s)), weight);
+    hi = vmlaq_n_u16 (hi, vmovl_u8 (vget_high_u8 (s)), weight);
+    vst1q_u8 (dest + i, vcombine_u8 (vshrn_n_u16 (lo, 8), vshrn_n_u16 (hi,
+                8)));
+  }
+#endif
+
+  for (; i < n_bytes; i++)
+    dest[i] = (dest[i] * inv + src[i] * weight) >> 8;
+}
+
+static void
+_blend_frames (GstVideoFrame * dest, GstVideoFrame * src, guint weight)
+{
+  const GstVideoFormatInfo *finfo = dest->info.finfo;
+  guint plane, comp;
+  gint row, width, height;
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (dest); plane++) {
+    guint8 *d = GST_VIDEO_FRAME_PLANE_DATA (dest, plane);
+    const guint8 *s = GST_VIDEO_FRAME_PLANE_DATA (src, plane);
+
+    /* Any component of the plane tells its size */
+    for (comp = 0; comp < GST_VIDEO_FORMAT_INFO_N_COMPONENTS (finfo); comp++) {
+      if (GST_VIDEO_FORMAT_INFO_PLANE (finfo, comp) == plane)
+        break;
+    }
+    if (comp == GST_VIDEO_FORMAT_INFO_N_COMPONENTS (finfo))
+      continue;
+
+    width = GST_VIDEO_FRAME_COMP_WIDTH (dest, comp) *
+        GST_VIDEO_FRAME_COMP_PSTRIDE (dest, comp);
+    height = GST_VIDEO_FRAME_COMP_HEIGHT (dest, comp);
+
+    for (row = 0; row < height; row++)
+      gst_crossfade_blend_line (d + row * GST_VIDEO_FRAME_PLANE_STRIDE (dest,
+              plane), s + row * GST_VIDEO_FRAME_PLANE_STRIDE (src, plane),
+          width, weight);
+  }
+}
+
+/* The input fading out is the one on top, the first one if we can't tell */
+static guint
+_get_fadeout_input (GstBuffer * buffers[2])
+{
+  GstFramePositionnerMeta *metas[2];
+
+  if (!buffers[0])
+    return 1;
+  if (!buffers[1])
+    return 0;
+
+  metas[0] = (GstFramePositionnerMeta *) gst_buffer_get_meta (buffers[0],
+      gst_frame_positionner_meta_api_get_type ());
+  metas[1] = (GstFramePositionnerMeta *) gst_buffer_get_meta (buffers[1],
+      gst_frame_positionner_meta_api_get_type ());
+
+  if (metas[0] && metas[1] && metas[1]->zorder > metas[0]->zorder)
+    return 1;
+
+  return 0;
+}
+
+/* The weight of the input fading in at @stream_time of the output, out of
+ * 256 */
+static guint
+_get_weight (GstCrossfade * self, GstClockTime stream_time)
+{
+  GstClockTime duration;
+
+  GST_OBJECT_LOCK (self);
+  duration = self->duration;
+  GST_OBJECT_UNLOCK (self);
+
+  if (!GST_CLOCK_TIME_IS_VALID (stream_time) || !duration
+      || !GST_CLOCK_TIME_IS_VALID (duration))
+    return 0;
+
+  return gst_util_uint64_scale (MIN (stream_time, duration), 256, duration);
+}
+
+static GstFlowReturn
+_collected (GstCollectPads * pads, GstCrossfade * self)
+{
+  GstBuffer *buffers[2];
+  GstVideoFrame dest, src;
+  GstClockTime stream_time;
+  gboolean send_segment;
+  guint fadeout, fadein, weight;
+
+  buffers[0] = gst_collect_pads_pop (pads, self->inputs[0]);
+  buffers[1] = gst_collect_pads_pop (pads, self->inputs[1]);
+
+  if (!buffers[0] && !buffers[1]) {
+    gst_pad_push_event (self->srcpad, gst_event_new_eos ());
+    return GST_FLOW_EOS;
+  }
+
+  fadeout = _get_fadeout_input (buffers);
+  fadein = !fadeout;
+
+  /* The output is the frame fading out, in its segment */
+  GST_OBJECT_LOCK (self);
+  send_segment = self->segment_input != fadeout;
+  self->segment_input = fadeout;
+  GST_OBJECT_UNLOCK (self);
+
+  if (send_segment) {
+    gst_segment_copy_into (&self->inputs[fadeout]->segment, &self->segment);
+    gst_pad_push_event (self->srcpad, gst_event_new_segment (&self->segment));
+  }
+
+  /* Only one input left, nothing to blend it with */
+  if (!buffers[fadein])
+    return gst_pad_push (self->srcpad, buffers[fadeout]);
+
+  /* Inside an nleoperation, the stream time of the output is the position
+   * in the operation, whatever the inpoint of the sources and after seeks */
+  stream_time = gst_segment_to_stream_time (&self->segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (buffers[fadeout]));
+  weight = _get_weight (self, stream_time);
+
+  if (weight) {
+    buffers[fadeout] = gst_buffer_make_writable (buffers[fadeout]);
+
+    if (gst_video_frame_map (&dest, &self->info, buffers[fadeout],
+            GST_MAP_READWRITE)) {
+      if (gst_video_frame_map (&src, &self->info, buffers[fadein],
+              GST_MAP_READ)) {
+        _blend_frames (&dest, &src, weight);
+        gst_video_frame_unmap (&src);
+      }
+      gst_video_frame_unmap (&dest);
+    }
+  }
+
+  gst_buffer_unref (buffers[fadein]);
+
+  return gst_pad_push (self->srcpad, buffers[fadeout]);
+}
+
+static gboolean
+_set_caps (GstCrossfade * self, GstEvent * event)
+{
+  GstCaps *caps;
+  gboolean ret = TRUE;
+
+  gst_event_parse_caps (event, &caps);
+
+  GST_OBJECT_LOCK (self);
+  if (self->caps) {
+    ret = gst_caps_is_equal (caps, self->caps);
+    GST_OBJECT_UNLOCK (self);
+
+    if (!ret)
+      GST_WARNING_OBJECT (self, "inputs disagree on caps, got %"
+          GST_PTR_FORMAT " and %" GST_PTR_FORMAT, caps, self->caps);
+    gst_event_unref (event);
+    return ret;
+  }
+
+  if (!gst_video_info_from_caps (&self->info, caps)) {
+    GST_OBJECT_UNLOCK (self);
+    gst_event_unref (event);
+    return FALSE;
+  }
+  self->caps = gst_caps_ref (caps);
+  GST_OBJECT_UNLOCK (self);
+
+  return gst_pad_push_event (self->srcpad, event);
+}
+
+static gboolean
+_sink_event (GstCollectPads * pads, GstCollectData * data, GstEvent * event,
+    GstCrossfade * self)
+{
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_STREAM_START:
+    {
+      gboolean send;
+      gchar *stream_id;
+
+      GST_OBJECT_LOCK (self);
+      send = self->send_stream_start;
+      self->send_stream_start = FALSE;
+      GST_OBJECT_UNLOCK (self);
+
+      gst_event_unref (event);
+      if (!send)
+        return TRUE;
+
+      stream_id = gst_pad_create_stream_id (self->srcpad, GST_ELEMENT (self),
+          NULL);
+      gst_pad_push_event (self->srcpad, gst_event_new_stream_start (stream_id));
+      g_free (stream_id);
+
+      return TRUE;
+    }
+    case GST_EVENT_CAPS:
+      return _set_caps (self, event);
+    case GST_EVENT_SEGMENT:
+    case GST_EVENT_FLUSH_STOP:
+      GST_OBJECT_LOCK (self);
+      self->segment_input = -1;
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      break;
+  }
+
+  return gst_collect_pads_event_default (pads, data, event, FALSE);
+}
+
+/* Once an input is negotiated, the other one has to output the same */
+static gboolean
+_sink_query (GstCollectPads * pads, GstCollectData * data, GstQuery * query,
+    GstCrossfade * self)
+{
+  GstCaps *filter, *caps, *tmp;
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_CAPS)
+    return gst_collect_pads_query_default (pads, data, query, FALSE);
+
+  gst_query_parse_caps (query, &filter);
+
+  GST_OBJECT_LOCK (self);
+  if (self->caps)
+    caps = gst_caps_ref (self->caps);
+  else
+    caps = gst_pad_get_pad_template_caps (data->pad);
+  GST_OBJECT_UNLOCK (self);
+
+  if (filter) {
+    tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (caps);
+    caps = tmp;
+  }
+
+  gst_query_set_caps_result (query, caps);
+  gst_caps_unref (caps);
+
+  return TRUE;
+}
+
+static GstStateChangeReturn
+gst_crossfade_change_state (GstElement * element, GstStateChange transition)
+{
+  GstCrossfade *self = GST_CROSSFADE (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      GST_OBJECT_LOCK (self);
+      self->send_stream_start = TRUE;
+      self->segment_input = -1;
+      GST_OBJECT_UNLOCK (self);
+      gst_collect_pads_start (self->collect);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* Unblocks the streaming threads before chaining up */
+      gst_collect_pads_stop (self->collect);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (gst_crossfade_parent_class)->change_state (element,
+      transition);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY) {
+    GST_OBJECT_LOCK (self);
+    gst_caps_replace (&self->caps, NULL);
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  return ret;
+}
+
+static void
+gst_crossfade_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstCrossfade *self = GST_CROSSFADE (object);
+
+  switch (property_id) {
+    case PROP_DURATION:
+      GST_OBJECT_LOCK (self);
+      self->duration = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_crossfade_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstCrossfade *self = GST_CROSSFADE (object);
+
+  switch (property_id) {
+    case PROP_DURATION:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->duration);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_crossfade_finalize (GObject * object)
+{
+  GstCrossfade *self = GST_CROSSFADE (object);
+
+  gst_caps_replace (&self->caps, NULL);
+  gst_object_unref (self->collect);
+
+  G_OBJECT_CLASS (gst_crossfade_parent_class)->finalize (object);
+}
+
+static void
+gst_crossfade_class_init (GstCrossfadeClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_0_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_1_template));
+
+  gobject_class->set_property = gst_crossfade_set_property;
+  gobject_class->get_property = gst_crossfade_get_property;
+  gobject_class->finalize = gst_crossfade_finalize;
+  element_class->change_state = GST_DEBUG_FUNCPTR (gst_crossfade_change_state);
+
+  /**
+   * gstcrossfade:duration:
+   *
+   * How long the fade lasts, starting at stream time 0. The input on top,
+   * according to the zorder of its frames, fades out and the other one in.
+   */
+  g_object_class_install_property (gobject_class, PROP_DURATION,
+      g_param_spec_uint64 ("duration", "duration", "duration of the fade",
+          0, G_MAXUINT64, 0, G_PARAM_READWRITE));
+
+  gst_element_class_set_static_metadata (element_class,
+      "crossfade", "Filter/Editor/Video",
+      "Crossfades two video streams in a single blend",
+      "mduponchelle1@gmail.com");
+}
+
+static void
+gst_crossfade_init (GstCrossfade * self)
+{
+  GstPad *pad;
+
+  self->collect = gst_collect_pads_new ();
+  gst_collect_pads_set_function (self->collect,
+      (GstCollectPadsFunction) GST_DEBUG_FUNCPTR (_collected), self);
+  gst_collect_pads_set_event_function (self->collect,
+      (GstCollectPadsEventFunction) GST_DEBUG_FUNCPTR (_sink_event), self);
+  gst_collect_pads_set_query_function (self->collect,
+      (GstCollectPadsQueryFunction) GST_DEBUG_FUNCPTR (_sink_query), self);
+
+  pad = gst_pad_new_from_static_template (&sink_0_template, "sink_0");
+  self->inputs[0] = gst_collect_pads_add_pad (self->collect, pad,
+      sizeof (GstCollectData), NULL, TRUE);
+  gst_element_add_pad (GST_ELEMENT (self), pad);
+
+  pad = gst_pad_new_from_static_template (&sink_1_template, "sink_1");
+  self->inputs[1] = gst_collect_pads_add_pad (self->collect, pad,
+      sizeof (GstCollectData), NULL, TRUE);
+  gst_element_add_pad (GST_ELEMENT (self), pad);
+
+  self->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_use_fixed_caps (self->srcpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+
+  self->duration = 0;
+  self->caps = NULL;
+  self->send_stream_start = TRUE;
+  self->segment_input = -1;
+  gst_segment_init (&self->segment, GST_FORMAT_TIME);
+}
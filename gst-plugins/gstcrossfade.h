@@ -0,0 +1,73 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_CROSSFADE_H_
+#define _GST_CROSSFADE_H_
+
+#include <gst/base/gstcollectpads.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CROSSFADE   (gst_crossfade_get_type())
+#define GST_CROSSFADE(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_CROSSFADE,GstCrossfade))
+#define GST_CROSSFADE_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_CROSSFADE,GstCrossfadeClass))
+#define GST_IS_CROSSFADE(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_CROSSFADE))
+#define GST_IS_CROSSFADE_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_CROSSFADE))
+
+typedef struct _GstCrossfade GstCrossfade;
+typedef struct _GstCrossfadeClass GstCrossfadeClass;
+
+struct _GstCrossfade
+{
+  GstElement parent;
+
+  GstPad *srcpad;
+  GstCollectPads *collect;
+  GstCollectData *inputs[2];
+
+  /* How long the fade lasts, from the start of the stream time */
+  GstClockTime duration;
+
+  /* Both inputs have to agree on it */
+  GstCaps *caps;
+  GstVideoInfo info;
+
+  gboolean send_stream_start;
+  /* The input whose segment was last sent, -1 if none since a flush */
+  gint segment_input;
+  /* The segment last sent, the fade follows its stream time */
+  GstSegment segment;
+
+  /*  This should never be made public, no padding needed */
+};
+
+struct _GstCrossfadeClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_crossfade_get_type (void);
+
+void  gst_crossfade_blend_line (guint8 * dest, const guint8 * src, guint n_bytes,
+                                guint weight);
+
+G_END_DECLS
+
+#endif
@@ -30,12 +30,16 @@
 #define MAX_PIXELS 100000
 #define MIN_PIXELS -100000
 
+#define ROUND(x) ((gint) ((x) < 0 ? (x) - 0.5 : (x) + 0.5))
+
 static void gst_frame_positionner_set_property (GObject * object,
     guint property_id, const GValue * value, GParamSpec * pspec);
 static void gst_frame_positionner_get_property (GObject * object,
     guint property_id, GValue * value, GParamSpec * pspec);
 static GstFlowReturn gst_frame_positionner_transform_ip (GstBaseTransform *
     trans, GstBuffer * buf);
+static gboolean gst_frame_positionner_set_caps (GstBaseTransform * trans,
+    GstCaps * incaps, GstCaps * outcaps);
 
 static gboolean
 gst_frame_positionner_meta_transform (GstBuffer * dest, GstMeta * meta,
@@ -49,7 +53,8 @@ enum
   PROP_POSY,
   PROP_ZORDER,
   PROP_WIDTH,
-  PROP_HEIGHT
+  PROP_HEIGHT,
+  PROP_BAKE
 };
 
 static GstStaticPadTemplate gst_frame_positionner_src_template =
@@ -69,49 +74,6 @@ GST_STATIC_PAD_TEMPLATE ("sink",
 G_DEFINE_TYPE (GstFramePositionner, gst_frame_positionner,
     GST_TYPE_BASE_TRANSFORM);
 
-static void
-gst_frame_positionner_update_properties (GstFramePositionner * pos,
-    gint old_track_width, gint old_track_height)
-{
-  GstCaps *caps;
-  gint final_width;
-  gint final_height;
-
-  if (pos->capsfilter == NULL)
-    return;
-
-  final_width = pos->width;
-  final_height = pos->height;
-
-  if (final_width == 0 && final_height == 0)
-    caps = gst_caps_new_empty_simple ("video/x-raw");
-  else if (final_width == 0)
-    caps =
-        gst_caps_new_simple ("video/x-raw", "height", G_TYPE_INT, final_height,
-        NULL);
-  else if (final_height == 0)
-    caps =
-        gst_caps_new_simple ("video/x-raw", "width", G_TYPE_INT, final_width,
-        NULL);
-  else
-    caps =
-        gst_caps_new_simple ("video/x-raw", "width", G_TYPE_INT,
-        final_width, "height", G_TYPE_INT, final_height, NULL);
-
-  GST_DEBUG_OBJECT (pos, "updated size to : %d %d", final_width, final_height);
-
-  if (pos->fps_n != -1)
-    gst_caps_set_simple (caps, "framerate", GST_TYPE_FRACTION, pos->fps_n,
-        pos->fps_d, NULL);
-
-  GST_DEBUG_OBJECT (pos, "setting caps : %s", gst_caps_to_string (caps));
-
-  g_object_set (pos->capsfilter, "caps", caps, NULL);
-  pos->width = final_width;
-  pos->height = final_height;
-  gst_caps_unref (caps);
-}
-
 void
 ges_frame_positionner_set_source_and_filter (GstFramePositionner * pos)
 {
@@ -123,6 +85,19 @@ gst_frame_positionner_dispose (GObject * object)
   G_OBJECT_CLASS (gst_frame_positionner_parent_class)->dispose (object);
 }
 
+static void
+gst_frame_positionner_finalize (GObject * object)
+{
+  GstFramePositionner *pos = GST_FRAME_POSITIONNER (object);
+
+  gst_baked_curve_free (pos->alpha_curve);
+  gst_baked_curve_free (pos->posx_curve);
+  gst_baked_curve_free (pos->posy_curve);
+  gst_baked_curve_free (pos->zorder_curve);
+
+  G_OBJECT_CLASS (gst_frame_positionner_parent_class)->finalize (object);
+}
+
 static void
 gst_frame_positionner_class_init (GstFramePositionnerClass * klass)
 {
@@ -138,8 +113,11 @@ gst_frame_positionner_class_init (GstFramePositionnerClass * klass)
   gobject_class->set_property = gst_frame_positionner_set_property;
   gobject_class->get_property = gst_frame_positionner_get_property;
   gobject_class->dispose = gst_frame_positionner_dispose;
+  gobject_class->finalize = gst_frame_positionner_finalize;
   base_transform_class->transform_ip =
       GST_DEBUG_FUNCPTR (gst_frame_positionner_transform_ip);
+  base_transform_class->set_caps =
+      GST_DEBUG_FUNCPTR (gst_frame_positionner_set_caps);
 
   /**
    * gstframepositionner:alpha:
@@ -183,7 +161,7 @@ gst_frame_positionner_class_init (GstFramePositionnerClass * klass)
   /**
    * gesframepositionner:width:
    *
-   * The desired width for that source.
+   * The desired width for that source, the mixer scales it while blending.
    * Set to 0 if size is not mandatory, will be set to width of the current track.
    */
   g_object_class_install_property (gobject_class, PROP_WIDTH,
@@ -193,13 +171,25 @@ gst_frame_positionner_class_init (GstFramePositionnerClass * klass)
   /**
    * gesframepositionner:height:
    *
-   * The desired height for that source.
+   * The desired height for that source, the mixer scales it while blending.
    * Set to 0 if size is not mandatory, will be set to height of the current track.
    */
   g_object_class_install_property (gobject_class, PROP_HEIGHT,
       g_param_spec_int ("height", "height", "height of the source",
           0, MAX_PIXELS, 0, G_PARAM_READWRITE));
 
+  /**
+   * gesframepositionner:bake:
+   *
+   * Precompute the control curves of the properties into tables, once per
+   * frame duration, and look the values up from them instead of syncing
+   * the properties for each buffer. The tables have to be rebuilt when
+   * control points change, which setting this to TRUE again requests.
+   */
+  g_object_class_install_property (gobject_class, PROP_BAKE,
+      g_param_spec_boolean ("bake", "bake", "Bake the control curves",
+          FALSE, G_PARAM_READWRITE));
+
   gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
       "frame positionner", "Metadata",
       "This element provides with tagging facilities",
@@ -215,11 +205,17 @@ gst_frame_positionner_init (GstFramePositionner * framepositionner)
   framepositionner->zorder = 0;
   framepositionner->width = 0;
   framepositionner->height = 0;
-  framepositionner->fps_n = -1;
-  framepositionner->fps_d = -1;
   framepositionner->track_width = 0;
   framepositionner->track_height = 0;
-  framepositionner->capsfilter = NULL;
+  framepositionner->bake = FALSE;
+  framepositionner->alpha_curve =
+      gst_baked_curve_new (GST_OBJECT (framepositionner), "alpha");
+  framepositionner->posx_curve =
+      gst_baked_curve_new (GST_OBJECT (framepositionner), "posx");
+  framepositionner->posy_curve =
+      gst_baked_curve_new (GST_OBJECT (framepositionner), "posy");
+  framepositionner->zorder_curve =
+      gst_baked_curve_new (GST_OBJECT (framepositionner), "zorder");
 }
 
 void
@@ -245,11 +241,16 @@ gst_frame_positionner_set_property (GObject * object, guint property_id,
       break;
     case PROP_WIDTH:
       framepositionner->width = g_value_get_int (value);
-      gst_frame_positionner_update_properties (framepositionner, 0, 0);
       break;
     case PROP_HEIGHT:
       framepositionner->height = g_value_get_int (value);
-      gst_frame_positionner_update_properties (framepositionner, 0, 0);
+      break;
+    case PROP_BAKE:
+      framepositionner->bake = g_value_get_boolean (value);
+      gst_baked_curve_invalidate (framepositionner->alpha_curve);
+      gst_baked_curve_invalidate (framepositionner->posx_curve);
+      gst_baked_curve_invalidate (framepositionner->posy_curve);
+      gst_baked_curve_invalidate (framepositionner->zorder_curve);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -288,6 +289,9 @@ gst_frame_positionner_get_property (GObject * object, guint property_id,
       real_height = (pos->height > 0) ? pos->height : pos->track_height;
       g_value_set_int (value, real_height);
       break;
+    case PROP_BAKE:
+      g_value_set_boolean (value, pos->bake);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -341,11 +345,59 @@ gst_frame_positionner_meta_transform (GstBuffer * dest, GstMeta * meta,
     dmeta->posx = smeta->posx;
     dmeta->posy = smeta->posy;
     dmeta->zorder = smeta->zorder;
+    dmeta->width = smeta->width;
+    dmeta->height = smeta->height;
   }
 
   return TRUE;
 }
 
+static gboolean
+gst_frame_positionner_set_caps (GstBaseTransform * trans, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstFramePositionner *pos = GST_FRAME_POSITIONNER (trans);
+  GstVideoInfo info;
+  GstClockTime interval = 0;
+
+  /* One value per frame, the default interval if we don't know the rate */
+  if (gst_video_info_from_caps (&info, incaps) && info.fps_n > 0)
+    interval = gst_util_uint64_scale_int (GST_SECOND, info.fps_d, info.fps_n);
+
+  gst_baked_curve_set_interval (pos->alpha_curve, interval);
+  gst_baked_curve_set_interval (pos->posx_curve, interval);
+  gst_baked_curve_set_interval (pos->posy_curve, interval);
+  gst_baked_curve_set_interval (pos->zorder_curve, interval);
+
+  return TRUE;
+}
+
+/* Looks the controlled properties up in the baked curves, the object lock
+ * must not be held as baking takes it */
+static void
+_lookup_baked_values (GstFramePositionner * pos, GstClockTime timestamp)
+{
+  gdouble alpha, posx, posy, zorder;
+  gboolean has_alpha, has_posx, has_posy, has_zorder;
+
+  has_alpha = gst_baked_curve_get_value (pos->alpha_curve, timestamp, &alpha);
+  has_posx = gst_baked_curve_get_value (pos->posx_curve, timestamp, &posx);
+  has_posy = gst_baked_curve_get_value (pos->posy_curve, timestamp, &posy);
+  has_zorder =
+      gst_baked_curve_get_value (pos->zorder_curve, timestamp, &zorder);
+
+  GST_OBJECT_LOCK (pos);
+  if (has_alpha)
+    pos->alpha = CLAMP (alpha, 0.0, 1.0);
+  if (has_posx)
+    pos->posx = ROUND (posx);
+  if (has_posy)
+    pos->posy = ROUND (posy);
+  if (has_zorder)
+    pos->zorder = MAX (ROUND (zorder), 0);
+  GST_OBJECT_UNLOCK (pos);
+}
+
 static GstFlowReturn
 gst_frame_positionner_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
 {
@@ -354,7 +406,10 @@ gst_frame_positionner_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
   GstClockTime timestamp = GST_BUFFER_TIMESTAMP (buf);
 
   if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
-    gst_object_sync_values (GST_OBJECT (trans), timestamp);
+    if (framepositionner->bake)
+      _lookup_baked_values (framepositionner, timestamp);
+    else
+      gst_object_sync_values (GST_OBJECT (trans), timestamp);
   }
 
   meta =
@@ -366,6 +421,8 @@ gst_frame_positionner_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
   meta->posx = framepositionner->posx;
   meta->posy = framepositionner->posy;
   meta->zorder = framepositionner->zorder;
+  meta->width = framepositionner->width;
+  meta->height = framepositionner->height;
   GST_OBJECT_UNLOCK (framepositionner);
 
   return GST_FLOW_OK;
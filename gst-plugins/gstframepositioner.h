@@ -22,6 +22,8 @@
 
 #include <gst/base/gstbasetransform.h>
 
+#include "gstbakedcurve.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_FRAME_POSITIONNER   (gst_frame_positionner_get_type())
@@ -38,8 +40,6 @@ struct _GstFramePositionner
 {
   GstBaseTransform base_framepositionner;
 
-  GstElement *capsfilter;
-
   gdouble alpha;
   gint posx;
   gint posy;
@@ -48,8 +48,14 @@ struct _GstFramePositionner
   gint height;
   gint track_width;
   gint track_height;
-  gint fps_n;
-  gint fps_d;
+
+  /* Lookup tables for the controllable properties, used instead of syncing
+   * them when baking */
+  gboolean bake;
+  GstBakedCurve *alpha_curve;
+  GstBakedCurve *posx_curve;
+  GstBakedCurve *posy_curve;
+  GstBakedCurve *zorder_curve;
 
   /*  This should never be made public, no padding needed */
 };
@@ -66,6 +72,9 @@ struct _GstFramePositionnerMeta {
   gint posx;
   gint posy;
   guint zorder;
+  /* What to scale to when blending, 0 to keep the size of the frame */
+  gint width;
+  gint height;
 };
 
 void ges_frame_positionner_set_source_and_filter (GstFramePositionner *pos);
@@ -0,0 +1,331 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstgainramp.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HAVE_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+typedef void (*RampF32Func) (gfloat * data, guint n_samples, guint channels,
+    gfloat gain, gfloat step);
+typedef void (*RampS16Func) (gint16 * data, guint n_samples, guint channels,
+    gfloat gain, gfloat step);
+
+/* The vector kernels only deal with channel counts dividing their width,
+ * so that the gain pattern of a vector is the same for all of them, and
+ * leave the remaining samples to these. They take samples, not frames, and
+ * @gain is the one of frame 0 */
+static void
+_ramp_f32_scalar (gfloat * data, guint first, guint n_samples,
+    guint channels, gfloat gain, gfloat step)
+{
+  guint i;
+
+  for (i = first; i < n_samples; i++)
+    data[i] *= gain + step * (i / channels);
+}
+
+static void
+_ramp_s16_scalar (gint16 * data, guint first, guint n_samples,
+    guint channels, gfloat gain, gfloat step)
+{
+  guint i;
+  gfloat v;
+
+  for (i = first; i < n_samples; i++) {
+    v = CLAMP (data[i] * (gain + step * (i / channels)), G_MININT16, G_MAXINT16);
+    data[i] = v < 0 ? (gint16) (v - 0.5f) : (gint16) (v + 0.5f);
+  }
+}
+
+static void
+_ramp_f32_c (gfloat * data, guint n_samples, guint channels, gfloat gain,
+    gfloat step)
+{
+  _ramp_f32_scalar (data, 0, n_samples, channels, gain, step);
+}
+
+static void
+_ramp_s16_c (gint16 * data, guint n_samples, guint channels, gfloat gain,
+    gfloat step)
+{
+  _ramp_s16_scalar (data, 0, n_samples, channels, gain, step);
+}
+
+#ifdef HAVE_X86_KERNELS
+/* SSE2 is part of x86_64, the i386 build checks for it at runtime */
+__attribute__ ((target ("sse2")))
+static void
+_ramp_f32_sse2 (gfloat * data, guint n_samples, guint channels, gfloat gain,
+    gfloat step)
+{
+  __m128 frames, steps, inc, gains, v;
+  guint i = 0;
+
+  if (channels == 1 || channels == 2 || channels == 4) {
+    frames = channels == 1 ? _mm_setr_ps (0, 1, 2, 3) :
+        channels == 2 ? _mm_setr_ps (0, 0, 1, 1) : _mm_setzero_ps ();
+    inc = _mm_set1_ps (4 / channels);
+    steps = _mm_set1_ps (step);
+    gains = _mm_set1_ps (gain);
+
+    for (; i + 4 <= n_samples; i += 4) {
+      v = _mm_loadu_ps (data + i);
+      v = _mm_mul_ps (v, _mm_add_ps (gains, _mm_mul_ps (frames, steps)));
+      _mm_storeu_ps (data + i, v);
+      frames = _mm_add_ps (frames, inc);
+    }
+  }
+
+  _ramp_f32_scalar (data, i, n_samples, channels, gain, step);
+}
+
+__attribute__ ((target ("avx")))
+static void
+_ramp_f32_avx (gfloat * data, guint n_samples, guint channels, gfloat gain,
+    gfloat step)
+{
+  __m256 frames, steps, inc, gains, v;
+  guint i = 0;
+
+  if (channels == 1 || channels == 2 || channels == 4 || channels == 8) {
+    switch (channels) {
+      case 1:
+        frames = _mm256_setr_ps (0, 1, 2, 3, 4, 5, 6, 7);
+        break;
+      case 2:
+        frames = _mm256_setr_ps (0, 0, 1, 1, 2, 2, 3, 3);
+        break;
+      case 4:
+        frames = _mm256_setr_ps (0, 0, 0, 0, 1, 1, 1, 1);
+        break;
+      default:
+        frames = _mm256_setzero_ps ();
+        break;
+    }
+    inc = _mm256_set1_ps (8 / channels);
+    steps = _mm256_set1_ps (step);
+    gains = _mm256_set1_ps (gain);
+
+    for (; i + 8 <= n_samples; i += 8) {
+      v = _mm256_loadu_ps (data + i);
+      v = _mm256_mul_ps (v, _mm256_add_ps (gains, _mm256_mul_ps (frames,
+                  steps)));
+      _mm256_storeu_ps (data + i, v);
+      frames = _mm256_add_ps (frames, inc);
+    }
+  }
+
+  _ramp_f32_scalar (data, i, n_samples, channels, gain, step);
+}
+
+/* 8 samples at a time, hence the two gain vectors */
+__attribute__ ((target ("sse2")))
+static void
+_ramp_s16_sse2 (gint16 * data, guint n_samples, guint channels, gfloat gain,
+    gfloat step)
+{
+  __m128 frames_lo, frames_hi, steps, inc, gains, min, max, half, sign;
+  __m128 flo, fhi;
+  __m128i v, lo, hi;
+  guint i = 0;
+
+  if (channels == 1 || channels == 2 || channels == 4 || channels == 8) {
+    switch (channels) {
+      case 1:
+        frames_lo = _mm_setr_ps (0, 1, 2, 3);
+        frames_hi = _mm_setr_ps (4, 5, 6, 7);
+        break;
+      case 2:
+        frames_lo = _mm_setr_ps (0, 0, 1, 1);
+        frames_hi = _mm_setr_ps (2, 2, 3, 3);
+        break;
+      case 4:
+        frames_lo = _mm_setzero_ps ();
+        frames_hi = _mm_set1_ps (1);
+        break;
+      default:
+        frames_lo = frames_hi = _mm_setzero_ps ();
+        break;
+    }
+    inc = _mm_set1_ps (8 / channels);
+    steps = _mm_set1_ps (step);
+    gains = _mm_set1_ps (gain);
+    min = _mm_set1_ps (G_MININT16);
+    max = _mm_set1_ps (G_MAXINT16);
+    half = _mm_set1_ps (0.5f);
+    sign = _mm_set1_ps (-0.0f);
+
+    for (; i + 8 <= n_samples; i += 8) {
+      v = _mm_loadu_si128 ((__m128i *) (data + i));
+      /* Sign extend to 32 bits */
+      lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16);
+      hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16);
+      flo = _mm_mul_ps (_mm_cvtepi32_ps (lo),
+          _mm_add_ps (gains, _mm_mul_ps (frames_lo, steps)));
+      fhi = _mm_mul_ps (_mm_cvtepi32_ps (hi),
+          _mm_add_ps (gains, _mm_mul_ps (frames_hi, steps)));
+      flo = _mm_min_ps (_mm_max_ps (flo, min), max);
+      fhi = _mm_min_ps (_mm_max_ps (fhi, min), max);
+      /* _mm_cvtps_epi32 rounds half to even, add 0.5 with the sign of the
+       * sample and truncate instead, like the scalar version */
+      lo = _mm_cvttps_epi32 (_mm_add_ps (flo,
+              _mm_or_ps (half, _mm_and_ps (flo, sign))));
+      hi = _mm_cvttps_epi32 (_mm_add_ps (fhi,
+              _mm_or_ps (half, _mm_and_ps (fhi, sign))));
+      _mm_storeu_si128 ((__m128i *) (data + i), _mm_packs_epi32 (lo, hi));
+      frames_lo = _mm_add_ps (frames_lo, inc);
+      frames_hi = _mm_add_ps (frames_hi, inc);
+    }
+  }
+
+  _ramp_s16_scalar (data, i, n_samples, channels, gain, step);
+}
+#endif
+
+#ifdef HAVE_NEON_KERNELS
+static void
+_ramp_f32_neon (gfloat * data, guint n_samples, guint channels, gfloat gain,
+    gfloat step)
+{
+  static const gfloat mono[] = { 0, 1, 2, 3 }, stereo[] = { 0, 0, 1, 1 };
+  float32x4_t frames, inc, gains, v;
+  guint i = 0;
+
+  if (channels == 1 || channels == 2 || channels == 4) {
+    frames = channels == 1 ? vld1q_f32 (mono) :
+        channels == 2 ? vld1q_f32 (stereo) : vdupq_n_f32 (0);
+    inc = vdupq_n_f32 (4 / channels);
+    gains = vdupq_n_f32 (gain);
+
+    for (; i + 4 <= n_samples; i += 4) {
+      v = vld1q_f32 (data + i);
+      v = vmulq_f32 (v, vmlaq_n_f32 (gains, frames, step));
+      vst1q_f32 (data + i, v);
+      frames = vaddq_f32 (frames, inc);
+    }
+  }
+
+  _ramp_f32_scalar (data, i, n_samples, channels, gain, step);
+}
+
+static void
+_ramp_s16_neon (gint16 * data, guint n_samples, guint channels, gfloat gain,
+    gfloat step)
+{
+  static const gfloat mono[] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+  static const gfloat stereo[] = { 0, 0, 1, 1, 2, 2, 3, 3 };
+  static const gfloat quad[] = { 0, 0, 0, 0, 1, 1, 1, 1 };
+  static const gfloat octo[] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  float32x4_t frames_lo, frames_hi, inc, gains, half;
+  int16x8_t v;
+  int32x4_t lo, hi;
+  float32x4_t flo, fhi;
+  const gfloat *pattern;
+  guint i = 0;
+
+  if (channels == 1 || channels == 2 || channels == 4 || channels == 8) {
+    pattern = channels == 1 ? mono : channels == 2 ? stereo :
+        channels == 4 ? quad : octo;
+    frames_lo = vld1q_f32 (pattern);
+    frames_hi = vld1q_f32 (pattern + 4);
+    inc = vdupq_n_f32 (8 / channels);
+    gains = vdupq_n_f32 (gain);
+    half = vdupq_n_f32 (0.5f);
+
+    for (; i + 8 <= n_samples; i += 8) {
+      v = vld1q_s16 (data + i);
+      flo = vmulq_f32 (vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (v))),
+          vmlaq_n_f32 (gains, frames_lo, step));
+      fhi = vmulq_f32 (vcvtq_f32_s32 (vmovl_s16 (vget_high_s16 (v))),
+          vmlaq_n_f32 (gains, frames_hi, step));
+      /* vcvtq truncates, round half away from zero instead */
+      flo = vaddq_f32 (flo, vbslq_f32 (vcltq_f32 (flo, vdupq_n_f32 (0)),
+              vnegq_f32 (half), half));
+      fhi = vaddq_f32 (fhi, vbslq_f32 (vcltq_f32 (fhi, vdupq_n_f32 (0)),
+              vnegq_f32 (half), half));
+      lo = vcvtq_s32_f32 (flo);
+      hi = vcvtq_s32_f32 (fhi);
+      vst1q_s16 (data + i, vcombine_s16 (vqmovn_s32 (lo), vqmovn_s32 (hi)));
+      frames_lo = vaddq_f32 (frames_lo, inc);
+      frames_hi = vaddq_f32 (frames_hi, inc);
+    }
+  }
+
+  _ramp_s16_scalar (data, i, n_samples, channels, gain, step);
+}
+#endif
+
+static RampF32Func ramp_f32;
+static RampS16Func ramp_s16;
+
+static gpointer
+_pick_kernels (gpointer unused)
+{
+  ramp_f32 = _ramp_f32_c;
+  ramp_s16 = _ramp_s16_c;
+
+#if defined(HAVE_X86_KERNELS)
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("sse2")) {
+    ramp_f32 = _ramp_f32_sse2;
+    ramp_s16 = _ramp_s16_sse2;
+  }
+  if (__builtin_cpu_supports ("avx"))
+    ramp_f32 = _ramp_f32_avx;
+#elif defined(HAVE_NEON_KERNELS)
+  ramp_f32 = _ramp_f32_neon;
+  ramp_s16 = _ramp_s16_neon;
+#endif
+
+  return NULL;
+}
+
+static void
+_init_kernels (void)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  g_once (&once, _pick_kernels, NULL);
+}
+
+void
+gst_gain_ramp_f32 (gfloat * data, guint n_frames, guint channels,
+    gfloat gain, gfloat step)
+{
+  _init_kernels ();
+  ramp_f32 (data, n_frames * channels, channels, gain, step);
+}
+
+void
+gst_gain_ramp_s16 (gint16 * data, guint n_frames, guint channels,
+    gfloat gain, gfloat step)
+{
+  _init_kernels ();
+  ramp_s16 (data, n_frames * channels, channels, gain, step);
+}
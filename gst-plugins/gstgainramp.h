@@ -0,0 +1,37 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_GAIN_RAMP_H_
+#define _GST_GAIN_RAMP_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Multiplies @n_frames interleaved frames of @channels samples by a gain
+ * going linearly from @gain, by @step for each frame. The samples are
+ * native endian, s16 ones are rounded and clamped. */
+void gst_gain_ramp_f32 (gfloat * data, guint n_frames, guint channels,
+    gfloat gain, gfloat step);
+void gst_gain_ramp_s16 (gint16 * data, guint n_frames, guint channels,
+    gfloat gain, gfloat step);
+
+G_END_DECLS
+
+#endif
@@ -31,6 +31,9 @@
 #include "gstsamplecontroller.h"
 #include "ges-smart-video-mixer.h"
 #include "ges-smart-audio-mixer.h"
+#include "gstbackgroundsrc.h"
+#include "gstcrossfade.h"
+#include "gstpixeltransform.h"
 
 static gboolean
 plugin_init (GstPlugin * plugin)
@@ -45,6 +48,12 @@ plugin_init (GstPlugin * plugin)
       GES_TYPE_SMART_MIXER);
   gst_element_register (plugin, "smartaudiomixer", GST_RANK_NONE,
       GES_TYPE_SMART_AUDIO_MIXER);
+  gst_element_register (plugin, "backgroundsrc", GST_RANK_NONE,
+      GST_TYPE_BACKGROUND_SRC);
+  gst_element_register (plugin, "crossfade", GST_RANK_NONE,
+      GST_TYPE_CROSSFADE);
+  gst_element_register (plugin, "pixeltransform", GST_RANK_NONE,
+      GST_TYPE_PIXEL_TRANSFORM);
 
   return TRUE;
 }
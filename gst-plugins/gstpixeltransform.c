@@ -0,0 +1,335 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstpixeltransform.h"
+
+/* 8 bits per component, so that all of them go through a 256 entries table */
+#define PIXEL_TRANSFORM_CAPS GST_VIDEO_CAPS_MAKE ("{ AYUV, Y444, Y42B, I420, " \
+    "YV12, Y41B, NV12, NV21, YUY2, UYVY, YVYU, GRAY8, ARGB, BGRA, RGBA, ABGR, " \
+    "xRGB, RGBx, xBGR, BGRx, RGB, BGR }")
+
+#define MAX_SATURATION 16.0
+
+enum
+{
+  PROP_0,
+  PROP_CURVE,
+  PROP_SATURATION,
+};
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (PIXEL_TRANSFORM_CAPS)
+    );
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (PIXEL_TRANSFORM_CAPS)
+    );
+
+G_DEFINE_TYPE (GstPixelTransform, gst_pixel_transform, GST_TYPE_VIDEO_FILTER);
+
+/* Called with the object lock taken. Returns whether the element leaves
+ * frames untouched, passthrough has to be set once the lock is released
+ * since basetransform takes it too */
+static gboolean
+_update_tables (GstPixelTransform * self)
+{
+  gboolean identity = self->saturation == 1.0;
+  guint i;
+
+  for (i = 0; i < 256; i++) {
+    /* Truncation only rounds wrong below 0, which gets clamped anyway */
+    gint chroma = (gint) (((gint) i - 128) * self->saturation + 128.5);
+
+    self->chroma_table[i] = CLAMP (chroma, 0, 255);
+    identity &= self->curve[i] == i;
+  }
+
+  self->saturation_fixed = (gint) (self->saturation * 256 + 0.5);
+
+  return identity;
+}
+
+static void
+_apply_table (guint8 * data, gint pstride, gint width, const guint8 * table)
+{
+  gint x;
+
+  if (pstride == 1) {
+    for (x = 0; x < width; x++)
+      data[x] = table[data[x]];
+    return;
+  }
+
+  for (x = 0; x < width; x++, data += pstride)
+    *data = table[*data];
+}
+
+/* Parses the 256 levels of @string, separated by spaces or commas. NULL
+ * or empty means the identity */
+static gboolean
+_parse_curve (const gchar * string, guint8 * curve)
+{
+  gchar **levels;
+  guint i, n = 0;
+  gboolean ret = TRUE;
+
+  if (!string || !*string) {
+    for (i = 0; i < 256; i++)
+      curve[i] = i;
+    return TRUE;
+  }
+
+  levels = g_strsplit_set (string, " ,", -1);
+  for (i = 0; levels[i]; i++) {
+    gchar *end;
+    guint64 level;
+
+    if (!*levels[i])
+      continue;
+
+    level = g_ascii_strtoull (levels[i], &end, 10);
+    if (*end || level > 255 || n == 256) {
+      ret = FALSE;
+      break;
+    }
+    curve[n++] = level;
+  }
+  g_strfreev (levels);
+
+  return ret && n == 256;
+}
+
+/* Goes over each plane once, row by row, so that the components sharing a
+ * plane get transformed while its row is still in cache */
+static void
+_transform_yuv (GstVideoFrame * frame, const guint8 * curve,
+    const guint8 * chroma_table)
+{
+  guint n_components = GST_VIDEO_FRAME_N_COMPONENTS (frame);
+  guint plane, comp;
+  gint y;
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (frame); plane++) {
+    gint height = -1;
+
+    for (comp = 0; comp < MIN (n_components, 3); comp++) {
+      if (GST_VIDEO_FORMAT_INFO_PLANE (frame->info.finfo, comp) == plane)
+        height = GST_VIDEO_FRAME_COMP_HEIGHT (frame, comp);
+    }
+
+    for (y = 0; y < height; y++) {
+      for (comp = 0; comp < MIN (n_components, 3); comp++) {
+        if (GST_VIDEO_FORMAT_INFO_PLANE (frame->info.finfo, comp) != plane)
+          continue;
+
+        _apply_table (GST_VIDEO_FRAME_COMP_DATA (frame, comp) +
+            y * GST_VIDEO_FRAME_COMP_STRIDE (frame, comp),
+            GST_VIDEO_FRAME_COMP_PSTRIDE (frame, comp),
+            GST_VIDEO_FRAME_COMP_WIDTH (frame, comp),
+            comp == 0 ? curve : chroma_table);
+      }
+    }
+  }
+}
+
+/* RGB is packed, the channels are transformed together, then pulled
+ * towards their luma for the saturation */
+static void
+_transform_rgb (GstVideoFrame * frame, const guint8 * curve, gint saturation)
+{
+  guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+  gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+  gint pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
+  gint r_offset = GST_VIDEO_FRAME_COMP_POFFSET (frame, GST_VIDEO_COMP_R);
+  gint g_offset = GST_VIDEO_FRAME_COMP_POFFSET (frame, GST_VIDEO_COMP_G);
+  gint b_offset = GST_VIDEO_FRAME_COMP_POFFSET (frame, GST_VIDEO_COMP_B);
+  gint width = GST_VIDEO_FRAME_WIDTH (frame);
+  gint height = GST_VIDEO_FRAME_HEIGHT (frame);
+  gint x, y;
+
+  for (y = 0; y < height; y++) {
+    guint8 *pixel = data + y * stride;
+
+    for (x = 0; x < width; x++, pixel += pstride) {
+      gint r = curve[pixel[r_offset]];
+      gint g = curve[pixel[g_offset]];
+      gint b = curve[pixel[b_offset]];
+
+      if (saturation != 256) {
+        gint luma = (77 * r + 150 * g + 29 * b) >> 8;
+
+        r = luma + (((r - luma) * saturation) >> 8);
+        g = luma + (((g - luma) * saturation) >> 8);
+        b = luma + (((b - luma) * saturation) >> 8);
+      }
+
+      pixel[r_offset] = CLAMP (r, 0, 255);
+      pixel[g_offset] = CLAMP (g, 0, 255);
+      pixel[b_offset] = CLAMP (b, 0, 255);
+    }
+  }
+}
+
+static GstFlowReturn
+gst_pixel_transform_transform_frame_ip (GstVideoFilter * filter,
+    GstVideoFrame * frame)
+{
+  GstPixelTransform *self = GST_PIXEL_TRANSFORM (filter);
+  guint8 curve[256], chroma_table[256];
+  gint saturation;
+
+  GST_OBJECT_LOCK (self);
+  memcpy (curve, self->curve, sizeof (curve));
+  memcpy (chroma_table, self->chroma_table, sizeof (chroma_table));
+  saturation = self->saturation_fixed;
+  GST_OBJECT_UNLOCK (self);
+
+  if (GST_VIDEO_FRAME_IS_RGB (frame))
+    _transform_rgb (frame, curve, saturation);
+  else
+    _transform_yuv (frame, curve, chroma_table);
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_pixel_transform_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstPixelTransform *self = GST_PIXEL_TRANSFORM (object);
+  gboolean identity;
+  guint8 curve[256];
+
+  GST_OBJECT_LOCK (self);
+  switch (property_id) {
+    case PROP_CURVE:
+      if (!_parse_curve (g_value_get_string (value), curve)) {
+        GST_WARNING_OBJECT (self, "ignoring curve, it needs 256 levels "
+            "between 0 and 255");
+        GST_OBJECT_UNLOCK (self);
+        return;
+      }
+
+      memcpy (self->curve, curve, sizeof (curve));
+      break;
+    case PROP_SATURATION:
+      self->saturation = g_value_get_double (value);
+      break;
+    default:
+      GST_OBJECT_UNLOCK (self);
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      return;
+  }
+  identity = _update_tables (self);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (self), identity);
+}
+
+static void
+gst_pixel_transform_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPixelTransform *self = GST_PIXEL_TRANSFORM (object);
+  GString *curve;
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  switch (property_id) {
+    case PROP_CURVE:
+      curve = g_string_sized_new (4 * 256);
+      for (i = 0; i < 256; i++)
+        g_string_append_printf (curve, i ? " %u" : "%u", self->curve[i]);
+      g_value_take_string (value, g_string_free (curve, FALSE));
+      break;
+    case PROP_SATURATION:
+      g_value_set_double (value, self->saturation);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_pixel_transform_class_init (GstPixelTransformClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
+
+  gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
+      gst_static_pad_template_get (&src_template));
+  gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
+      gst_static_pad_template_get (&sink_template));
+
+  gobject_class->set_property = gst_pixel_transform_set_property;
+  gobject_class->get_property = gst_pixel_transform_get_property;
+  video_filter_class->transform_frame_ip =
+      GST_DEBUG_FUNCPTR (gst_pixel_transform_transform_frame_ip);
+
+  /**
+   * gstpixeltransform:curve:
+   *
+   * The 256 values luma, or each colour channel of RGB formats, get
+   * mapped to, separated by spaces or commas. Brightness, contrast, gamma
+   * and lookup tables all compose into a single curve. %NULL or an empty
+   * string leaves them untouched.
+   */
+  g_object_class_install_property (gobject_class, PROP_CURVE,
+      g_param_spec_string ("curve", "curve", "The level each level maps to",
+          NULL, G_PARAM_READWRITE));
+
+  /**
+   * gstpixeltransform:saturation:
+   *
+   * The factor chroma gets scaled by, applied after the curve.
+   */
+  g_object_class_install_property (gobject_class, PROP_SATURATION,
+      g_param_spec_double ("saturation", "saturation", "saturation factor",
+          0.0, MAX_SATURATION, 1.0, G_PARAM_READWRITE));
+
+  gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
+      "pixel transform", "Filter/Effect/Video",
+      "Applies a tone curve and a saturation factor in a single pass",
+      "mduponchelle1@gmail.com");
+}
+
+static void
+gst_pixel_transform_init (GstPixelTransform * self)
+{
+  guint i;
+
+  for (i = 0; i < 256; i++)
+    self->curve[i] = i;
+  self->saturation = 1.0;
+
+  gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (self),
+      _update_tables (self));
+}
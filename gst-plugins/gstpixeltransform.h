@@ -0,0 +1,62 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_PIXEL_TRANSFORM_H_
+#define _GST_PIXEL_TRANSFORM_H_
+
+#include <gst/video/video.h>
+#include <gst/video/gstvideofilter.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_PIXEL_TRANSFORM   (gst_pixel_transform_get_type())
+#define GST_PIXEL_TRANSFORM(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_PIXEL_TRANSFORM,GstPixelTransform))
+#define GST_PIXEL_TRANSFORM_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_PIXEL_TRANSFORM,GstPixelTransformClass))
+#define GST_IS_PIXEL_TRANSFORM(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_PIXEL_TRANSFORM))
+#define GST_IS_PIXEL_TRANSFORM_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_PIXEL_TRANSFORM))
+
+typedef struct _GstPixelTransform GstPixelTransform;
+typedef struct _GstPixelTransformClass GstPixelTransformClass;
+
+struct _GstPixelTransform
+{
+  GstVideoFilter parent;
+
+  /* Applied to luma, or to each colour channel of RGB formats */
+  guint8 curve[256];
+  gdouble saturation;
+
+  /* Built from the saturation for the chroma of YUV formats */
+  guint8 chroma_table[256];
+  /* Saturation in 8.8 fixed point, for RGB formats */
+  gint saturation_fixed;
+
+  /*  This should never be made public, no padding needed */
+};
+
+struct _GstPixelTransformClass
+{
+  GstVideoFilterClass parent_class;
+};
+
+GType gst_pixel_transform_get_type (void);
+
+G_END_DECLS
+
+#endif
@@ -24,6 +24,11 @@
 #include <gst/gst.h>
 
 #include "gstsamplecontroller.h"
+#include "gstgainramp.h"
+
+/* Frames between two evaluations of the volume curve when sample accurate,
+ * it is linearly interpolated in between */
+#define RAMP_BLOCK_SIZE 64
 
 static void gst_sample_controller_set_property (GObject * object,
     guint property_id, const GValue * value, GParamSpec * pspec);
@@ -31,6 +36,8 @@ static void gst_sample_controller_get_property (GObject * object,
     guint property_id, GValue * value, GParamSpec * pspec);
 static GstFlowReturn gst_sample_controller_transform_ip (GstBaseTransform *
     trans, GstBuffer * buf);
+static gboolean gst_sample_controller_set_caps (GstBaseTransform * trans,
+    GstCaps * incaps, GstCaps * outcaps);
 
 static gboolean
 gst_sample_controller_meta_transform (GstBuffer * dest, GstMeta * meta,
@@ -41,6 +48,8 @@ enum
   PROP_0,
   PROP_VOLUME,
   PROP_ZORDER,
+  PROP_SAMPLE_ACCURATE,
+  PROP_BAKE,
 };
 
 static GstStaticPadTemplate gst_sample_controller_src_template =
@@ -66,6 +75,14 @@ gst_sample_controller_dispose (GObject * object)
   G_OBJECT_CLASS (gst_sample_controller_parent_class)->dispose (object);
 }
 
+static void
+gst_sample_controller_finalize (GObject * object)
+{
+  gst_baked_curve_free (GST_SAMPLE_CONTROLLER (object)->volume_curve);
+
+  G_OBJECT_CLASS (gst_sample_controller_parent_class)->finalize (object);
+}
+
 static void
 gst_sample_controller_class_init (GstSampleControllerClass * klass)
 {
@@ -81,8 +98,11 @@ gst_sample_controller_class_init (GstSampleControllerClass * klass)
   gobject_class->set_property = gst_sample_controller_set_property;
   gobject_class->get_property = gst_sample_controller_get_property;
   gobject_class->dispose = gst_sample_controller_dispose;
+  gobject_class->finalize = gst_sample_controller_finalize;
   base_transform_class->transform_ip =
       GST_DEBUG_FUNCPTR (gst_sample_controller_transform_ip);
+  base_transform_class->set_caps =
+      GST_DEBUG_FUNCPTR (gst_sample_controller_set_caps);
 
   /**
    * gstframepositionner:alpha:
@@ -102,6 +122,30 @@ gst_sample_controller_class_init (GstSampleControllerClass * klass)
       g_param_spec_uint ("zorder", "zorder", "z order of the stream",
           0, 10000, 0, G_PARAM_READWRITE));
 
+  /**
+   * gstsamplecontroller:sample-accurate:
+   *
+   * When the volume is controlled, apply it to the samples ourselves,
+   * following its curve, instead of letting the mixer apply the volume
+   * of the start of the buffer to all of it. Only done for native endian
+   * interleaved F32 and S16.
+   */
+  g_object_class_install_property (gobject_class, PROP_SAMPLE_ACCURATE,
+      g_param_spec_boolean ("sample-accurate", "sample accurate",
+          "Follow the volume curve within buffers", FALSE, G_PARAM_READWRITE));
+
+  /**
+   * gstsamplecontroller:bake:
+   *
+   * Precompute the volume curve into a table, with one value per ramp
+   * block, and look the volume up from it instead of syncing it for each
+   * buffer. The table has to be rebuilt when control points change, which
+   * setting this to TRUE again requests.
+   */
+  g_object_class_install_property (gobject_class, PROP_BAKE,
+      g_param_spec_boolean ("bake", "bake", "Bake the volume curve",
+          FALSE, G_PARAM_READWRITE));
+
   gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
       "sample controller", "Metadata",
       "This element provides with tagging facilities",
@@ -114,6 +158,11 @@ gst_sample_controller_init (GstSampleController *samplecontroller)
   samplecontroller->volume = 1.0;
   samplecontroller->zorder = 0;
   samplecontroller->capsfilter = NULL;
+  samplecontroller->sample_accurate = FALSE;
+  samplecontroller->can_ramp = FALSE;
+  samplecontroller->bake = FALSE;
+  samplecontroller->volume_curve =
+      gst_baked_curve_new (GST_OBJECT (samplecontroller), "volume");
 }
 
 void
@@ -131,6 +180,13 @@ gst_sample_controller_set_property (GObject * object, guint property_id,
     case PROP_ZORDER:
       samplecontroller->zorder = g_value_get_uint (value);
       break;
+    case PROP_SAMPLE_ACCURATE:
+      samplecontroller->sample_accurate = g_value_get_boolean (value);
+      break;
+    case PROP_BAKE:
+      samplecontroller->bake = g_value_get_boolean (value);
+      gst_baked_curve_invalidate (samplecontroller->volume_curve);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -151,6 +207,12 @@ gst_sample_controller_get_property (GObject * object, guint property_id,
     case PROP_ZORDER:
       g_value_set_uint (value, samplecontroller->zorder);
       break;
+    case PROP_SAMPLE_ACCURATE:
+      g_value_set_boolean (value, samplecontroller->sample_accurate);
+      break;
+    case PROP_BAKE:
+      g_value_set_boolean (value, samplecontroller->bake);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -207,15 +269,121 @@ gst_sample_controller_meta_transform (GstBuffer * dest, GstMeta * meta,
   return TRUE;
 }
 
+static gboolean
+gst_sample_controller_set_caps (GstBaseTransform * trans, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstSampleController *samplecontroller = GST_SAMPLE_CONTROLLER (trans);
+  GstAudioFormat format;
+
+  samplecontroller->can_ramp = FALSE;
+
+  if (!gst_audio_info_from_caps (&samplecontroller->info, incaps))
+    return TRUE;
+
+  format = GST_AUDIO_INFO_FORMAT (&samplecontroller->info);
+  samplecontroller->can_ramp =
+      GST_AUDIO_INFO_LAYOUT (&samplecontroller->info) ==
+      GST_AUDIO_LAYOUT_INTERLEAVED && (format == GST_AUDIO_FORMAT_F32
+      || format == GST_AUDIO_FORMAT_S16);
+
+  gst_baked_curve_set_interval (samplecontroller->volume_curve,
+      gst_util_uint64_scale_int (RAMP_BLOCK_SIZE, GST_SECOND,
+          GST_AUDIO_INFO_RATE (&samplecontroller->info)));
+
+  return TRUE;
+}
+
+/* Applies the volume curve to @buf, evaluating it every RAMP_BLOCK_SIZE
+ * frames. Returns FALSE if there's no curve to follow */
+static gboolean
+_apply_volume_ramp (GstSampleController * samplecontroller, GstBuffer * buf)
+{
+  GstAudioInfo *info = &samplecontroller->info;
+  GstClockTime timestamp = GST_BUFFER_TIMESTAMP (buf);
+  GstClockTime block_duration;
+  GstMapInfo map;
+  gdouble *values;
+  guint n_frames, n_blocks, block, frames;
+  guint channels = GST_AUDIO_INFO_CHANNELS (info);
+  gboolean ret = FALSE;
+
+  if (!GST_CLOCK_TIME_IS_VALID (timestamp)
+      || !gst_object_has_active_control_bindings (GST_OBJECT (samplecontroller)))
+    return FALSE;
+
+  block_duration = gst_util_uint64_scale_int (RAMP_BLOCK_SIZE, GST_SECOND,
+      GST_AUDIO_INFO_RATE (info));
+
+  if (!gst_buffer_map (buf, &map, GST_MAP_READWRITE))
+    return FALSE;
+
+  n_frames = map.size / GST_AUDIO_INFO_BPF (info);
+  n_blocks = (n_frames + RAMP_BLOCK_SIZE - 1) / RAMP_BLOCK_SIZE;
+  values = g_new (gdouble, n_blocks + 1);
+
+  if (samplecontroller->bake) {
+    /* The table has exactly one value per block */
+    for (block = 0; block <= n_blocks; block++) {
+      if (!gst_baked_curve_get_value (samplecontroller->volume_curve,
+              timestamp + block * block_duration, &values[block]))
+        goto done;
+    }
+  } else {
+    /* Entries without a value, before the first keyframe for example,
+     * are left alone */
+    for (block = 0; block <= n_blocks; block++)
+      values[block] = samplecontroller->volume;
+    if (!gst_object_get_value_array (GST_OBJECT (samplecontroller),
+            "volume", timestamp, block_duration, n_blocks + 1, values))
+      goto done;
+  }
+
+  for (block = 0; block < n_blocks; block++) {
+    gfloat gain = values[block];
+    gfloat step = (values[block + 1] - gain) / RAMP_BLOCK_SIZE;
+    guint offset = block * RAMP_BLOCK_SIZE;
+
+    frames = MIN (RAMP_BLOCK_SIZE, n_frames - offset);
+    if (GST_AUDIO_INFO_FORMAT (info) == GST_AUDIO_FORMAT_F32)
+      gst_gain_ramp_f32 ((gfloat *) map.data + offset * channels, frames,
+          channels, gain, step);
+    else
+      gst_gain_ramp_s16 ((gint16 *) map.data + offset * channels, frames,
+          channels, gain, step);
+  }
+
+  ret = TRUE;
+
+done:
+  g_free (values);
+  gst_buffer_unmap (buf, &map);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_sample_controller_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
 {
   GstSampleControllerMeta *meta;
   GstSampleController *samplecontroller = GST_SAMPLE_CONTROLLER (trans);
   GstClockTime timestamp = GST_BUFFER_TIMESTAMP (buf);
-
-  if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
-    gst_object_sync_values (GST_OBJECT (trans), timestamp);
+  gboolean ramped = FALSE;
+
+  if (samplecontroller->sample_accurate && samplecontroller->can_ramp)
+    ramped = _apply_volume_ramp (samplecontroller, buf);
+
+  if (!ramped && GST_CLOCK_TIME_IS_VALID (timestamp)) {
+    gdouble volume;
+
+    if (!samplecontroller->bake) {
+      gst_object_sync_values (GST_OBJECT (trans), timestamp);
+    } else if (gst_baked_curve_get_value (samplecontroller->volume_curve,
+            timestamp, &volume)) {
+      GST_OBJECT_LOCK (samplecontroller);
+      samplecontroller->volume = CLAMP (volume, 0.0, 1.0);
+      GST_OBJECT_UNLOCK (samplecontroller);
+    }
   }
 
   meta =
@@ -223,7 +391,8 @@ gst_sample_controller_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
       gst_sample_controller_get_info (), NULL);
 
   GST_OBJECT_LOCK (samplecontroller);
-  meta->volume = samplecontroller->volume;
+  /* Already applied */
+  meta->volume = ramped ? 1.0 : samplecontroller->volume;
   meta->zorder = samplecontroller->zorder;
   GST_OBJECT_UNLOCK (samplecontroller);
 
@@ -21,6 +21,9 @@
 #define _GST_SAMPLE_CONTROLLER
 
 #include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+
+#include "gstbakedcurve.h"
 
 G_BEGIN_DECLS
 
@@ -42,6 +45,15 @@ struct _GstSampleController
 
   gdouble volume;
   guint zorder;
+  gboolean sample_accurate;
+
+  /* Whether we know how to apply the volume to our format ourselves */
+  gboolean can_ramp;
+  GstAudioInfo info;
+
+  /* Lookup table for the volume, used instead of syncing it when baking */
+  gboolean bake;
+  GstBakedCurve *volume_curve;
 
   /*  This should never be made public, no padding needed */
 };
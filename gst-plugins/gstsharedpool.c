@@ -0,0 +1,222 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/video/video.h>
+
+#include "gstsharedpool.h"
+
+typedef struct _GstSharedPool
+{
+  GstVideoBufferPool parent;
+
+  GstCaps *caps;
+  /* Buffers actually allocated, as opposed to recycled */
+  gint n_allocated;
+} GstSharedPool;
+
+typedef struct _GstSharedPoolClass
+{
+  GstVideoBufferPoolClass parent_class;
+} GstSharedPoolClass;
+
+typedef struct _GstSharedPoolClient
+{
+  GstBufferPool parent;
+
+  GstBufferPool *shared;
+} GstSharedPoolClient;
+
+typedef struct _GstSharedPoolClientClass
+{
+  GstBufferPoolClass parent_class;
+} GstSharedPoolClientClass;
+
+static GType gst_shared_pool_get_type (void);
+static GType gst_shared_pool_client_get_type (void);
+
+G_DEFINE_TYPE (GstSharedPool, gst_shared_pool, GST_TYPE_VIDEO_BUFFER_POOL);
+G_DEFINE_TYPE (GstSharedPoolClient, gst_shared_pool_client,
+    GST_TYPE_BUFFER_POOL);
+
+/* Shared pool */
+
+static GstFlowReturn
+gst_shared_pool_alloc_buffer (GstBufferPool * pool, GstBuffer ** buffer,
+    GstBufferPoolAcquireParams * params)
+{
+  GstFlowReturn ret =
+      GST_BUFFER_POOL_CLASS (gst_shared_pool_parent_class)->alloc_buffer (pool,
+      buffer, params);
+
+  if (ret == GST_FLOW_OK)
+    g_atomic_int_inc (&((GstSharedPool *) pool)->n_allocated);
+
+  return ret;
+}
+
+static void
+gst_shared_pool_finalize (GObject * object)
+{
+  gst_caps_replace (&((GstSharedPool *) object)->caps, NULL);
+
+  G_OBJECT_CLASS (gst_shared_pool_parent_class)->finalize (object);
+}
+
+static void
+gst_shared_pool_class_init (GstSharedPoolClass * klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = gst_shared_pool_finalize;
+  GST_BUFFER_POOL_CLASS (klass)->alloc_buffer = gst_shared_pool_alloc_buffer;
+}
+
+static void
+gst_shared_pool_init (GstSharedPool * self)
+{
+}
+
+/* Client pool, only ever lends the buffers of the shared one */
+
+static gboolean
+gst_shared_pool_client_start (GstBufferPool * pool)
+{
+  /* Nothing to preallocate */
+  return TRUE;
+}
+
+static gboolean
+gst_shared_pool_client_stop (GstBufferPool * pool)
+{
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_shared_pool_client_acquire_buffer (GstBufferPool * pool,
+    GstBuffer ** buffer, GstBufferPoolAcquireParams * params)
+{
+  GstSharedPoolClient *self = (GstSharedPoolClient *) pool;
+  GstFlowReturn ret;
+
+  ret = gst_buffer_pool_acquire_buffer (self->shared, buffer, params);
+
+  /* The buffer goes back to us first, see release_buffer */
+  if (ret == GST_FLOW_OK) {
+    gst_object_unref ((*buffer)->pool);
+    (*buffer)->pool = NULL;
+  }
+
+  return ret;
+}
+
+static void
+gst_shared_pool_client_release_buffer (GstBufferPool * pool,
+    GstBuffer * buffer)
+{
+  GstSharedPoolClient *self = (GstSharedPoolClient *) pool;
+
+  buffer->pool = gst_object_ref (self->shared);
+  gst_buffer_pool_release_buffer (self->shared, buffer);
+}
+
+static void
+gst_shared_pool_client_finalize (GObject * object)
+{
+  gst_object_unref (((GstSharedPoolClient *) object)->shared);
+
+  G_OBJECT_CLASS (gst_shared_pool_client_parent_class)->finalize (object);
+}
+
+static void
+gst_shared_pool_client_class_init (GstSharedPoolClientClass * klass)
+{
+  GstBufferPoolClass *pool_class = GST_BUFFER_POOL_CLASS (klass);
+
+  G_OBJECT_CLASS (klass)->finalize = gst_shared_pool_client_finalize;
+  pool_class->start = gst_shared_pool_client_start;
+  pool_class->stop = gst_shared_pool_client_stop;
+  pool_class->acquire_buffer = gst_shared_pool_client_acquire_buffer;
+  pool_class->release_buffer = gst_shared_pool_client_release_buffer;
+}
+
+static void
+gst_shared_pool_client_init (GstSharedPoolClient * self)
+{
+}
+
+/* API */
+
+GstBufferPool *
+gst_shared_pool_new (GstCaps * caps)
+{
+  GstSharedPool *self;
+  GstStructure *config;
+  GstVideoInfo info;
+
+  if (!gst_video_info_from_caps (&info, caps))
+    return NULL;
+
+  self = g_object_new (gst_shared_pool_get_type (), NULL);
+  gst_object_ref_sink (self);
+  self->caps = gst_caps_ref (caps);
+
+  config = gst_buffer_pool_get_config (GST_BUFFER_POOL (self));
+  gst_buffer_pool_config_set_params (config, caps, GST_VIDEO_INFO_SIZE (&info),
+      0, 0);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+  if (!gst_buffer_pool_set_config (GST_BUFFER_POOL (self), config)
+      || !gst_buffer_pool_set_active (GST_BUFFER_POOL (self), TRUE)) {
+    gst_object_unref (self);
+    return NULL;
+  }
+
+  return GST_BUFFER_POOL (self);
+}
+
+gboolean
+gst_shared_pool_has_caps (GstBufferPool * shared, GstCaps * caps)
+{
+  return gst_caps_is_equal (((GstSharedPool *) shared)->caps, caps);
+}
+
+guint
+gst_shared_pool_get_n_allocated (GstBufferPool * shared)
+{
+  return g_atomic_int_get (&((GstSharedPool *) shared)->n_allocated);
+}
+
+GstBufferPool *
+gst_shared_pool_new_client (GstBufferPool * shared)
+{
+  GstSharedPoolClient *self;
+  GstStructure *config;
+
+  self = g_object_new (gst_shared_pool_client_get_type (), NULL);
+  gst_object_ref_sink (self);
+  self->shared = gst_object_ref (shared);
+
+  /* Same parameters, for elements to know what they get */
+  config = gst_buffer_pool_get_config (shared);
+  gst_buffer_pool_set_config (GST_BUFFER_POOL (self), config);
+
+  return GST_BUFFER_POOL (self);
+}
@@ -0,0 +1,39 @@
+/* GStreamer
+ * Copyright (C) 2013 Mathieu Duponchelle <mduponchelle1@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_SHARED_POOL_H_
+#define _GST_SHARED_POOL_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* A video buffer pool for @caps, active, meant to be shared by elements
+ * through gst_shared_pool_new_client */
+GstBufferPool * gst_shared_pool_new (GstCaps * caps);
+gboolean        gst_shared_pool_has_caps (GstBufferPool * shared, GstCaps * caps);
+guint           gst_shared_pool_get_n_allocated (GstBufferPool * shared);
+
+/* A pool handing out the buffers of @shared, that one element can activate
+ * and deactivate as it wishes without affecting the others */
+GstBufferPool * gst_shared_pool_new_client (GstBufferPool * shared);
+
+G_END_DECLS
+
+#endif
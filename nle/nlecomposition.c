@@ -103,25 +103,57 @@ typedef struct
   gint32 seqnum;
 
   NleUpdateStackReason reason;
+  /* Only for COMP_UPDATE_STACK_ON_COMMIT, see commit_serial */
+  guint commit_serial;
 } UpdateCompositionData;
 
-struct _NleCompositionPrivate
+/*
+   Snapshot of the objects a composition can put in its stack, never
+   modified once built. The composition task replaces it as a whole at the
+   safe point of _commit_all_values, threads that got a reference with
+   _get_index can keep reading the previous one meanwhile.
+ */
+typedef struct
 {
-  gboolean dispose_has_run;
+  gint refcount;
 
   /*
-     Sorted List of NleObjects , ThreadSafe
+     Lists of NleObjects, each referenced once, expandables excluded
      objects_start : sorted by start-time then priority
      objects_stop : sorted by stop-time then priority
+   */
+  GList *objects_start;
+  GList *objects_stop;
+} NleObjectIndex;
+
+struct _NleCompositionPrivate
+{
+  gboolean dispose_has_run;
+
+  /*
+     index : the published NleObjectIndex, only replaced by the task,
+     which can read it without taking a reference.
      objects_hash : contains all controlled objects
 
-     Those list should be manipulated exclusively in the main context
+     objects_hash should be manipulated exclusively in the main context
      or while the task is totally stopped.
    */
-  GList *objects_start;
-  GList *objects_stop;
+  NleObjectIndex *index;
   GHashTable *objects_hash;
 
+  /*
+     Protects the fields below and the publication of index.
+
+     next_objects : objects added to the composition and not removed
+     since, as seen by the threads editing it.
+     next_index : the index built from next_objects when the last commit
+     was requested. Sorting happens there, in the editing thread, the task
+     only picks the result up at the next safe point.
+   */
+  GMutex index_lock;
+  GHashTable *next_objects;
+  NleObjectIndex *next_index;
+
   /* List of NleObject to be inserted or removed from the composition on the
    * next commit */
   GHashTable *pending_io;
@@ -179,6 +211,18 @@ struct _NleCompositionPrivate
   gboolean tearing_down_stack;
 
   NleUpdateStackReason updating_reason;
+
+  /*
+     commit_serial : serial of the last commit requested, incremented
+     atomically by the threads committing.
+     commited_serial : serial of the commit the "commited" signal being
+     emitted reports, only touched by the task.
+     restart_commit_serial : serial of the commit waiting for the new
+     stack to be ready before it gets reported.
+   */
+  guint commit_serial;
+  guint commited_serial;
+  guint restart_commit_serial;
 };
 
 typedef struct _Action
@@ -314,6 +358,195 @@ _assert_proper_thread (NleComposition * comp)
   }
 }
 
+static gint
+pending_objects_start_compare (NleObject * a, NleObject * b)
+{
+  if (a->pending_start == b->pending_start) {
+    if (a->pending_priority < b->pending_priority)
+      return -1;
+    if (a->pending_priority > b->pending_priority)
+      return 1;
+    return 0;
+  }
+  if (a->pending_start < b->pending_start)
+    return -1;
+  return 1;
+}
+
+static gint
+pending_objects_stop_compare (NleObject * a, NleObject * b)
+{
+  GstClockTime a_stop = a->pending_start + a->pending_duration;
+  GstClockTime b_stop = b->pending_start + b->pending_duration;
+
+  if (a_stop == b_stop) {
+    if (a->pending_priority < b->pending_priority)
+      return -1;
+    if (a->pending_priority > b->pending_priority)
+      return 1;
+    return 0;
+  }
+  if (b_stop < a_stop)
+    return -1;
+  return 1;
+}
+
+/* Takes ownership of @objects, sorting it with the committed values of
+ * the objects, or their pending ones if @pending */
+static NleObjectIndex *
+_index_new (GList * objects, gboolean pending)
+{
+  NleObjectIndex *index = g_slice_new0 (NleObjectIndex);
+
+  index->refcount = 1;
+  g_list_foreach (objects, (GFunc) gst_object_ref, NULL);
+  index->objects_stop = g_list_sort (g_list_copy (objects), (GCompareFunc)
+      (pending ? pending_objects_stop_compare : objects_stop_compare));
+  index->objects_start = g_list_sort (objects, (GCompareFunc)
+      (pending ? pending_objects_start_compare : objects_start_compare));
+
+  return index;
+}
+
+static NleObjectIndex *
+_index_ref (NleObjectIndex * index)
+{
+  g_atomic_int_inc (&index->refcount);
+
+  return index;
+}
+
+static void
+_index_unref (NleObjectIndex * index)
+{
+  if (!index || !g_atomic_int_dec_and_test (&index->refcount))
+    return;
+
+  g_list_free_full (index->objects_start, gst_object_unref);
+  g_list_free (index->objects_stop);
+  g_slice_free (NleObjectIndex, index);
+}
+
+static gboolean
+_list_is_sorted (GList * list, GCompareFunc compare)
+{
+  for (; list && list->next; list = list->next) {
+    if (compare (list->data, list->next->data) > 0)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* For threads other than the task */
+static NleObjectIndex *
+_get_index (NleComposition * comp)
+{
+  NleObjectIndex *index;
+
+  g_mutex_lock (&comp->priv->index_lock);
+  index = _index_ref (comp->priv->index);
+  g_mutex_unlock (&comp->priv->index_lock);
+
+  return index;
+}
+
+/* Called from the thread requesting the commit */
+static void
+_build_next_index (NleComposition * comp)
+{
+  NleCompositionPrivate *priv = comp->priv;
+  GHashTableIter iter;
+  NleObject *object;
+  GList *objects = NULL;
+  NleObjectIndex *index, *old;
+
+  g_mutex_lock (&priv->index_lock);
+  g_hash_table_iter_init (&iter, priv->next_objects);
+  while (g_hash_table_iter_next (&iter, (gpointer *) & object, NULL)) {
+    if (!NLE_OBJECT_IS_EXPANDABLE (object))
+      objects = g_list_prepend (objects, gst_object_ref (object));
+  }
+  g_mutex_unlock (&priv->index_lock);
+
+  /* Sort without holding the lock so the task never waits for it */
+  index = _index_new (objects, TRUE);
+  g_list_foreach (index->objects_start, (GFunc) gst_object_unref, NULL);
+
+  g_mutex_lock (&priv->index_lock);
+  old = priv->next_index;
+  priv->next_index = index;
+  g_mutex_unlock (&priv->index_lock);
+
+  _index_unref (old);
+}
+
+/* Whether @index contains exactly the objects of the composition */
+static gboolean
+_index_is_current (NleComposition * comp, NleObjectIndex * index)
+{
+  NleCompositionPrivate *priv = comp->priv;
+  GList *tmp;
+  guint n_objects = 0;
+
+  for (tmp = index->objects_start; tmp; tmp = tmp->next, n_objects++) {
+    if (!g_hash_table_contains (priv->objects_hash, tmp->data))
+      return FALSE;
+  }
+
+  return n_objects + g_list_length (priv->expandables) ==
+      g_hash_table_size (priv->objects_hash);
+}
+
+/* Returns a new index matching the objects of the composition, reusing
+ * the one built by the editing thread when possible */
+static NleObjectIndex *
+_take_next_index (NleComposition * comp)
+{
+  NleCompositionPrivate *priv = comp->priv;
+  NleObjectIndex *index;
+  GHashTableIter iter;
+  NleObject *object;
+  GList *objects = NULL;
+
+  g_mutex_lock (&priv->index_lock);
+  index = priv->next_index;
+  priv->next_index = NULL;
+  g_mutex_unlock (&priv->index_lock);
+
+  /* Objects were added or removed after it was built, their actions
+   * aren't processed yet */
+  if (index && !_index_is_current (comp, index)) {
+    GST_DEBUG_OBJECT (comp, "next index is outdated, rebuilding it");
+    _index_unref (index);
+    index = NULL;
+  }
+
+  if (index)
+    return index;
+
+  g_hash_table_iter_init (&iter, priv->objects_hash);
+  while (g_hash_table_iter_next (&iter, (gpointer *) & object, NULL)) {
+    if (!g_list_find (priv->expandables, object))
+      objects = g_list_prepend (objects, object);
+  }
+
+  return _index_new (objects, TRUE);
+}
+
+static void
+_publish_index (NleComposition * comp, NleObjectIndex * index)
+{
+  NleObjectIndex *old;
+
+  g_mutex_lock (&comp->priv->index_lock);
+  old = comp->priv->index;
+  comp->priv->index = index;
+  g_mutex_unlock (&comp->priv->index_lock);
+
+  _index_unref (old);
+}
+
 static void
 _remove_actions_for_type (NleComposition * comp, GCallback callback)
 {
@@ -575,13 +808,12 @@ _process_pending_entries (NleComposition * comp)
 
 
 static inline gboolean
-_commit_values (NleComposition * comp)
+_commit_values (NleComposition * comp, NleObjectIndex * index)
 {
   GList *tmp;
   gboolean commited = FALSE;
-  NleCompositionPrivate *priv = comp->priv;
 
-  for (tmp = priv->objects_start; tmp; tmp = tmp->next) {
+  for (tmp = index->objects_start; tmp; tmp = tmp->next) {
     if (nle_object_commit (tmp->data, TRUE))
       commited = TRUE;
   }
@@ -596,23 +828,29 @@ static gboolean
 _commit_all_values (NleComposition * comp)
 {
   NleCompositionPrivate *priv = comp->priv;
+  NleObjectIndex *index;
+  gboolean commited;
 
   priv->next_base_time = 0;
 
+  /* This is the safe point where the next index gets swapped in */
   _process_pending_entries (comp);
+  index = _take_next_index (comp);
+  commited = _commit_values (comp, index);
 
-  if (_commit_values (comp) == FALSE) {
+  /* It was sorted on the values pending when the commit was requested,
+   * only sort again if some changed since */
+  if (!_list_is_sorted (index->objects_start, (GCompareFunc) objects_start_compare) ||
+      !_list_is_sorted (index->objects_stop, (GCompareFunc) objects_stop_compare)) {
+    NleObjectIndex *sorted = _index_new (g_list_copy (index->objects_start), FALSE);
 
-    return FALSE;;
+    _index_unref (index);
+    index = sorted;
   }
 
-  /* The topology of the composition might have changed, update the lists */
-  priv->objects_start = g_list_sort
-      (priv->objects_start, (GCompareFunc) objects_start_compare);
-  priv->objects_stop = g_list_sort
-      (priv->objects_stop, (GCompareFunc) objects_stop_compare);
+  _publish_index (comp, index);
 
-  return TRUE;
+  return commited;
 }
 
 static gboolean
@@ -805,20 +1043,29 @@ _remove_seek_actions (NleComposition * comp)
   _remove_actions_for_type (comp, G_CALLBACK (_seek_pipeline_func));
 }
 
-static void
+/* Returns the serial of the commit for COMP_UPDATE_STACK_ON_COMMIT, 0
+ * otherwise */
+static guint
 _add_update_compo_action (NleComposition * comp,
     GCallback callback, NleUpdateStackReason reason)
 {
   UpdateCompositionData *ucompo = g_slice_new0 (UpdateCompositionData);
+  guint commit_serial = 0;
 
   ucompo->comp = comp;
   ucompo->reason = reason;
   ucompo->seqnum = gst_util_seqnum_next ();
+  if (reason == COMP_UPDATE_STACK_ON_COMMIT)
+    commit_serial = ucompo->commit_serial =
+        g_atomic_int_add (&comp->priv->commit_serial, 1) + 1;
 
   GST_INFO_OBJECT (comp, "Updating because: %s -- Setting seqnum: %i",
       UPDATE_PIPELINE_REASONS[reason], ucompo->seqnum);
 
+  /* @ucompo belongs to the task from now on */
   _add_action (comp, callback, ucompo, G_PRIORITY_DEFAULT);
+
+  return commit_serial;
 }
 
 static void
@@ -965,8 +1212,9 @@ nle_composition_init (NleComposition * comp)
 
   priv = G_TYPE_INSTANCE_GET_PRIVATE (comp, NLE_TYPE_COMPOSITION,
       NleCompositionPrivate);
-  priv->objects_start = NULL;
-  priv->objects_stop = NULL;
+  priv->index = _index_new (NULL, FALSE);
+  g_mutex_init (&priv->index_lock);
+  priv->next_objects = g_hash_table_new (g_direct_hash, g_direct_equal);
 
   priv->segment = gst_segment_new ();
   priv->outside_segment = gst_segment_new ();
@@ -1004,15 +1252,15 @@ nle_composition_dispose (GObject * object)
 
   priv->dispose_has_run = TRUE;
 
-  iter = priv->objects_start;
-  while (iter) {
-    GList *next = iter->next;
-
+  for (iter = priv->index->objects_start; iter; iter = iter->next)
     _nle_composition_remove_object (comp, iter->data);
-    iter = next;
-  }
 
-  g_list_free (priv->objects_stop);
+  _publish_index (comp, _index_new (NULL, FALSE));
+  g_mutex_lock (&priv->index_lock);
+  _index_unref (priv->next_index);
+  priv->next_index = NULL;
+  g_hash_table_remove_all (priv->next_objects);
+  g_mutex_unlock (&priv->index_lock);
 
   if (priv->expandables) {
     GList *iter;
@@ -1050,6 +1298,9 @@ nle_composition_finalize (GObject * object)
   }
 
   g_hash_table_destroy (priv->objects_hash);
+  _index_unref (priv->index);
+  g_hash_table_unref (priv->next_objects);
+  g_mutex_clear (&priv->index_lock);
 
   gst_segment_free (priv->segment);
   gst_segment_free (priv->outside_segment);
@@ -1306,11 +1557,19 @@ have_to_update_pipeline (NleComposition * comp,
   return FALSE;
 }
 
+static guint
+_commit_composition (NleComposition * comp)
+{
+  _build_next_index (comp);
+
+  return _add_update_compo_action (comp, G_CALLBACK (_commit_func),
+      COMP_UPDATE_STACK_ON_COMMIT);
+}
+
 static gboolean
 nle_composition_commit_func (NleObject * object, gboolean recurse)
 {
-  _add_update_compo_action (NLE_COMPOSITION (object),
-      G_CALLBACK (_commit_func), COMP_UPDATE_STACK_ON_COMMIT);
+  _commit_composition (NLE_COMPOSITION (object));
 
   return TRUE;
 }
@@ -1723,7 +1982,7 @@ refine_start_stop_in_region_above_priority (NleComposition * composition,
       GST_TIME_FORMAT " priority:%u", GST_TIME_ARGS (timestamp),
       GST_TIME_ARGS (start), GST_TIME_ARGS (stop), priority);
 
-  for (tmp = composition->priv->objects_start; tmp; tmp = tmp->next) {
+  for (tmp = composition->priv->index->objects_start; tmp; tmp = tmp->next) {
     object = (NleObject *) tmp->data;
 
     GST_LOG_OBJECT (object, "START %" GST_TIME_FORMAT "--%" GST_TIME_FORMAT,
@@ -1748,7 +2007,7 @@ refine_start_stop_in_region_above_priority (NleComposition * composition,
     break;
   }
 
-  for (tmp = composition->priv->objects_stop; tmp; tmp = tmp->next) {
+  for (tmp = composition->priv->index->objects_stop; tmp; tmp = tmp->next) {
     object = (NleObject *) tmp->data;
 
     GST_LOG_OBJECT (object, "STOP %" GST_TIME_FORMAT "--%" GST_TIME_FORMAT,
@@ -1897,11 +2156,11 @@ get_stack_list (NleComposition * comp, GstClockTime timestamp,
       "timestamp:%" GST_TIME_FORMAT ", priority:%u, activeonly:%d",
       GST_TIME_ARGS (timestamp), priority, activeonly);
 
-  GST_LOG ("objects_start:%p objects_stop:%p", comp->priv->objects_start,
-      comp->priv->objects_stop);
+  GST_LOG ("objects_start:%p objects_stop:%p", comp->priv->index->objects_start,
+      comp->priv->index->objects_stop);
 
   if (reverse) {
-    for (tmp = comp->priv->objects_stop; tmp; tmp = g_list_next (tmp)) {
+    for (tmp = comp->priv->index->objects_stop; tmp; tmp = g_list_next (tmp)) {
       NleObject *object = (NleObject *) tmp->data;
 
       GST_LOG_OBJECT (object,
@@ -1928,7 +2187,7 @@ get_stack_list (NleComposition * comp, GstClockTime timestamp,
       }
     }
   } else {
-    for (tmp = comp->priv->objects_start; tmp; tmp = g_list_next (tmp)) {
+    for (tmp = comp->priv->index->objects_start; tmp; tmp = g_list_next (tmp)) {
       NleObject *object = (NleObject *) tmp->data;
 
       GST_LOG_OBJECT (object,
@@ -2131,12 +2390,19 @@ _set_current_bin_to_ready (NleComposition * comp, gboolean flush_downstream)
   comp->priv->tearing_down_stack = FALSE;
 }
 
+static void
+_emit_commited (NleComposition * comp, guint commit_serial, gboolean changed)
+{
+  comp->priv->commited_serial = commit_serial;
+  g_signal_emit (comp, _signals[COMMITED_SIGNAL], 0, changed);
+}
+
 static void
 _emit_commited_signal_func (NleComposition * comp, gpointer udata)
 {
   GST_INFO_OBJECT (comp, "Emiting COMMITED now that the stack " "is ready");
 
-  g_signal_emit (comp, _signals[COMMITED_SIGNAL], 0, TRUE);
+  _emit_commited (comp, comp->priv->restart_commit_serial, TRUE);
 }
 
 static void
@@ -2211,7 +2477,7 @@ _commit_func (NleComposition * comp, UpdateCompositionData * ucompo)
   if (!_commit_all_values (comp)) {
     GST_DEBUG_OBJECT (comp, "Nothing to commit, leaving");
 
-    g_signal_emit (comp, _signals[COMMITED_SIGNAL], 0, FALSE);
+    _emit_commited (comp, ucompo->commit_serial, FALSE);
     _post_start_composition_update_done (comp, ucompo->seqnum, ucompo->reason);
 
     return;
@@ -2222,19 +2488,20 @@ _commit_func (NleComposition * comp, UpdateCompositionData * ucompo)
 
     update_start_stop_duration (comp);
 
-    g_signal_emit (comp, _signals[COMMITED_SIGNAL], 0, TRUE);
+    _emit_commited (comp, ucompo->commit_serial, TRUE);
 
   } else {
     /* And update the pipeline at current position if needed */
 
     update_start_stop_duration (comp);
+    priv->restart_commit_serial = ucompo->commit_serial;
     update_pipeline (comp, curpos, ucompo->seqnum, COMP_UPDATE_STACK_ON_COMMIT);
 
     if (!priv->current) {
       GST_INFO_OBJECT (comp, "No new stack set, we can go and keep acting on"
           " our children");
 
-      g_signal_emit (comp, _signals[COMMITED_SIGNAL], 0, TRUE);
+      _emit_commited (comp, ucompo->commit_serial, TRUE);
     }
   }
 
@@ -2290,14 +2557,16 @@ static void
 _set_all_children_state (NleComposition * comp, GstState state)
 {
   GList *tmp;
+  NleObjectIndex *index = _get_index (comp);
 
   GST_DEBUG_OBJECT (comp, "Setting all children state to %s",
       gst_element_state_get_name (state));
 
   comp->priv->tearing_down_stack = TRUE;
   gst_element_set_state (comp->priv->current_bin, state);
-  for (tmp = comp->priv->objects_start; tmp; tmp = tmp->next)
+  for (tmp = index->objects_start; tmp; tmp = tmp->next)
     gst_element_set_state (tmp->data, state);
+  _index_unref (index);
 
   for (tmp = comp->priv->expandables; tmp; tmp = tmp->next)
     gst_element_set_state (tmp->data, state);
@@ -2399,7 +2668,7 @@ update_start_stop_duration (NleComposition * comp)
 
   _assert_proper_thread (comp);
 
-  if (!priv->objects_start) {
+  if (!priv->index->objects_start) {
     GST_INFO_OBJECT (comp, "no objects, resetting everything to 0");
 
     if (cobj->start) {
@@ -2438,7 +2707,7 @@ update_start_stop_duration (NleComposition * comp)
   } else {
 
     /* Else it's the first object's start value */
-    obj = (NleObject *) priv->objects_start->data;
+    obj = (NleObject *) priv->index->objects_start->data;
 
     if (obj->start != cobj->start) {
       GST_INFO_OBJECT (obj, "setting start from %s to %" GST_TIME_FORMAT,
@@ -2450,7 +2719,7 @@ update_start_stop_duration (NleComposition * comp)
 
   }
 
-  obj = (NleObject *) priv->objects_stop->data;
+  obj = (NleObject *) priv->index->objects_stop->data;
 
   if (obj->stop != cobj->stop) {
     GST_INFO_OBJECT (obj, "setting stop from %s to %" GST_TIME_FORMAT,
@@ -2737,7 +3006,7 @@ _activate_new_stack (NleComposition * comp)
   NleCompositionPrivate *priv = comp->priv;
 
   if (!priv->current) {
-    if ((!priv->objects_start)) {
+    if ((!priv->index->objects_start)) {
       nle_composition_reset_target_pad (comp);
       priv->segment_start = 0;
       priv->segment_stop = GST_CLOCK_TIME_NONE;
@@ -2786,7 +3055,7 @@ _set_real_eos_seqnum_from_seek (NleComposition * comp, GstEvent * event)
     should_check_objects = TRUE;
 
   if (should_check_objects) {
-    for (tmp = priv->objects_stop; tmp; tmp = g_list_next (tmp)) {
+    for (tmp = priv->index->objects_stop; tmp; tmp = g_list_next (tmp)) {
       NleObject *object = (NleObject *) tmp->data;
 
       if (!NLE_IS_SOURCE (object))
@@ -2988,6 +3257,9 @@ nle_composition_add_object (GstBin * bin, GstElement * element)
   gst_object_ref_sink (object);
 
   object->composition = GST_ELEMENT (comp);
+  g_mutex_lock (&comp->priv->index_lock);
+  g_hash_table_add (comp->priv->next_objects, object);
+  g_mutex_unlock (&comp->priv->index_lock);
   _add_add_object_action (comp, object);
 
   return TRUE;
@@ -3044,27 +3316,13 @@ _nle_composition_add_object (NleComposition * comp, NleObject * object)
 
   /* Special case for default source. */
   if (NLE_OBJECT_IS_EXPANDABLE (object)) {
-    /* It doesn't get added to objects_start and objects_stop. */
+    /* It doesn't get added to the index. */
     priv->expandables = g_list_prepend (priv->expandables, object);
     goto beach;
   }
 
-  /* add it sorted to the objects list */
-  priv->objects_start = g_list_insert_sorted
-      (priv->objects_start, object, (GCompareFunc) objects_start_compare);
-
-  if (priv->objects_start)
-    GST_LOG_OBJECT (comp,
-        "Head of objects_start is now %s [%" GST_TIME_FORMAT "--%"
-        GST_TIME_FORMAT "]",
-        GST_OBJECT_NAME (priv->objects_start->data),
-        GST_TIME_ARGS (NLE_OBJECT_START (priv->objects_start->data)),
-        GST_TIME_ARGS (NLE_OBJECT_STOP (priv->objects_start->data)));
-
-  priv->objects_stop = g_list_insert_sorted
-      (priv->objects_stop, object, (GCompareFunc) objects_stop_compare);
-
-  /* Now the object is ready to be commited and then used */
+  /* Now the object is ready to be commited, and then used once the next
+   * index is published */
 
 beach:
   return ret;
@@ -3092,6 +3350,9 @@ nle_composition_remove_object (GstBin * bin, GstElement * element)
   object = NLE_OBJECT (element);
 
   object->composition = NULL;
+  g_mutex_lock (&comp->priv->index_lock);
+  g_hash_table_remove (comp->priv->next_objects, object);
+  g_mutex_unlock (&comp->priv->index_lock);
   _add_remove_object_action (comp, object);
 
   return TRUE;
@@ -3117,10 +3378,8 @@ _nle_composition_remove_object (NleComposition * comp, NleObject * object)
     /* Find it in the list */
     priv->expandables = g_list_remove (priv->expandables, object);
   } else {
-    /* remove it from the objects list and resort the lists */
-    priv->objects_start = g_list_remove (priv->objects_start, object);
-    priv->objects_stop = g_list_remove (priv->objects_stop, object);
-    GST_LOG_OBJECT (object, "Removed from the objects start/stop list");
+    /* The index keeps a reference until the next one is published */
+    GST_LOG_OBJECT (object, "Will be removed from the index on publication");
   }
 
   if (priv->current && NLE_OBJECT (priv->current->data) == NLE_OBJECT (object))
@@ -3136,3 +3395,57 @@ _nle_composition_remove_object (NleComposition * comp, NleObject * object)
 
   return TRUE;
 }
+
+/**
+ * nle_composition_commit:
+ * @comp: a #NleComposition
+ *
+ * Same as nle_object_commit(), for callers that need to know which
+ * #NleComposition::commited emission reports this commit.
+ *
+ * Returns: The serial of the commit, see
+ * nle_composition_get_commited_serial()
+ */
+guint
+nle_composition_commit (NleComposition * comp)
+{
+  NleObject *object = NLE_OBJECT (comp);
+  guint serial;
+
+  object->commiting = TRUE;
+  serial = _commit_composition (comp);
+  object->commiting = FALSE;
+
+  return serial;
+}
+
+/**
+ * nle_composition_get_commit_serial:
+ * @comp: a #NleComposition
+ *
+ * Each commit of @comp gets a serial, greater than the one of the commits
+ * requested before it.
+ *
+ * Returns: The serial of the last commit requested
+ */
+guint
+nle_composition_get_commit_serial (NleComposition * comp)
+{
+  return g_atomic_int_get (&comp->priv->commit_serial);
+}
+
+/**
+ * nle_composition_get_commited_serial:
+ * @comp: a #NleComposition
+ *
+ * Only meaningful from #NleComposition::commited handlers. Commits are
+ * applied in the order they were requested, the ones with a lower serial
+ * are applied too.
+ *
+ * Returns: The serial of the commit being reported
+ */
+guint
+nle_composition_get_commited_serial (NleComposition * comp)
+{
+  return comp->priv->commited_serial;
+}
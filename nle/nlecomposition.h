@@ -62,5 +62,9 @@ struct _NleCompositionClass
 
 GType nle_composition_get_type (void);
 
+guint nle_composition_commit (NleComposition * comp);
+guint nle_composition_get_commit_serial (NleComposition * comp);
+guint nle_composition_get_commited_serial (NleComposition * comp);
+
 G_END_DECLS
 #endif /* __NLE_COMPOSITION_H__ */
@@ -64,6 +64,14 @@ struct _NleSourcePrivate
   gulong probeid;
 };
 
+enum
+{
+  POPULATE_SIGNAL,
+  LAST_SIGNAL
+};
+
+static guint _signals[LAST_SIGNAL] = { 0 };
+
 static gboolean nle_source_prepare (NleObject * object);
 static gboolean nle_source_send_event (GstElement * element, GstEvent * event);
 static gboolean nle_source_add_element (GstBin * bin, GstElement * element);
@@ -109,6 +117,18 @@ nle_source_class_init (NleSourceClass * klass)
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&nle_source_src_template));
 
+  /**
+   * NleSource::populate
+   * @source: a #NleSource
+   *
+   * Emitted when @source is about to be prepared for playback but does
+   * not control any element yet. Handlers can add the element to control
+   * to @source at that point, which allows applications to only build
+   * the (potentially expensive) element graph once it is actually needed.
+   */
+  _signals[POPULATE_SIGNAL] =
+      g_signal_new ("populate", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST,
+      0, NULL, NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 0);
 }
 
 
@@ -214,8 +234,8 @@ element_pad_removed_cb (GstElement * element G_GNUC_UNUSED, GstPad * pad,
 
     GST_DEBUG_OBJECT (source, "Clearing up ghostpad");
 
-    nle_object_ghost_pad_set_target (NLE_OBJECT (source), nleobject->srcpad,
-        NULL);
+    nle_object_ghost_pad_set_target (NLE_OBJECT (source),
+        NLE_OBJECT_SRC (source), NULL);
     priv->ghostedpad = NULL;
   } else {
     GST_DEBUG_OBJECT (source, "The removed pad is NOT our controlled pad");
@@ -364,7 +384,6 @@ static gboolean
 nle_source_remove_element (GstBin * bin, GstElement * element)
 {
   NleSource *source = (NleSource *) bin;
-  NleObject *nleobject = (NleObject *) element;
   NleSourcePrivate *priv = source->priv;
   gboolean pret;
 
@@ -391,6 +410,11 @@ nle_source_remove_element (GstBin * bin, GstElement * element)
       priv->padaddedid = 0;
     }
 
+    if (priv->staticpad) {
+      gst_object_unref (priv->staticpad);
+      priv->staticpad = NULL;
+    }
+
     priv->dynamicpads = FALSE;
     gst_object_unref (element);
     source->element = NULL;
@@ -468,6 +492,9 @@ nle_source_prepare (NleObject * object)
   GstElement *parent =
       (GstElement *) gst_element_get_parent ((GstElement *) object);
 
+  if (!source->element)
+    g_signal_emit (source, _signals[POPULATE_SIGNAL], 0);
+
   if (!source->element) {
     GST_WARNING_OBJECT (source,
         "NleSource doesn't have an element to control !");
@@ -0,0 +1,86 @@
+#include <gst/gst.h>
+#include <ges.h>
+
+/* Mixes 2, 8 and 64 audio layers, plus a silent background like the one
+ * of timelines, through smartaudiomixer in the timeline's internal format,
+ * and prints how much faster than realtime that goes. A second run mutes
+ * all layers to show what skipping them saves. Each run is made again with
+ * a background that isn't flagged as a gap, audiotestsrc at volume 0, to
+ * show what skipping the background saves.
+ *
+ * Usage: bench_audio_mixing [seconds]
+ */
+
+#define CAPS "audio/x-raw,format=F32LE,layout=interleaved,rate=48000,channels=2"
+
+#define GAP_BACKGROUND "backgroundsrc"
+#define SILENT_BACKGROUND "audiotestsrc samplesperbuffer=1024 volume=0"
+
+static gdouble
+_run (guint n_layers, guint seconds, const gchar * volume,
+    const gchar * background)
+{
+  GString *description = g_string_new (NULL);
+  GstElement *pipeline;
+  GstBus *bus;
+  GstMessage *message;
+  gint64 start_time;
+  guint i, n_buffers = seconds * 48000 / 1024;
+
+  g_string_append_printf (description, "smartaudiomixer name=mixer caps=\"%s\" ! "
+      "fakesink sync=false ", CAPS);
+  g_string_append_printf (description, "%s num-buffers=%u ! %s ! "
+      "samplecontroller volume=0 ! mixer. ", background, n_buffers, CAPS);
+
+  for (i = 0; i < n_layers; i++)
+    g_string_append_printf (description, "audiotestsrc num-buffers=%u "
+        "samplesperbuffer=1024 freq=%u ! %s ! samplecontroller volume=%s "
+        "zorder=%u ! mixer. ", n_buffers, 220 + i * 10, CAPS, volume, i + 1);
+
+  pipeline = gst_parse_launch (description->str, NULL);
+  g_string_free (description, TRUE);
+
+  bus = gst_element_get_bus (pipeline);
+  start_time = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  start_time = g_get_monotonic_time () - start_time;
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    g_printerr ("pipeline errored out\n");
+
+  gst_message_unref (message);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  return start_time / (gdouble) G_USEC_PER_SEC;
+}
+
+int main (int ac, char **av)
+{
+  static const guint n_layers[] = { 0, 2, 8, 64 };
+  static const gchar *backgrounds[] = { GAP_BACKGROUND, SILENT_BACKGROUND };
+  guint seconds, i, j;
+  gdouble audible, muted;
+
+  gst_init (NULL, NULL);
+  ges_init ();
+
+  seconds = ac > 1 ? g_ascii_strtoull (av[1], NULL, 10) : 60;
+
+  for (i = 0; i < G_N_ELEMENTS (n_layers); i++) {
+    for (j = 0; j < G_N_ELEMENTS (backgrounds); j++) {
+      audible = _run (n_layers[i], seconds, "0.5", backgrounds[j]);
+      muted = _run (n_layers[i], seconds, "0", backgrounds[j]);
+
+      g_print ("%u layers, %s background: %.3fs (%.0fx realtime), "
+          "muted: %.3fs (%.0fx realtime)\n", n_layers[i],
+          j ? "silent" : "gap", audible, seconds / audible, muted,
+          seconds / muted);
+    }
+  }
+
+  return 0;
+}
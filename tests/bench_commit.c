@@ -0,0 +1,101 @@
+#include <gst/gst.h>
+#include <ges.h>
+
+/* Plays a timeline and measures, for a series of edits, the time between
+ * requesting a commit with ges_timeline_commit_async and the compositions
+ * outputting data that reflects it. Each edit requests several commits in
+ * a row to show them getting coalesced.
+ *
+ * Usage: bench_commit [n_edits] [n_requests_per_edit]
+ */
+
+typedef struct
+{
+  GESTimeline *timeline;
+  GESObject *moved;
+  GMainLoop *loop;
+  guint n_edits;
+  guint n_requests;
+  guint edit;
+  guint pending_callbacks;
+  GstClockTime total_latency;
+} BenchData;
+
+static gboolean _edit (BenchData *data);
+
+static void
+_committed_cb (GESTimeline *timeline, GAsyncResult *result, BenchData *data)
+{
+  ges_timeline_commit_finish (timeline, result, NULL);
+
+  if (--data->pending_callbacks)
+    return;
+
+  g_print ("edit %u: %u requests, applied after %" GST_TIME_FORMAT "\n", data->edit,
+      data->n_requests, GST_TIME_ARGS (ges_timeline_get_last_commit_latency (timeline)));
+  data->total_latency += ges_timeline_get_last_commit_latency (timeline);
+
+  if (++data->edit == data->n_edits) {
+    g_main_loop_quit (data->loop);
+    return;
+  }
+
+  g_timeout_add (200, (GSourceFunc) _edit, data);
+}
+
+static gboolean
+_edit (BenchData *data)
+{
+  guint i;
+
+  for (i = 0; i < data->n_requests; i++) {
+    ges_object_set_start (data->moved, (data->edit % 2 ? 1 : 3) * GST_SECOND + i * GST_MSECOND);
+    data->pending_callbacks += 1;
+    ges_timeline_commit_async (data->timeline, NULL, (GAsyncReadyCallback) _committed_cb, data);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+int main (int ac, char **av)
+{
+  BenchData data = { 0, };
+  GstPlayer *player;
+  guint i;
+
+  gst_init (NULL, NULL);
+  ges_init ();
+
+  data.n_edits = ac > 1 ? g_ascii_strtoull (av[1], NULL, 10) : 20;
+  data.n_requests = ac > 2 ? g_ascii_strtoull (av[2], NULL, 10) : 5;
+  data.loop = g_main_loop_new (NULL, FALSE);
+  data.timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+
+  for (i = 0; i < 4; i++) {
+    GESSource *source = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+
+    ges_object_set_start (GES_OBJECT (source), i * 2 * GST_SECOND);
+    ges_object_set_duration (GES_OBJECT (source), 60 * GST_SECOND);
+    ges_object_set_video_track_index (GES_OBJECT (source), i);
+    ges_timeline_add_object (data.timeline, GES_OBJECT (source));
+    data.moved = GES_OBJECT (source);
+  }
+  ges_timeline_commit (data.timeline);
+
+  player = ges_playable_make_player (GES_PLAYABLE (data.timeline));
+  gst_player_play (player);
+
+  g_timeout_add_seconds (1, (GSourceFunc) _edit, &data);
+  g_main_loop_run (data.loop);
+
+  if (data.n_edits)
+    g_print ("average commit to output latency: %" GST_TIME_FORMAT "\n",
+        GST_TIME_ARGS (data.total_latency / data.n_edits));
+
+  gst_player_stop (player);
+  g_object_unref (player);
+  g_object_unref (data.timeline);
+  g_main_loop_unref (data.loop);
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include <gst/gst.h>
+#include <ges.h>
+
+/* Mixes a stack of 16 full-frame layers through smartvideomixer, with the
+ * top layer opaque so that the ones below it can be culled, then with all
+ * of them translucent so that everything has to be blended, and prints
+ * how long each took.
+ *
+ * Then mixes a single opaque layer, which gets output as it is, and the
+ * same layer moved by one pixel, which the compositor has to copy. The
+ * compositor still allocates and fills the background of the frame it
+ * outputs in both cases, so the difference is only what bypassing saves.
+ * Those layers come from backgroundsrc, which doesn't draw its frames.
+ *
+ * Usage: bench_mixer_culling [n_frames] [width] [height]
+ */
+
+#define N_LAYERS 16
+
+static gdouble
+_run_pipeline (const gchar * description)
+{
+  GstElement *pipeline;
+  GstBus *bus;
+  GstMessage *message;
+  gint64 start_time;
+
+  pipeline = gst_parse_launch (description, NULL);
+
+  bus = gst_element_get_bus (pipeline);
+  start_time = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  start_time = g_get_monotonic_time () - start_time;
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    g_printerr ("pipeline errored out\n");
+
+  gst_message_unref (message);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  return start_time / (gdouble) G_USEC_PER_SEC;
+}
+
+static gdouble
+_run (guint n_frames, gint width, gint height, const gchar * alpha)
+{
+  GString *description = g_string_new (NULL);
+  gdouble res;
+  gchar *caps;
+  guint i;
+
+  caps = g_strdup_printf ("video/x-raw,format=I420,width=%d,height=%d,framerate=30/1",
+      width, height);
+  g_string_append_printf (description, "smartvideomixer name=mixer caps=\"%s\" ! %s ! "
+      "fakesink sync=false ", caps, caps);
+
+  for (i = 0; i < N_LAYERS; i++) {
+    g_string_append_printf (description, "videotestsrc num-buffers=%u pattern=%u ! "
+        "%s ! framepositioner zorder=%u alpha=%s ! mixer. ", n_frames, i % 10,
+        caps, i + 1, i == N_LAYERS - 1 ? "1.0" : alpha);
+  }
+
+  res = _run_pipeline (description->str);
+  g_string_free (description, TRUE);
+  g_free (caps);
+
+  return res;
+}
+
+static gdouble
+_run_lone_layer (guint n_frames, gint width, gint height, gint posx)
+{
+  gchar *caps, *description;
+  gdouble res;
+
+  caps = g_strdup_printf ("video/x-raw,format=I420,width=%d,height=%d,framerate=30/1",
+      width, height);
+  description = g_strdup_printf ("smartvideomixer name=mixer caps=\"%s\" ! %s ! "
+      "fakesink sync=false backgroundsrc num-buffers=%u ! %s ! "
+      "framepositioner zorder=1 posx=%d ! mixer. ", caps, caps, n_frames, caps,
+      posx);
+
+  res = _run_pipeline (description);
+  g_free (description);
+  g_free (caps);
+
+  return res;
+}
+
+int main (int ac, char **av)
+{
+  guint n_frames;
+  gint width, height;
+  gdouble occluded, translucent, bypassed, blended;
+
+  gst_init (NULL, NULL);
+  ges_init ();
+
+  n_frames = ac > 1 ? g_ascii_strtoull (av[1], NULL, 10) : 300;
+  width = ac > 2 ? g_ascii_strtoll (av[2], NULL, 10) : 1920;
+  height = ac > 3 ? g_ascii_strtoll (av[3], NULL, 10) : 1080;
+
+  /* Everything below the top layer is hidden by it */
+  occluded = _run (n_frames, width, height, "1.0");
+  /* Everything shows through */
+  translucent = _run (n_frames, width, height, "0.5");
+  /* Output as it is */
+  bypassed = _run_lone_layer (n_frames, width, height, 0);
+  /* Copied by the compositor */
+  blended = _run_lone_layer (n_frames, width, height, 1);
+
+  g_print ("%d layers, %u frames of %dx%d\n", N_LAYERS, n_frames, width, height);
+  g_print ("opaque top layer: %.3fs (%.1f fps)\n", occluded, n_frames / occluded);
+  g_print ("translucent layers: %.3fs (%.1f fps)\n", translucent, n_frames / translucent);
+  g_print ("lone layer bypassed: %.3fs (%.1f fps), blended: %.3fs (%.1f fps)\n",
+      bypassed, n_frames / bypassed, blended, n_frames / blended);
+
+  return 0;
+}
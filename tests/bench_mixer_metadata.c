@@ -0,0 +1,69 @@
+#include <gst/gst.h>
+#include <ges.h>
+
+/* Pushes tiny buffers through the smart mixers so that the per-buffer
+ * costs, metadata parsing included, dominate, and prints the average time
+ * spent per buffer and per layer.
+ *
+ * Usage: bench_mixer_metadata [n_buffers] [n_layers]
+ */
+
+static gdouble
+_run (const gchar * branch, guint n_buffers, guint n_layers,
+    const gchar * mixer)
+{
+  GString *description = g_string_new (NULL);
+  GstElement *pipeline;
+  GstBus *bus;
+  GstMessage *message;
+  gint64 start_time;
+  guint i;
+
+  g_string_append_printf (description, "%s name=mixer ! fakesink sync=false ",
+      mixer);
+  for (i = 0; i < n_layers; i++)
+    g_string_append_printf (description, branch, n_buffers, i + 1);
+
+  pipeline = gst_parse_launch (description->str, NULL);
+  g_string_free (description, TRUE);
+
+  bus = gst_element_get_bus (pipeline);
+  start_time = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  start_time = g_get_monotonic_time () - start_time;
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    g_printerr ("pipeline errored out\n");
+
+  gst_message_unref (message);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  return start_time * 1000.0 / (n_buffers * n_layers);
+}
+
+int main (int ac, char **av)
+{
+  guint n_buffers, n_layers;
+
+  gst_init (NULL, NULL);
+  ges_init ();
+
+  n_buffers = ac > 1 ? g_ascii_strtoull (av[1], NULL, 10) : 20000;
+  n_layers = ac > 2 ? g_ascii_strtoull (av[2], NULL, 10) : 4;
+
+  g_print ("%u layers, %u buffers each\n", n_layers, n_buffers);
+  g_print ("video: %.0f ns per buffer\n", _run ("videotestsrc num-buffers=%u ! "
+          "video/x-raw,format=AYUV,width=16,height=16,framerate=1000/1 ! "
+          "framepositioner zorder=%u ! mixer. ", n_buffers, n_layers,
+          "smartvideomixer"));
+  g_print ("audio: %.0f ns per buffer\n", _run ("audiotestsrc num-buffers=%u "
+          "samplesperbuffer=16 ! audio/x-raw,format=F32LE,rate=44100,channels=1 ! "
+          "samplecontroller zorder=%u ! mixer. ", n_buffers, n_layers,
+          "smartaudiomixer"));
+
+  return 0;
+}
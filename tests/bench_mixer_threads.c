@@ -0,0 +1,120 @@
+#include <gst/gst.h>
+#include <ges.h>
+
+/* Blends a dozen translucent 4K layers through smartvideomixer with one
+ * blending thread, then with one per processor, and prints the speedup.
+ * The layers come from backgroundsrc, which doesn't draw its frames, so
+ * that blending is what gets measured.
+ *
+ * With more than one thread, one more compositor stitches the stripes
+ * together, which costs a background fill and a copy of each output
+ * frame. The same stitching is then run on its own, with opaque stripes,
+ * to print that cost.
+ *
+ * Usage: bench_mixer_threads [n_frames] [n_layers] [n_threads]
+ */
+
+#define CAPS "video/x-raw,format=AYUV,width=3840,height=2160,framerate=30/1"
+#define STRIPE_CAPS "video/x-raw,format=AYUV,width=3840,height=%u,framerate=30/1"
+#define HEIGHT 2160
+
+static gdouble
+_run_pipeline (const gchar * description)
+{
+  GstElement *pipeline;
+  GstBus *bus;
+  GstMessage *message;
+  gint64 start_time;
+
+  pipeline = gst_parse_launch (description, NULL);
+
+  bus = gst_element_get_bus (pipeline);
+  start_time = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  start_time = g_get_monotonic_time () - start_time;
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    g_printerr ("pipeline errored out\n");
+
+  gst_message_unref (message);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  return start_time / (gdouble) G_USEC_PER_SEC;
+}
+
+static gdouble
+_run (guint n_frames, guint n_layers, guint n_threads)
+{
+  GString *description = g_string_new (NULL);
+  gdouble res;
+  guint i;
+
+  g_string_append_printf (description, "smartvideomixer name=mixer threads=%u "
+      "caps=\"%s\" ! fakesink sync=false ", n_threads, CAPS);
+
+  for (i = 0; i < n_layers; i++)
+    g_string_append_printf (description, "backgroundsrc num-buffers=%u ! %s ! "
+        "framepositioner zorder=%u alpha=0.5 ! mixer. ", n_frames, CAPS, i + 1);
+
+  res = _run_pipeline (description->str);
+  g_string_free (description, TRUE);
+
+  return res;
+}
+
+/* What the outer compositor of smartvideomixer does with @n_threads
+ * stripes */
+static gdouble
+_run_stitching (guint n_frames, guint n_threads)
+{
+  GString *description = g_string_new (NULL);
+  guint height = GST_ROUND_UP_16 ((HEIGHT + n_threads - 1) / n_threads);
+  gdouble res;
+  guint i, y;
+
+  g_string_append (description, "compositor name=mixer background=1 ");
+  for (i = 0, y = 0; y < HEIGHT; i++, y += height)
+    g_string_append_printf (description, "sink_%u::ypos=%u ", i, y);
+  g_string_append_printf (description, "! %s ! fakesink sync=false ", CAPS);
+
+  for (i = 0, y = 0; y < HEIGHT; i++, y += height) {
+    g_string_append_printf (description, "backgroundsrc num-buffers=%u ! "
+        STRIPE_CAPS " ! mixer.sink_%u ", n_frames, MIN (height, HEIGHT - y), i);
+  }
+
+  res = _run_pipeline (description->str);
+  g_string_free (description, TRUE);
+
+  return res;
+}
+
+int main (int ac, char **av)
+{
+  guint n_frames, n_layers, n_threads;
+  gdouble single, threaded, stitching;
+
+  gst_init (NULL, NULL);
+  ges_init ();
+
+  n_frames = ac > 1 ? g_ascii_strtoull (av[1], NULL, 10) : 60;
+  n_layers = ac > 2 ? g_ascii_strtoull (av[2], NULL, 10) : 12;
+  n_threads = ac > 3 ? g_ascii_strtoull (av[3], NULL, 10) : g_get_num_processors ();
+
+  single = _run (n_frames, n_layers, 1);
+  threaded = _run (n_frames, n_layers, n_threads);
+  stitching = n_threads > 1 ? _run_stitching (n_frames, n_threads) : 0;
+
+  g_print ("%u layers, %u 4K frames\n", n_layers, n_frames);
+  g_print ("1 thread: %.3fs (%.1f fps)\n", single, n_frames / single);
+  g_print ("%u threads: %.3fs (%.1f fps)\n", n_threads, threaded, n_frames / threaded);
+  g_print ("speedup: %.2fx\n", single / threaded);
+  if (n_threads > 1)
+    g_print ("stitching for %u threads: %.3fs (%.2fms per frame)\n", n_threads,
+        stitching, stitching * 1000 / n_frames);
+
+  return 0;
+}
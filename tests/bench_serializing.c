@@ -0,0 +1,150 @@
+#include <sys/resource.h>
+#include <gst/gst.h>
+#include <ges.h>
+
+/* Compares loading a project saved as one serialized variant per object
+ * with loading it from a single file written by ges_timeline_save_to_file.
+ *
+ * Projects are saved and loaded in separate runs so that the peak RSS
+ * reported for loading isn't polluted by the saving:
+ *
+ * Usage: bench_serializing save [n_objects]
+ *        bench_serializing load-objects
+ *        bench_serializing load-project
+ */
+
+#define OBJECTS_FILE "ges-bench-objects"
+#define PROJECT_FILE "ges-bench-project"
+
+static glong
+_get_peak_rss (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+static GESTimeline *
+_make_timeline (guint n_objects)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO | GES_MEDIA_TYPE_AUDIO);
+  guint i;
+
+  for (i = 0; i < n_objects; i++) {
+    GESSource *source = ges_test_source_new (i % 2 ? GES_MEDIA_TYPE_AUDIO : GES_MEDIA_TYPE_VIDEO, NULL);
+
+    ges_object_set_start (GES_OBJECT (source), (i / 2) * GST_SECOND);
+    ges_object_set_duration (GES_OBJECT (source), GST_SECOND);
+    ges_timeline_add_object (timeline, GES_OBJECT (source));
+  }
+
+  return timeline;
+}
+
+/* What applications had to do before, one variant per object */
+static void
+_save_objects (const gchar *path, guint n_objects)
+{
+  GVariantBuilder builder;
+  GVariant *variant;
+  guint i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("av"));
+  for (i = 0; i < n_objects; i++) {
+    GESSource *source = ges_test_source_new (i % 2 ? GES_MEDIA_TYPE_AUDIO : GES_MEDIA_TYPE_VIDEO, NULL);
+
+    ges_object_set_start (GES_OBJECT (source), (i / 2) * GST_SECOND);
+    ges_object_set_duration (GES_OBJECT (source), GST_SECOND);
+    g_variant_builder_add_value (&builder, ges_object_serialize (GES_OBJECT (source)));
+    g_object_unref (g_object_ref_sink (source));
+  }
+
+  variant = g_variant_ref_sink (g_variant_builder_end (&builder));
+  g_file_set_contents (path, g_variant_get_data (variant), g_variant_get_size (variant), NULL);
+  g_variant_unref (variant);
+}
+
+static GESTimeline *
+_load_objects (const gchar *path)
+{
+  GESTimeline *timeline;
+  GVariant *variant;
+  gchar *contents;
+  gsize length, i;
+
+  if (!g_file_get_contents (path, &contents, &length, NULL))
+    return NULL;
+
+  timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO | GES_MEDIA_TYPE_AUDIO);
+  variant = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE ("av"),
+        contents, length, FALSE, g_free, contents));
+
+  for (i = 0; i < g_variant_n_children (variant); i++) {
+    GVariant *child = g_variant_get_child_value (variant, i);
+
+    ges_timeline_add_object (timeline, ges_object_deserialize (child));
+    g_variant_unref (child);
+  }
+
+  g_variant_unref (variant);
+
+  return timeline;
+}
+
+int main (int ac, char **av)
+{
+  GESTimeline *timeline;
+  guint n_objects = 10000;
+  gchar *objects_path, *project_path;
+  gint64 start_time, load_time;
+  glong baseline_rss;
+
+  gst_init (NULL, NULL);
+  ges_init ();
+
+  if (ac < 2) {
+    g_printerr ("Usage: %s save [n_objects] | load-objects | load-project\n", av[0]);
+    return 1;
+  }
+
+  objects_path = g_build_filename (g_get_tmp_dir (), OBJECTS_FILE, NULL);
+  project_path = g_build_filename (g_get_tmp_dir (), PROJECT_FILE, NULL);
+
+  if (!g_strcmp0 (av[1], "save")) {
+    if (ac > 2)
+      n_objects = g_ascii_strtoull (av[2], NULL, 10);
+
+    _save_objects (objects_path, n_objects);
+    timeline = _make_timeline (n_objects);
+    ges_timeline_save_to_file (timeline, project_path, NULL);
+    g_object_unref (timeline);
+    goto done;
+  }
+
+  baseline_rss = _get_peak_rss ();
+  start_time = g_get_monotonic_time ();
+
+  if (!g_strcmp0 (av[1], "load-objects"))
+    timeline = _load_objects (objects_path);
+  else
+    timeline = ges_timeline_load_from_file (project_path, NULL);
+
+  load_time = g_get_monotonic_time () - start_time;
+
+  if (!timeline) {
+    g_printerr ("Nothing to load, run %s save first\n", av[0]);
+    goto done;
+  }
+
+  g_print ("%s: loaded in %" GST_TIME_FORMAT ", peak RSS %ld kB (%ld kB before loading)\n",
+      av[1], GST_TIME_ARGS (load_time * GST_USECOND), _get_peak_rss (), baseline_rss);
+
+  g_object_unref (timeline);
+
+done:
+  g_free (objects_path);
+  g_free (project_path);
+
+  return 0;
+}
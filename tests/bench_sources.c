@@ -0,0 +1,84 @@
+#include <gst/gst.h>
+#include <ges.h>
+
+/* Measures how long it takes to build a timeline with a large number of
+ * sources, and how many elements end up being instantiated for it.
+ *
+ * Usage: bench_sources [n_sources]
+ */
+
+static guint
+_count_elements (GESTimeline *timeline)
+{
+  GList *compositions = ges_timeline_get_compositions_by_media_type (timeline, GES_MEDIA_TYPE_UNKNOWN);
+  GList *tmp;
+  guint count = 0;
+
+  for (tmp = compositions; tmp; tmp = tmp->next) {
+    GstIterator *it = gst_bin_iterate_recurse (GST_BIN (tmp->data));
+    GValue item = G_VALUE_INIT;
+
+    while (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+      count += 1;
+      g_value_reset (&item);
+    }
+
+    g_value_unset (&item);
+    gst_iterator_free (it);
+  }
+
+  g_list_free (compositions);
+
+  return count;
+}
+
+int main (int ac, char **av)
+{
+  GESTimeline *timeline;
+  guint n_sources = 1000;
+  guint i;
+  gint64 start_time, add_time, lookup_time;
+
+  gst_init (NULL, NULL);
+  ges_init ();
+
+  if (ac > 1)
+    n_sources = g_ascii_strtoull (av[1], NULL, 10);
+
+  timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO | GES_MEDIA_TYPE_AUDIO);
+
+  start_time = g_get_monotonic_time ();
+  for (i = 0; i < n_sources; i++) {
+    GESMediaType media_type = i % 2 ? GES_MEDIA_TYPE_AUDIO : GES_MEDIA_TYPE_VIDEO;
+    GESSource *source = ges_test_source_new (media_type, NULL);
+
+    ges_object_set_start (GES_OBJECT (source), (i / 2) * GST_SECOND);
+    ges_object_set_duration (GES_OBJECT (source), GST_SECOND);
+    ges_timeline_add_object (timeline, GES_OBJECT (source));
+  }
+  ges_timeline_commit (timeline);
+  add_time = g_get_monotonic_time () - start_time;
+
+  g_print ("%u sources added and committed in %" GST_TIME_FORMAT ", %u elements\n",
+      n_sources, GST_TIME_ARGS (add_time * GST_USECOND), _count_elements (timeline));
+
+  /* Looking up a child forces the elements of a source to be built */
+  start_time = g_get_monotonic_time ();
+  for (i = 0; i < n_sources; i++) {
+    GESSource *source = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+    GObject *child;
+    GParamSpec *pspec;
+
+    ges_timeline_add_object (timeline, GES_OBJECT (source));
+    if (gst_child_proxy_lookup (GST_CHILD_PROXY (source), "framepositioner::alpha", &child, &pspec))
+      g_object_unref (child);
+  }
+  lookup_time = g_get_monotonic_time () - start_time;
+
+  g_print ("%u sources added and populated in %" GST_TIME_FORMAT ", %u elements\n",
+      n_sources, GST_TIME_ARGS (lookup_time * GST_USECOND), _count_elements (timeline));
+
+  g_object_unref (timeline);
+
+  return 0;
+}
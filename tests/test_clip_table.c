@@ -0,0 +1,117 @@
+#include <ges.h>
+#include <gst/check/gstcheck.h>
+
+#include "test-utils.h"
+
+#define TEST_URI "file:///home/meh/Videos/homeland.mp4"
+#define OTHER_TEST_URI "file:///home/meh/Videos/big_buck_bunny.mp4"
+
+GST_START_TEST (test_clip_table_rows)
+{
+  GESClipTable *table = ges_clip_table_new ();
+  GArray *indexes;
+  guint i;
+
+  for (i = 0; i < 1000; i++) {
+    fail_unless_equals_int (ges_clip_table_add_clip (table, i % 2 ? TEST_URI : OTHER_TEST_URI,
+          GES_MEDIA_TYPE_VIDEO, i * GST_SECOND, GST_SECOND, 0, i % 3), i);
+  }
+
+  fail_unless_equals_int (ges_clip_table_get_n_clips (table), 1000);
+  fail_unless_equals_uint64 (ges_clip_table_get_start (table, 42), 42 * GST_SECOND);
+  fail_unless_equals_uint64 (ges_clip_table_get_duration (table, 42), GST_SECOND);
+  fail_unless_equals_int (ges_clip_table_get_track_index (table, 42), 0);
+
+  /* Clips using the same media share their asset id */
+  fail_unless_equals_int (ges_clip_table_get_asset_id (table, 1), ges_clip_table_get_asset_id (table, 3));
+  fail_if (ges_clip_table_get_asset_id (table, 1) == ges_clip_table_get_asset_id (table, 2));
+  fail_unless_equals_string (ges_clip_table_get_asset_uri (table, ges_clip_table_get_asset_id (table, 1)), TEST_URI);
+
+  fail_unless (ges_clip_table_set_start (table, 500, 10 * GST_SECOND + GST_SECOND / 2));
+
+  indexes = ges_clip_table_find_clips (table, 10 * GST_SECOND, 11 * GST_SECOND);
+  fail_unless_equals_int (indexes->len, 2);
+  fail_unless_equals_int (g_array_index (indexes, guint, 0), 10);
+  fail_unless_equals_int (g_array_index (indexes, guint, 1), 500);
+  g_array_unref (indexes);
+
+  /* Nothing was materialized */
+  for (i = 0; i < 1000; i++)
+    fail_if (ges_clip_table_is_materialized (table, i));
+
+  g_object_unref (table);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_clip_table_materialize)
+{
+  GESClipTable *table = ges_clip_table_new ();
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  GESObject *object;
+  guint index;
+
+  ges_clip_table_add_clip (table, TEST_URI, GES_MEDIA_TYPE_VIDEO, 0, GST_SECOND, 0, 0);
+  index = ges_clip_table_add_clip (table, TEST_URI, GES_MEDIA_TYPE_VIDEO,
+      5 * GST_SECOND, GST_SECOND, 2 * GST_SECOND, 1);
+
+  object = ges_clip_table_get_object (table, index);
+  fail_unless (object != NULL);
+  fail_unless (ges_clip_table_is_materialized (table, index));
+  fail_unless_equals_uint64 (ges_object_get_start (object), 5 * GST_SECOND);
+  fail_unless_equals_uint64 (ges_object_get_inpoint (object), 2 * GST_SECOND);
+  fail_unless_equals_int (ges_object_get_video_track_index (object), 1);
+
+  /* The same wrapper is returned while it is materialized */
+  fail_unless (ges_clip_table_get_object (table, index) == object);
+  g_object_unref (object);
+
+  /* Changes to the wrapper are reflected by the table, and kept on release */
+  ges_object_set_start (object, 7 * GST_SECOND);
+  fail_unless_equals_uint64 (ges_clip_table_get_start (table, index), 7 * GST_SECOND);
+  ges_clip_table_release_object (table, index);
+  g_object_unref (object);
+  fail_if (ges_clip_table_is_materialized (table, index));
+  fail_unless_equals_uint64 (ges_clip_table_get_start (table, index), 7 * GST_SECOND);
+
+  /* Only the clips in range get added to the timeline, and only once */
+  fail_unless_equals_int (ges_clip_table_add_to_timeline (table, timeline, 0, 2 * GST_SECOND), 1);
+  fail_unless_equals_int (ges_clip_table_add_to_timeline (table, timeline, 0, 2 * GST_SECOND), 0);
+  fail_unless (ges_clip_table_is_materialized (table, 0));
+  fail_if (ges_clip_table_is_materialized (table, index));
+
+  /* Can't be released while in the timeline */
+  ges_clip_table_release_object (table, 0);
+  fail_unless (ges_clip_table_is_materialized (table, 0));
+
+  /* Once the timeline is gone, the clips can be added to another one */
+  g_object_unref (timeline);
+  timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  fail_unless_equals_int (ges_clip_table_add_to_timeline (table, timeline, 0, 2 * GST_SECOND), 1);
+  g_object_unref (timeline);
+
+  /* Or released */
+  ges_clip_table_release_object (table, 0);
+  fail_if (ges_clip_table_is_materialized (table, 0));
+
+  g_object_unref (table);
+}
+
+GST_END_TEST
+
+static Suite *
+ges_suite (void)
+{
+  Suite *s = suite_create ("ges");
+  TCase *tc_chain = tcase_create ("a");
+
+  suite_add_tcase (s, tc_chain);
+  ges_init ();
+
+  tcase_add_test (tc_chain, test_clip_table_rows);
+  tcase_add_test (tc_chain, test_clip_table_materialize);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ges);
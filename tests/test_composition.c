@@ -0,0 +1,232 @@
+#include <ges.h>
+#include <gst/check/gstcheck.h>
+
+#include "nle.h"
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint commited_serial;
+} CommitWaiter;
+
+static void
+_commited_cb (GstElement *composition, gboolean changed, CommitWaiter *waiter)
+{
+  g_mutex_lock (&waiter->lock);
+  waiter->commited_serial = nle_composition_get_commited_serial (NLE_COMPOSITION (composition));
+  g_cond_signal (&waiter->cond);
+  g_mutex_unlock (&waiter->lock);
+}
+
+/* Commits are processed by the composition task, wait for the new index
+ * to be published */
+static void
+_commit_and_wait (GstElement *composition, CommitWaiter *waiter)
+{
+  guint serial = nle_composition_commit (NLE_COMPOSITION (composition));
+
+  g_mutex_lock (&waiter->lock);
+  while (waiter->commited_serial < serial)
+    g_cond_wait (&waiter->cond, &waiter->lock);
+  g_mutex_unlock (&waiter->lock);
+}
+
+static GstElement *
+_make_source (GstClockTime start, GstClockTime duration, guint priority)
+{
+  GstElement *source = gst_element_factory_make ("nlesource", NULL);
+
+  g_object_set (source, "start", start, "duration", duration,
+      "priority", priority, NULL);
+  gst_bin_add (GST_BIN (source), gst_element_factory_make ("videotestsrc", NULL));
+
+  return source;
+}
+
+static GstElement *
+_make_pipeline (GstElement *composition, GstElement *sink)
+{
+  GstElement *pipeline = gst_pipeline_new (NULL);
+  GstCaps *caps =
+      gst_caps_from_string ("video/x-raw,format=I420,width=16,height=16,framerate=10/1");
+
+  g_object_set (composition, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  gst_bin_add_many (GST_BIN (pipeline), composition, sink, NULL);
+  fail_unless (gst_element_link (composition, sink));
+
+  return pipeline;
+}
+
+static GstClockTime
+_get_stop (GstElement *composition)
+{
+  GstClockTime stop;
+
+  g_object_get (composition, "stop", &stop, NULL);
+
+  return stop;
+}
+
+GST_START_TEST (test_composition_commit_playing)
+{
+  CommitWaiter waiter = { 0, };
+  GstElement *composition = gst_element_factory_make ("nlecomposition", NULL);
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstElement *pipeline = _make_pipeline (composition, sink);
+  GstElement *source_a, *source_b;
+
+  g_mutex_init (&waiter.lock);
+  g_cond_init (&waiter.cond);
+  g_signal_connect (composition, "commited", G_CALLBACK (_commited_cb), &waiter);
+  g_object_set (sink, "sync", TRUE, NULL);
+
+  source_a = _make_source (0, 10 * GST_SECOND, 1);
+  gst_bin_add (GST_BIN (composition), source_a);
+  nle_object_commit (NLE_OBJECT (composition), TRUE);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_uint64 (_get_stop (composition), 10 * GST_SECOND);
+
+  /* Added */
+  source_b = _make_source (5 * GST_SECOND, 15 * GST_SECOND, 2);
+  gst_bin_add (GST_BIN (composition), source_b);
+  _commit_and_wait (composition, &waiter);
+  fail_unless_equals_uint64 (_get_stop (composition), 20 * GST_SECOND);
+
+  /* Moved, the old entries of source_b must not linger in the index */
+  g_object_set (source_b, "duration", 25 * GST_SECOND, NULL);
+  _commit_and_wait (composition, &waiter);
+  fail_unless_equals_uint64 (_get_stop (composition), 30 * GST_SECOND);
+
+  g_object_set (source_b, "start", 0 * GST_SECOND, NULL);
+  _commit_and_wait (composition, &waiter);
+  fail_unless_equals_uint64 (_get_stop (composition), 25 * GST_SECOND);
+
+  /* Removed */
+  gst_bin_remove (GST_BIN (composition), source_b);
+  _commit_and_wait (composition, &waiter);
+  fail_unless_equals_uint64 (_get_stop (composition), 10 * GST_SECOND);
+
+  /* Each commit is reported with its own serial */
+  fail_unless_equals_int (waiter.commited_serial,
+      nle_composition_get_commit_serial (NLE_COMPOSITION (composition)));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_cond_clear (&waiter.cond);
+  g_mutex_clear (&waiter.lock);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_composition_uncommited_object)
+{
+  CommitWaiter waiter = { 0, };
+  GstElement *composition = gst_element_factory_make ("nlecomposition", NULL);
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstElement *pipeline = _make_pipeline (composition, sink);
+  GstElement *source_c;
+
+  g_mutex_init (&waiter.lock);
+  g_cond_init (&waiter.cond);
+  g_signal_connect (composition, "commited", G_CALLBACK (_commited_cb), &waiter);
+
+  gst_bin_add (GST_BIN (composition), _make_source (0, 10 * GST_SECOND, 1));
+  nle_object_commit (NLE_OBJECT (composition), TRUE);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+
+  /* Not part of the stack until it gets commited, even when the stack is
+   * rebuilt by a seek */
+  source_c = _make_source (0, 40 * GST_SECOND, 0);
+  gst_bin_add (GST_BIN (composition), source_c);
+
+  fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, 2 * GST_SECOND));
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_uint64 (_get_stop (composition), 10 * GST_SECOND);
+
+  _commit_and_wait (composition, &waiter);
+  fail_unless_equals_uint64 (_get_stop (composition), 40 * GST_SECOND);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_cond_clear (&waiter.cond);
+  g_mutex_clear (&waiter.lock);
+}
+
+GST_END_TEST
+
+static void
+_handoff_cb (GstElement *sink, GstBuffer *buffer, GstPad *pad, GList **timestamps)
+{
+  *timestamps = g_list_append (*timestamps, GUINT_TO_POINTER (GST_BUFFER_PTS (buffer) / GST_MSECOND));
+}
+
+GST_START_TEST (test_composition_reverse)
+{
+  GstElement *composition = gst_element_factory_make ("nlecomposition", NULL);
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstElement *pipeline = _make_pipeline (composition, sink);
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *message;
+  GList *timestamps = NULL, *tmp;
+
+  g_object_set (sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (_handoff_cb), &timestamps);
+
+  gst_bin_add (GST_BIN (composition), _make_source (0, GST_SECOND, 1));
+  gst_bin_add (GST_BIN (composition), _make_source (GST_SECOND, GST_SECOND, 1));
+  nle_object_commit (NLE_OBJECT (composition), TRUE);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+
+  /* Stacks are looked up by their stop in the index when playing backward */
+  g_list_free (timestamps);
+  timestamps = NULL;
+  fail_unless (gst_element_seek (pipeline, -1.0, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+        GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, 2 * GST_SECOND));
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  fail_unless (timestamps != NULL);
+  fail_unless (GPOINTER_TO_UINT (timestamps->data) >= 1000);
+  fail_unless (GPOINTER_TO_UINT (g_list_last (timestamps)->data) < 1000);
+  for (tmp = timestamps; tmp->next; tmp = tmp->next)
+    fail_unless (GPOINTER_TO_UINT (tmp->data) > GPOINTER_TO_UINT (tmp->next->data));
+
+  g_list_free (timestamps);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST
+
+static Suite *
+ges_suite (void)
+{
+  Suite *s = suite_create ("ges");
+  TCase *tc_chain = tcase_create ("a");
+
+  suite_add_tcase (s, tc_chain);
+  ges_init ();
+
+  tcase_add_test (tc_chain, test_composition_commit_playing);
+  tcase_add_test (tc_chain, test_composition_uncommited_object);
+  tcase_add_test (tc_chain, test_composition_reverse);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ges);
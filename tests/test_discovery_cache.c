@@ -0,0 +1,250 @@
+#include <glib/gstdio.h>
+#include <ges.h>
+#include <gst/check/gstcheck.h>
+
+#include "test-utils.h"
+
+#define TEST_URI "file:///home/meh/Videos/homeland.mp4"
+
+GST_START_TEST (test_discovery_cache_hit)
+{
+  gchar *directory = g_dir_make_tmp ("ges-discovery-cache-XXXXXX", NULL);
+  GESDiscoveryCache *cache;
+  GESSource *video_source;
+  GESSource *audio_source;
+
+  g_setenv ("GES_DISCOVERY_CACHE_DIR", directory, TRUE);
+  ges_init ();
+
+  cache = ges_discovery_cache_get_default ();
+  ges_discovery_cache_clear (cache);
+  ges_asset_registry_clear ();
+
+  /* First discovery goes through grilo and fills the cache */
+  video_source = ges_uri_source_new (TEST_URI, GES_MEDIA_TYPE_VIDEO);
+  fail_unless_equals_int (ges_discovery_cache_get_misses (cache), 1);
+  fail_unless_equals_int (ges_discovery_cache_get_hits (cache), 0);
+
+  /* Same file, different media type, the asset is rediscovered from the cache */
+  ges_asset_registry_clear ();
+  audio_source = ges_uri_source_new (TEST_URI, GES_MEDIA_TYPE_AUDIO);
+  fail_unless_equals_int (ges_discovery_cache_get_misses (cache), 1);
+  fail_unless_equals_int (ges_discovery_cache_get_hits (cache), 1);
+
+  fail_unless_equals_uint64 (ges_object_get_duration (GES_OBJECT (video_source)),
+      ges_object_get_duration (GES_OBJECT (audio_source)));
+
+  g_object_unref (video_source);
+  g_object_unref (audio_source);
+
+  ges_discovery_cache_clear (cache);
+  g_rmdir (directory);
+  g_free (directory);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_discovery_cache_stale_entry)
+{
+  gchar *directory = g_dir_make_tmp ("ges-discovery-cache-XXXXXX", NULL);
+  gchar *media_path = g_build_filename (directory, "media", NULL);
+  gchar *media_uri = gst_filename_to_uri (media_path, NULL);
+  GESDiscoveryCache *cache = ges_discovery_cache_new (directory);
+  GstDiscovererInfo *info;
+  GstDiscoverer *discoverer;
+  gchar *url = NULL;
+
+  ges_init ();
+
+  fail_unless (g_file_set_contents (media_path, "not a media", -1, NULL));
+
+  /* Nothing cached yet */
+  fail_unless (ges_discovery_cache_lookup (cache, media_uri, &url) == NULL);
+  fail_unless_equals_int (ges_discovery_cache_get_misses (cache), 1);
+
+  discoverer = gst_discoverer_new (5 * GST_SECOND, NULL);
+  info = gst_discoverer_discover_uri (discoverer, TEST_URI, NULL);
+  fail_unless (info != NULL);
+  fail_unless (ges_discovery_cache_store (cache, media_uri, TEST_URI, info));
+  gst_discoverer_info_unref (info);
+
+  info = ges_discovery_cache_lookup (cache, media_uri, &url);
+  fail_unless (info != NULL);
+  fail_unless_equals_string (url, TEST_URI);
+  fail_unless_equals_int (ges_discovery_cache_get_hits (cache), 1);
+  gst_discoverer_info_unref (info);
+  g_free (url);
+
+  /* Changing the size of the file invalidates the entry */
+  fail_unless (g_file_set_contents (media_path, "still not a media", -1, NULL));
+  fail_unless (ges_discovery_cache_lookup (cache, media_uri, NULL) == NULL);
+  fail_unless_equals_int (ges_discovery_cache_get_invalidations (cache), 1);
+  fail_unless_equals_int (ges_discovery_cache_get_misses (cache), 2);
+
+  ges_discovery_cache_clear (cache);
+  g_object_unref (discoverer);
+  g_object_unref (cache);
+  g_unlink (media_path);
+  g_rmdir (directory);
+  g_free (media_uri);
+  g_free (media_path);
+  g_free (directory);
+}
+
+GST_END_TEST
+
+static gpointer
+_request_asset (gpointer unused)
+{
+  return ges_asset_request (TEST_URI);
+}
+
+GST_START_TEST (test_asset_shared)
+{
+  gchar *directory = g_dir_make_tmp ("ges-discovery-cache-XXXXXX", NULL);
+  GESDiscoveryCache *cache;
+  GThread *threads[4];
+  GESAsset *asset;
+  guint i;
+
+  g_setenv ("GES_DISCOVERY_CACHE_DIR", directory, TRUE);
+  ges_init ();
+
+  cache = ges_discovery_cache_get_default ();
+  ges_discovery_cache_clear (cache);
+  ges_asset_registry_clear ();
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("asset-request", _request_asset, NULL);
+
+  asset = ges_asset_request (TEST_URI);
+  fail_unless (asset != NULL);
+
+  /* Only one of the requests went down to the cache */
+  for (i = 0; i < G_N_ELEMENTS (threads); i++) {
+    GESAsset *thread_asset = g_thread_join (threads[i]);
+
+    fail_unless (thread_asset == asset);
+    g_object_unref (thread_asset);
+  }
+  fail_unless_equals_int (ges_discovery_cache_get_hits (cache) +
+      ges_discovery_cache_get_misses (cache), 1);
+
+  g_object_unref (asset);
+  ges_asset_registry_clear ();
+  ges_discovery_cache_clear (cache);
+  g_rmdir (directory);
+  g_free (directory);
+}
+
+GST_END_TEST
+
+static void
+_source_created_cb (GObject *unused, GAsyncResult *result, GList **sources)
+{
+  GESSource *source = ges_uri_source_new_finish (result, NULL);
+
+  fail_unless (source != NULL);
+  *sources = g_list_append (*sources, source);
+}
+
+GST_START_TEST (test_uri_source_new_async)
+{
+  gchar *directory = g_dir_make_tmp ("ges-discovery-cache-XXXXXX", NULL);
+  GESDiscoveryCache *cache;
+  GList *sources = NULL;
+
+  g_setenv ("GES_DISCOVERY_CACHE_DIR", directory, TRUE);
+  ges_init ();
+
+  cache = ges_discovery_cache_get_default ();
+  ges_asset_registry_clear ();
+  ges_asset_set_max_discovery_threads (2);
+
+  ges_uri_source_new_async (TEST_URI, GES_MEDIA_TYPE_VIDEO, NULL,
+      (GAsyncReadyCallback) _source_created_cb, &sources);
+  ges_uri_source_new_async (TEST_URI, GES_MEDIA_TYPE_AUDIO, NULL,
+      (GAsyncReadyCallback) _source_created_cb, &sources);
+
+  while (g_list_length (sources) < 2)
+    g_main_context_iteration (NULL, TRUE);
+
+  /* Both sources were served by a single discovery */
+  fail_unless_equals_int (ges_discovery_cache_get_hits (cache) +
+      ges_discovery_cache_get_misses (cache), 1);
+
+  g_list_free_full (sources, g_object_unref);
+  ges_asset_registry_clear ();
+  ges_discovery_cache_clear (cache);
+  g_rmdir (directory);
+  g_free (directory);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_load_prefetches_assets)
+{
+  gchar *directory = g_dir_make_tmp ("ges-discovery-cache-XXXXXX", NULL);
+  gchar *path = g_build_filename (directory, "project.ges", NULL);
+  GESDiscoveryCache *cache;
+  GESTimeline *timeline;
+  GList *objects, *tmp;
+
+  g_setenv ("GES_DISCOVERY_CACHE_DIR", directory, TRUE);
+  ges_init ();
+
+  cache = ges_discovery_cache_get_default ();
+
+  timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO | GES_MEDIA_TYPE_AUDIO);
+  ges_timeline_add_object (timeline,
+      GES_OBJECT (ges_uri_source_new (TEST_URI, GES_MEDIA_TYPE_VIDEO)));
+  ges_timeline_add_object (timeline,
+      GES_OBJECT (ges_uri_source_new (TEST_URI, GES_MEDIA_TYPE_AUDIO)));
+  fail_unless (ges_timeline_save_to_file (timeline, path, NULL));
+  g_object_unref (timeline);
+
+  ges_asset_registry_clear ();
+  ges_discovery_cache_clear (cache);
+
+  timeline = ges_timeline_load_from_file (path, NULL);
+  fail_unless (GES_IS_TIMELINE (timeline));
+
+  /* The media was discovered once, before the sources got created */
+  fail_unless_equals_int (ges_discovery_cache_get_hits (cache) +
+      ges_discovery_cache_get_misses (cache), 1);
+
+  objects = ges_timeline_get_objects (timeline);
+  fail_unless_equals_int (g_list_length (objects), 2);
+  for (tmp = objects; tmp; tmp = tmp->next)
+    fail_unless (ges_object_get_duration (tmp->data) != GST_CLOCK_TIME_NONE);
+  g_list_free (objects);
+
+  g_object_unref (timeline);
+  ges_asset_registry_clear ();
+  ges_discovery_cache_clear (cache);
+  g_unlink (path);
+  g_rmdir (directory);
+  g_free (path);
+  g_free (directory);
+}
+
+GST_END_TEST
+
+static Suite *
+ges_suite (void)
+{
+  Suite *s = suite_create ("ges");
+  TCase *tc_chain = tcase_create ("a");
+
+  suite_add_tcase (s, tc_chain);
+
+  tcase_add_test (tc_chain, test_discovery_cache_hit);
+  tcase_add_test (tc_chain, test_discovery_cache_stale_entry);
+  tcase_add_test (tc_chain, test_asset_shared);
+  tcase_add_test (tc_chain, test_uri_source_new_async);
+  tcase_add_test (tc_chain, test_load_prefetches_assets);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ges);
@@ -0,0 +1,157 @@
+#include <glib/gstdio.h>
+#include <ges.h>
+#include <gst/check/gstcheck.h>
+
+#include "test-utils.h"
+
+static gchar *
+_make_directory (void)
+{
+  gchar *directory = g_build_filename (g_get_tmp_dir (), "ges-test-journal-XXXXXX", NULL);
+
+  fail_unless (g_mkdtemp (directory) != NULL);
+
+  return directory;
+}
+
+static void
+_remove_directory (const gchar *directory)
+{
+  GDir *dir = g_dir_open (directory, 0, NULL);
+  const gchar *name;
+
+  while ((name = g_dir_read_name (dir))) {
+    gchar *path = g_build_filename (directory, name, NULL);
+
+    g_unlink (path);
+    g_free (path);
+  }
+
+  g_dir_close (dir);
+  g_rmdir (directory);
+}
+
+static GESObject *
+_get_object (GESTimeline *timeline, guint index)
+{
+  GList *objects = ges_timeline_get_objects (timeline);
+  GESObject *object = g_list_nth_data (objects, index);
+
+  g_list_free (objects);
+
+  return object;
+}
+
+GST_START_TEST (test_journal_recover)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  GESSource *first = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+  GESSource *second = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+  gchar *directory = _make_directory ();
+  GESTimeline *recovered;
+  GESJournal *journal;
+  GESObject *object;
+
+  ges_object_set_duration (GES_OBJECT (first), 2 * GST_SECOND);
+  ges_timeline_add_object (timeline, GES_OBJECT (first));
+
+  journal = ges_journal_new (timeline, directory, NULL);
+  fail_unless (journal != NULL);
+  fail_unless_equals_int (ges_journal_get_n_records (journal), 0);
+
+  ges_object_set_start (GES_OBJECT (first), 5 * GST_SECOND);
+  ges_object_set_inpoint (GES_OBJECT (first), GST_SECOND);
+  ges_object_set_duration (GES_OBJECT (second), 3 * GST_SECOND);
+  ges_timeline_add_object (timeline, GES_OBJECT (second));
+  ges_object_set_video_track_index (GES_OBJECT (second), 1);
+  fail_unless_equals_int (ges_journal_get_n_records (journal), 4);
+  fail_unless (ges_journal_flush (journal, NULL));
+
+  /* Not flushed, this is lost */
+  ges_object_set_start (GES_OBJECT (second), 10 * GST_SECOND);
+
+  recovered = ges_journal_recover (directory, NULL);
+  fail_unless (recovered != NULL);
+
+  object = _get_object (recovered, 0);
+  fail_unless_equals_uint64 (ges_object_get_start (object), 5 * GST_SECOND);
+  fail_unless_equals_uint64 (ges_object_get_inpoint (object), GST_SECOND);
+  fail_unless_equals_uint64 (ges_object_get_duration (object), 2 * GST_SECOND);
+
+  object = _get_object (recovered, 1);
+  fail_unless_equals_uint64 (ges_object_get_start (object), 0);
+  fail_unless_equals_uint64 (ges_object_get_duration (object), 3 * GST_SECOND);
+  fail_unless_equals_int (ges_object_get_video_track_index (object), 1);
+
+  g_object_unref (recovered);
+  g_object_unref (journal);
+  g_object_unref (timeline);
+  _remove_directory (directory);
+  g_free (directory);
+}
+
+GST_END_TEST
+
+static void
+_compacted_cb (GESJournal *journal, GAsyncResult *result, GMainLoop *loop)
+{
+  fail_unless (ges_journal_compact_finish (journal, result, NULL));
+  g_main_loop_quit (loop);
+}
+
+GST_START_TEST (test_journal_compact)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  GESSource *source = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+  GMainLoop *loop = g_main_loop_new (NULL, FALSE);
+  gchar *directory = _make_directory ();
+  gchar *old_journal = g_build_filename (directory, "journal-1", NULL);
+  GESTimeline *recovered;
+  GESJournal *journal;
+
+  ges_object_set_duration (GES_OBJECT (source), GST_SECOND);
+  ges_timeline_add_object (timeline, GES_OBJECT (source));
+  journal = ges_journal_new (timeline, directory, NULL);
+
+  ges_object_set_start (GES_OBJECT (source), GST_SECOND);
+  ges_journal_compact_async (journal, NULL, (GAsyncReadyCallback) _compacted_cb, loop);
+
+  /* Recorded in the new journal while the snapshot gets written */
+  ges_object_set_start (GES_OBJECT (source), 2 * GST_SECOND);
+  fail_unless_equals_int (ges_journal_get_n_records (journal), 1);
+  fail_unless (ges_journal_flush (journal, NULL));
+
+  g_main_loop_run (loop);
+  fail_if (g_file_test (old_journal, G_FILE_TEST_EXISTS));
+
+  recovered = ges_journal_recover (directory, NULL);
+  fail_unless (recovered != NULL);
+  fail_unless_equals_uint64 (ges_object_get_start (_get_object (recovered, 0)), 2 * GST_SECOND);
+
+  g_object_unref (recovered);
+  g_object_unref (journal);
+  g_object_unref (timeline);
+  g_main_loop_unref (loop);
+  _remove_directory (directory);
+  g_free (old_journal);
+  g_free (directory);
+}
+
+GST_END_TEST
+
+static Suite *
+ges_suite (void)
+{
+  Suite *s = suite_create ("ges");
+  TCase *tc_chain = tcase_create ("a");
+
+  suite_add_tcase (s, tc_chain);
+  ges_init ();
+
+  tcase_add_test (tc_chain, test_journal_recover);
+  tcase_add_test (tc_chain, test_journal_compact);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ges);
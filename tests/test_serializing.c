@@ -1,3 +1,5 @@
+#include <glib/gstdio.h>
+#include <gio/gio.h>
 #include <ges.h>
 #include <gst/check/gstcheck.h>
 
@@ -68,6 +70,107 @@ GST_START_TEST (test_serializing_uri_source)
 
 GST_END_TEST
 
+GST_START_TEST (test_serializing_uri_source_twice)
+{
+  ges_init ();
+  GESSource *video_source1 = ges_uri_source_new ("file:///home/meh/Music/taliban.mp4",
+      GES_MEDIA_TYPE_VIDEO);
+  GESObjectClass *klass = GES_OBJECT_GET_CLASS (video_source1);
+  GESAsset *asset = ges_asset_request ("file:///home/meh/Music/taliban.mp4");
+  GVariant *variant = g_variant_ref_sink (g_variant_new ("(ms)",
+        "file:///home/meh/Music/taliban.mp4"));
+
+  fail_unless (asset != NULL);
+  g_object_add_weak_pointer (G_OBJECT (asset), (gpointer *) &asset);
+
+  /* The asset of the previous deserialization is released */
+  fail_unless (klass->deserialize (GES_OBJECT (video_source1), variant));
+  fail_unless (klass->deserialize (GES_OBJECT (video_source1), variant));
+
+  g_object_unref (asset);
+  ges_asset_registry_clear ();
+  g_object_unref (video_source1);
+  fail_unless (asset == NULL);
+
+  g_variant_unref (variant);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_serializing_uri_source_no_uri)
+{
+  ges_init ();
+  GESObject *video_source1 = g_object_new (GES_TYPE_URI_SOURCE,
+      "media-type", GES_MEDIA_TYPE_VIDEO, NULL);
+  GESObject *ds_object;
+  GVariant *object_variant;
+
+  object_variant = ges_object_serialize (video_source1);
+  ds_object = ges_object_deserialize (object_variant);
+
+  /* No asset to look up, the source is left alone */
+  fail_unless (GES_IS_URI_SOURCE (ds_object));
+
+  g_object_unref (video_source1);
+  g_object_unref (ds_object);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_serializing_timeline)
+{
+  ges_init ();
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO | GES_MEDIA_TYPE_AUDIO);
+  GESTimeline *loaded;
+  GVariant *variant, *loaded_variant;
+  GError *error = NULL;
+  gchar *path;
+  gint fd;
+  guint i;
+
+  for (i = 0; i < 10; i++) {
+    GESSource *source = ges_test_source_new (i % 2 ? GES_MEDIA_TYPE_AUDIO : GES_MEDIA_TYPE_VIDEO,
+        i % 2 ? "sine" : "ball");
+
+    ges_object_set_start (GES_OBJECT (source), i * GST_SECOND);
+    ges_object_set_duration (GES_OBJECT (source), 2 * GST_SECOND);
+    ges_object_set_inpoint (GES_OBJECT (source), i * GST_MSECOND);
+    ges_object_set_video_track_index (GES_OBJECT (source), i % 3);
+    ges_timeline_add_object (timeline, GES_OBJECT (source));
+  }
+
+  fd = g_file_open_tmp ("ges-project-XXXXXX", &path, NULL);
+  fail_unless (fd != -1);
+  g_close (fd, NULL);
+
+  fail_unless (ges_timeline_save_to_file (timeline, path, &error));
+  g_assert_no_error (error);
+
+  loaded = ges_timeline_load_from_file (path, &error);
+  g_assert_no_error (error);
+  fail_unless (GES_IS_TIMELINE (loaded));
+
+  /* Serializing the loaded timeline gives back the same data */
+  variant = g_variant_ref_sink (ges_object_serialize (GES_OBJECT (timeline)));
+  loaded_variant = g_variant_ref_sink (ges_object_serialize (GES_OBJECT (loaded)));
+  fail_unless (g_variant_equal (variant, loaded_variant));
+
+  /* Anything else is rejected */
+  fail_unless (g_file_set_contents (path, "not a project", -1, NULL));
+  fail_unless (ges_timeline_load_from_file (path, &error) == NULL);
+  fail_unless (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA));
+  g_clear_error (&error);
+
+  g_variant_unref (variant);
+  g_variant_unref (loaded_variant);
+  g_object_unref (timeline);
+  g_object_unref (loaded);
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST
+
 static Suite *
 ges_suite (void)
 {
@@ -78,6 +181,9 @@ ges_suite (void)
 
   tcase_add_test (tc_chain, test_serializing_test_source);
   tcase_add_test (tc_chain, test_serializing_uri_source);
+  tcase_add_test (tc_chain, test_serializing_uri_source_twice);
+  tcase_add_test (tc_chain, test_serializing_uri_source_no_uri);
+  tcase_add_test (tc_chain, test_serializing_timeline);
 
   return s;
 }
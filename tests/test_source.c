@@ -1,5 +1,8 @@
 #include <ges.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/controller/controller.h>
+#include <gst/audio/audio.h>
 
 #include "test-utils.h"
 
@@ -16,6 +19,769 @@ GST_START_TEST (test_source)
 
 GST_END_TEST
 
+static void
+_handoff_cb (GstElement *sink, GstBuffer *buffer, GstPad *pad, GList **buffers)
+{
+  *buffers = g_list_append (*buffers, gst_buffer_ref (buffer));
+}
+
+GST_START_TEST (test_background_src)
+{
+  GstElement *pipeline = gst_parse_launch ("backgroundsrc num-buffers=3 ! "
+      "video/x-raw,format=I420,width=4,height=2,framerate=25/1 ! "
+      "fakesink name=sink signal-handoffs=true", NULL);
+  GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GList *buffers = NULL, *tmp;
+  GstMessage *message;
+  GstMapInfo map, first_map;
+  guint i = 0;
+
+  g_signal_connect (sink, "handoff", G_CALLBACK (_handoff_cb), &buffers);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  fail_unless_equals_int (g_list_length (buffers), 3);
+
+  /* Black luma, neutral chroma */
+  gst_buffer_map (buffers->data, &first_map, GST_MAP_READ);
+  fail_unless_equals_int (first_map.data[0], 16);
+  fail_unless_equals_int (first_map.data[8], 128);
+
+  for (tmp = buffers; tmp; tmp = tmp->next, i++) {
+    GstBuffer *buffer = tmp->data;
+
+    /* Timestamps change, the data is shared */
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), i * GST_SECOND / 25);
+    gst_buffer_map (buffer, &map, GST_MAP_READ);
+    fail_unless (map.data == first_map.data);
+    gst_buffer_unmap (buffer, &map);
+  }
+  gst_buffer_unmap (buffers->data, &first_map);
+
+  g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST
+
+/* The compositor pad the framepositioner named @name feeds */
+static GstPad *
+_get_compositor_pad (GstElement *pipeline, const gchar *name)
+{
+  GstElement *positioner = gst_bin_get_by_name (GST_BIN (pipeline), name);
+  GstPad *srcpad = gst_element_get_static_pad (positioner, "src");
+  GstPad *ghost = gst_pad_get_peer (srcpad);
+  GstPad *pad = gst_ghost_pad_get_target (GST_GHOST_PAD (ghost));
+
+  gst_object_unref (ghost);
+  gst_object_unref (srcpad);
+  gst_object_unref (positioner);
+
+  return pad;
+}
+
+static void
+_play_to_eos (GstElement *pipeline)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *message;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+  gst_object_unref (bus);
+}
+
+static void
+_count_culled_cb (GstPad *pad, GParamSpec *pspec, guint *n_culled)
+{
+  gdouble alpha;
+
+  g_object_get (pad, "alpha", &alpha, NULL);
+  if (alpha == 0.0)
+    g_atomic_int_inc (n_culled);
+}
+
+GST_START_TEST (test_mixer_culling)
+{
+  GstElement *pipeline = gst_parse_launch ("smartvideomixer name=mixer "
+      "caps=video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! fakesink name=sink "
+      "videotestsrc num-buffers=30 pattern=red ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "framepositioner name=hidden zorder=1 ! mixer. "
+      "videotestsrc num-buffers=30 pattern=green ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "framepositioner name=covering zorder=2 ! mixer. "
+      "videotestsrc num-buffers=30 pattern=blue ! video/x-raw,format=I420,width=32,height=24,framerate=30/1 ! "
+      "framepositioner name=top zorder=3 ! mixer.", NULL);
+  GstPad *hidden = _get_compositor_pad (pipeline, "hidden");
+  GstPad *covering = _get_compositor_pad (pipeline, "covering");
+  GstPad *top = _get_compositor_pad (pipeline, "top");
+  GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  guint n_hidden_culled = 0, n_covering_culled = 0, n_top_culled = 0;
+  GstSample *sample;
+  GstMapInfo map;
+
+  g_signal_connect (hidden, "notify::alpha", G_CALLBACK (_count_culled_cb), &n_hidden_culled);
+  g_signal_connect (covering, "notify::alpha", G_CALLBACK (_count_culled_cb), &n_covering_culled);
+  g_signal_connect (top, "notify::alpha", G_CALLBACK (_count_culled_cb), &n_top_culled);
+
+  _play_to_eos (pipeline);
+
+  /* The hidden layer gets skipped, the others are still blended */
+  fail_unless (n_hidden_culled > 0);
+  fail_unless_equals_int (n_covering_culled, 0);
+  fail_unless_equals_int (n_top_culled, 0);
+
+  /* Luma of the top layer in the top left corner, of the covering one
+   * everywhere else */
+  g_object_get (sink, "last-sample", &sample, NULL);
+  gst_buffer_map (gst_sample_get_buffer (sample), &map, GST_MAP_READ);
+  fail_unless (ABS (map.data[0] - 41) < 4);
+  fail_unless (ABS (map.data[47 * 64 + 63] - 145) < 4);
+  gst_buffer_unmap (gst_sample_get_buffer (sample), &map);
+  gst_sample_unref (sample);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (top);
+  gst_object_unref (covering);
+  gst_object_unref (hidden);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST
+
+static void
+_count_writes_cb (GstPad *pad, GParamSpec *pspec, guint *n_writes)
+{
+  g_atomic_int_inc (n_writes);
+}
+
+GST_START_TEST (test_mixer_changed_values)
+{
+  GstElement *pipeline = gst_parse_launch ("smartvideomixer name=mixer "
+      "caps=video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! fakesink "
+      "videotestsrc num-buffers=30 ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "framepositioner zorder=1 ! mixer. "
+      "videotestsrc num-buffers=30 ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "framepositioner name=positioner zorder=2 posy=8 width=32 height=24 ! mixer.", NULL);
+  GstElement *positioner = gst_bin_get_by_name (GST_BIN (pipeline), "positioner");
+  GstPad *pad = _get_compositor_pad (pipeline, "positioner");
+  GstControlSource *control_source = gst_interpolation_control_source_new ();
+  guint n_xpos = 0, n_ypos = 0, n_zorder = 0, n_width = 0;
+
+  /* Moves once, halfway through */
+  g_object_set (control_source, "mode", GST_INTERPOLATION_MODE_NONE, NULL);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), 0, 0.0);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source),
+      GST_SECOND / 2, 16.0);
+  gst_object_add_control_binding (GST_OBJECT (positioner),
+      gst_direct_control_binding_new_absolute (GST_OBJECT (positioner), "posx", control_source));
+
+  g_signal_connect (pad, "notify::xpos", G_CALLBACK (_count_writes_cb), &n_xpos);
+  g_signal_connect (pad, "notify::ypos", G_CALLBACK (_count_writes_cb), &n_ypos);
+  g_signal_connect (pad, "notify::zorder", G_CALLBACK (_count_writes_cb), &n_zorder);
+  g_signal_connect (pad, "notify::width", G_CALLBACK (_count_writes_cb), &n_width);
+
+  _play_to_eos (pipeline);
+
+  /* Set for the first frame, and then only when they change */
+  fail_unless_equals_int (n_xpos, 2);
+  fail_unless_equals_int (n_ypos, 1);
+  fail_unless_equals_int (n_zorder, 1);
+  fail_unless_equals_int (n_width, 1);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (control_source);
+  gst_object_unref (pad);
+  gst_object_unref (positioner);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST
+
+static void
+_collect_frames_cb (GstElement *sink, GstBuffer *buffer, GstPad *pad, GList **frames)
+{
+  GstMapInfo map;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  *frames = g_list_append (*frames, g_bytes_new (map.data, map.size));
+  gst_buffer_unmap (buffer, &map);
+}
+
+/* The frames output by a mixer blending with @threads threads */
+static GList *
+_mix_frames (guint threads)
+{
+  gchar *description = g_strdup_printf ("smartvideomixer name=mixer threads=%u "
+      "caps=video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "fakesink name=sink sync=false signal-handoffs=true "
+      "videotestsrc num-buffers=10 ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "framepositioner zorder=1 ! mixer. "
+      "videotestsrc num-buffers=10 pattern=ball ! video/x-raw,format=I420,width=32,height=24,framerate=30/1 ! "
+      "framepositioner zorder=2 posx=6 posy=10 alpha=0.5 ! mixer.", threads);
+  GstElement *pipeline = gst_parse_launch (description, NULL);
+  GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  GList *frames = NULL;
+
+  g_signal_connect (sink, "handoff", G_CALLBACK (_collect_frames_cb), &frames);
+  _play_to_eos (pipeline);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+  g_free (description);
+
+  return frames;
+}
+
+GST_START_TEST (test_mixer_stripes)
+{
+  /* Three stripes of 16 lines, the top layer crosses both seams */
+  GList *single = _mix_frames (1);
+  GList *striped = _mix_frames (4);
+  GList *tmp, *other;
+
+  fail_unless_equals_int (g_list_length (single), 10);
+  fail_unless_equals_int (g_list_length (striped), 10);
+
+  for (tmp = single, other = striped; tmp; tmp = tmp->next, other = other->next)
+    fail_unless (g_bytes_equal (tmp->data, other->data));
+
+  g_list_free_full (single, (GDestroyNotify) g_bytes_unref);
+  g_list_free_full (striped, (GDestroyNotify) g_bytes_unref);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_background_src_audio)
+{
+  GstElement *pipeline = gst_parse_launch ("backgroundsrc num-buffers=1 ! "
+      "audio/x-raw,format=S16LE,rate=8000,channels=1 ! "
+      "fakesink name=sink signal-handoffs=true", NULL);
+  GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GList *buffers = NULL;
+  GstMessage *message;
+
+  g_signal_connect (sink, "handoff", G_CALLBACK (_handoff_cb), &buffers);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  /* Mixers can skip silence */
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buffers->data, GST_BUFFER_FLAG_GAP));
+
+  g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_background_src_audio_mixed)
+{
+  GstElement *pipeline = gst_parse_launch ("smartaudiomixer name=mixer "
+      "caps=\"audio/x-raw,format=F32LE,layout=interleaved,rate=8000,channels=1\" ! "
+      "fakesink name=sink signal-handoffs=true "
+      "backgroundsrc num-buffers=1 ! "
+      "audio/x-raw,format=F32LE,layout=interleaved,rate=8000,channels=1 ! mixer.", NULL);
+  GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GList *buffers = NULL, *tmp;
+  GstMessage *message;
+
+  g_signal_connect (sink, "handoff", G_CALLBACK (_handoff_cb), &buffers);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  /* The background alone is skipped, and the mix is silence too */
+  fail_unless (buffers != NULL);
+  for (tmp = buffers; tmp; tmp = tmp->next)
+    fail_unless (GST_BUFFER_FLAG_IS_SET (tmp->data, GST_BUFFER_FLAG_GAP));
+
+  g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_mixer_shared_pool)
+{
+  GstElement *pipeline = gst_parse_launch ("smartvideomixer name=mixer "
+      "caps=video/x-raw,format=AYUV,width=64,height=48,framerate=30/1 ! fakesink "
+      "videotestsrc num-buffers=30 ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "videoconvert ! video/x-raw,format=AYUV ! framepositioner zorder=1 ! mixer. "
+      "videotestsrc num-buffers=30 ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "videoconvert ! video/x-raw,format=AYUV ! framepositioner zorder=2 ! mixer.", NULL);
+  GstElement *mixer = gst_bin_get_by_name (GST_BIN (pipeline), "mixer");
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *message;
+  guint n_allocated;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  /* Both converters output in the same recycled buffers */
+  g_object_get (mixer, "allocated-buffers", &n_allocated, NULL);
+  fail_unless (n_allocated > 0);
+  fail_unless (n_allocated < 30);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (mixer);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_mixer_scaling)
+{
+  GstElement *pipeline = gst_parse_launch ("videotestsrc num-buffers=2 ! "
+      "video/x-raw,format=AYUV,width=64,height=48,framerate=30/1 ! "
+      "framepositioner name=positioner width=32 height=24 ! "
+      "smartvideomixer name=mixer ! fakesink", NULL);
+  GstElement *mixer = gst_bin_get_by_name (GST_BIN (pipeline), "mixer");
+  GstElement *positioner = gst_bin_get_by_name (GST_BIN (pipeline), "positioner");
+  GstPad *pad;
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *message;
+  GstStructure *structure;
+  GstCaps *caps;
+  gint width;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  /* The source keeps its size, the mixer scales it */
+  pad = gst_element_get_static_pad (positioner, "src");
+  caps = gst_pad_get_current_caps (pad);
+  structure = gst_caps_get_structure (caps, 0);
+  fail_unless (gst_structure_get_int (structure, "width", &width));
+  fail_unless_equals_int (width, 64);
+  gst_caps_unref (caps);
+  gst_object_unref (pad);
+
+  pad = gst_element_get_static_pad (mixer, "src");
+  caps = gst_pad_get_current_caps (pad);
+  structure = gst_caps_get_structure (caps, 0);
+  fail_unless (gst_structure_get_int (structure, "width", &width));
+  fail_unless_equals_int (width, 32);
+  gst_caps_unref (caps);
+  gst_object_unref (pad);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (positioner);
+  gst_object_unref (mixer);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST
+
+static guint
+_count_bypassed_frames (const gchar *description)
+{
+  GstElement *pipeline = gst_parse_launch (description, NULL);
+  GstElement *mixer = gst_bin_get_by_name (GST_BIN (pipeline), "mixer");
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *message;
+  guint n_bypassed;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  g_object_get (mixer, "bypassed-frames", &n_bypassed, NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (mixer);
+  gst_object_unref (pipeline);
+
+  return n_bypassed;
+}
+
+GST_START_TEST (test_mixer_bypass)
+{
+  /* A single opaque layer covering everything */
+  fail_unless (_count_bypassed_frames ("smartvideomixer name=mixer "
+      "caps=video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! fakesink "
+      "videotestsrc num-buffers=30 ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "framepositioner zorder=1 ! mixer.") > 0);
+
+  /* It gets blended when translucent */
+  fail_unless_equals_int (_count_bypassed_frames ("smartvideomixer name=mixer "
+      "caps=video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! fakesink "
+      "videotestsrc num-buffers=30 ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "framepositioner zorder=1 alpha=0.5 ! mixer."), 0);
+
+  /* Unless the mixer is told not to mix */
+  fail_unless (_count_bypassed_frames ("smartvideomixer name=mixer mixing=false "
+      "caps=video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! fakesink "
+      "videotestsrc num-buffers=30 ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "framepositioner zorder=1 ! mixer. "
+      "videotestsrc num-buffers=30 ! video/x-raw,format=I420,width=64,height=48,framerate=30/1 ! "
+      "framepositioner zorder=2 alpha=0.5 ! mixer.") > 0);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_sample_accurate_volume)
+{
+  GstHarness *h = gst_harness_new ("samplecontroller");
+  GstControlSource *control_source = gst_interpolation_control_source_new ();
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gfloat *samples;
+  guint i;
+
+  g_object_set (control_source, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), 0, 0.0);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), GST_SECOND, 1.0);
+  gst_object_add_control_binding (GST_OBJECT (h->element),
+      gst_direct_control_binding_new (GST_OBJECT (h->element), "volume", control_source));
+  g_object_set (h->element, "sample-accurate", TRUE, NULL);
+
+  gst_harness_set_src_caps_str (h, "audio/x-raw,format=" GST_AUDIO_NE (F32)
+      ",rate=1000,channels=2,layout=interleaved");
+
+  /* One second fading in, in a single buffer */
+  buffer = gst_buffer_new_allocate (NULL, 1000 * 2 * sizeof (gfloat), NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  samples = (gfloat *) map.data;
+  for (i = 0; i < 2000; i++)
+    samples[i] = 1.0;
+  gst_buffer_unmap (buffer, &map);
+  GST_BUFFER_PTS (buffer) = 0;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND;
+
+  buffer = gst_harness_push_and_pull (h, buffer);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  samples = (gfloat *) map.data;
+  for (i = 0; i < 1000; i++) {
+    fail_unless (ABS (samples[2 * i] - i / 1000.0) < 0.0001);
+    fail_unless (samples[2 * i] == samples[2 * i + 1]);
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  gst_buffer_unref (buffer);
+  gst_object_unref (control_source);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_sample_accurate_volume_rounding)
+{
+  GstHarness *h = gst_harness_new ("samplecontroller");
+  GstControlSource *control_source = gst_interpolation_control_source_new ();
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint16 *samples;
+  gfloat v;
+  guint i;
+
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), 0, 0.5);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), GST_SECOND, 0.5);
+  gst_object_add_control_binding (GST_OBJECT (h->element),
+      gst_direct_control_binding_new (GST_OBJECT (h->element), "volume", control_source));
+  g_object_set (h->element, "sample-accurate", TRUE, NULL);
+
+  gst_harness_set_src_caps_str (h, "audio/x-raw,format=" GST_AUDIO_NE (S16)
+      ",rate=1000,channels=2,layout=interleaved");
+
+  /* Odd samples, halving them always gives a tie */
+  buffer = gst_buffer_new_allocate (NULL, 1000 * 2 * sizeof (gint16), NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  samples = (gint16 *) map.data;
+  for (i = 0; i < 2000; i++)
+    samples[i] = 2 * i - 1999;
+  gst_buffer_unmap (buffer, &map);
+  GST_BUFFER_PTS (buffer) = 0;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND;
+
+  /* The vector kernels round like the scalar one, half away from zero */
+  buffer = gst_harness_push_and_pull (h, buffer);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  samples = (gint16 *) map.data;
+  for (i = 0; i < 2000; i++) {
+    v = (2 * (gint) i - 1999) * 0.5f;
+    fail_unless_equals_int (samples[i], v < 0 ? (gint16) (v - 0.5f) : (gint16) (v + 0.5f));
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  gst_buffer_unref (buffer);
+  gst_object_unref (control_source);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST
+
+static gdouble
+_push_and_get_alpha (GstHarness *h, GstClockTime pts)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, 16 * 16 * 4, NULL);
+  gdouble alpha;
+
+  GST_BUFFER_PTS (buffer) = pts;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 25;
+  gst_buffer_unref (gst_harness_push_and_pull (h, buffer));
+  g_object_get (h->element, "alpha", &alpha, NULL);
+
+  return alpha;
+}
+
+GST_START_TEST (test_baked_curves)
+{
+  GstHarness *h = gst_harness_new ("framepositioner");
+  GstControlSource *control_source = gst_interpolation_control_source_new ();
+
+  g_object_set (control_source, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), 0, 0.0);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), GST_SECOND, 1.0);
+  gst_object_add_control_binding (GST_OBJECT (h->element),
+      gst_direct_control_binding_new (GST_OBJECT (h->element), "alpha", control_source));
+  g_object_set (h->element, "bake", TRUE, NULL);
+
+  gst_harness_set_src_caps_str (h, "video/x-raw,format=RGBA,width=16,height=16,framerate=25/1");
+
+  fail_unless (ABS (_push_and_get_alpha (h, 0) - 0.0) < 0.0001);
+  fail_unless (ABS (_push_and_get_alpha (h, GST_SECOND / 2) - 0.5) < 0.0001);
+  /* In between two baked values */
+  fail_unless (ABS (_push_and_get_alpha (h, GST_SECOND / 2 + GST_MSECOND) - 0.501) < 0.0001);
+  /* Past the first baked chunk */
+  fail_unless (ABS (_push_and_get_alpha (h, 3 * GST_SECOND) - 1.0) < 0.0001);
+
+  /* The table is only rebuilt once invalidated */
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), GST_SECOND, 0.0);
+  fail_unless (ABS (_push_and_get_alpha (h, 3 * GST_SECOND) - 1.0) < 0.0001);
+  g_object_set (h->element, "bake", TRUE, NULL);
+  fail_unless (ABS (_push_and_get_alpha (h, 3 * GST_SECOND) - 0.0) < 0.0001);
+
+  gst_object_unref (control_source);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_baked_curves_late_keyframe)
+{
+  GstHarness *h = gst_harness_new ("framepositioner");
+  GstControlSource *control_source = gst_interpolation_control_source_new ();
+
+  g_object_set (control_source, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), 400 * GST_MSECOND, 0.0);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), 1200 * GST_MSECOND, 1.0);
+  gst_object_add_control_binding (GST_OBJECT (h->element),
+      gst_direct_control_binding_new (GST_OBJECT (h->element), "alpha", control_source));
+  g_object_set (h->element, "alpha", 0.7, "bake", TRUE, NULL);
+
+  gst_harness_set_src_caps_str (h, "video/x-raw,format=RGBA,width=16,height=16,framerate=25/1");
+
+  /* No value before the first keyframe, the property keeps its own */
+  fail_unless (ABS (_push_and_get_alpha (h, 0) - 0.7) < 0.0001);
+  fail_unless (ABS (_push_and_get_alpha (h, 200 * GST_MSECOND) - 0.7) < 0.0001);
+  fail_unless (ABS (_push_and_get_alpha (h, 400 * GST_MSECOND) - 0.0) < 0.0001);
+  fail_unless (ABS (_push_and_get_alpha (h, 800 * GST_MSECOND) - 0.5) < 0.0001);
+
+  gst_object_unref (control_source);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST
+
+static GstBuffer *
+_make_gray_frame (guint8 value, GstClockTime pts)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, 16 * 16, NULL);
+
+  gst_buffer_memset (buffer, 0, value, 16 * 16);
+  GST_BUFFER_PTS (buffer) = pts;
+  GST_BUFFER_DURATION (buffer) = GST_SECOND / 25;
+
+  return buffer;
+}
+
+static gpointer
+_push_thread (GstHarness *h)
+{
+  gst_harness_push (h, g_object_steal_data (G_OBJECT (h->element), "buffer"));
+
+  return NULL;
+}
+
+/* Crossfades a white frame of @h0 with a black one of @h1 at @pts, and
+ * returns the luma of the output. The inputs block until both have a
+ * frame, so the first one is pushed from its own thread */
+static guint8
+_crossfade_frames (GstHarness *h0, GstHarness *h1, GstClockTime pts)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  GThread *thread;
+  guint8 res;
+
+  g_object_set_data (G_OBJECT (h0->element), "buffer", _make_gray_frame (255, pts));
+  thread = g_thread_new ("push", (GThreadFunc) _push_thread, h0);
+  fail_unless_equals_int (gst_harness_push (h1, _make_gray_frame (0, pts)), GST_FLOW_OK);
+  g_thread_join (thread);
+
+  buffer = gst_harness_pull (h0);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  res = map.data[0];
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  return res;
+}
+
+GST_START_TEST (test_crossfade_segment)
+{
+  GstHarness *h0 = gst_harness_new_with_padnames ("crossfade", "sink_0", "src");
+  GstHarness *h1 = gst_harness_new_with_element (h0->element, "sink_1", NULL);
+  GstSegment segment;
+
+  g_object_set (h0->element, "duration", GST_SECOND, NULL);
+  gst_harness_set_src_caps_str (h0, "video/x-raw,format=GRAY8,width=16,height=16,framerate=25/1");
+  gst_harness_set_src_caps_str (h1, "video/x-raw,format=GRAY8,width=16,height=16,framerate=25/1");
+
+  /* Sources with an inpoint, the fade follows the stream time */
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  segment.start = 10 * GST_SECOND;
+  segment.time = 0;
+  fail_unless (gst_harness_push_event (h0, gst_event_new_segment (&segment)));
+  fail_unless (gst_harness_push_event (h1, gst_event_new_segment (&segment)));
+  fail_unless_equals_int (_crossfade_frames (h0, h1, 10 * GST_SECOND + GST_SECOND / 2), 127);
+
+  /* After a seek */
+  segment.start = 10 * GST_SECOND + 3 * GST_SECOND / 4;
+  segment.time = 3 * GST_SECOND / 4;
+  fail_unless (gst_harness_push_event (h0, gst_event_new_segment (&segment)));
+  fail_unless (gst_harness_push_event (h1, gst_event_new_segment (&segment)));
+  fail_unless_equals_int (_crossfade_frames (h0, h1, 10 * GST_SECOND + 3 * GST_SECOND / 4), 63);
+
+  gst_harness_teardown (h1);
+  gst_harness_teardown (h0);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_pixel_transform)
+{
+  GstHarness *h = gst_harness_new ("pixeltransform");
+  GString *curve = g_string_new (NULL);
+  gchar *levels;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint i;
+
+  /* Inverts luma and removes all colour */
+  for (i = 0; i < 256; i++)
+    g_string_append_printf (curve, "%u,", 255 - i);
+  g_object_set (h->element, "curve", curve->str, "saturation", 0.0, NULL);
+  g_string_free (curve, TRUE);
+
+  gst_harness_set_src_caps_str (h, "video/x-raw,format=I420,width=16,height=16,framerate=25/1");
+
+  /* 16x16 luma then two 8x8 chroma planes */
+  buffer = gst_buffer_new_allocate (NULL, 16 * 16 + 2 * 8 * 8, NULL);
+  gst_buffer_memset (buffer, 0, 10, 16 * 16);
+  gst_buffer_memset (buffer, 16 * 16, 200, 2 * 8 * 8);
+
+  buffer = gst_harness_push_and_pull (h, buffer);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  for (i = 0; i < 16 * 16; i++)
+    fail_unless_equals_int (map.data[i], 245);
+  for (; i < map.size; i++)
+    fail_unless_equals_int (map.data[i], 128);
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (buffer);
+
+  /* Curves need all their levels */
+  g_object_set (h->element, "curve", "0 1 2", NULL);
+  g_object_get (h->element, "curve", &levels, NULL);
+  fail_unless (g_str_has_prefix (levels, "255 254 253"));
+  g_free (levels);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_release_keeps_settings)
+{
+  GESSource *source = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, "snow");
+  GstControlSource *control_source, *rebound_source;
+  GObject *child, *rebuilt_child;
+  GParamSpec *pspec;
+  GValue *value;
+  gint posx;
+
+  ges_object_set_duration (GES_OBJECT (source), GST_SECOND);
+
+  /* Looking children up builds the elements */
+  gst_child_proxy_set (GST_CHILD_PROXY (source), "framepositioner::posx", 10, NULL);
+  control_source = ges_object_get_interpolation_control_source (GES_OBJECT (source),
+      "framepositioner::alpha", G_TYPE_NONE);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (control_source), 0, 0.5);
+  fail_unless (gst_child_proxy_lookup (GST_CHILD_PROXY (source), "framepositioner::alpha",
+        &child, &pspec));
+
+  fail_unless (ges_source_release_elements (source, 0));
+
+  /* Rebuilt with what was set on the released ones */
+  fail_unless (gst_child_proxy_lookup (GST_CHILD_PROXY (source), "framepositioner::alpha",
+        &rebuilt_child, &pspec));
+  fail_if (rebuilt_child == child);
+  gst_child_proxy_get (GST_CHILD_PROXY (source), "framepositioner::posx", &posx, NULL);
+  fail_unless_equals_int (posx, 10);
+  value = gst_object_get_value (GST_OBJECT (rebuilt_child), "alpha", 0);
+  fail_unless (value != NULL);
+  fail_unless (ABS (g_value_get_double (value) - 0.5) < 0.0001);
+  /* The existing control source is handed out again */
+  rebound_source = ges_object_get_interpolation_control_source (GES_OBJECT (source),
+      "framepositioner::alpha", G_TYPE_NONE);
+  fail_unless (rebound_source == control_source);
+
+  gst_object_unref (rebound_source);
+  g_value_unset (value);
+  g_free (value);
+  g_object_unref (rebuilt_child);
+  g_object_unref (child);
+  g_object_unref (source);
+}
+
+GST_END_TEST
+
 static Suite *
 ges_suite (void)
 {
@@ -26,6 +792,22 @@ ges_suite (void)
   ges_init ();
 
   tcase_add_test (tc_chain, test_source);
+  tcase_add_test (tc_chain, test_background_src);
+  tcase_add_test (tc_chain, test_background_src_audio);
+  tcase_add_test (tc_chain, test_background_src_audio_mixed);
+  tcase_add_test (tc_chain, test_mixer_shared_pool);
+  tcase_add_test (tc_chain, test_mixer_scaling);
+  tcase_add_test (tc_chain, test_mixer_bypass);
+  tcase_add_test (tc_chain, test_mixer_culling);
+  tcase_add_test (tc_chain, test_mixer_changed_values);
+  tcase_add_test (tc_chain, test_mixer_stripes);
+  tcase_add_test (tc_chain, test_sample_accurate_volume);
+  tcase_add_test (tc_chain, test_sample_accurate_volume_rounding);
+  tcase_add_test (tc_chain, test_baked_curves);
+  tcase_add_test (tc_chain, test_baked_curves_late_keyframe);
+  tcase_add_test (tc_chain, test_crossfade_segment);
+  tcase_add_test (tc_chain, test_pixel_transform);
+  tcase_add_test (tc_chain, test_release_keeps_settings);
 
   return s;
 }
@@ -56,6 +56,563 @@ GST_START_TEST (test_tracks)
 
 GST_END_TEST
 
+static void
+_start_notify_cb (GESObject *object, GParamSpec *pspec, guint *n_notifies)
+{
+  *n_notifies += 1;
+}
+
+GST_START_TEST (test_edit)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  GESSource *sources[2];
+  guint n_notifies = 0, i;
+
+  for (i = 0; i < G_N_ELEMENTS (sources); i++) {
+    sources[i] = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+    ges_object_set_duration (GES_OBJECT (sources[i]), GST_SECOND);
+    ges_timeline_add_object (timeline, GES_OBJECT (sources[i]));
+    g_signal_connect (sources[i], "notify::start", G_CALLBACK (_start_notify_cb), &n_notifies);
+  }
+
+  ges_timeline_begin_edit (timeline);
+  ges_timeline_begin_edit (timeline);
+
+  for (i = 1; i <= 10; i++) {
+    ges_object_set_start (GES_OBJECT (sources[0]), i * GST_SECOND);
+    ges_object_set_start (GES_OBJECT (sources[1]), 2 * i * GST_SECOND);
+  }
+
+  fail_unless_equals_uint64 (ges_object_get_start (GES_OBJECT (sources[0])), 10 * GST_SECOND);
+  fail_unless_equals_int (n_notifies, 0);
+
+  /* Only the outermost edit applies the changes */
+  fail_unless (ges_timeline_end_edit (timeline));
+  fail_unless_equals_int (n_notifies, 0);
+  fail_unless (ges_timeline_end_edit (timeline));
+  fail_unless_equals_int (n_notifies, 2);
+  fail_unless_equals_uint64 (ges_object_get_start (GES_OBJECT (sources[1])), 20 * GST_SECOND);
+
+  /* And changes get notified right away again */
+  ges_object_set_start (GES_OBJECT (sources[0]), 0);
+  fail_unless_equals_int (n_notifies, 3);
+
+  g_object_unref (timeline);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_edit_rejected)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_AUDIO);
+  GESSource *source = ges_uri_source_new ("file:///home/meh/Videos/homeland.mp4", GES_MEDIA_TYPE_AUDIO);
+  GstClockTime media_duration = ges_object_get_duration (GES_OBJECT (source));
+
+  fail_unless (GST_CLOCK_TIME_IS_VALID (media_duration));
+  ges_timeline_add_object (timeline, GES_OBJECT (source));
+
+  /* Past the end of the media, only the inpoint is reverted */
+  ges_timeline_begin_edit (timeline);
+  ges_object_set_inpoint (GES_OBJECT (source), media_duration + GST_SECOND);
+  ges_object_set_duration (GES_OBJECT (source), media_duration / 2);
+  ges_object_set_start (GES_OBJECT (source), GST_SECOND);
+  fail_if (ges_timeline_end_edit (timeline));
+
+  fail_unless_equals_uint64 (ges_object_get_inpoint (GES_OBJECT (source)), 0);
+  fail_unless_equals_uint64 (ges_object_get_duration (GES_OBJECT (source)), media_duration / 2);
+  fail_unless_equals_uint64 (ges_object_get_start (GES_OBJECT (source)), GST_SECOND);
+
+  /* Trimming the start out then back in, the two changes only fit when
+   * applied in the right order */
+  ges_timeline_begin_edit (timeline);
+  ges_object_set_duration (GES_OBJECT (source), media_duration / 4);
+  ges_object_set_inpoint (GES_OBJECT (source), media_duration / 2);
+  fail_unless (ges_timeline_end_edit (timeline));
+  fail_unless_equals_uint64 (ges_object_get_duration (GES_OBJECT (source)), media_duration / 4);
+
+  ges_timeline_begin_edit (timeline);
+  ges_object_set_inpoint (GES_OBJECT (source), 0);
+  ges_object_set_duration (GES_OBJECT (source), media_duration);
+  fail_unless (ges_timeline_end_edit (timeline));
+  fail_unless_equals_uint64 (ges_object_get_inpoint (GES_OBJECT (source)), 0);
+  fail_unless_equals_uint64 (ges_object_get_duration (GES_OBJECT (source)), media_duration);
+
+  g_object_unref (timeline);
+}
+
+GST_END_TEST
+
+static void
+_committed_cb (GESTimeline *timeline, GAsyncResult *result, guint *n_commits)
+{
+  fail_unless (ges_timeline_commit_finish (timeline, result, NULL));
+  *n_commits += 1;
+}
+
+GST_START_TEST (test_commit_async)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  GESSource *source = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+  guint n_commits = 0, i;
+
+  ges_object_set_duration (GES_OBJECT (source), GST_SECOND);
+  ges_timeline_add_object (timeline, GES_OBJECT (source));
+  fail_unless_equals_uint64 (ges_timeline_get_last_commit_latency (timeline), GST_CLOCK_TIME_NONE);
+
+  /* Coalesced into a single commit, which serves all of them */
+  for (i = 0; i < 3; i++) {
+    ges_object_set_start (GES_OBJECT (source), i * GST_SECOND);
+    ges_timeline_commit_async (timeline, NULL, (GAsyncReadyCallback) _committed_cb, &n_commits);
+  }
+  fail_unless_equals_int (n_commits, 0);
+
+  while (n_commits < 3)
+    g_main_context_iteration (NULL, TRUE);
+
+  fail_if (ges_timeline_get_last_commit_latency (timeline) == GST_CLOCK_TIME_NONE);
+
+  g_object_unref (timeline);
+}
+
+GST_END_TEST
+
+/* The nlesource wrapping the elements of @source */
+static GstElement *
+_get_nle_source (GESSource *source)
+{
+  GObject *positioner;
+  GParamSpec *pspec;
+  GstObject *topbin, *nlesource;
+
+  fail_unless (gst_child_proxy_lookup (GST_CHILD_PROXY (source), "framepositioner::zorder",
+        &positioner, &pspec));
+  topbin = gst_object_get_parent (GST_OBJECT (positioner));
+  nlesource = gst_object_get_parent (topbin);
+  gst_object_unref (topbin);
+  g_object_unref (positioner);
+
+  return GST_ELEMENT (nlesource);
+}
+
+static guint
+_get_zorder (GESSource *source)
+{
+  GObject *positioner;
+  GParamSpec *pspec;
+  guint zorder;
+
+  fail_unless (gst_child_proxy_lookup (GST_CHILD_PROXY (source), "framepositioner::zorder",
+        &positioner, &pspec));
+  g_object_get (positioner, "zorder", &zorder, NULL);
+  g_object_unref (positioner);
+
+  return zorder;
+}
+
+GST_START_TEST (test_nesting)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  GESTimeline *nested = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  GESSource *source = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+  GESSource *hidden = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+  GESSource *overlapping = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+  GList *compositions, *nested_compositions;
+  GstElement *nlesource, *composition;
+  guint64 start, inpoint;
+  gint64 duration;
+  guint priority, n_transitions = 0;
+  gboolean active;
+
+  ges_object_set_start (GES_OBJECT (source), GST_SECOND);
+  ges_object_set_duration (GES_OBJECT (source), 4 * GST_SECOND);
+  ges_timeline_add_object (nested, GES_OBJECT (source));
+  ges_object_set_start (GES_OBJECT (hidden), 10 * GST_SECOND);
+  ges_object_set_duration (GES_OBJECT (hidden), GST_SECOND);
+  ges_timeline_add_object (nested, GES_OBJECT (hidden));
+  ges_object_set_start (GES_OBJECT (overlapping), 3 * GST_SECOND);
+  ges_object_set_duration (GES_OBJECT (overlapping), 3 * GST_SECOND);
+  ges_timeline_add_object (nested, GES_OBJECT (overlapping));
+  g_signal_connect (nested, "transition-added", G_CALLBACK (_transition_added_cb), &n_transitions);
+  g_signal_connect (nested, "transition-removed", G_CALLBACK (_transition_removed_cb), &n_transitions);
+
+  /* Only shows [2s, 5s[ of the nested timeline */
+  ges_object_set_start (GES_OBJECT (nested), 10 * GST_SECOND);
+  ges_object_set_inpoint (GES_OBJECT (nested), 2 * GST_SECOND);
+  ges_object_set_duration (GES_OBJECT (nested), 3 * GST_SECOND);
+  ges_timeline_add_object (timeline, GES_OBJECT (nested));
+  ges_timeline_commit (timeline);
+
+  compositions = ges_timeline_get_compositions_by_media_type (timeline, GES_MEDIA_TYPE_VIDEO);
+  nlesource = _get_nle_source (source);
+  g_object_get (nlesource, "composition", &composition, "start", &start,
+      "inpoint", &inpoint, "duration", &duration, NULL);
+
+  fail_unless (composition == compositions->data);
+  fail_unless_equals_uint64 (start, 10 * GST_SECOND);
+  fail_unless_equals_uint64 (inpoint, GST_SECOND);
+  fail_unless_equals_int64 (duration, 3 * GST_SECOND);
+  gst_object_unref (composition);
+  gst_object_unref (nlesource);
+
+  /* Its sources get their lanes in the range after our single track, and
+   * the transition between them */
+  fail_unless_equals_int (n_transitions, 1);
+  nlesource = _get_nle_source (source);
+  g_object_get (nlesource, "priority", &priority, NULL);
+  fail_unless_equals_int (priority, TRACK_PRIORITY_HEIGHT + TIMELINE_PRIORITY_OFFSET);
+  gst_object_unref (nlesource);
+  nlesource = _get_nle_source (overlapping);
+  g_object_get (nlesource, "priority", &priority, NULL);
+  fail_unless_equals_int (priority, TRACK_PRIORITY_HEIGHT + TIMELINE_PRIORITY_OFFSET +
+      SOURCE_PRIORITY_HEIGHT);
+  gst_object_unref (nlesource);
+
+  fail_unless (_get_zorder (source) > _get_zorder (overlapping));
+
+  /* Once out of view, they go back to the nested timeline */
+  ges_object_set_inpoint (GES_OBJECT (nested), 20 * GST_SECOND);
+  ges_timeline_commit (timeline);
+
+  fail_unless_equals_int (n_transitions, 0);
+  nested_compositions = ges_timeline_get_compositions_by_media_type (nested, GES_MEDIA_TYPE_VIDEO);
+  nlesource = _get_nle_source (source);
+  g_object_get (nlesource, "composition", &composition, "start", &start,
+      "duration", &duration, "active", &active, NULL);
+
+  fail_unless (composition == nested_compositions->data);
+  fail_unless_equals_uint64 (start, GST_SECOND);
+  fail_unless_equals_int64 (duration, 4 * GST_SECOND);
+  fail_unless (active);
+
+  gst_object_unref (composition);
+  gst_object_unref (nlesource);
+  g_list_free (nested_compositions);
+  g_list_free (compositions);
+  g_object_unref (timeline);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_restriction_caps)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  GESSource *source = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+  GstCaps *caps = gst_caps_from_string ("video/x-raw,format=I420,width=320,height=240,framerate=25/1");
+  GstCaps *audio_caps = gst_caps_from_string ("audio/x-raw,rate=48000");
+  GstCaps *current;
+  GObject *positioner;
+  GParamSpec *pspec;
+  GstPad *sinkpad, *peer;
+  GstElement *filter, *testsrc;
+  GList *compositions;
+
+  fail_if (ges_timeline_set_restriction_caps (timeline, GES_MEDIA_TYPE_VIDEO, audio_caps));
+  fail_unless (ges_timeline_set_restriction_caps (timeline, GES_MEDIA_TYPE_VIDEO, caps));
+
+  ges_object_set_duration (GES_OBJECT (source), GST_SECOND);
+  ges_timeline_add_object (timeline, GES_OBJECT (source));
+
+  compositions = ges_timeline_get_compositions_by_media_type (timeline, GES_MEDIA_TYPE_VIDEO);
+  g_object_get (compositions->data, "caps", &current, NULL);
+  fail_unless (gst_caps_is_equal (current, caps));
+  gst_caps_unref (current);
+  g_list_free (compositions);
+
+  /* The source converts straight into that format */
+  fail_unless (gst_child_proxy_lookup (GST_CHILD_PROXY (source), "framepositioner::zorder",
+        &positioner, &pspec));
+  sinkpad = gst_element_get_static_pad (GST_ELEMENT (positioner), "sink");
+  peer = gst_pad_get_peer (sinkpad);
+  filter = gst_pad_get_parent_element (peer);
+  g_object_get (filter, "caps", &current, NULL);
+  fail_unless (gst_caps_is_equal (current, caps));
+  gst_caps_unref (current);
+  gst_object_unref (peer);
+  gst_object_unref (sinkpad);
+
+  /* Test sources can output any format, no conversion needed */
+  sinkpad = gst_element_get_static_pad (filter, "sink");
+  peer = gst_pad_get_peer (sinkpad);
+  testsrc = gst_pad_get_parent_element (peer);
+  fail_unless_equals_string (GST_OBJECT_NAME (gst_element_get_factory (testsrc)), "videotestsrc");
+
+  gst_object_unref (testsrc);
+  gst_object_unref (filter);
+  gst_object_unref (peer);
+  gst_object_unref (sinkpad);
+  g_object_unref (positioner);
+  gst_caps_unref (audio_caps);
+  gst_caps_unref (caps);
+  g_object_unref (timeline);
+}
+
+GST_END_TEST
+
+/* The operations in @composition, leaving out the expandable mixer */
+static GList *
+_get_operations (GstElement *composition)
+{
+  GstIterator *it = gst_bin_iterate_elements (GST_BIN (composition));
+  GValue item = G_VALUE_INIT;
+  GList *res = NULL;
+
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+    GstElement *element = g_value_get_object (&item);
+    gboolean expandable;
+
+    if (!g_strcmp0 (GST_OBJECT_NAME (gst_element_get_factory (element)), "nleoperation")) {
+      g_object_get (element, "expandable", &expandable, NULL);
+      if (!expandable)
+        res = g_list_prepend (res, gst_object_ref (element));
+    }
+    g_value_reset (&item);
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  return res;
+}
+
+/* The only element in @operation */
+static GstElement *
+_get_operation_element (GstElement *operation)
+{
+  GstIterator *it = gst_bin_iterate_elements (GST_BIN (operation));
+  GValue item = G_VALUE_INIT;
+  GstElement *res = NULL;
+
+  if (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+    res = g_value_dup_object (&item);
+    g_value_unset (&item);
+  }
+  gst_iterator_free (it);
+
+  return res;
+}
+
+GST_START_TEST (test_crossfade_transition)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  GstCaps *caps = gst_caps_from_string ("video/x-raw,format=I420,width=320,height=240,framerate=25/1");
+  GESSource *sources[2];
+  GList *compositions, *operations;
+  GstElement *operation;
+  guint64 start;
+  gint64 duration;
+  guint i, priority;
+
+  fail_unless (ges_timeline_set_restriction_caps (timeline, GES_MEDIA_TYPE_VIDEO, caps));
+
+  for (i = 0; i < G_N_ELEMENTS (sources); i++) {
+    sources[i] = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+    ges_object_set_start (GES_OBJECT (sources[i]), i * GST_SECOND);
+    ges_object_set_duration (GES_OBJECT (sources[i]), 2 * GST_SECOND);
+    ges_timeline_add_object (timeline, GES_OBJECT (sources[i]));
+  }
+  ges_timeline_commit (timeline);
+
+  /* The overlap is blended by a single operation above the sources */
+  compositions = ges_timeline_get_compositions_by_media_type (timeline, GES_MEDIA_TYPE_VIDEO);
+  operations = _get_operations (compositions->data);
+  fail_unless_equals_int (g_list_length (operations), 1);
+  operation = operations->data;
+  g_list_free (operations);
+
+  g_object_get (operation, "start", &start, "duration", &duration, "priority", &priority, NULL);
+  fail_unless_equals_uint64 (start, GST_SECOND);
+  fail_unless_equals_int64 (duration, GST_SECOND);
+  fail_unless_equals_int (priority, TIMELINE_PRIORITY_OFFSET - 1 - MAX_EFFECT_OPERATIONS);
+
+  play_playable (GES_PLAYABLE (timeline));
+
+  /* And goes away with the transition */
+  ges_object_set_start (GES_OBJECT (sources[1]), 2 * GST_SECOND);
+  ges_timeline_commit (timeline);
+  fail_if (GST_OBJECT_PARENT (operation));
+  gst_object_unref (operation);
+
+  /* A source that doesn't cover the whole output gets its alpha animated,
+   * a crossfade would blend the background in */
+  gst_child_proxy_set (GST_CHILD_PROXY (sources[1]), "framepositioner::posx", 10, NULL);
+  ges_object_set_start (GES_OBJECT (sources[1]), GST_SECOND);
+  ges_timeline_commit (timeline);
+  fail_unless (ges_source_get_transition (sources[0]) != NULL);
+  operations = _get_operations (compositions->data);
+  fail_unless_equals_int (g_list_length (operations), 0);
+
+  g_list_free (compositions);
+  gst_caps_unref (caps);
+  g_object_unref (timeline);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_effects)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO);
+  GstCaps *caps = gst_caps_from_string ("video/x-raw,format=I420,width=320,height=240,framerate=25/1");
+  GESSource *source = ges_test_source_new (GES_MEDIA_TYPE_VIDEO, NULL);
+  const gchar *fused[] = { "videobalance brightness=0.2", "gamma gamma=1.0",
+    "videobalance contrast=0.5 saturation=0.5", "videobalance saturation=0.5" };
+  GESEffect *effect;
+  GList *compositions, *operations, *tmp;
+  GstElement *element;
+  gchar *curve, **levels;
+  gdouble saturation;
+  guint i, priority, priorities = 0;
+
+  fail_unless (ges_timeline_set_restriction_caps (timeline, GES_MEDIA_TYPE_VIDEO, caps));
+  ges_object_set_duration (GES_OBJECT (source), GST_SECOND);
+  ges_timeline_add_object (timeline, GES_OBJECT (source));
+
+  for (i = 0; i < G_N_ELEMENTS (fused); i++) {
+    effect = ges_effect_new (fused[i]);
+    fail_unless (ges_source_add_effect (source, effect));
+    g_object_unref (effect);
+  }
+
+  /* Doesn't apply to video */
+  effect = ges_effect_new ("volume volume=0.5");
+  fail_if (ges_source_add_effect (source, effect));
+  g_object_unref (effect);
+
+  ges_timeline_commit (timeline);
+
+  /* All of them go through a single pass */
+  compositions = ges_timeline_get_compositions_by_media_type (timeline, GES_MEDIA_TYPE_VIDEO);
+  operations = _get_operations (compositions->data);
+  fail_unless_equals_int (g_list_length (operations), 1);
+  element = _get_operation_element (operations->data);
+  fail_unless_equals_string (GST_OBJECT_NAME (gst_element_get_factory (element)), "pixeltransform");
+
+  /* 101 gets brightened to 152, then 16 + (152 - 16) * 0.5 */
+  g_object_get (element, "curve", &curve, "saturation", &saturation, NULL);
+  levels = g_strsplit (curve, " ", -1);
+  fail_unless_equals_string (levels[101], "84");
+  fail_unless (ABS (saturation - 0.25) < 0.0001);
+  g_strfreev (levels);
+  g_free (curve);
+  gst_object_unref (element);
+  g_list_free_full (operations, gst_object_unref);
+
+  /* Which can't get past an effect that isn't per-pixel */
+  effect = ges_effect_new ("identity");
+  fail_unless (ges_source_add_effect (source, effect));
+  g_object_unref (effect);
+  effect = ges_effect_new ("gamma gamma=2.0");
+  fail_unless (ges_source_add_effect (source, effect));
+  ges_timeline_commit (timeline);
+
+  operations = _get_operations (compositions->data);
+  fail_unless_equals_int (g_list_length (operations), 3);
+  for (tmp = operations; tmp; tmp = tmp->next) {
+    g_object_get (tmp->data, "priority", &priority, NULL);
+    fail_if (priority >= TIMELINE_PRIORITY_OFFSET);
+    priorities |= 1 << (TIMELINE_PRIORITY_OFFSET - priority);
+  }
+  /* Stacked right above the source */
+  fail_unless_equals_int (priorities, (1 << 1) | (1 << 2) | (1 << 3));
+  g_list_free_full (operations, gst_object_unref);
+
+  play_playable (GES_PLAYABLE (timeline));
+
+  fail_unless (ges_source_remove_effect (source, effect));
+  fail_if (ges_source_remove_effect (source, effect));
+  g_object_unref (effect);
+  ges_timeline_commit (timeline);
+  operations = _get_operations (compositions->data);
+  fail_unless_equals_int (g_list_length (operations), 2);
+  g_list_free_full (operations, gst_object_unref);
+
+  g_list_free (compositions);
+  gst_caps_unref (caps);
+  g_object_unref (timeline);
+}
+
+GST_END_TEST
+
+/* The priorities of the sources in @composition, leaving out the
+ * expandable background */
+static guint
+_get_source_priorities (GstElement *composition, guint offset)
+{
+  GstIterator *it = gst_bin_iterate_elements (GST_BIN (composition));
+  GValue item = G_VALUE_INIT;
+  guint res = 0, priority;
+
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+    GstElement *element = g_value_get_object (&item);
+    gboolean expandable;
+
+    if (!g_strcmp0 (GST_OBJECT_NAME (gst_element_get_factory (element)), "nlesource")) {
+      g_object_get (element, "expandable", &expandable, "priority", &priority, NULL);
+      if (!expandable)
+        res |= 1 << ((priority - offset) / SOURCE_PRIORITY_HEIGHT);
+    }
+    g_value_reset (&item);
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  return res;
+}
+
+GST_START_TEST (test_overlapping_effects)
+{
+  GESTimeline *timeline = ges_timeline_new (GES_MEDIA_TYPE_AUDIO);
+  const gchar *descriptions[] = { "volume name=effect0 volume=0.5",
+    "volume name=effect1 volume=0.25" };
+  GESSource *sources[2];
+  GList *compositions, *operations, *tmp;
+  guint i, priority;
+
+  for (i = 0; i < G_N_ELEMENTS (sources); i++) {
+    GESEffect *effect = ges_effect_new (descriptions[i]);
+
+    sources[i] = ges_test_source_new (GES_MEDIA_TYPE_AUDIO, NULL);
+    ges_object_set_start (GES_OBJECT (sources[i]), i * GST_SECOND);
+    ges_object_set_duration (GES_OBJECT (sources[i]), 2 * GST_SECOND);
+    fail_unless (ges_source_add_effect (sources[i], effect));
+    g_object_unref (effect);
+    ges_timeline_add_object (timeline, GES_OBJECT (sources[i]));
+  }
+  ges_timeline_commit (timeline);
+
+  /* The sources get mixed, each in a lane of its own */
+  compositions = ges_timeline_get_compositions_by_media_type (timeline, GES_MEDIA_TYPE_AUDIO);
+  fail_unless_equals_int (_get_source_priorities (compositions->data,
+        TIMELINE_PRIORITY_OFFSET), (1 << 0) | (1 << 1));
+
+  /* With its effects right above it, they can't take the other source */
+  operations = _get_operations (compositions->data);
+  fail_unless_equals_int (g_list_length (operations), 2);
+  for (tmp = operations; tmp; tmp = tmp->next) {
+    GstElement *effect = gst_bin_get_by_name (GST_BIN (tmp->data), "effect0");
+
+    g_object_get (tmp->data, "priority", &priority, NULL);
+    if (effect) {
+      fail_unless_equals_int (priority, TIMELINE_PRIORITY_OFFSET - 1);
+      gst_object_unref (effect);
+    } else {
+      fail_unless_equals_int (priority, TIMELINE_PRIORITY_OFFSET + SOURCE_PRIORITY_HEIGHT - 1);
+    }
+  }
+  g_list_free_full (operations, gst_object_unref);
+
+  play_playable (GES_PLAYABLE (timeline));
+
+  /* Lanes get reused once free */
+  ges_object_set_start (GES_OBJECT (sources[1]), 2 * GST_SECOND);
+  ges_timeline_commit (timeline);
+  fail_unless_equals_int (_get_source_priorities (compositions->data,
+        TIMELINE_PRIORITY_OFFSET), 1 << 0);
+
+  g_list_free (compositions);
+  g_object_unref (timeline);
+}
+
+GST_END_TEST
+
 static Suite *
 ges_suite (void)
 {
@@ -66,6 +623,14 @@ ges_suite (void)
   ges_init ();
 
   tcase_add_test (tc_chain, test_tracks);
+  tcase_add_test (tc_chain, test_edit);
+  tcase_add_test (tc_chain, test_edit_rejected);
+  tcase_add_test (tc_chain, test_commit_async);
+  tcase_add_test (tc_chain, test_nesting);
+  tcase_add_test (tc_chain, test_restriction_caps);
+  tcase_add_test (tc_chain, test_crossfade_transition);
+  tcase_add_test (tc_chain, test_effects);
+  tcase_add_test (tc_chain, test_overlapping_effects);
 
   return s;
 }
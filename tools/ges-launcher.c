@@ -54,6 +54,7 @@ typedef struct
   gboolean list_transitions;
   gboolean inspect_action_type;
   gchar *sanitized_timeline;
+  gint discovery_threads;
 } ParsedOptions;
 
 typedef struct _GESLauncherPrivate
@@ -65,6 +66,10 @@ typedef struct _GESLauncherPrivate
 #endif
   ParsedOptions parsed_options;
   GHashTable *function_map;
+  /* Sources being discovered, in command line order */
+  GQueue pending_sources;
+  /* The ones of the last +source, +effect applies to them */
+  GList *last_sources;
 } GESLauncherPrivate;
 
 struct _GESLauncher
@@ -170,42 +175,146 @@ _parse_structures (const gchar * string)
 
 typedef gboolean (*StructuredFunction)(GESLauncher *self, const GstStructure *structure);
 
+typedef struct
+{
+  GESLauncher *self;
+  GstStructure *structure;
+  GESMediaType media_type;
+  /* The bin descriptions of the effects to add once created */
+  GList *effects;
+  gboolean created;
+  GESSource *source;
+} PendingSource;
+
 static void
-_add_source_for_media_type (GESLauncher *self, const GstStructure *structure, GESMediaType media_type)
+_add_created_source (GESLauncher *self, PendingSource *pending)
 {
   GESLauncherPrivate *priv = GES_LAUNCHER_PRIV (self);
-  const gchar *uri = gst_structure_get_string (structure, "uri");
-  GESSource *source = ges_uri_source_new (uri, media_type);
+  GESSource *source = pending->source;
   gdouble time;
+  GList *tmp;
 
   if (!source)
-    return;
+    goto done;
 
-  if (gst_structure_get_double (structure, "inpoint", &time)) {
+  if (gst_structure_get_double (pending->structure, "inpoint", &time)) {
     GST_ERROR ("setting inpoint dude");
     ges_object_set_inpoint (GES_OBJECT (source), time * GST_SECOND);
   }
 
-  if (gst_structure_get_double (structure, "start", &time)) {
+  if (gst_structure_get_double (pending->structure, "start", &time)) {
     ges_object_set_start (GES_OBJECT (source), time * GST_SECOND);
   }
 
-  if (gst_structure_get_double (structure, "duration", &time)) {
+  if (gst_structure_get_double (pending->structure, "duration", &time)) {
     ges_object_set_duration (GES_OBJECT (source), time * GST_SECOND);
   }
 
+  for (tmp = pending->effects; tmp; tmp = tmp->next) {
+    GESEffect *effect = ges_effect_new (tmp->data);
+
+    if (!ges_source_add_effect (source, effect))
+      g_printerr ("Could not add +effect %s to %s\n", (gchar *) tmp->data,
+          gst_structure_get_string (pending->structure, "uri"));
+    g_object_unref (effect);
+  }
+
   ges_timeline_add_object (priv->timeline, GES_OBJECT (source));
+
+done:
+  g_list_free_full (pending->effects, g_free);
+  gst_structure_free (pending->structure);
+  g_slice_free (PendingSource, pending);
+}
+
+static void
+_source_created_cb (GObject *unused, GAsyncResult *result, PendingSource *pending)
+{
+  GESLauncherPrivate *priv = GES_LAUNCHER_PRIV (pending->self);
+  GESLauncher *self = pending->self;
+
+  pending->source = ges_uri_source_new_finish (result, NULL);
+  pending->created = TRUE;
+  priv->last_sources = g_list_remove (priv->last_sources, pending);
+
+  /* Discoveries complete in any order, the timeline still gets populated
+   * in command line order so that the result doesn't depend on it */
+  while (!g_queue_is_empty (&priv->pending_sources) &&
+      ((PendingSource *) g_queue_peek_head (&priv->pending_sources))->created)
+    _add_created_source (self, g_queue_pop_head (&priv->pending_sources));
+}
+
+static void
+_add_source_for_media_type (GESLauncher *self, const GstStructure *structure, GESMediaType media_type)
+{
+  GESLauncherPrivate *priv = GES_LAUNCHER_PRIV (self);
+  const gchar *uri = gst_structure_get_string (structure, "uri");
+  PendingSource *pending = g_slice_new0 (PendingSource);
+
+  pending->self = self;
+  pending->media_type = media_type;
+  pending->structure = gst_structure_copy (structure);
+  g_queue_push_tail (&priv->pending_sources, pending);
+  priv->last_sources = g_list_append (priv->last_sources, pending);
+
+  ges_uri_source_new_async (uri, media_type, NULL,
+      (GAsyncReadyCallback) _source_created_cb, pending);
 }
 
 static gboolean
 _add_source (GESLauncher *self, const GstStructure *structure)
 {
+  GESLauncherPrivate *priv = GES_LAUNCHER_PRIV (self);
+
+  g_list_free (priv->last_sources);
+  priv->last_sources = NULL;
+
   _add_source_for_media_type (self, structure, GES_MEDIA_TYPE_VIDEO);
   _add_source_for_media_type (self, structure, GES_MEDIA_TYPE_AUDIO);
 
   return TRUE;
 }
 
+static gboolean
+_add_effect (GESLauncher *self, const GstStructure *structure)
+{
+  GESLauncherPrivate *priv = GES_LAUNCHER_PRIV (self);
+  const gchar *bin_description = gst_structure_get_string (structure, "bin-description");
+  GESEffect *effect;
+  GESMediaType media_type;
+  gboolean applied = FALSE;
+  GList *tmp;
+
+  if (!priv->last_sources) {
+    g_printerr ("+effect %s has no +source to apply to\n", bin_description);
+    return FALSE;
+  }
+
+  /* Only applies to the audio or the video of the source, unless it
+   * deals with any media */
+  effect = ges_effect_new (bin_description);
+  media_type = ges_effect_get_media_type (effect);
+  g_object_unref (effect);
+
+  for (tmp = priv->last_sources; tmp; tmp = tmp->next) {
+    PendingSource *pending = tmp->data;
+
+    if (media_type && !(media_type & pending->media_type))
+      continue;
+
+    pending->effects = g_list_append (pending->effects, g_strdup (bin_description));
+    applied = TRUE;
+  }
+
+  if (!applied) {
+    g_printerr ("+effect %s applies to neither the audio nor the video of "
+        "the last +source\n", bin_description);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 _create_timeline (GESLauncher * self, const gchar * serialized_timeline,
     const gchar * proj_uri, const gchar * scenario)
@@ -215,6 +324,9 @@ _create_timeline (GESLauncher * self, const gchar * serialized_timeline,
   GList *tmp;
 
   priv->timeline = ges_timeline_new (GES_MEDIA_TYPE_VIDEO | GES_MEDIA_TYPE_AUDIO);
+  if (priv->parsed_options.disable_mixing)
+    ges_timeline_set_mixing (priv->timeline, FALSE);
+
   for (tmp = parser->structures; tmp; tmp = tmp->next) {
     GstStructure *structure = GST_STRUCTURE (tmp->data);
     StructuredFunction func = g_hash_table_lookup (priv->function_map, gst_structure_get_name (structure));
@@ -222,6 +334,10 @@ _create_timeline (GESLauncher * self, const gchar * serialized_timeline,
     func (self, structure);
   }
 
+  /* Sources are discovered in parallel, wait for all of them */
+  while (!g_queue_is_empty (&priv->pending_sources))
+    g_main_context_iteration (NULL, TRUE);
+
   return TRUE;
 }
 
@@ -337,6 +453,10 @@ ges_launcher_get_project_option_group (GESLauncher * self)
           "Same as save project, except exit as soon as the timeline "
           "is saved instead of playing it back",
         "<path>"},
+    {"discovery-threads", 0, 0, G_OPTION_ARG_INT, &opts->discovery_threads,
+          "Maximum number of media to discover at once when loading, "
+          "defaults to the number of processors.",
+        "<n>"},
     {NULL}
   };
   group = g_option_group_new ("project", "Project Options",
@@ -541,6 +661,9 @@ _startup (GApplication * application)
     goto done;
   }
 
+  if (opts->discovery_threads > 0)
+    ges_asset_set_max_discovery_threads (opts->discovery_threads);
+
   if (!_create_pipeline (self, opts->sanitized_timeline))
     goto failure;
 
@@ -596,6 +719,7 @@ ges_launcher_init (GESLauncher * self)
 
   priv->function_map = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
   g_hash_table_insert (priv->function_map, g_strdup ("source"), _add_source);
+  g_hash_table_insert (priv->function_map, g_strdup ("effect"), _add_effect);
 }
 
 gint